@@ -154,6 +154,18 @@ typedef struct aas_routingcache_s
 	unsigned short int traveltimes[1];			//travel time for every area (variable sized)
 } aas_routingcache_t;
 
+//precomputed routing table for one set of travel flags, holds the
+//contents of every area and portal routing cache for those flags
+typedef struct aas_routetable_s
+{
+	int travelflags;							//travel flags the table was built for
+	int *clusteroffsets;						//first area travel time of every cluster
+	unsigned short int *areatraveltimes;		//per cluster [goal][area] like the area cache
+	unsigned char *areareachabilities;			//reachabilities for the above
+	unsigned short int *portaltraveltimes;		//[goal area][portal] like the portal cache
+	unsigned char *portalreachabilities;		//portal caches don't store any, all zero
+} aas_routetable_t;
+
 //fields for the routing algorithm
 typedef struct aas_routingupdate_s
 {
@@ -270,6 +282,8 @@ typedef struct aas_s
 	aas_reversedreachability_t *reversedreachability;
 	//travel times within the areas
 	unsigned short ***areatraveltimes;
+	//set for the areas that have their travel times calculated
+	byte *areatraveltimescalculated;
 	//array of size numclusters with cluster cache
 	aas_routingcache_t ***clusterareacache;
 	aas_routingcache_t **portalcache;
@@ -278,6 +292,16 @@ typedef struct aas_s
 	aas_routingcache_t *newestcache;		// end of cache list sorted on time
 	//maximum travel time through portal areas
 	int *portalmaxtraveltimes;
+	//routing table used instead of the cache while no area is disabled
+	aas_routetable_t *routetable;
+	int numdisabledareas;
+	//route cache dump loaded over several frames
+	fileHandle_t routecachefile;
+	int numroutecacheread;
+	int numroutecachetotal;
+	//time the routing was initialized and whether the route cache has been written since
+	float routinginittime;
+	int routecachesaved;
 	//areas the reachabilities go through
 	int *reachabilityareaindex;
 	aas_reachabilityareas_t *reachabilityareas;
@@ -46,6 +46,8 @@ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
 //#define AASFILEDEBUG
 
 //===========================================================================
+// the AAS file is little endian, on little endian hosts the data is
+// used as it is read from the file
 //
 // Parameter:				-
 // Returns:					-
@@ -53,6 +55,7 @@ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
 //===========================================================================
 void AAS_SwapAASData(void)
 {
+#ifdef Q3_BIG_ENDIAN
 	int i, j;
 	//bounding boxes
 	for (i = 0; i < aasworld.numbboxes; i++)
@@ -61,8 +64,8 @@ void AAS_SwapAASData(void)
 		aasworld.bboxes[i].flags = LittleLong(aasworld.bboxes[i].flags);
 		for (j = 0; j < 3; j++)
 		{
-			aasworld.bboxes[i].mins[j] = LittleLong(aasworld.bboxes[i].mins[j]);
-			aasworld.bboxes[i].maxs[j] = LittleLong(aasworld.bboxes[i].maxs[j]);
+			aasworld.bboxes[i].mins[j] = LittleFloat(aasworld.bboxes[i].mins[j]);
+			aasworld.bboxes[i].maxs[j] = LittleFloat(aasworld.bboxes[i].maxs[j]);
 		} //end for
 	} //end for
 	//vertexes
@@ -172,6 +175,7 @@ void AAS_SwapAASData(void)
 		aasworld.clusters[i].numportals = LittleLong(aasworld.clusters[i].numportals);
 		aasworld.clusters[i].firstportal = LittleLong(aasworld.clusters[i].firstportal);
 	} //end for
+#endif //Q3_BIG_ENDIAN
 } //end of the function AAS_SwapAASData
 //===========================================================================
 // dump the current loaded aas file
@@ -308,14 +312,12 @@ char *AAS_LoadAASLump(fileHandle_t fp, int offset, int length, int *lastoffset,
 			return NULL;
 		} //end if
 	} //end if
-	//allocate memory
-	buf = (char *) GetClearedHunkMemory(length+1);
+	//allocate memory, all but the last byte is read from the file
+	buf = (char *) GetHunkMemory(length+1);
+	buf[length] = 0;
 	//read the data
-	if (length)
-	{
-		botimport.FS_Read(buf, length, fp );
-		*lastoffset += length;
-	} //end if
+	botimport.FS_Read(buf, length, fp );
+	*lastoffset += length;
 	return buf;
 } //end of the function AAS_LoadAASLump
 //===========================================================================
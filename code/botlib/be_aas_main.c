@@ -47,6 +47,9 @@ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
 aas_t aasworld;
 
 libvar_t *saveroutingcache;
+libvar_t *saveroutetable;
+libvar_t *routingcachestats;
+libvar_t *routecachewarmup;
 
 //===========================================================================
 //
@@ -244,8 +247,12 @@ int AAS_StartFrame(float time)
 	AAS_InvalidateEntities();
 	//initialize AAS
 	AAS_ContinueInit(time);
+	//load the next part of the route cache dump
+	AAS_ContinueReadRouteCache();
 	//
 	aasworld.frameroutingupdates = 0;
+	//report the routing cache use of the last frame
+	AAS_RoutingCacheFrameStats(routingcachestats->value);
 	//
 	if (botDeveloper)
 	{
@@ -271,6 +278,15 @@ int AAS_StartFrame(float time)
 		AAS_WriteRouteCache();
 		LibVarSet("saveroutingcache", "0");
 	} //end if
+	if (saveroutetable->value)
+	{
+		AAS_WriteRouteTable();
+		LibVarSet("saveroutetable", "0");
+	} //end if
+	if (aasworld.initialized)
+	{
+		AAS_CheckWriteRouteCache(routecachewarmup->value);
+	} //end if
 	//
 	aasworld.numframes++;
 	return BLERR_NOERROR;
@@ -386,6 +402,13 @@ int AAS_Setup(void)
 	aasworld.maxentities = (int) LibVarValue("maxentities", "1024");
 	// as soon as it's set to 1 the routing cache will be saved
 	saveroutingcache = LibVar("saveroutingcache", "0");
+	// as soon as it's set to 1 the route table will be built and saved
+	saveroutetable = LibVar("saveroutetable", "0");
+	// print the routing cache hits, misses and evictions every frame
+	routingcachestats = LibVar("routingcachestats", "0");
+	// seconds of routing after which the routing cache is written automatically,
+	// the whole cache is written in one frame so this is off by default
+	routecachewarmup = LibVar("routecachewarmup", "0");
 	//allocate memory for the entities
 	if (aasworld.entities) FreeMemory(aasworld.entities);
 	aasworld.entities = (aas_entity_t *) GetClearedHunkMemory(aasworld.maxentities * sizeof(aas_entity_t));
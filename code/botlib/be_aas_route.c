@@ -84,6 +84,36 @@ int numportalcacheupdates;
 int routingcachesize;
 int max_routingcachesize;
 
+//routing caches are carved from chunks of this size
+#define ROUTINGCACHE_CHUNKSIZE			(256 * 1024)
+//the smallest size class holds blocks of 1 << ROUTINGCACHE_MINSIZESHIFT bytes
+#define ROUTINGCACHE_MINSIZESHIFT		6
+//every power of two is split in this many size classes
+#define ROUTINGCACHE_CLASSSTEPS			4
+#define MAX_ROUTINGCACHE_SIZECLASSES	((32 - ROUTINGCACHE_MINSIZESHIFT) * ROUTINGCACHE_CLASSSTEPS + 1)
+
+//chunk of memory routing caches are allocated from
+typedef struct aas_routingcachechunk_s
+{
+	struct aas_routingcachechunk_s *next;
+	int size;									//size of the chunk without this header
+	int used;									//bytes handed out from the chunk
+} aas_routingcachechunk_t;
+
+//size classed arena for the routing caches
+typedef struct aas_routingcachepool_s
+{
+	aas_routingcachechunk_t *chunks;			//all chunks, the first one is carved from
+	aas_routingcache_t *freecaches[MAX_ROUTINGCACHE_SIZECLASSES];	//freed blocks per size class
+	int poolsize;								//bytes allocated for chunks
+	int blocksize;								//bytes in blocks handed out to caches
+	//routing cache statistics for the current frame and since the map was loaded
+	int framehits, framemisses, frameevictions;
+	int hits, misses, evictions;
+} aas_routingcachepool_t;
+
+aas_routingcachepool_t routingcachepool;
+
 //===========================================================================
 //
 // Parameter:			-
@@ -96,6 +126,10 @@ void AAS_RoutingInfo(void)
 	botimport.Print(PRT_MESSAGE, "%d area cache updates\n", numareacacheupdates);
 	botimport.Print(PRT_MESSAGE, "%d portal cache updates\n", numportalcacheupdates);
 	botimport.Print(PRT_MESSAGE, "%d bytes routing cache\n", routingcachesize);
+	botimport.Print(PRT_MESSAGE, "%d bytes in routing cache blocks, %d bytes in the pool\n",
+						routingcachepool.blocksize, routingcachepool.poolsize);
+	botimport.Print(PRT_MESSAGE, "%d cache hits, %d misses, %d evictions\n",
+						routingcachepool.hits, routingcachepool.misses, routingcachepool.evictions);
 } //end of the function AAS_RoutingInfo
 #endif //ROUTING_DEBUG
 //===========================================================================
@@ -199,6 +233,8 @@ int AAS_TravelFlagForType(int traveltype)
 //===========================================================================
 void AAS_UnlinkCache(aas_routingcache_t *cache)
 {
+	//the cache might not be in the list
+	if (!cache->time_prev && aasworld.oldestcache != cache) return;
 	if (cache->time_next) cache->time_next->time_prev = cache->time_prev;
 	else aasworld.newestcache = cache->time_prev;
 	if (cache->time_prev) cache->time_prev->time_next = cache->time_next;
@@ -214,6 +250,8 @@ void AAS_UnlinkCache(aas_routingcache_t *cache)
 //===========================================================================
 void AAS_LinkCache(aas_routingcache_t *cache)
 {
+	//area cache leading towards a portal is never freed so it's not put in the list
+	if (cache->type == CACHETYPE_AREA && aasworld.areasettings[cache->areanum].cluster < 0) return;
 	if (aasworld.newestcache)
 	{
 		aasworld.newestcache->time_next = cache;
@@ -228,6 +266,68 @@ void AAS_LinkCache(aas_routingcache_t *cache)
 	aasworld.newestcache = cache;
 } //end of the function AAS_LinkCache
 //===========================================================================
+// returns the size class for a routing cache of the given size and the
+// size of the blocks in that class
+//
+// Parameter:			-
+// Returns:				-
+// Changes Globals:		-
+//===========================================================================
+static int AAS_RoutingCacheSizeClass(int size, int *blocksize)
+{
+	int shift, step, n;
+
+	if (size <= (1 << ROUTINGCACHE_MINSIZESHIFT))
+	{
+		*blocksize = 1 << ROUTINGCACHE_MINSIZESHIFT;
+		return 0;
+	} //end if
+	//find the power of two just below the size
+	for (shift = ROUTINGCACHE_MINSIZESHIFT; (1 << (shift + 1)) < size; shift++) ;
+	//round up to the next step between this and the next power of two
+	step = (1 << shift) / ROUTINGCACHE_CLASSSTEPS;
+	n = (size - (1 << shift) + step - 1) / step;
+	*blocksize = (1 << shift) + n * step;
+	return (shift - ROUTINGCACHE_MINSIZESHIFT) * ROUTINGCACHE_CLASSSTEPS + n;
+} //end of the function AAS_RoutingCacheSizeClass
+//===========================================================================
+// carves a new block from the routing cache pool
+//
+// Parameter:			-
+// Returns:				-
+// Changes Globals:		-
+//===========================================================================
+static void *AAS_RoutingCachePoolBlock(int blocksize)
+{
+	aas_routingcachechunk_t *chunk;
+	int size;
+
+	chunk = routingcachepool.chunks;
+	if (!chunk || chunk->size - chunk->used < blocksize)
+	{
+		//large blocks get a chunk of their own
+		size = ROUTINGCACHE_CHUNKSIZE;
+		if (blocksize > size / 4) size = blocksize;
+		chunk = (aas_routingcachechunk_t *) GetMemory(sizeof(aas_routingcachechunk_t) + size);
+		chunk->size = size;
+		chunk->used = 0;
+		routingcachepool.poolsize += sizeof(aas_routingcachechunk_t) + size;
+		//keep carving from the current chunk if it still has room
+		if (routingcachepool.chunks && size == blocksize)
+		{
+			chunk->next = routingcachepool.chunks->next;
+			routingcachepool.chunks->next = chunk;
+		} //end if
+		else
+		{
+			chunk->next = routingcachepool.chunks;
+			routingcachepool.chunks = chunk;
+		} //end else
+	} //end if
+	chunk->used += blocksize;
+	return (byte *) (chunk + 1) + chunk->used - blocksize;
+} //end of the function AAS_RoutingCachePoolBlock
+//===========================================================================
 //
 // Parameter:			-
 // Returns:				-
@@ -235,11 +335,55 @@ void AAS_LinkCache(aas_routingcache_t *cache)
 //===========================================================================
 void AAS_FreeRoutingCache(aas_routingcache_t *cache)
 {
+	int sizeclass, blocksize;
+
 	AAS_UnlinkCache(cache);
 	routingcachesize -= cache->size;
-	FreeMemory(cache);
+	//put the block back in the free list of its size class
+	sizeclass = AAS_RoutingCacheSizeClass(cache->size, &blocksize);
+	routingcachepool.blocksize -= blocksize;
+	cache->next = routingcachepool.freecaches[sizeclass];
+	routingcachepool.freecaches[sizeclass] = cache;
 } //end of the function AAS_FreeRoutingCache
 //===========================================================================
+// frees all chunks of the routing cache pool, all routing caches
+// must have been freed before calling this
+//
+// Parameter:			-
+// Returns:				-
+// Changes Globals:		-
+//===========================================================================
+static void AAS_FreeRoutingCachePool(void)
+{
+	aas_routingcachechunk_t *chunk, *nextchunk;
+
+	for (chunk = routingcachepool.chunks; chunk; chunk = nextchunk)
+	{
+		nextchunk = chunk->next;
+		FreeMemory(chunk);
+	} //end for
+	Com_Memset(&routingcachepool, 0, sizeof(routingcachepool));
+} //end of the function AAS_FreeRoutingCachePool
+//===========================================================================
+// prints the routing cache statistics of the last frame and resets them
+//
+// Parameter:			print	: print the statistics
+// Returns:				-
+// Changes Globals:		-
+//===========================================================================
+void AAS_RoutingCacheFrameStats(int print)
+{
+	if (print && (routingcachepool.framehits || routingcachepool.framemisses || routingcachepool.frameevictions))
+	{
+		botimport.Print(PRT_MESSAGE, "routing cache: %d hits, %d misses, %d evictions, %d KB used of %d KB, %d KB pool\n",
+							routingcachepool.framehits, routingcachepool.framemisses, routingcachepool.frameevictions,
+							routingcachesize >> 10, max_routingcachesize >> 10, routingcachepool.poolsize >> 10);
+	} //end if
+	routingcachepool.framehits = 0;
+	routingcachepool.framemisses = 0;
+	routingcachepool.frameevictions = 0;
+} //end of the function AAS_RoutingCacheFrameStats
+//===========================================================================
 //
 // Parameter:			-
 // Returns:				-
@@ -328,6 +472,9 @@ int AAS_EnableRoutingArea(int areanum, int enable)
 	// if the status of the area changed
 	if ( (flags & AREA_DISABLED) != (aasworld.areasettings[areanum].areaflags & AREA_DISABLED) )
 	{
+		//the route table is only valid while no areas are disabled
+		if (flags) aasworld.numdisabledareas--;
+		else aasworld.numdisabledareas++;
 		//remove all routing cache involving this area
 		AAS_RemoveRoutingCacheUsingArea( areanum );
 	} //end if
@@ -492,6 +639,8 @@ unsigned short int AAS_AreaTravelTime(int areanum, vec3_t start, vec3_t end)
 	return intdist;
 } //end of the function AAS_AreaTravelTime
 //===========================================================================
+// allocates the travel times within the areas, the travel times of an
+// area are only calculated when the routing first needs them
 //
 // Parameter:			-
 // Returns:				-
@@ -499,22 +648,15 @@ unsigned short int AAS_AreaTravelTime(int areanum, vec3_t start, vec3_t end)
 //===========================================================================
 void AAS_CalculateAreaTravelTimes(void)
 {
-	int i, l, n, size;
+	int i, l, size;
 	char *ptr;
-	vec3_t end;
 	aas_reversedreachability_t *revreach;
-	aas_reversedlink_t *revlink;
-	aas_reachability_t *reach;
 	aas_areasettings_t *settings;
-#ifdef DEBUG
-	int starttime;
 
-	starttime = Sys_MilliSeconds();
-#endif
 	//if there are still area travel times, free the memory
 	if (aasworld.areatraveltimes) FreeMemory(aasworld.areatraveltimes);
 	//get the total size of all the area travel times
-	size = aasworld.numareas * sizeof(unsigned short **);
+	size = aasworld.numareas * sizeof(unsigned short **) + aasworld.numareas * sizeof(byte);
 	for (i = 0; i < aasworld.numareas; i++)
 	{
 		revreach = &aasworld.reversedreachability[i];
@@ -530,7 +672,7 @@ void AAS_CalculateAreaTravelTimes(void)
 	ptr = (char *) GetClearedMemory(size);
 	aasworld.areatraveltimes = (unsigned short ***) ptr;
 	ptr += aasworld.numareas * sizeof(unsigned short **);
-	//calcluate the travel times for all the areas
+	//set up the travel time arrays of all the areas
 	for (i = 0; i < aasworld.numareas; i++)
 	{
 		//reversed reachabilities of this area
@@ -545,22 +687,63 @@ void AAS_CalculateAreaTravelTimes(void)
 		{
 			aasworld.areatraveltimes[i][l] = (unsigned short *) ptr;
 			ptr += PAD(revreach->numlinks, sizeof(long)) * sizeof(unsigned short);
-			//reachability link
-			reach = &aasworld.reachability[settings->firstreachablearea + l];
-			//
-			for (n = 0, revlink = revreach->first; revlink; revlink = revlink->next, n++)
-			{
-				VectorCopy(aasworld.reachability[revlink->linknum].end, end);
-				//
-				aasworld.areatraveltimes[i][l][n] = AAS_AreaTravelTime(i, end, reach->start);
-			} //end for
 		} //end for
 	} //end for
-#ifdef DEBUG
-	botimport.Print(PRT_MESSAGE, "area travel times %d msec\n", Sys_MilliSeconds() - starttime);
-#endif
+	//none of the travel times have been calculated yet
+	aasworld.areatraveltimescalculated = (byte *) ptr;
 } //end of the function AAS_CalculateAreaTravelTimes
 //===========================================================================
+// calculates the travel times from every reversed reachability of the
+// area to every reachability of the area
+//
+// Parameter:			-
+// Returns:				-
+// Changes Globals:		-
+//===========================================================================
+static void AAS_CalculateTravelTimesInArea(int areanum)
+{
+	int l, n;
+	vec3_t end;
+	aas_reversedreachability_t *revreach;
+	aas_reversedlink_t *revlink;
+	aas_reachability_t *reach;
+	aas_areasettings_t *settings;
+
+	//reversed reachabilities of this area
+	revreach = &aasworld.reversedreachability[areanum];
+	//settings of the area
+	settings = &aasworld.areasettings[areanum];
+	//
+	for (l = 0; l < settings->numreachableareas; l++)
+	{
+		//reachability link
+		reach = &aasworld.reachability[settings->firstreachablearea + l];
+		//
+		for (n = 0, revlink = revreach->first; revlink; revlink = revlink->next, n++)
+		{
+			VectorCopy(aasworld.reachability[revlink->linknum].end, end);
+			//
+			aasworld.areatraveltimes[areanum][l][n] = AAS_AreaTravelTime(areanum, end, reach->start);
+		} //end for
+	} //end for
+	aasworld.areatraveltimescalculated[areanum] = qtrue;
+} //end of the function AAS_CalculateTravelTimesInArea
+//===========================================================================
+// returns the travel times within the area, calculates them if needed
+//
+// Parameter:			-
+// Returns:				-
+// Changes Globals:		-
+//===========================================================================
+static ID_INLINE unsigned short int **AAS_AreaTravelTimes(int areanum)
+{
+	if (!aasworld.areatraveltimescalculated[areanum])
+	{
+		AAS_CalculateTravelTimesInArea(areanum);
+	} //end if
+	return aasworld.areatraveltimes[areanum];
+} //end of the function AAS_AreaTravelTimes
+//===========================================================================
 //
 // Parameter:			-
 // Returns:				-
@@ -585,7 +768,7 @@ int AAS_PortalMaxTravelTime(int portalnum)
 	{
 		for (n = 0, revlink = revreach->first; revlink; revlink = revlink->next, n++)
 		{
-			t = aasworld.areatraveltimes[portal->areanum][l][n];
+			t = AAS_AreaTravelTimes(portal->areanum)[l][n];
 			if (t > maxt)
 			{
 				maxt = t;
@@ -700,14 +883,10 @@ int AAS_FreeOldestCache(void)
 	int clusterareanum;
 	aas_routingcache_t *cache;
 
-	for (cache = aasworld.oldestcache; cache; cache = cache->time_next) {
-		// never free area cache leading towards a portal
-		if (cache->type == CACHETYPE_AREA && aasworld.areasettings[cache->areanum].cluster < 0) {
-			continue;
-		}
-		break;
-	}
-	if (cache) {
+	// area cache leading towards a portal is never in the list
+	cache = aasworld.oldestcache;
+	// never free cache used this frame, the caller might still be using it
+	if (cache && cache->time < AAS_RoutingTime()) {
 		// unlink the cache
 		if (cache->type == CACHETYPE_AREA) {
 			//number of the area in the cluster
@@ -724,6 +903,8 @@ int AAS_FreeOldestCache(void)
 			if (cache->next) cache->next->prev = cache->prev;
 		}
 		AAS_FreeRoutingCache(cache);
+		routingcachepool.frameevictions++;
+		routingcachepool.evictions++;
 		return qtrue;
 	}
 	return qfalse;
@@ -734,19 +915,45 @@ int AAS_FreeOldestCache(void)
 // Returns:				-
 // Changes Globals:		-
 //===========================================================================
+static int AAS_RoutingCacheSize(int numtraveltimes)
+{
+	return sizeof(aas_routingcache_t)
+						+ numtraveltimes * sizeof(unsigned short int)
+						+ numtraveltimes * sizeof(unsigned char);
+} //end of the function AAS_RoutingCacheSize
+//===========================================================================
+//
+// Parameter:			-
+// Returns:				-
+// Changes Globals:		-
+//===========================================================================
 aas_routingcache_t *AAS_AllocRoutingCache(int numtraveltimes)
 {
 	aas_routingcache_t *cache;
-	int size;
+	int size, sizeclass, blocksize;
 
 	//
-	size = sizeof(aas_routingcache_t)
-						+ numtraveltimes * sizeof(unsigned short int)
-						+ numtraveltimes * sizeof(unsigned char);
+	size = AAS_RoutingCacheSize(numtraveltimes);
+	//make room for the cache by freeing the least recently used ones
+	while (routingcachesize + size > max_routingcachesize)
+	{
+		if (!AAS_FreeOldestCache()) break;
+	} //end while
 	//
+	sizeclass = AAS_RoutingCacheSizeClass(size, &blocksize);
+	//don't grow the pool when running low on memory but reuse freed cache
+	while (!routingcachepool.freecaches[sizeclass] &&
+			AvailableMemory() < 1024 * 1024 + ROUTINGCACHE_CHUNKSIZE)
+	{
+		if (!AAS_FreeOldestCache()) break;
+	} //end while
+	cache = routingcachepool.freecaches[sizeclass];
+	if (cache) routingcachepool.freecaches[sizeclass] = cache->next;
+	else cache = (aas_routingcache_t *) AAS_RoutingCachePoolBlock(blocksize);
+	Com_Memset(cache, 0, size);
 	routingcachesize += size;
+	routingcachepool.blocksize += blocksize;
 	//
-	cache = (aas_routingcache_t *) GetClearedMemory(size);
 	cache->reachabilities = (unsigned char *) cache + sizeof(aas_routingcache_t)
 								+ numtraveltimes * sizeof(unsigned short int);
 	cache->size = size;
@@ -916,26 +1123,91 @@ void AAS_CreateAllRoutingCache(void)
 //===========================================================================
 
 //the route cache header
-//this header is followed by numportalcache + numareacache aas_routingcache_t
-//structures that store routing cache
+//this header is followed by numportalcache + numareacache caches, every
+//cache is a routecacherecord_t followed by the travel times and reachabilities
 typedef struct routecacheheader_s
 {
 	int ident;
 	int version;
 	int numareas;
 	int numclusters;
+	int numportals;
+	int bspchecksum;
 	int areacrc;
 	int clustercrc;
+	int reachabilitycrc;
 	int numportalcache;
 	int numareacache;
 } routecacheheader_t;
 
+//a routing cache without the pointers
+typedef struct routecacherecord_s
+{
+	int type;
+	int cluster;
+	int areanum;
+	vec3_t origin;
+	float starttraveltime;
+	int travelflags;
+	int numtraveltimes;
+} routecacherecord_t;
+
 #define RCID						(('C'<<24)+('R'<<16)+('E'<<8)+'M')
-#define RCVERSION					2
+#define RCVERSION					3
 
-//void AAS_DecompressVis(byte *in, int numareas, byte *decompressed);
-//int AAS_CompressVis(byte *vis, int numareas, byte *dest);
+//maximum number of bytes of routing cache loaded each frame
+#define MAX_ROUTECACHELOADSIZE		(128 * 1024)
 
+//===========================================================================
+// fills in the route cache header for the currently loaded AAS data
+//
+// Parameter:			-
+// Returns:				-
+// Changes Globals:		-
+//===========================================================================
+static void AAS_RouteCacheHeader(routecacheheader_t *header, int numportalcache, int numareacache)
+{
+	header->ident = RCID;
+	header->version = RCVERSION;
+	header->numareas = aasworld.numareas;
+	header->numclusters = aasworld.numclusters;
+	header->numportals = aasworld.numportals;
+	header->bspchecksum = aasworld.bspchecksum;
+	header->areacrc = CRC_ProcessString( (unsigned char *)aasworld.areas, sizeof(aas_area_t) * aasworld.numareas );
+	header->clustercrc = CRC_ProcessString( (unsigned char *)aasworld.clusters, sizeof(aas_cluster_t) * aasworld.numclusters );
+	header->reachabilitycrc = CRC_ProcessString( (unsigned char *)aasworld.reachability, sizeof(aas_reachability_t) * aasworld.reachabilitysize );
+	header->numportalcache = numportalcache;
+	header->numareacache = numareacache;
+} //end of the function AAS_RouteCacheHeader
+//===========================================================================
+//
+// Parameter:			-
+// Returns:				-
+// Changes Globals:		-
+//===========================================================================
+static int AAS_WriteCache(fileHandle_t fp, aas_routingcache_t *cache)
+{
+	routecacherecord_t record;
+
+	record.type = cache->type;
+	record.cluster = cache->cluster;
+	record.areanum = cache->areanum;
+	VectorCopy(cache->origin, record.origin);
+	record.starttraveltime = cache->starttraveltime;
+	record.travelflags = cache->travelflags;
+	if (cache->type == CACHETYPE_AREA) record.numtraveltimes = aasworld.clusters[cache->cluster].numreachabilityareas;
+	else record.numtraveltimes = aasworld.numportals;
+	botimport.FS_Write(&record, sizeof(routecacherecord_t), fp);
+	botimport.FS_Write(cache->traveltimes, record.numtraveltimes * sizeof(unsigned short int), fp);
+	botimport.FS_Write(cache->reachabilities, record.numtraveltimes * sizeof(unsigned char), fp);
+	return sizeof(routecacherecord_t) + record.numtraveltimes * (sizeof(unsigned short int) + sizeof(unsigned char));
+} //end of the function AAS_WriteCache
+//===========================================================================
+//
+// Parameter:			-
+// Returns:				-
+// Changes Globals:		-
+//===========================================================================
 void AAS_WriteRouteCache(void)
 {
 	int i, j, numportalcache, numareacache, totalsize;
@@ -945,6 +1217,15 @@ void AAS_WriteRouteCache(void)
 	char filename[MAX_QPATH];
 	routecacheheader_t routecacheheader;
 
+	aasworld.routecachesaved = qtrue;
+	//stop loading the old route cache before overwriting it
+	AAS_StopReadRouteCache();
+	//caches calculated with disabled areas are not valid for the next load
+	if (aasworld.numdisabledareas)
+	{
+		botimport.Print(PRT_MESSAGE, "not writing the route cache while areas are disabled\n");
+		return;
+	} //end if
 	numportalcache = 0;
 	for (i = 0; i < aasworld.numareas; i++)
 	{
@@ -973,16 +1254,8 @@ void AAS_WriteRouteCache(void)
 		AAS_Error("Unable to open file: %s\n", filename);
 		return;
 	} //end if
-	//create the header
-	routecacheheader.ident = RCID;
-	routecacheheader.version = RCVERSION;
-	routecacheheader.numareas = aasworld.numareas;
-	routecacheheader.numclusters = aasworld.numclusters;
-	routecacheheader.areacrc = CRC_ProcessString( (unsigned char *)aasworld.areas, sizeof(aas_area_t) * aasworld.numareas );
-	routecacheheader.clustercrc = CRC_ProcessString( (unsigned char *)aasworld.clusters, sizeof(aas_cluster_t) * aasworld.numclusters );
-	routecacheheader.numportalcache = numportalcache;
-	routecacheheader.numareacache = numareacache;
 	//write the header
+	AAS_RouteCacheHeader(&routecacheheader, numportalcache, numareacache);
 	botimport.FS_Write(&routecacheheader, sizeof(routecacheheader_t), fp);
 	//
 	totalsize = 0;
@@ -991,8 +1264,7 @@ void AAS_WriteRouteCache(void)
 	{
 		for (cache = aasworld.portalcache[i]; cache; cache = cache->next)
 		{
-			botimport.FS_Write(cache, cache->size, fp);
-			totalsize += cache->size;
+			totalsize += AAS_WriteCache(fp, cache);
 		} //end for
 	} //end for
 	for (i = 0; i < aasworld.numclusters; i++)
@@ -1002,51 +1274,157 @@ void AAS_WriteRouteCache(void)
 		{
 			for (cache = aasworld.clusterareacache[i][j]; cache; cache = cache->next)
 			{
-				botimport.FS_Write(cache, cache->size, fp);
-				totalsize += cache->size;
+				totalsize += AAS_WriteCache(fp, cache);
 			} //end for
 		} //end for
 	} //end for
-	// write the visareas
-	/*
-	for (i = 0; i < aasworld.numareas; i++)
-	{
-		if (!aasworld.areavisibility[i]) {
-			size = 0;
-			botimport.FS_Write(&size, sizeof(int), fp);
-			continue;
-		}
-		AAS_DecompressVis( aasworld.areavisibility[i], aasworld.numareas, aasworld.decompressedvis );
-		size = AAS_CompressVis( aasworld.decompressedvis, aasworld.numareas, aasworld.decompressedvis );
-		botimport.FS_Write(&size, sizeof(int), fp);
-		botimport.FS_Write(aasworld.decompressedvis, size, fp);
-	}
-	*/
 	//
 	botimport.FS_FCloseFile(fp);
 	botimport.Print(PRT_MESSAGE, "\nroute cache written to %s\n", filename);
 	botimport.Print(PRT_MESSAGE, "written %d bytes of routing cache\n", totalsize);
 } //end of the function AAS_WriteRouteCache
 //===========================================================================
+// writes the route cache once the bots have been routing for a while,
+// the write happens within a single frame
+//
+// Parameter:			warmuptime	: seconds of routing before writing
+// Returns:				-
+// Changes Globals:		-
+//===========================================================================
+void AAS_CheckWriteRouteCache(float warmuptime)
+{
+	if (warmuptime <= 0) return;
+	if (aasworld.routecachesaved || aasworld.routecachefile) return;
+	if (AAS_RoutingTime() - aasworld.routinginittime < warmuptime) return;
+	//don't replace the dump if nothing has been calculated since loading it
+	if (!routingcachepool.misses) return;
+	AAS_WriteRouteCache();
+} //end of the function AAS_CheckWriteRouteCache
+//===========================================================================
+// reads the next cache from the route cache dump, returns NULL if the
+// cache is not valid for the loaded AAS data
 //
 // Parameter:			-
 // Returns:				-
 // Changes Globals:		-
 //===========================================================================
-aas_routingcache_t *AAS_ReadCache(fileHandle_t fp)
+static aas_routingcache_t *AAS_ReadCache(fileHandle_t fp)
 {
-	int size;
+	routecacherecord_t record;
 	aas_routingcache_t *cache;
 
-	botimport.FS_Read(&size, sizeof(size), fp);
-	cache = (aas_routingcache_t *) GetMemory(size);
-	cache->size = size;
-	botimport.FS_Read((unsigned char *)cache + sizeof(size), size - sizeof(size), fp);
-	cache->reachabilities = (unsigned char *) cache + sizeof(aas_routingcache_t) - sizeof(unsigned short) +
-		(size - sizeof(aas_routingcache_t) + sizeof(unsigned short)) / 3 * 2;
+	botimport.FS_Read(&record, sizeof(routecacherecord_t), fp);
+	if (record.type == CACHETYPE_AREA)
+	{
+		if (record.cluster <= 0 || record.cluster >= aasworld.numclusters) return NULL;
+		if (record.numtraveltimes != aasworld.clusters[record.cluster].numreachabilityareas) return NULL;
+	} //end if
+	else if (record.type != CACHETYPE_PORTAL || record.numtraveltimes != aasworld.numportals) return NULL;
+	if (record.areanum <= 0 || record.areanum >= aasworld.numareas) return NULL;
+	//don't push out routing cache that is in use
+	if (routingcachesize + AAS_RoutingCacheSize(record.numtraveltimes) > max_routingcachesize) return NULL;
+	//
+	cache = AAS_AllocRoutingCache(record.numtraveltimes);
+	cache->type = record.type;
+	cache->cluster = record.cluster;
+	cache->areanum = record.areanum;
+	VectorCopy(record.origin, cache->origin);
+	cache->starttraveltime = record.starttraveltime;
+	cache->travelflags = record.travelflags;
+	cache->time = AAS_RoutingTime();
+	botimport.FS_Read(cache->traveltimes, record.numtraveltimes * sizeof(unsigned short int), fp);
+	botimport.FS_Read(cache->reachabilities, record.numtraveltimes * sizeof(unsigned char), fp);
 	return cache;
 } //end of the function AAS_ReadCache
 //===========================================================================
+// adds a cache read from the route cache dump unless the same cache
+// has been calculated in the meantime
+//
+// Parameter:			-
+// Returns:				-
+// Changes Globals:		-
+//===========================================================================
+static void AAS_AddReadCache(aas_routingcache_t *cache)
+{
+	aas_routingcache_t **list, *c;
+
+	if (cache->type == CACHETYPE_AREA)
+		list = &aasworld.clusterareacache[cache->cluster][AAS_ClusterAreaNum(cache->cluster, cache->areanum)];
+	else
+		list = &aasworld.portalcache[cache->areanum];
+	for (c = *list; c; c = c->next)
+	{
+		if (c->travelflags == cache->travelflags)
+		{
+			AAS_FreeRoutingCache(cache);
+			return;
+		} //end if
+	} //end for
+	cache->prev = NULL;
+	cache->next = *list;
+	if (*list) (*list)->prev = cache;
+	*list = cache;
+	AAS_LinkCache(cache);
+} //end of the function AAS_AddReadCache
+//===========================================================================
+// stops loading the route cache dump
+//
+// Parameter:			-
+// Returns:				-
+// Changes Globals:		-
+//===========================================================================
+void AAS_StopReadRouteCache(void)
+{
+	if (!aasworld.routecachefile) return;
+	botimport.FS_FCloseFile(aasworld.routecachefile);
+	aasworld.routecachefile = 0;
+	aasworld.numroutecacheread = 0;
+} //end of the function AAS_StopReadRouteCache
+//===========================================================================
+// loads the next part of the route cache dump, called every frame so
+// the dump is loaded in the background while the bots are already routing
+//
+// Parameter:			-
+// Returns:				-
+// Changes Globals:		-
+//===========================================================================
+void AAS_ContinueReadRouteCache(void)
+{
+	int size;
+	aas_routingcache_t *cache;
+
+	if (!aasworld.routecachefile) return;
+	//caches in the dump were calculated without disabled areas
+	if (aasworld.numdisabledareas)
+	{
+		AAS_StopReadRouteCache();
+		return;
+	} //end if
+	size = 0;
+	while (size < MAX_ROUTECACHELOADSIZE)
+	{
+		if (aasworld.numroutecacheread >= aasworld.numroutecachetotal)
+		{
+			botimport.Print(PRT_MESSAGE, "loaded %d routing caches\n", aasworld.numroutecacheread);
+			AAS_StopReadRouteCache();
+			return;
+		} //end if
+		cache = AAS_ReadCache(aasworld.routecachefile);
+		if (!cache)
+		{
+			//either the cache doesn't fit or the dump is not valid
+			botimport.Print(PRT_MESSAGE, "loaded %d of %d routing caches\n",
+								aasworld.numroutecacheread, aasworld.numroutecachetotal);
+			AAS_StopReadRouteCache();
+			return;
+		} //end if
+		aasworld.numroutecacheread++;
+		size += cache->size;
+		AAS_AddReadCache(cache);
+	} //end while
+} //end of the function AAS_ContinueReadRouteCache
+//===========================================================================
+// opens the route cache dump, the caches are loaded over the next frames
 //
 // Parameter:			-
 // Returns:				-
@@ -1054,11 +1432,9 @@ aas_routingcache_t *AAS_ReadCache(fileHandle_t fp)
 //===========================================================================
 int AAS_ReadRouteCache(void)
 {
-	int i, clusterareanum;//, size;
 	fileHandle_t fp;
 	char filename[MAX_QPATH];
-	routecacheheader_t routecacheheader;
-	aas_routingcache_t *cache;
+	routecacheheader_t routecacheheader, check;
 
 	Com_sprintf(filename, MAX_QPATH, "maps/%s.rcd", aasworld.mapname);
 	botimport.FS_FOpenFile( filename, &fp, FS_READ );
@@ -1070,71 +1446,26 @@ int AAS_ReadRouteCache(void)
 	if (routecacheheader.ident != RCID)
 	{
 		AAS_Error("%s is not a route cache dump\n", filename);
+		botimport.FS_FCloseFile(fp);
 		return qfalse;
 	} //end if
 	if (routecacheheader.version != RCVERSION)
 	{
-		AAS_Error("route cache dump has wrong version %d, should be %d\n", routecacheheader.version, RCVERSION);
+		//an old dump is replaced by the next one written
+		botimport.Print(PRT_MESSAGE, "%s has wrong version %d, should be %d\n", filename, routecacheheader.version, RCVERSION);
+		botimport.FS_FCloseFile(fp);
 		return qfalse;
 	} //end if
-	if (routecacheheader.numareas != aasworld.numareas)
+	//a dump of different AAS data is just ignored
+	AAS_RouteCacheHeader(&check, routecacheheader.numportalcache, routecacheheader.numareacache);
+	if (memcmp(&routecacheheader, &check, sizeof(routecacheheader_t)))
 	{
-		//AAS_Error("route cache dump has wrong number of areas\n");
+		botimport.FS_FCloseFile(fp);
 		return qfalse;
 	} //end if
-	if (routecacheheader.numclusters != aasworld.numclusters)
-	{
-		//AAS_Error("route cache dump has wrong number of clusters\n");
-		return qfalse;
-	} //end if
-	if (routecacheheader.areacrc !=
-		CRC_ProcessString( (unsigned char *)aasworld.areas, sizeof(aas_area_t) * aasworld.numareas ))
-	{
-		//AAS_Error("route cache dump area CRC incorrect\n");
-		return qfalse;
-	} //end if
-	if (routecacheheader.clustercrc !=
-		CRC_ProcessString( (unsigned char *)aasworld.clusters, sizeof(aas_cluster_t) * aasworld.numclusters ))
-	{
-		//AAS_Error("route cache dump cluster CRC incorrect\n");
-		return qfalse;
-	} //end if
-	//read all the portal cache
-	for (i = 0; i < routecacheheader.numportalcache; i++)
-	{
-		cache = AAS_ReadCache(fp);
-		cache->next = aasworld.portalcache[cache->areanum];
-		cache->prev = NULL;
-		if (aasworld.portalcache[cache->areanum])
-			aasworld.portalcache[cache->areanum]->prev = cache;
-		aasworld.portalcache[cache->areanum] = cache;
-	} //end for
-	//read all the cluster area cache
-	for (i = 0; i < routecacheheader.numareacache; i++)
-	{
-		cache = AAS_ReadCache(fp);
-		clusterareanum = AAS_ClusterAreaNum(cache->cluster, cache->areanum);
-		cache->next = aasworld.clusterareacache[cache->cluster][clusterareanum];
-		cache->prev = NULL;
-		if (aasworld.clusterareacache[cache->cluster][clusterareanum])
-			aasworld.clusterareacache[cache->cluster][clusterareanum]->prev = cache;
-		aasworld.clusterareacache[cache->cluster][clusterareanum] = cache;
-	} //end for
-	// read the visareas
-	/*
-	aasworld.areavisibility = (byte **) GetClearedMemory(aasworld.numareas * sizeof(byte *));
-	aasworld.decompressedvis = (byte *) GetClearedMemory(aasworld.numareas * sizeof(byte));
-	for (i = 0; i < aasworld.numareas; i++)
-	{
-		botimport.FS_Read(&size, sizeof(size), fp );
-		if (size) {
-			aasworld.areavisibility[i] = (byte *) GetMemory(size);
-			botimport.FS_Read(aasworld.areavisibility[i], size, fp );
-		}
-	}
-	*/
-	//
-	botimport.FS_FCloseFile(fp);
+	aasworld.routecachefile = fp;
+	aasworld.numroutecacheread = 0;
+	aasworld.numroutecachetotal = routecacheheader.numportalcache + routecacheheader.numareacache;
 	return qtrue;
 } //end of the function AAS_ReadRouteCache
 //===========================================================================
@@ -1219,6 +1550,8 @@ void AAS_InitReachabilityAreas(void)
 //===========================================================================
 void AAS_InitRouting(void)
 {
+	int i;
+
 	AAS_InitTravelFlagFromType();
 	//
 	AAS_InitAreaContentsTravelFlags();
@@ -1244,8 +1577,18 @@ void AAS_InitRouting(void)
 	//
 	routingcachesize = 0;
 	max_routingcachesize = 1024 * (int) LibVarValue("max_routingcache", "4096");
-	// read any routing cache if available
+	//
+	aasworld.numdisabledareas = 0;
+	for (i = 1; i < aasworld.numareas; i++)
+	{
+		if (aasworld.areasettings[i].areaflags & AREA_DISABLED) aasworld.numdisabledareas++;
+	} //end for
+	// start loading any routing cache if available
+	aasworld.routinginittime = AAS_RoutingTime();
+	aasworld.routecachesaved = qfalse;
 	AAS_ReadRouteCache();
+	// read the route table if available
+	if (LibVarValue("routetable", "1")) AAS_ReadRouteTable();
 } //end of the function AAS_InitRouting
 //===========================================================================
 //
@@ -1255,13 +1598,21 @@ void AAS_InitRouting(void)
 //===========================================================================
 void AAS_FreeRoutingCaches(void)
 {
+	// stop loading the route cache dump
+	AAS_StopReadRouteCache();
 	// free all the existing cluster area cache
 	AAS_FreeAllClusterAreaCache();
 	// free all the existing portal cache
 	AAS_FreeAllPortalCache();
+	// free the memory the routing caches were allocated from
+	AAS_FreeRoutingCachePool();
+	// free the route table
+	if (aasworld.routetable) FreeMemory(aasworld.routetable);
+	aasworld.routetable = NULL;
 	// free cached travel times within areas
 	if (aasworld.areatraveltimes) FreeMemory(aasworld.areatraveltimes);
 	aasworld.areatraveltimes = NULL;
+	aasworld.areatraveltimescalculated = NULL;
 	// free cached maximum travel time through cluster portals
 	if (aasworld.portalmaxtraveltimes) FreeMemory(aasworld.portalmaxtraveltimes);
 	aasworld.portalmaxtraveltimes = NULL;
@@ -1377,7 +1728,7 @@ void AAS_UpdateAreaRoutingCache(aas_routingcache_t *areacache)
 				nextupdate->areanum = nextareanum;
 				nextupdate->tmptraveltime = t;
 				//VectorCopy(reach->start, nextupdate->start);
-				nextupdate->areatraveltimes = aasworld.areatraveltimes[nextareanum][linknum -
+				nextupdate->areatraveltimes = AAS_AreaTravelTimes(nextareanum)[linknum -
 													aasworld.areasettings[nextareanum].firstreachablearea];
 				if (!nextupdate->inlist)
 				{
@@ -1420,6 +1771,8 @@ aas_routingcache_t *AAS_GetAreaRoutingCache(int clusternum, int areanum, int tra
 	if (!cache)
 	{
 		cache = AAS_AllocRoutingCache(aasworld.clusters[clusternum].numreachabilityareas);
+		//the allocation might have freed cache in the list
+		clustercache = aasworld.clusterareacache[clusternum][clusterareanum];
 		cache->cluster = clusternum;
 		cache->areanum = areanum;
 		VectorCopy(aasworld.areas[areanum].center, cache->origin);
@@ -1430,10 +1783,14 @@ aas_routingcache_t *AAS_GetAreaRoutingCache(int clusternum, int areanum, int tra
 		if (clustercache) clustercache->prev = cache;
 		aasworld.clusterareacache[clusternum][clusterareanum] = cache;
 		AAS_UpdateAreaRoutingCache(cache);
+		routingcachepool.framemisses++;
+		routingcachepool.misses++;
 	} //end if
 	else
 	{
 		AAS_UnlinkCache(cache);
+		routingcachepool.framehits++;
+		routingcachepool.hits++;
 	} //end else
 	//the cache has been accessed
 	cache->time = AAS_RoutingTime();
@@ -1442,6 +1799,39 @@ aas_routingcache_t *AAS_GetAreaRoutingCache(int clusternum, int areanum, int tra
 	return cache;
 } //end of the function AAS_GetAreaRoutingCache
 //===========================================================================
+// returns the travel times and reachabilities of the areas in the cluster
+// towards the given area, from the route table if it holds them
+//
+// Parameter:			-
+// Returns:				-
+// Changes Globals:		-
+//===========================================================================
+static void AAS_AreaRoutingTimes(int clusternum, int areanum, int travelflags,
+								 unsigned short int **traveltimes, unsigned char **reachabilities)
+{
+	int clusterareanum, numreachabilityareas, offset;
+	aas_routetable_t *table;
+	aas_routingcache_t *cache;
+
+	table = aasworld.routetable;
+	if (table && table->travelflags == travelflags && !aasworld.numdisabledareas)
+	{
+		numreachabilityareas = aasworld.clusters[clusternum].numreachabilityareas;
+		clusterareanum = AAS_ClusterAreaNum(clusternum, areanum);
+		//the table only has caches towards reachability areas
+		if (clusterareanum < numreachabilityareas)
+		{
+			offset = table->clusteroffsets[clusternum] + clusterareanum * numreachabilityareas;
+			*traveltimes = table->areatraveltimes + offset;
+			*reachabilities = table->areareachabilities + offset;
+			return;
+		} //end if
+	} //end if
+	cache = AAS_GetAreaRoutingCache(clusternum, areanum, travelflags);
+	*traveltimes = cache->traveltimes;
+	*reachabilities = cache->reachabilities;
+} //end of the function AAS_AreaRoutingTimes
+//===========================================================================
 //
 // Parameter:			-
 // Returns:				-
@@ -1453,7 +1843,8 @@ void AAS_UpdatePortalRoutingCache(aas_routingcache_t *portalcache)
 	unsigned short int t;
 	aas_portal_t *portal;
 	aas_cluster_t *cluster;
-	aas_routingcache_t *cache;
+	unsigned short int *traveltimes;
+	unsigned char *reachabilities;
 	aas_routingupdate_t *updateliststart, *updatelistend, *curupdate, *nextupdate;
 
 #ifdef ROUTING_DEBUG
@@ -1490,8 +1881,8 @@ void AAS_UpdatePortalRoutingCache(aas_routingcache_t *portalcache)
 		//
 		cluster = &aasworld.clusters[curupdate->cluster];
 		//
-		cache = AAS_GetAreaRoutingCache(curupdate->cluster,
-								curupdate->areanum, portalcache->travelflags);
+		AAS_AreaRoutingTimes(curupdate->cluster, curupdate->areanum,
+								portalcache->travelflags, &traveltimes, &reachabilities);
 		//take all portals of the cluster
 		for (i = 0; i < cluster->numportals; i++)
 		{
@@ -1503,7 +1894,7 @@ void AAS_UpdatePortalRoutingCache(aas_routingcache_t *portalcache)
 			clusterareanum = AAS_ClusterAreaNum(curupdate->cluster, portal->areanum);
 			if (clusterareanum >= cluster->numreachabilityareas) continue;
 			//
-			t = cache->traveltimes[clusterareanum];
+			t = traveltimes[clusterareanum];
 			if (!t) continue;
 			t += curupdate->tmptraveltime;
 			//
@@ -1570,10 +1961,14 @@ aas_routingcache_t *AAS_GetPortalRoutingCache(int clusternum, int areanum, int t
 		aasworld.portalcache[areanum] = cache;
 		//update the cache
 		AAS_UpdatePortalRoutingCache(cache);
+		routingcachepool.framemisses++;
+		routingcachepool.misses++;
 	} //end if
 	else
 	{
 		AAS_UnlinkCache(cache);
+		routingcachepool.framehits++;
+		routingcachepool.hits++;
 	} //end else
 	//the cache has been accessed
 	cache->time = AAS_RoutingTime();
@@ -1582,6 +1977,319 @@ aas_routingcache_t *AAS_GetPortalRoutingCache(int clusternum, int areanum, int t
 	return cache;
 } //end of the function AAS_GetPortalRoutingCache
 //===========================================================================
+// returns the travel times from the portals towards the given area,
+// from the route table if it holds them
+//
+// Parameter:			-
+// Returns:				-
+// Changes Globals:		-
+//===========================================================================
+static void AAS_PortalRoutingTimes(int clusternum, int areanum, int travelflags,
+								   unsigned short int **traveltimes, unsigned char **reachabilities)
+{
+	aas_routetable_t *table;
+	aas_routingcache_t *cache;
+
+	table = aasworld.routetable;
+	if (table && table->travelflags == travelflags && !aasworld.numdisabledareas)
+	{
+		*traveltimes = table->portaltraveltimes + areanum * aasworld.numportals;
+		*reachabilities = table->portalreachabilities;
+		return;
+	} //end if
+	cache = AAS_GetPortalRoutingCache(clusternum, areanum, travelflags);
+	*traveltimes = cache->traveltimes;
+	*reachabilities = cache->reachabilities;
+} //end of the function AAS_PortalRoutingTimes
+//===========================================================================
+//
+// Parameter:			-
+// Returns:				-
+// Changes Globals:		-
+//===========================================================================
+
+//the route table header
+//this header is followed by the area travel times of all clusters, the
+//portal travel times of all areas and the area reachabilities
+typedef struct routetableheader_s
+{
+	int ident;
+	int version;
+	int numareas;
+	int numclusters;
+	int numportals;
+	int areacrc;
+	int clustercrc;
+	int reachabilitycrc;
+	int travelflags;
+	int numareatraveltimes;
+} routetableheader_t;
+
+#define RTID						(('L'<<24)+('B'<<16)+('T'<<8)+'R')
+#define RTVERSION					1
+
+//===========================================================================
+// returns the size of the route table data that's stored in the file
+//
+// Parameter:			-
+// Returns:				-
+// Changes Globals:		-
+//===========================================================================
+static int AAS_RouteTableDataSize(int *numareatraveltimes)
+{
+	int i, n;
+
+	n = 0;
+	for (i = 0; i < aasworld.numclusters; i++)
+	{
+		n += aasworld.clusters[i].numreachabilityareas * aasworld.clusters[i].numreachabilityareas;
+	} //end for
+	*numareatraveltimes = n;
+	return n * sizeof(unsigned short int) +
+				aasworld.numareas * aasworld.numportals * sizeof(unsigned short int) +
+				n * sizeof(unsigned char);
+} //end of the function AAS_RouteTableDataSize
+//===========================================================================
+// allocates the route table as a single block, the data that's stored
+// in the file is contiguous and starts at areatraveltimes
+//
+// Parameter:			-
+// Returns:				-
+// Changes Globals:		-
+//===========================================================================
+static aas_routetable_t *AAS_AllocRouteTable(int travelflags)
+{
+	int i, n, size, datasize;
+	aas_routetable_t *table;
+	char *ptr;
+
+	datasize = AAS_RouteTableDataSize(&n);
+	size = sizeof(aas_routetable_t) + aasworld.numclusters * sizeof(int) +
+				datasize + aasworld.numportals * sizeof(unsigned char);
+	//don't take more than half of the memory that's left
+	if (size > AvailableMemory() / 2)
+	{
+		botimport.Print(PRT_WARNING, "route table of %d KB is too large\n", size >> 10);
+		return NULL;
+	} //end if
+	ptr = (char *) GetClearedMemory(size);
+	table = (aas_routetable_t *) ptr;
+	ptr += sizeof(aas_routetable_t);
+	table->travelflags = travelflags;
+	table->clusteroffsets = (int *) ptr;
+	ptr += aasworld.numclusters * sizeof(int);
+	table->areatraveltimes = (unsigned short int *) ptr;
+	ptr += n * sizeof(unsigned short int);
+	table->portaltraveltimes = (unsigned short int *) ptr;
+	ptr += aasworld.numareas * aasworld.numportals * sizeof(unsigned short int);
+	table->areareachabilities = (unsigned char *) ptr;
+	ptr += n * sizeof(unsigned char);
+	table->portalreachabilities = (unsigned char *) ptr;
+	//
+	for (n = 0, i = 0; i < aasworld.numclusters; i++)
+	{
+		table->clusteroffsets[i] = n;
+		n += aasworld.clusters[i].numreachabilityareas * aasworld.clusters[i].numreachabilityareas;
+	} //end for
+	return table;
+} //end of the function AAS_AllocRouteTable
+//===========================================================================
+//
+// Parameter:			-
+// Returns:				-
+// Changes Globals:		-
+//===========================================================================
+static void AAS_RouteTableHeader(routetableheader_t *header, int travelflags, int numareatraveltimes)
+{
+	header->ident = RTID;
+	header->version = RTVERSION;
+	header->numareas = aasworld.numareas;
+	header->numclusters = aasworld.numclusters;
+	header->numportals = aasworld.numportals;
+	header->areacrc = CRC_ProcessString( (unsigned char *)aasworld.areas, sizeof(aas_area_t) * aasworld.numareas );
+	header->clustercrc = CRC_ProcessString( (unsigned char *)aasworld.clusters, sizeof(aas_cluster_t) * aasworld.numclusters );
+	header->reachabilitycrc = CRC_ProcessString( (unsigned char *)aasworld.reachability, sizeof(aas_reachability_t) * aasworld.reachabilitysize );
+	header->travelflags = travelflags;
+	header->numareatraveltimes = numareatraveltimes;
+} //end of the function AAS_RouteTableHeader
+//===========================================================================
+// builds the routing cache towards every area for the given travel flags
+//
+// Parameter:			-
+// Returns:				-
+// Changes Globals:		-
+//===========================================================================
+static aas_routetable_t *AAS_BuildRouteTable(int travelflags)
+{
+	int i, j, clusterareanum, numreachabilityareas, maxreachabilityareas;
+	int offset, side;
+	aas_routetable_t *table;
+	aas_routingcache_t *cache;
+	aas_portal_t *portal;
+
+	table = AAS_AllocRouteTable(travelflags);
+	if (!table) return NULL;
+	//
+	maxreachabilityareas = 0;
+	for (i = 0; i < aasworld.numclusters; i++)
+	{
+		if (aasworld.clusters[i].numreachabilityareas > maxreachabilityareas)
+			maxreachabilityareas = aasworld.clusters[i].numreachabilityareas;
+	} //end for
+	//the area cache of every reachability area in every cluster
+	cache = AAS_AllocRoutingCache(maxreachabilityareas);
+	for (i = 1; i < aasworld.numareas; i++)
+	{
+		for (side = 0; side < 2; side++)
+		{
+			j = aasworld.areasettings[i].cluster;
+			if (j < 0)
+			{
+				portal = &aasworld.portals[-j];
+				j = side ? portal->backcluster : portal->frontcluster;
+			} //end if
+			else if (side) break;
+			//
+			numreachabilityareas = aasworld.clusters[j].numreachabilityareas;
+			clusterareanum = AAS_ClusterAreaNum(j, i);
+			if (clusterareanum >= numreachabilityareas) continue;
+			//
+			Com_Memset(cache->traveltimes, 0, maxreachabilityareas * sizeof(unsigned short int));
+			Com_Memset(cache->reachabilities, 0, maxreachabilityareas * sizeof(unsigned char));
+			cache->cluster = j;
+			cache->areanum = i;
+			VectorCopy(aasworld.areas[i].center, cache->origin);
+			cache->starttraveltime = 1;
+			cache->travelflags = travelflags;
+			AAS_UpdateAreaRoutingCache(cache);
+			//
+			offset = table->clusteroffsets[j] + clusterareanum * numreachabilityareas;
+			Com_Memcpy(table->areatraveltimes + offset, cache->traveltimes, numreachabilityareas * sizeof(unsigned short int));
+			Com_Memcpy(table->areareachabilities + offset, cache->reachabilities, numreachabilityareas * sizeof(unsigned char));
+		} //end for
+	} //end for
+	AAS_FreeRoutingCache(cache);
+	//the portal caches are built from the area caches in the table
+	aasworld.routetable = table;
+	cache = AAS_AllocRoutingCache(aasworld.numportals);
+	for (i = 1; i < aasworld.numareas; i++)
+	{
+		Com_Memset(cache->traveltimes, 0, aasworld.numportals * sizeof(unsigned short int));
+		j = aasworld.areasettings[i].cluster;
+		//just assume a portal is part of the front cluster
+		if (j < 0) j = aasworld.portals[-j].frontcluster;
+		cache->cluster = j;
+		cache->areanum = i;
+		VectorCopy(aasworld.areas[i].center, cache->origin);
+		cache->starttraveltime = 1;
+		cache->travelflags = travelflags;
+		AAS_UpdatePortalRoutingCache(cache);
+		Com_Memcpy(table->portaltraveltimes + i * aasworld.numportals, cache->traveltimes, aasworld.numportals * sizeof(unsigned short int));
+	} //end for
+	AAS_FreeRoutingCache(cache);
+	return table;
+} //end of the function AAS_BuildRouteTable
+//===========================================================================
+// builds the route table for the default travel flags and writes it
+// to maps/<mapname>.rtb
+//
+// Parameter:			-
+// Returns:				-
+// Changes Globals:		-
+//===========================================================================
+void AAS_WriteRouteTable(void)
+{
+	int numareatraveltimes, datasize, starttime;
+	fileHandle_t fp;
+	char filename[MAX_QPATH];
+	routetableheader_t header;
+	aas_routetable_t *table;
+
+	if (!aasworld.loaded)
+	{
+		botimport.Print(PRT_ERROR, "AAS_WriteRouteTable: no AAS loaded\n");
+		return;
+	} //end if
+	if (aasworld.numdisabledareas)
+	{
+		botimport.Print(PRT_ERROR, "AAS_WriteRouteTable: can't build the route table while areas are disabled\n");
+		return;
+	} //end if
+	if (aasworld.routetable) FreeMemory(aasworld.routetable);
+	aasworld.routetable = NULL;
+	//
+	starttime = Sys_MilliSeconds();
+	table = AAS_BuildRouteTable(TFL_DEFAULT);
+	if (!table) return;
+	datasize = AAS_RouteTableDataSize(&numareatraveltimes);
+	//
+	Com_sprintf(filename, MAX_QPATH, "maps/%s.rtb", aasworld.mapname);
+	botimport.FS_FOpenFile( filename, &fp, FS_WRITE );
+	if (!fp)
+	{
+		AAS_Error("Unable to open file: %s\n", filename);
+		return;
+	} //end if
+	AAS_RouteTableHeader(&header, table->travelflags, numareatraveltimes);
+	botimport.FS_Write(&header, sizeof(routetableheader_t), fp);
+	botimport.FS_Write(table->areatraveltimes, datasize, fp);
+	botimport.FS_FCloseFile(fp);
+	botimport.Print(PRT_MESSAGE, "route table written to %s\n", filename);
+	botimport.Print(PRT_MESSAGE, "%d KB route table built in %d msec\n", datasize >> 10, Sys_MilliSeconds() - starttime);
+} //end of the function AAS_WriteRouteTable
+//===========================================================================
+//
+// Parameter:			-
+// Returns:				-
+// Changes Globals:		-
+//===========================================================================
+int AAS_ReadRouteTable(void)
+{
+	int length, numareatraveltimes, datasize;
+	fileHandle_t fp;
+	char filename[MAX_QPATH];
+	routetableheader_t header, check;
+	aas_routetable_t *table;
+
+	Com_sprintf(filename, MAX_QPATH, "maps/%s.rtb", aasworld.mapname);
+	length = botimport.FS_FOpenFile( filename, &fp, FS_READ );
+	if (!fp)
+	{
+		return qfalse;
+	} //end if
+	if (length < sizeof(routetableheader_t))
+	{
+		botimport.FS_FCloseFile(fp);
+		return qfalse;
+	} //end if
+	botimport.FS_Read(&header, sizeof(routetableheader_t), fp );
+	AAS_RouteTableHeader(&check, header.travelflags, header.numareatraveltimes);
+	//a table built for different AAS data is just ignored
+	if (memcmp(&header, &check, sizeof(routetableheader_t)))
+	{
+		botimport.FS_FCloseFile(fp);
+		return qfalse;
+	} //end if
+	datasize = AAS_RouteTableDataSize(&numareatraveltimes);
+	if (numareatraveltimes != header.numareatraveltimes ||
+		length != sizeof(routetableheader_t) + datasize)
+	{
+		botimport.Print(PRT_WARNING, "%s has the wrong size\n", filename);
+		botimport.FS_FCloseFile(fp);
+		return qfalse;
+	} //end if
+	table = AAS_AllocRouteTable(header.travelflags);
+	if (!table)
+	{
+		botimport.FS_FCloseFile(fp);
+		return qfalse;
+	} //end if
+	botimport.FS_Read(table->areatraveltimes, datasize, fp);
+	botimport.FS_FCloseFile(fp);
+	aasworld.routetable = table;
+	return qtrue;
+} //end of the function AAS_ReadRouteTable
+//===========================================================================
 //
 // Parameter:			-
 // Returns:				-
@@ -1593,7 +2301,8 @@ int AAS_AreaRouteToGoalArea(int areanum, vec3_t origin, int goalareanum, int tra
 	unsigned short int t, besttime;
 	aas_portal_t *portal;
 	aas_cluster_t *cluster;
-	aas_routingcache_t *areacache, *portalcache;
+	unsigned short int *areatraveltimes, *portaltraveltimes;
+	unsigned char *areareachabilities, *portalreachabilities;
 	aas_reachability_t *reach;
 
 	if (!aasworld.initialized) return qfalse;
@@ -1621,11 +2330,6 @@ int AAS_AreaRouteToGoalArea(int areanum, vec3_t origin, int goalareanum, int tra
 		} //end if
 		return qfalse;
 	} //end if
-	// make sure the routing cache doesn't grow to large
-	while(AvailableMemory() < 1 * 1024 * 1024) {
-		if (!AAS_FreeOldestCache()) break;
-	}
-	//
 	if (AAS_AreaDoNotEnter(areanum) || AAS_AreaDoNotEnter(goalareanum))
 	{
 		travelflags |= TFL_DONOTENTER;
@@ -1668,7 +2372,7 @@ int AAS_AreaRouteToGoalArea(int areanum, vec3_t origin, int goalareanum, int tra
 	if (clusternum > 0 && goalclusternum > 0 && clusternum == goalclusternum)
 	{
 		//
-		areacache = AAS_GetAreaRoutingCache(clusternum, goalareanum, travelflags);
+		AAS_AreaRoutingTimes(clusternum, goalareanum, travelflags, &areatraveltimes, &areareachabilities);
 		//the number of the area in the cluster
 		clusterareanum = AAS_ClusterAreaNum(clusternum, areanum);
 		//the cluster the area is in
@@ -1676,16 +2380,16 @@ int AAS_AreaRouteToGoalArea(int areanum, vec3_t origin, int goalareanum, int tra
 		//if the area is NOT a reachability area
 		if (clusterareanum >= cluster->numreachabilityareas) return 0;
 		//if it is possible to travel to the goal area through this cluster
-		if (areacache->traveltimes[clusterareanum] != 0)
+		if (areatraveltimes[clusterareanum] != 0)
 		{
 			*reachnum = aasworld.areasettings[areanum].firstreachablearea +
-							areacache->reachabilities[clusterareanum];
+							areareachabilities[clusterareanum];
 			if (!origin) {
-				*traveltime = areacache->traveltimes[clusterareanum];
+				*traveltime = areatraveltimes[clusterareanum];
 				return qtrue;
 			}
 			reach = &aasworld.reachability[*reachnum];
-			*traveltime = areacache->traveltimes[clusterareanum] +
+			*traveltime = areatraveltimes[clusterareanum] +
 							AAS_AreaTravelTime(areanum, origin, reach->start);
 			//
 			return qtrue;
@@ -1702,13 +2406,13 @@ int AAS_AreaRouteToGoalArea(int areanum, vec3_t origin, int goalareanum, int tra
 		goalclusternum = portal->frontcluster;
 	} //end if
 	//get the portal routing cache
-	portalcache = AAS_GetPortalRoutingCache(goalclusternum, goalareanum, travelflags);
+	AAS_PortalRoutingTimes(goalclusternum, goalareanum, travelflags, &portaltraveltimes, &portalreachabilities);
 	//if the area is a cluster portal, read directly from the portal cache
 	if (clusternum < 0)
 	{
-		*traveltime = portalcache->traveltimes[-clusternum];
+		*traveltime = portaltraveltimes[-clusternum];
 		*reachnum = aasworld.areasettings[areanum].firstreachablearea +
-						portalcache->reachabilities[-clusternum];
+						portalreachabilities[-clusternum];
 		return qtrue;
 	} //end if
 	//
@@ -1721,20 +2425,20 @@ int AAS_AreaRouteToGoalArea(int areanum, vec3_t origin, int goalareanum, int tra
 	{
 		portalnum = aasworld.portalindex[cluster->firstportal + i];
 		//if the goal area isn't reachable from the portal
-		if (!portalcache->traveltimes[portalnum]) continue;
+		if (!portaltraveltimes[portalnum]) continue;
 		//
 		portal = &aasworld.portals[portalnum];
 		//get the cache of the portal area
-		areacache = AAS_GetAreaRoutingCache(clusternum, portal->areanum, travelflags);
+		AAS_AreaRoutingTimes(clusternum, portal->areanum, travelflags, &areatraveltimes, &areareachabilities);
 		//current area inside the current cluster
 		clusterareanum = AAS_ClusterAreaNum(clusternum, areanum);
 		//if the area is NOT a reachability area
 		if (clusterareanum >= cluster->numreachabilityareas) continue;
 		//if the portal is NOT reachable from this area
-		if (!areacache->traveltimes[clusterareanum]) continue;
+		if (!areatraveltimes[clusterareanum]) continue;
 		//total travel time is the travel time the portal area is from
 		//the goal area plus the travel time towards the portal area
-		t = portalcache->traveltimes[portalnum] + areacache->traveltimes[clusterareanum];
+		t = portaltraveltimes[portalnum] + areatraveltimes[clusterareanum];
 		//FIXME: add the exact travel time through the actual portal area
 		//NOTE: for now we just add the largest travel time through the portal area
 		//		because we can't directly calculate the exact travel time
@@ -1745,7 +2449,7 @@ int AAS_AreaRouteToGoalArea(int areanum, vec3_t origin, int goalareanum, int tra
 		if (origin)
 		{
 			*reachnum = aasworld.areasettings[areanum].firstreachablearea +
-							areacache->reachabilities[clusterareanum];
+							areareachabilities[clusterareanum];
 			reach = aasworld.reachability + *reachnum;
 			t += AAS_AreaTravelTime(areanum, origin, reach->start);
 		} //end if
@@ -39,8 +39,18 @@ unsigned short int AAS_AreaTravelTime(int areanum, vec3_t start, vec3_t end);
 //
 void AAS_CreateAllRoutingCache(void);
 void AAS_WriteRouteCache(void);
+//loads the next part of the route cache dump
+void AAS_ContinueReadRouteCache(void);
+//stops loading the route cache dump
+void AAS_StopReadRouteCache(void);
+//writes the route cache after the given warm up time
+void AAS_CheckWriteRouteCache(float warmuptime);
+void AAS_WriteRouteTable(void);
+int AAS_ReadRouteTable(void);
 //
 void AAS_RoutingInfo(void);
+//prints the routing cache statistics of the last frame and resets them
+void AAS_RoutingCacheFrameStats(int print);
 #endif //AASINTERN
 
 //returns the travel flag for the given travel type
@@ -61,6 +61,34 @@ typedef struct aas_tracestack_s
 	int nodenum;		//node found after splitting with planenum
 } aas_tracestack_t;
 
+//maximum number of points walked down the tree together
+#define MAX_POINTAREABATCH			256
+//maximum number of lines traced down the tree together
+#define MAX_TRACEAREABATCH			64
+#define MAX_TRACEBATCHPIECES		1024
+#define MAX_TRACEBATCHSTACK			256
+
+typedef struct aas_pointstack_s
+{
+	int nodenum;		//node the points are tested against
+	int firstpoint;		//first index in the point index list
+	int numpoints;		//number of points in the node
+} aas_pointstack_t;
+
+typedef struct aas_tracepiece_s
+{
+	vec3_t start;		//start point of the piece of line to trace
+	vec3_t end;			//end point of the piece of line to trace
+	int tracenum;		//line the piece belongs to
+} aas_tracepiece_t;
+
+typedef struct aas_tracebatchstack_s
+{
+	int nodenum;		//node the pieces are tested against
+	int firstpiece;		//first piece of line in the piece list
+	int numpieces;		//number of pieces of line in the node
+} aas_tracebatchstack_t;
+
 int numaaslinks;
 
 //===========================================================================
@@ -257,6 +285,110 @@ int AAS_PointAreaNum(vec3_t point)
 	return -nodenum;
 } //end of the function AAS_PointAreaNum
 //===========================================================================
+// stores the AAS area each of the points is in
+// all points are walked down the tree together, the point indexes are
+// partitioned at each node so every node plane is fetched once per batch
+//
+// Parameter:				points		: points to find the area for
+//								numpoints	: number of points
+//								areas		: area (or zero when in solid) per point
+// Returns:					-
+// Changes Globals:		-
+//===========================================================================
+void AAS_PointAreaNums(vec3_t *points, int numpoints, int *areas)
+{
+	int i, j, first, last, batch, nodenum, tmp;
+	int pointindex[MAX_POINTAREABATCH];
+	vec_t dist;
+	aas_pointstack_t pointstack[128];
+	aas_pointstack_t *pstack_p;
+	aas_node_t *node;
+	aas_plane_t *plane;
+
+	if (!aasworld.loaded)
+	{
+		botimport.Print(PRT_ERROR, "AAS_PointAreaNums: aas not loaded\n");
+		for (i = 0; i < numpoints; i++) areas[i] = 0;
+		return;
+	} //end if
+
+	for (batch = 0; batch < numpoints; batch += MAX_POINTAREABATCH)
+	{
+		pstack_p = pointstack;
+		pstack_p->nodenum = 1;
+		pstack_p->firstpoint = 0;
+		pstack_p->numpoints = numpoints - batch;
+		if (pstack_p->numpoints > MAX_POINTAREABATCH) pstack_p->numpoints = MAX_POINTAREABATCH;
+		for (i = 0; i < pstack_p->numpoints; i++) pointindex[i] = batch + i;
+		pstack_p++;
+		//
+		while (pstack_p > pointstack)
+		{
+			pstack_p--;
+			nodenum = pstack_p->nodenum;
+			first = pstack_p->firstpoint;
+			last = first + pstack_p->numpoints;
+			//a single point is walked down the rest of the tree on its own
+			if (last - first == 1)
+			{
+				while (nodenum > 0)
+				{
+					node = &aasworld.nodes[nodenum];
+					plane = &aasworld.planes[node->planenum];
+					dist = DotProduct(points[pointindex[first]], plane->normal) - plane->dist;
+					if (dist > 0) nodenum = node->children[0];
+					else nodenum = node->children[1];
+				} //end while
+			} //end if
+			//if an area or solid leaf
+			if (nodenum <= 0)
+			{
+				for (i = first; i < last; i++) areas[pointindex[i]] = -nodenum;
+				continue;
+			} //end if
+			//the stack is deeper than the tree should ever be
+			if (pstack_p >= &pointstack[126])
+			{
+				for (i = first; i < last; i++) areas[pointindex[i]] = AAS_PointAreaNum(points[pointindex[i]]);
+				continue;
+			} //end if
+			node = &aasworld.nodes[nodenum];
+			plane = &aasworld.planes[node->planenum];
+			//move the points at the front of the plane to the start of the range
+			for (i = first, j = last; i < j; )
+			{
+				dist = DotProduct(points[pointindex[i]], plane->normal) - plane->dist;
+				if (dist > 0)
+				{
+					i++;
+				} //end if
+				else
+				{
+					j--;
+					tmp = pointindex[i];
+					pointindex[i] = pointindex[j];
+					pointindex[j] = tmp;
+				} //end else
+			} //end for
+			//push the back child first so the front child is handled first
+			if (i < last)
+			{
+				pstack_p->nodenum = node->children[1];
+				pstack_p->firstpoint = i;
+				pstack_p->numpoints = last - i;
+				pstack_p++;
+			} //end if
+			if (i > first)
+			{
+				pstack_p->nodenum = node->children[0];
+				pstack_p->firstpoint = first;
+				pstack_p->numpoints = i - first;
+				pstack_p++;
+			} //end if
+		} //end while
+	} //end for
+} //end of the function AAS_PointAreaNums
+//===========================================================================
 //
 // Parameter:			-
 // Returns:				-
@@ -716,6 +848,26 @@ aas_trace_t AAS_TraceClientBBox(vec3_t start, vec3_t end, int presencetype,
 //	return trace;
 } //end of the function AAS_TraceClientBBox
 //===========================================================================
+// calculates where the line crosses the node plane, shared by the single
+// and the batched area traces so both split the lines the same way
+//
+// Parameter:				-
+// Returns:					-
+// Changes Globals:		-
+//===========================================================================
+static ID_INLINE void AAS_TraceSplitPoint(vec3_t start, vec3_t end, float front, float back, vec3_t mid)
+{
+	float frac;
+
+	//calculate the hitpoint with the node (split point of the line)
+	frac = front / (front - back);
+	if (frac < 0) frac = 0;
+	else if (frac > 1) frac = 1;
+	mid[0] = start[0] + (end[0] - start[0]) * frac;
+	mid[1] = start[1] + (end[1] - start[1]) * frac;
+	mid[2] = start[2] + (end[2] - start[2]) * frac;
+} //end of the function AAS_TraceSplitPoint
+//===========================================================================
 // recursive subdivision of the line by the BSP tree.
 //
 // Parameter:				-
@@ -726,7 +878,7 @@ int AAS_TraceAreas(vec3_t start, vec3_t end, int *areas, vec3_t *points, int max
 {
 	int side, nodenum, tmpplanenum;
 	int numareas;
-	float front, back, frac;
+	float front, back;
 	vec3_t cur_start, cur_end, cur_mid;
 	aas_tracestack_t tracestack[127];
 	aas_tracestack_t *tstack_p;
@@ -858,16 +1010,7 @@ int AAS_TraceAreas(vec3_t start, vec3_t end, int *areas, vec3_t *points, int max
 		{
 			tmpplanenum = tstack_p->planenum;
 			//calculate the hitpoint with the node (split point of the line)
-			//put the crosspoint TRACEPLANE_EPSILON pixels on the near side
-			if (front < 0) frac = (front)/(front-back);
-			else frac = (front)/(front-back);
-			if (frac < 0) frac = 0;
-			else if (frac > 1) frac = 1;
-			//frac = front / (front-back);
-			//
-			cur_mid[0] = cur_start[0] + (cur_end[0] - cur_start[0]) * frac;
-			cur_mid[1] = cur_start[1] + (cur_end[1] - cur_start[1]) * frac;
-			cur_mid[2] = cur_start[2] + (cur_end[2] - cur_start[2]) * frac;
+			AAS_TraceSplitPoint(cur_start, cur_end, front, back, cur_mid);
 
 //			AAS_DrawPlaneCross(cur_mid, plane->normal, plane->dist, plane->type, LINECOLOR_RED);
 			//side the front part of the line is on
@@ -902,6 +1045,177 @@ int AAS_TraceAreas(vec3_t start, vec3_t end, int *areas, vec3_t *points, int max
 //	return numareas;
 } //end of the function AAS_TraceAreas
 //===========================================================================
+// traces several lines through the BSP tree together
+// the pieces of all lines in a node are tested against the node plane at
+// once and share one stack. Every line still visits the areas in the same
+// order as AAS_TraceAreas: when the lines in a node start at different
+// sides of the plane the child that is entered first is visited again for
+// the pieces that end up there last.
+//
+// Parameter:				starts, ends	: the lines to trace
+//								numtraces		: number of lines
+//								areas				: maxareas areas per line
+//								points			: maxareas entry points per line or NULL
+//								numareas			: number of passed areas per line
+// Returns:					total number of passed areas
+// Changes Globals:		-
+//===========================================================================
+int AAS_TraceAreasBatch(vec3_t *starts, vec3_t *ends, int numtraces, int *areas, vec3_t *points, int maxareas, int *numareas)
+{
+	int i, t, g, side, nodenum, first, numpieces, firstchild, totalareas;
+	int numgroup[3], childgroup[3], numside[2], splitside[2];
+	float front[MAX_TRACEAREABATCH], back[MAX_TRACEAREABATCH];
+	vec3_t mid;
+	aas_tracepiece_t tracepieces[MAX_TRACEBATCHPIECES];
+	aas_tracepiece_t groups[3][MAX_TRACEAREABATCH];
+	aas_tracepiece_t *piece, *near, *far;
+	aas_tracebatchstack_t tracestack[MAX_TRACEBATCHSTACK];
+	aas_tracebatchstack_t *tstack_p;
+	aas_node_t *aasnode;
+	aas_plane_t *plane;
+
+	totalareas = 0;
+	if (numtraces > MAX_TRACEAREABATCH)
+	{
+		botimport.Print(PRT_ERROR, "AAS_TraceAreasBatch: more than %d lines\n", MAX_TRACEAREABATCH);
+		numtraces = MAX_TRACEAREABATCH;
+	} //end if
+	for (t = 0; t < numtraces; t++)
+	{
+		numareas[t] = 0;
+		areas[t * maxareas] = 0;
+		VectorCopy(starts[t], tracepieces[t].start);
+		VectorCopy(ends[t], tracepieces[t].end);
+		tracepieces[t].tracenum = t;
+	} //end for
+	if (!aasworld.loaded || numtraces <= 0 || maxareas <= 0) return totalareas;
+
+	tstack_p = tracestack;
+	//we start with the whole lines on the stack
+	tstack_p->nodenum = 1;
+	tstack_p->firstpiece = 0;
+	tstack_p->numpieces = numtraces;
+	tstack_p++;
+	numpieces = numtraces;
+
+	while (tstack_p > tracestack)
+	{
+		//pop up the stack, the pieces of the node are always at the end of the piece list
+		tstack_p--;
+		nodenum = tstack_p->nodenum;
+		first = tstack_p->firstpiece;
+		numpieces = first;
+		//if it is an area
+		if (nodenum < 0)
+		{
+			for (i = 0; i < tstack_p->numpieces; i++)
+			{
+				piece = &tracepieces[first + i];
+				t = piece->tracenum;
+				if (numareas[t] >= maxareas) continue;
+				areas[t * maxareas + numareas[t]] = -nodenum;
+				if (points) VectorCopy(piece->start, points[t * maxareas + numareas[t]]);
+				numareas[t]++;
+				totalareas++;
+			} //end for
+			continue;
+		} //end if
+		//if it is a solid leaf
+		if (!nodenum)
+		{
+			continue;
+		} //end if
+		aasnode = &aasworld.nodes[nodenum];
+		plane = &aasworld.planes[aasnode->planenum];
+		//test all pieces against the node plane
+		numside[0] = numside[1] = 0;
+		splitside[0] = splitside[1] = qfalse;
+		for (i = 0; i < tstack_p->numpieces; i++)
+		{
+			piece = &tracepieces[first + i];
+			front[i] = DotProduct(piece->start, plane->normal) - plane->dist;
+			back[i] = DotProduct(piece->end, plane->normal) - plane->dist;
+			if (front[i] > 0 && back[i] > 0) numside[0]++;
+			else if (front[i] <= 0 && back[i] <= 0) numside[1]++;
+			else splitside[front[i] < 0] = qtrue;
+		} //end for
+		//if all pieces are at the same side of the node keep them where they are
+		//and go down the tree with that child
+		if (numside[0] == tstack_p->numpieces || numside[1] == tstack_p->numpieces)
+		{
+			tstack_p->nodenum = aasnode->children[numside[0] != tstack_p->numpieces];
+			numpieces = first + tstack_p->numpieces;
+			tstack_p++;
+			continue;
+		} //end if
+		//the first group goes down the child most split lines start in,
+		//the second group down the other child and the third group gets
+		//the far pieces of lines that started in the other child
+		firstchild = (splitside[0] || !splitside[1]) ? 0 : 1;
+		childgroup[0] = aasnode->children[firstchild];
+		childgroup[1] = aasnode->children[!firstchild];
+		childgroup[2] = aasnode->children[firstchild];
+		numgroup[0] = numgroup[1] = numgroup[2] = 0;
+		for (i = 0; i < tstack_p->numpieces; i++)
+		{
+			piece = &tracepieces[first + i];
+			//lines that already passed enough areas are done
+			if (numareas[piece->tracenum] >= maxareas) continue;
+			//if the whole piece is at one side of the node
+			if (front[i] > 0 && back[i] > 0)
+			{
+				g = (firstchild == 0) ? 0 : 1;
+				groups[g][numgroup[g]++] = *piece;
+				continue;
+			} //end if
+			if (front[i] <= 0 && back[i] <= 0)
+			{
+				g = (firstchild == 1) ? 0 : 1;
+				groups[g][numgroup[g]++] = *piece;
+				continue;
+			} //end if
+			//split the piece exactly like AAS_TraceAreas does
+			AAS_TraceSplitPoint(piece->start, piece->end, front[i], back[i], mid);
+			//side the start of the piece is on
+			side = front[i] < 0;
+			if (side == firstchild)
+			{
+				near = &groups[0][numgroup[0]++];
+				far = &groups[1][numgroup[1]++];
+			} //end if
+			else
+			{
+				near = &groups[1][numgroup[1]++];
+				far = &groups[2][numgroup[2]++];
+			} //end else
+			VectorCopy(piece->start, near->start);
+			VectorCopy(mid, near->end);
+			near->tracenum = piece->tracenum;
+			VectorCopy(mid, far->start);
+			VectorCopy(piece->end, far->end);
+			far->tracenum = piece->tracenum;
+		} //end for
+		//push the groups in reverse order so the first group is handled first
+		for (g = 2; g >= 0; g--)
+		{
+			if (!numgroup[g]) continue;
+			if (tstack_p >= &tracestack[MAX_TRACEBATCHSTACK] ||
+					numpieces + numgroup[g] > MAX_TRACEBATCHPIECES)
+			{
+				botimport.Print(PRT_ERROR, "AAS_TraceAreasBatch: stack overflow\n");
+				return totalareas;
+			} //end if
+			Com_Memcpy(&tracepieces[numpieces], groups[g], numgroup[g] * sizeof(aas_tracepiece_t));
+			tstack_p->nodenum = childgroup[g];
+			tstack_p->firstpiece = numpieces;
+			tstack_p->numpieces = numgroup[g];
+			tstack_p++;
+			numpieces += numgroup[g];
+		} //end for
+	} //end while
+	return totalareas;
+} //end of the function AAS_TraceAreasBatch
+//===========================================================================
 // a simple cross product
 //
 // Parameter:				-
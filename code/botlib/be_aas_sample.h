@@ -56,12 +56,16 @@ int AAS_PointPresenceType(vec3_t point);
 aas_trace_t AAS_TraceClientBBox(vec3_t start, vec3_t end, int presencetype, int passent);
 //stores the areas the trace went through and returns the number of passed areas
 int AAS_TraceAreas(vec3_t start, vec3_t end, int *areas, vec3_t *points, int maxareas);
+//traces several lines at once, stores maxareas areas and points per line like AAS_TraceAreas
+int AAS_TraceAreasBatch(vec3_t *starts, vec3_t *ends, int numtraces, int *areas, vec3_t *points, int maxareas, int *numareas);
 //returns the areas the bounding box is in
 int AAS_BBoxAreas(vec3_t absmins, vec3_t absmaxs, int *areas, int maxareas);
 //return area information
 int AAS_AreaInfo( int areanum, aas_areainfo_t *info );
 //returns the area the point is in
 int AAS_PointAreaNum(vec3_t point);
+//stores the area each of the points is in
+void AAS_PointAreaNums(vec3_t *points, int numpoints, int *areas);
 //
 int AAS_PointReachabilityAreaIndex( vec3_t point );
 //returns the plane the given face is in
@@ -71,6 +71,7 @@ typedef struct bot_character_s
 {
 	char filename[MAX_QPATH];
 	float skill;
+	int refcount;					//number of bots using the character
 	bot_characteristic_t c[1];		//variable sized
 } bot_character_t;
 
@@ -168,7 +169,15 @@ void BotFreeCharacter2(int handle)
 //========================================================================
 void BotFreeCharacter(int handle)
 {
+	bot_character_t *ch;
+
+	ch = BotCharacterFromHandle(handle);
+	if (!ch) return;
+	if (ch->refcount > 0) ch->refcount--;
+	//characters are kept for the next bot that loads them
 	if (!LibVarGetValue("bot_reloadcharacters")) return;
+	//if other bots still use the character
+	if (ch->refcount > 0) return;
 	BotFreeCharacter2(handle);
 } //end of the function BotFreeCharacter
 //===========================================================================
@@ -219,7 +228,7 @@ bot_character_t *BotLoadCharacterFromFile(char *charfile, int skill)
 	foundcharacter = qfalse;
 	//a bot character is parsed in two phases
 	PC_SetBaseFolder(BOTFILESBASEFOLDER);
-	source = LoadSourceFile(charfile);
+	source = LoadCachedSourceFile(charfile);
 	if (!source)
 	{
 		botimport.Print(PRT_ERROR, "counldn't load %s\n", charfile);
@@ -565,7 +574,7 @@ int BotInterpolateCharacters(int handle1, int handle2, float desiredskill)
 // Returns:				-
 // Changes Globals:		-
 //===========================================================================
-int BotLoadCharacter(char *charfile, float skill)
+int BotLoadCharacter2(char *charfile, float skill)
 {
 	int firstskill, secondskill, handle;
 
@@ -607,6 +616,22 @@ int BotLoadCharacter(char *charfile, float skill)
 	BotDumpCharacter(botcharacters[handle]);
 	//
 	return handle;
+} //end of the function BotLoadCharacter2
+//===========================================================================
+// the returned character is shared by all bots that load the same
+// character file and skill
+//
+// Parameter:			-
+// Returns:				-
+// Changes Globals:		-
+//===========================================================================
+int BotLoadCharacter(char *charfile, float skill)
+{
+	int handle;
+
+	handle = BotLoadCharacter2(charfile, skill);
+	if (handle) botcharacters[handle]->refcount++;
+	return handle;
 } //end of the function BotLoadCharacter
 //===========================================================================
 //
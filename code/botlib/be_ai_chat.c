@@ -2056,7 +2056,7 @@ bot_chat_t *BotLoadInitialChat(char *chatfile, char *chatname)
 		if (pass && size) ptr = (char *) GetClearedMemory(size);
 		//load the source file
 		PC_SetBaseFolder(BOTFILESBASEFOLDER);
-		source = LoadSourceFile(chatfile);
+		source = LoadCachedSourceFile(chatfile);
 		if (!source)
 		{
 			botimport.Print(PRT_ERROR, "counldn't load %s\n", chatfile);
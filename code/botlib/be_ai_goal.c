@@ -226,6 +226,10 @@ void BotInterbreedGoalFuzzyLogic(int parent1, int parent2, int child)
 	p1 = BotGoalStateFromHandle(parent1);
 	p2 = BotGoalStateFromHandle(parent2);
 	c = BotGoalStateFromHandle(child);
+	if (!p1 || !p2 || !c || !c->itemweightconfig) return;
+	//the child gets its own weights
+	c->itemweightconfig = UnshareWeightConfig(c->itemweightconfig);
+	c->itemweightindex = c->itemweightconfig->weightindex;
 
 	InterbreedWeightConfigs(p1->itemweightconfig, p2->itemweightconfig,
 									c->itemweightconfig);
@@ -255,6 +259,10 @@ void BotMutateGoalFuzzyLogic(int goalstate, float range)
 	bot_goalstate_t *gs;
 
 	gs = BotGoalStateFromHandle(goalstate);
+	if (!gs || !gs->itemweightconfig) return;
+	//mutate a copy of the weights if other bots use them as well
+	gs->itemweightconfig = UnshareWeightConfig(gs->itemweightconfig);
+	gs->itemweightindex = gs->itemweightconfig->weightindex;
 
 	EvolveWeightConfig(gs->itemweightconfig);
 } //end of the function BotMutateGoalFuzzyLogic
@@ -476,8 +484,9 @@ void BotInitInfoEntities(void)
 {
 	char classname[MAX_EPAIRKEY];
 	maplocation_t *ml;
-	campspot_t *cs;
-	int ent, numlocations, numcampspots;
+	campspot_t *cs, *lastcs, *nextcs;
+	int ent, i, numlocations, numcampspots, *areas;
+	vec3_t *points;
 
 	BotFreeInfoEntities();
 	//
@@ -493,7 +502,6 @@ void BotInitInfoEntities(void)
 			ml = (maplocation_t *) GetClearedMemory(sizeof(maplocation_t));
 			AAS_VectorForBSPEpairKey(ent, "origin", ml->origin);
 			AAS_ValueForBSPEpairKey(ent, "message", ml->name, sizeof(ml->name));
-			ml->areanum = AAS_PointAreaNum(ml->origin);
 			ml->next = maplocations;
 			maplocations = ml;
 			numlocations++;
@@ -509,19 +517,41 @@ void BotInitInfoEntities(void)
 			AAS_FloatForBSPEpairKey(ent, "weight", &cs->weight);
 			AAS_FloatForBSPEpairKey(ent, "wait", &cs->wait);
 			AAS_FloatForBSPEpairKey(ent, "random", &cs->random);
-			cs->areanum = AAS_PointAreaNum(cs->origin);
-			if (!cs->areanum)
-			{
-				botimport.Print(PRT_MESSAGE, "camp spot at %1.1f %1.1f %1.1f in solid\n", cs->origin[0], cs->origin[1], cs->origin[2]);
-				FreeMemory(cs);
-				continue;
-			} //end if
 			cs->next = campspots;
 			campspots = cs;
 			//AAS_DrawPermanentCross(cs->origin, 4, LINECOLOR_YELLOW);
 			numcampspots++;
 		} //end else if
 	} //end for
+	//find the areas of all the map locations and camp spots at once
+	if (numlocations + numcampspots)
+	{
+		points = (vec3_t *) GetMemory((numlocations + numcampspots) * (sizeof(vec3_t) + sizeof(int)));
+		areas = (int *) (points + numlocations + numcampspots);
+		i = 0;
+		for (ml = maplocations; ml; ml = ml->next) VectorCopy(ml->origin, points[i++]);
+		for (cs = campspots; cs; cs = cs->next) VectorCopy(cs->origin, points[i++]);
+		AAS_PointAreaNums(points, i, areas);
+		i = 0;
+		for (ml = maplocations; ml; ml = ml->next) ml->areanum = areas[i++];
+		lastcs = NULL;
+		for (cs = campspots; cs; cs = nextcs)
+		{
+			nextcs = cs->next;
+			cs->areanum = areas[i++];
+			if (!cs->areanum)
+			{
+				botimport.Print(PRT_MESSAGE, "camp spot at %1.1f %1.1f %1.1f in solid\n", cs->origin[0], cs->origin[1], cs->origin[2]);
+				if (lastcs) lastcs->next = nextcs;
+				else campspots = nextcs;
+				FreeMemory(cs);
+				numcampspots--;
+				continue;
+			} //end if
+			lastcs = cs;
+		} //end for
+		FreeMemory(points);
+	} //end if
 	if (botDeveloper)
 	{
 		botimport.Print(PRT_MESSAGE, "%d map locations\n", numlocations);
@@ -1693,6 +1723,7 @@ int BotLoadItemWeights(int goalstate, char *filename)
 
 	gs = BotGoalStateFromHandle(goalstate);
 	if (!gs) return BLERR_CANNOTLOADITEMWEIGHTS;
+	BotFreeItemWeights(goalstate);
 	//load the weight configuration
 	gs->itemweightconfig = ReadWeightConfig(filename);
 	if (!gs->itemweightconfig)
@@ -1702,8 +1733,13 @@ int BotLoadItemWeights(int goalstate, char *filename)
 	} //end if
 	//if there's no item configuration
 	if (!itemconfig) return BLERR_CANNOTLOADITEMWEIGHTS;
-	//create the item weight index
-	gs->itemweightindex = ItemWeightIndex(gs->itemweightconfig, itemconfig);
+	//create the item weight index shared by all users of the weights
+	if (!gs->itemweightconfig->weightindex)
+	{
+		gs->itemweightconfig->weightindex = ItemWeightIndex(gs->itemweightconfig, itemconfig);
+		gs->itemweightconfig->numweightindex = itemconfig->numiteminfo;
+	} //end if
+	gs->itemweightindex = gs->itemweightconfig->weightindex;
 	//everything went ok
 	return BLERR_NOERROR;
 } //end of the function BotLoadItemWeights
@@ -1719,8 +1755,10 @@ void BotFreeItemWeights(int goalstate)
 
 	gs = BotGoalStateFromHandle(goalstate);
 	if (!gs) return;
+	//the weight index is freed with the weights
 	if (gs->itemweightconfig) FreeWeightConfig(gs->itemweightconfig);
-	if (gs->itemweightindex) FreeMemory(gs->itemweightindex);
+	gs->itemweightconfig = NULL;
+	gs->itemweightindex = NULL;
 } //end of the function BotFreeItemWeights
 //===========================================================================
 //
@@ -238,10 +238,12 @@ float AngleDiff(float ang1, float ang2)
 //===========================================================================
 int BotFuzzyPointReachabilityArea(vec3_t origin)
 {
-	int firstareanum, j, x, y, z;
+	int firstareanum, i, j, x, y, z;
 	int areas[10], numareas, areanum, bestareanum;
+	int batchareas[9][10], batchnumareas[9];
 	float dist, bestdist;
 	vec3_t points[10], v, end;
+	vec3_t starts[9], ends[9], batchpoints[9][10];
 
 	firstareanum = 0;
 	areanum = AAS_PointAreaNum(origin);
@@ -261,29 +263,36 @@ int BotFuzzyPointReachabilityArea(vec3_t origin)
 	bestareanum = 0;
 	for (z = 1; z >= -1; z -= 1)
 	{
+		//trace the nine lines at this height together
+		i = 0;
 		for (x = 1; x >= -1; x -= 1)
 		{
 			for (y = 1; y >= -1; y -= 1)
 			{
-				VectorCopy(origin, end);
-				end[0] += x * 8;
-				end[1] += y * 8;
-				end[2] += z * 12;
-				numareas = AAS_TraceAreas(origin, end, areas, points, 10);
-				for (j = 0; j < numareas; j++)
+				VectorCopy(origin, starts[i]);
+				VectorCopy(origin, ends[i]);
+				ends[i][0] += x * 8;
+				ends[i][1] += y * 8;
+				ends[i][2] += z * 12;
+				i++;
+			} //end for
+		} //end for
+		AAS_TraceAreasBatch(starts, ends, 9, batchareas[0], batchpoints[0], 10, batchnumareas);
+		for (i = 0; i < 9; i++)
+		{
+			for (j = 0; j < batchnumareas[i]; j++)
+			{
+				if (AAS_AreaReachability(batchareas[i][j]))
 				{
-					if (AAS_AreaReachability(areas[j]))
+					VectorSubtract(batchpoints[i][j], origin, v);
+					dist = VectorLength(v);
+					if (dist < bestdist)
 					{
-						VectorSubtract(points[j], origin, v);
-						dist = VectorLength(v);
-						if (dist < bestdist)
-						{
-							bestareanum = areas[j];
-							bestdist = dist;
-						} //end if
+						bestareanum = batchareas[i][j];
+						bestdist = dist;
 					} //end if
-					if (!firstareanum) firstareanum = areas[j];
-				} //end for
+				} //end if
+				if (!firstareanum) firstareanum = batchareas[i][j];
 			} //end for
 		} //end for
 		if (bestareanum) return bestareanum;
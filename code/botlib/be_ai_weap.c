@@ -352,8 +352,10 @@ void BotFreeWeaponWeights(int weaponstate)
 
 	ws = BotWeaponStateFromHandle(weaponstate);
 	if (!ws) return;
+	//the weight index is freed with the weights
 	if (ws->weaponweightconfig) FreeWeightConfig(ws->weaponweightconfig);
-	if (ws->weaponweightindex) FreeMemory(ws->weaponweightindex);
+	ws->weaponweightconfig = NULL;
+	ws->weaponweightindex = NULL;
 } //end of the function BotFreeWeaponWeights
 //===========================================================================
 //
@@ -376,7 +378,13 @@ int BotLoadWeaponWeights(int weaponstate, char *filename)
 		return BLERR_CANNOTLOADWEAPONWEIGHTS;
 	} //end if
 	if (!weaponconfig) return BLERR_CANNOTLOADWEAPONCONFIG;
-	ws->weaponweightindex = WeaponWeightIndex(ws->weaponweightconfig, weaponconfig);
+	//create the weapon weight index shared by all users of the weights
+	if (!ws->weaponweightconfig->weightindex)
+	{
+		ws->weaponweightconfig->weightindex = WeaponWeightIndex(ws->weaponweightconfig, weaponconfig);
+		ws->weaponweightconfig->numweightindex = weaponconfig->numweapons;
+	} //end if
+	ws->weaponweightindex = ws->weaponweightconfig->weightindex;
 	return BLERR_NOERROR;
 } //end of the function BotLoadWeaponWeights
 //===========================================================================
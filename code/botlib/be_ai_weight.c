@@ -125,6 +125,93 @@ void FreeFuzzySeperators_r(fuzzyseperator_t *fs)
 } //end of the function FreeFuzzySeperators
 //===========================================================================
 //
+// Parameter:				-
+// Returns:					-
+// Changes Globals:		-
+//===========================================================================
+int CountFuzzySeperators_r(fuzzyseperator_t *fs, int *numswitches)
+{
+	int numcases;
+
+	(*numswitches)++;
+	for (numcases = 0; fs; fs = fs->next)
+	{
+		numcases++;
+		if (fs->child) numcases += CountFuzzySeperators_r(fs->child, numswitches);
+	} //end for
+	return numcases;
+} //end of the function CountFuzzySeperators_r
+//===========================================================================
+// stores the switch starting with the given seperator and all the child
+// switches in the flat arrays of the weight configuration
+//
+// Parameter:				-
+// Returns:					number of the compiled switch
+// Changes Globals:		-
+//===========================================================================
+int CompileFuzzySeperators_r(weightconfig_t *config, fuzzyseperator_t *fs)
+{
+	int switchnum, firstcase, numcases;
+	fuzzyswitch_t *fsw;
+	fuzzycase_t *fc;
+	fuzzyseperator_t *s;
+
+	for (numcases = 0, s = fs; s; s = s->next) numcases++;
+	switchnum = config->numswitches++;
+	firstcase = config->numcases;
+	config->numcases += numcases;
+	//
+	fsw = &config->switches[switchnum];
+	fsw->index = fs->index;
+	fsw->firstcase = firstcase;
+	fsw->numcases = numcases;
+	//
+	for (fc = &config->cases[firstcase], s = fs; s; s = s->next, fc++)
+	{
+		fc->value = s->value;
+		fc->weight = s->weight;
+		fc->minweight = s->minweight;
+		fc->maxweight = s->maxweight;
+		if (s->child) fc->child = CompileFuzzySeperators_r(config, s->child);
+		else fc->child = -1;
+	} //end for
+	return switchnum;
+} //end of the function CompileFuzzySeperators_r
+//===========================================================================
+// compiles the fuzzy seperators of the weight configuration into flat
+// arrays, has to be called again whenever the seperators change
+//
+// Parameter:				-
+// Returns:					-
+// Changes Globals:		-
+//===========================================================================
+void CompileWeightConfig(weightconfig_t *config)
+{
+	int i, numswitches, numcases;
+
+	if (config->switches) FreeMemory(config->switches);
+	config->switches = NULL;
+	config->cases = NULL;
+	//
+	numswitches = 0;
+	numcases = 0;
+	for (i = 0; i < config->numweights; i++)
+	{
+		numcases += CountFuzzySeperators_r(config->weights[i].firstseperator, &numswitches);
+	} //end for
+	//the cases are stored directly after the switches
+	config->switches = (fuzzyswitch_t *) GetMemory(numswitches * sizeof(fuzzyswitch_t) +
+												numcases * sizeof(fuzzycase_t));
+	config->cases = (fuzzycase_t *) &config->switches[numswitches];
+	config->numswitches = 0;
+	config->numcases = 0;
+	for (i = 0; i < config->numweights; i++)
+	{
+		config->weights[i].firstswitch = CompileFuzzySeperators_r(config, config->weights[i].firstseperator);
+	} //end for
+} //end of the function CompileWeightConfig
+//===========================================================================
+//
 // Parameter:			-
 // Returns:				-
 // Changes Globals:		-
@@ -138,6 +225,8 @@ void FreeWeightConfig2(weightconfig_t *config)
 		FreeFuzzySeperators_r(config->weights[i].firstseperator);
 		if (config->weights[i].name) FreeMemory(config->weights[i].name);
 	} //end for
+	if (config->switches) FreeMemory(config->switches);
+	if (config->weightindex) FreeMemory(config->weightindex);
 	FreeMemory(config);
 } //end of the function FreeWeightConfig2
 //===========================================================================
@@ -146,9 +235,29 @@ void FreeWeightConfig2(weightconfig_t *config)
 // Returns:				-
 // Changes Globals:		-
 //===========================================================================
+int WeightConfigCached(weightconfig_t *config)
+{
+	int i;
+
+	for (i = 0; i < MAX_WEIGHT_FILES; i++)
+	{
+		if (weightFileList[i] == config) return qtrue;
+	} //end for
+	return qfalse;
+} //end of the function WeightConfigCached
+//===========================================================================
+//
+// Parameter:			-
+// Returns:				-
+// Changes Globals:		-
+//===========================================================================
 void FreeWeightConfig(weightconfig_t *config)
 {
-	if (!LibVarGetValue("bot_reloadcharacters")) return;
+	config->refcount--;
+	//if other bots still use the configuration
+	if (config->refcount > 0) return;
+	//cached configurations are kept for the next bot that loads them
+	if (WeightConfigCached(config)) return;
 	FreeWeightConfig2(config);
 } //end of the function FreeWeightConfig
 //===========================================================================
@@ -157,6 +266,68 @@ void FreeWeightConfig(weightconfig_t *config)
 // Returns:				-
 // Changes Globals:		-
 //===========================================================================
+fuzzyseperator_t *CopyFuzzySeperators_r(fuzzyseperator_t *fs)
+{
+	fuzzyseperator_t *newfs;
+
+	if (!fs) return NULL;
+	newfs = (fuzzyseperator_t *) GetMemory(sizeof(fuzzyseperator_t));
+	Com_Memcpy(newfs, fs, sizeof(fuzzyseperator_t));
+	newfs->child = CopyFuzzySeperators_r(fs->child);
+	newfs->next = CopyFuzzySeperators_r(fs->next);
+	return newfs;
+} //end of the function CopyFuzzySeperators_r
+//===========================================================================
+//
+// Parameter:			-
+// Returns:				-
+// Changes Globals:		-
+//===========================================================================
+weightconfig_t *CopyWeightConfig(weightconfig_t *config)
+{
+	int i;
+	weightconfig_t *newconfig;
+
+	newconfig = (weightconfig_t *) GetClearedMemory(sizeof(weightconfig_t));
+	newconfig->numweights = config->numweights;
+	Q_strncpyz(newconfig->filename, config->filename, sizeof(newconfig->filename));
+	for (i = 0; i < config->numweights; i++)
+	{
+		newconfig->weights[i].name = (char *) GetMemory(strlen(config->weights[i].name) + 1);
+		strcpy(newconfig->weights[i].name, config->weights[i].name);
+		newconfig->weights[i].firstseperator = CopyFuzzySeperators_r(config->weights[i].firstseperator);
+	} //end for
+	if (config->weightindex)
+	{
+		newconfig->numweightindex = config->numweightindex;
+		newconfig->weightindex = (int *) GetMemory(config->numweightindex * sizeof(int));
+		Com_Memcpy(newconfig->weightindex, config->weightindex, config->numweightindex * sizeof(int));
+	} //end if
+	CompileWeightConfig(newconfig);
+	newconfig->refcount = 1;
+	return newconfig;
+} //end of the function CopyWeightConfig
+//===========================================================================
+//
+// Parameter:			-
+// Returns:				-
+// Changes Globals:		-
+//===========================================================================
+weightconfig_t *UnshareWeightConfig(weightconfig_t *config)
+{
+	weightconfig_t *newconfig;
+
+	if (config->refcount <= 1 && !WeightConfigCached(config)) return config;
+	newconfig = CopyWeightConfig(config);
+	FreeWeightConfig(config);
+	return newconfig;
+} //end of the function UnshareWeightConfig
+//===========================================================================
+//
+// Parameter:			-
+// Returns:				-
+// Changes Globals:		-
+//===========================================================================
 fuzzyseperator_t *ReadFuzzySeperators_r(source_t *source)
 {
 	int newindent, index, def, founddefault;
@@ -313,6 +484,7 @@ weightconfig_t *ReadWeightConfig(char *filename)
 			if( strcmp( filename, config->filename ) == 0 )
 			{
 				//botimport.Print( PRT_MESSAGE, "retained %s\n", filename );
+				config->refcount++;
 				return config;
 			} //end if
 		} //end for
@@ -325,7 +497,7 @@ weightconfig_t *ReadWeightConfig(char *filename)
 	} //end if
 
 	PC_SetBaseFolder(BOTFILESBASEFOLDER);
-	source = LoadSourceFile(filename);
+	source = LoadCachedSourceFile(filename);
 	if (!source)
 	{
 		botimport.Print(PRT_ERROR, "counldn't load %s\n", filename);
@@ -426,6 +598,8 @@ weightconfig_t *ReadWeightConfig(char *filename)
 	} //end while
 	//free the source at the end of a pass
 	FreeSource(source);
+	//compile the weights for fast evaluation
+	CompileWeightConfig(config);
 	//if the file was located in a pak file
 	botimport.Print(PRT_MESSAGE, "loaded %s\n", filename);
 #ifdef DEBUG
@@ -439,6 +613,7 @@ weightconfig_t *ReadWeightConfig(char *filename)
 	{
 		weightFileList[avail] = config;
 	} //end if
+	config->refcount = 1;
 	//
 	return config;
 } //end of the function ReadWeightConfig
@@ -580,73 +755,85 @@ int FindFuzzyWeight(weightconfig_t *wc, char *name)
 // Returns:					-
 // Changes Globals:		-
 //===========================================================================
-float FuzzyWeight_r(int *inventory, fuzzyseperator_t *fs)
+float FuzzyWeight_r(int *inventory, weightconfig_t *wc, int switchnum)
 {
 	float scale, w1, w2;
+	int inv;
+	fuzzyswitch_t *fsw;
+	fuzzycase_t *fc, *last;
 
-	if (inventory[fs->index] < fs->value)
+	fsw = &wc->switches[switchnum];
+	inv = inventory[fsw->index];
+	fc = &wc->cases[fsw->firstcase];
+	last = fc + fsw->numcases - 1;
+	if (inv < fc->value)
 	{
-		if (fs->child) return FuzzyWeight_r(inventory, fs->child);
-		else return fs->weight;
+		if (fc->child >= 0) return FuzzyWeight_r(inventory, wc, fc->child);
+		else return fc->weight;
 	} //end if
-	else if (fs->next)
+	for (; fc < last; fc++)
 	{
-		if (inventory[fs->index] < fs->next->value)
+		if (inv < fc[1].value)
 		{
-			//first weight
-			if (fs->child) w1 = FuzzyWeight_r(inventory, fs->child);
-			else w1 = fs->weight;
 			//second weight
-			if (fs->next->child) w2 = FuzzyWeight_r(inventory, fs->next->child);
-			else w2 = fs->next->weight;
+			if (fc[1].child >= 0) w2 = FuzzyWeight_r(inventory, wc, fc[1].child);
+			else w2 = fc[1].weight;
+			if (fc[1].value == MAX_INVENTORYVALUE) // is the next case the default case?
+				return w2;      // can't interpolate, return default weight
+			//first weight
+			if (fc->child >= 0) w1 = FuzzyWeight_r(inventory, wc, fc->child);
+			else w1 = fc->weight;
 			//the scale factor
-			if(fs->next->value == MAX_INVENTORYVALUE) // is fs->next the default case?
-        		return w2;      // can't interpolate, return default weight
-			else
-				scale = (float) (inventory[fs->index] - fs->value) / (fs->next->value - fs->value);
+			scale = (float) (inv - fc->value) / (fc[1].value - fc->value);
 			//scale between the two weights
 			return (1 - scale) * w1 + scale * w2;
 		} //end if
-		return FuzzyWeight_r(inventory, fs->next);
-	} //end else if
-	return fs->weight;
+	} //end for
+	return last->weight;
 } //end of the function FuzzyWeight_r
 //===========================================================================
+// the random balance weights are drawn in the same order as the
+// seperators would be visited
 //
 // Parameter:				-
 // Returns:					-
 // Changes Globals:		-
 //===========================================================================
-float FuzzyWeightUndecided_r(int *inventory, fuzzyseperator_t *fs)
+float FuzzyWeightUndecided_r(int *inventory, weightconfig_t *wc, int switchnum)
 {
 	float scale, w1, w2;
+	int inv;
+	fuzzyswitch_t *fsw;
+	fuzzycase_t *fc, *last;
 
-	if (inventory[fs->index] < fs->value)
+	fsw = &wc->switches[switchnum];
+	inv = inventory[fsw->index];
+	fc = &wc->cases[fsw->firstcase];
+	last = fc + fsw->numcases - 1;
+	if (inv < fc->value)
 	{
-		if (fs->child) return FuzzyWeightUndecided_r(inventory, fs->child);
-		else return fs->minweight + random() * (fs->maxweight - fs->minweight);
+		if (fc->child >= 0) return FuzzyWeightUndecided_r(inventory, wc, fc->child);
+		else return fc->minweight + random() * (fc->maxweight - fc->minweight);
 	} //end if
-	else if (fs->next)
+	for (; fc < last; fc++)
 	{
-		if (inventory[fs->index] < fs->next->value)
+		if (inv < fc[1].value)
 		{
 			//first weight
-			if (fs->child) w1 = FuzzyWeightUndecided_r(inventory, fs->child);
-			else w1 = fs->minweight + random() * (fs->maxweight - fs->minweight);
+			if (fc->child >= 0) w1 = FuzzyWeightUndecided_r(inventory, wc, fc->child);
+			else w1 = fc->minweight + random() * (fc->maxweight - fc->minweight);
 			//second weight
-			if (fs->next->child) w2 = FuzzyWeight_r(inventory, fs->next->child);
-			else w2 = fs->next->minweight + random() * (fs->next->maxweight - fs->next->minweight);
+			if (fc[1].child >= 0) w2 = FuzzyWeight_r(inventory, wc, fc[1].child);
+			else w2 = fc[1].minweight + random() * (fc[1].maxweight - fc[1].minweight);
+			if (fc[1].value == MAX_INVENTORYVALUE) // is the next case the default case?
+				return w2;      // can't interpolate, return default weight
 			//the scale factor
-			if(fs->next->value == MAX_INVENTORYVALUE) // is fs->next the default case?
-        		return w2;      // can't interpolate, return default weight
-			else
-				scale = (float) (inventory[fs->index] - fs->value) / (fs->next->value - fs->value);
+			scale = (float) (inv - fc->value) / (fc[1].value - fc->value);
 			//scale between the two weights
 			return (1 - scale) * w1 + scale * w2;
 		} //end if
-		return FuzzyWeightUndecided_r(inventory, fs->next);
-	} //end else if
-	return fs->weight;
+	} //end for
+	return last->weight;
 } //end of the function FuzzyWeightUndecided_r
 //===========================================================================
 //
@@ -657,7 +844,7 @@ float FuzzyWeightUndecided_r(int *inventory, fuzzyseperator_t *fs)
 float FuzzyWeight(int *inventory, weightconfig_t *wc, int weightnum)
 {
 #ifdef EVALUATERECURSIVELY
-	return FuzzyWeight_r(inventory, wc->weights[weightnum].firstseperator);
+	return FuzzyWeight_r(inventory, wc, wc->weights[weightnum].firstswitch);
 #else
 	fuzzyseperator_t *s;
 
@@ -688,7 +875,7 @@ float FuzzyWeight(int *inventory, weightconfig_t *wc, int weightnum)
 float FuzzyWeightUndecided(int *inventory, weightconfig_t *wc, int weightnum)
 {
 #ifdef EVALUATERECURSIVELY
-	return FuzzyWeightUndecided_r(inventory, wc->weights[weightnum].firstseperator);
+	return FuzzyWeightUndecided_r(inventory, wc, wc->weights[weightnum].firstswitch);
 #else
 	fuzzyseperator_t *s;
 
@@ -747,6 +934,7 @@ void EvolveWeightConfig(weightconfig_t *config)
 	{
 		EvolveFuzzySeperator_r(config->weights[i].firstseperator);
 	} //end for
+	CompileWeightConfig(config);
 } //end of the function EvolveWeightConfig
 //===========================================================================
 //
@@ -787,6 +975,7 @@ void ScaleWeight(weightconfig_t *config, char *name, float scale)
 		if (!strcmp(name, config->weights[i].name))
 		{
 			ScaleFuzzySeperator_r(config->weights[i].firstseperator, scale);
+			CompileWeightConfig(config);
 			break;
 		} //end if
 	} //end for
@@ -832,6 +1021,7 @@ void ScaleFuzzyBalanceRange(weightconfig_t *config, float scale)
 	{
 		ScaleFuzzySeperatorBalanceRange_r(config->weights[i].firstseperator, scale);
 	} //end for
+	CompileWeightConfig(config);
 } //end of the function ScaleFuzzyBalanceRange
 //===========================================================================
 //
@@ -903,6 +1093,7 @@ void InterbreedWeightConfigs(weightconfig_t *config1, weightconfig_t *config2,
 									config2->weights[i].firstseperator,
 									configout->weights[i].firstseperator);
 	} //end for
+	CompileWeightConfig(configout);
 } //end of the function InterbreedWeightConfigs
 //===========================================================================
 //
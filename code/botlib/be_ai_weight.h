@@ -45,11 +45,31 @@ typedef struct fuzzyseperator_s
 	struct fuzzyseperator_s *next;
 } fuzzyseperator_t;
 
+//switch of a compiled fuzzy weight, the cases of the switch
+//are stored in order in the case array of the weight configuration
+typedef struct fuzzyswitch_s
+{
+	int index;						//inventory index switched on
+	int firstcase;					//first case of the switch
+	int numcases;					//number of cases
+} fuzzyswitch_t;
+
+//case of a compiled fuzzy weight
+typedef struct fuzzycase_s
+{
+	int value;						//inventory value the case is used below
+	int child;						//child switch or -1 if the case returns a weight
+	float weight;
+	float minweight;
+	float maxweight;
+} fuzzycase_t;
+
 //fuzzy weight
 typedef struct weight_s
 {
 	char *name;
 	struct fuzzyseperator_s *firstseperator;
+	int firstswitch;				//compiled switch of the weight
 } weight_t;
 
 //weight configuration
@@ -58,12 +78,25 @@ typedef struct weightconfig_s
 	int numweights;
 	weight_t weights[MAX_WEIGHTS];
 	char		filename[MAX_QPATH];
+	//the fuzzy seperators compiled into flat arrays
+	int numswitches;
+	fuzzyswitch_t *switches;
+	int numcases;
+	fuzzycase_t *cases;
+	//the configuration is shared by all bots that load it
+	int refcount;					//number of users of the configuration
+	int numweightindex;				//size of the weight index
+	int *weightindex;				//index from item or weapon to weight
 } weightconfig_t;
 
 //reads a weight configuration
 weightconfig_t *ReadWeightConfig(char *filename);
-//free a weight configuration
+//free a weight configuration, the configuration is only freed when it
+//is no longer used and not cached
 void FreeWeightConfig(weightconfig_t *config);
+//returns a copy of the configuration when it is shared, the
+//configuration can be modified after this without affecting other users
+weightconfig_t *UnshareWeightConfig(weightconfig_t *config);
 //writes a weight configuration, returns true if successfull
 qboolean WriteWeightConfig(char *filename, weightconfig_t *config);
 //find the fuzzy weight with the given name
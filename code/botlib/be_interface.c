@@ -216,6 +216,8 @@ int Export_BotLibShutdown(void)
 	LibVarDeAllocAll();
 	//remove all global defines from the pre compiler
 	PC_RemoveAllGlobalDefines();
+	//free all sources kept precompiled
+	PC_FreeSourceCache();
 
 	//dump all allocated memory
 //	DumpMemory();
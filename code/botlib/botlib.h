@@ -484,6 +484,10 @@ name:						default:			module(s):			description:
 
 "max_aaslinks"				"4096"				be_aas_sample.c		maximum links in the AAS
 "max_routingcache"			"4096"				be_aas_route.c		maximum routing cache size in KB
+"routetable"				"1"					be_aas_route.c		use the precomputed route table if available
+"routingcachestats"			"0"					be_aas_main.c		print routing cache statistics every frame
+"routecachewarmup"			"0"					be_aas_main.c		seconds of routing before the routing cache is saved, 0 = never
+"saveroutetable"			"0"					be_aas_main.c		build and save the route table
 "forceclustering"			"0"					be_aas_main.c		force recalculation of clusters
 "forcereachability"			"0"					be_aas_main.c		force recalculation of reachabilities
 "forcewrite"				"0"					be_aas_main.c		force writing of aas file
@@ -60,6 +60,7 @@ typedef enum {qfalse, qtrue}	qboolean;
 #include "l_script.h"
 #include "l_precomp.h"
 #include "l_log.h"
+#include "l_libvar.h"
 #endif //BOTLIB
 
 #ifdef MEQCC
@@ -118,6 +119,71 @@ token_t *freetokens;					//free tokens from the heap
 
 //list with global defines added to every source loaded
 define_t *globaldefines;
+//changed whenever the global defines change
+int globaldefinesgen;
+
+#define SOURCESTRINGHASHSIZE	1024
+
+//token of a precompiled source
+typedef struct cachedtoken_s
+{
+	int string;							//offset of the token string
+	int type;							//token type
+	int subtype;						//token sub type
+#ifdef NUMBERVALUE
+	unsigned long int intvalue;			//integer value
+	float floatvalue;					//floating point value
+#endif //NUMBERVALUE
+	int line;							//line the token was on
+	int linescrossed;					//lines crossed in white space
+	int filename;						//offset of the name of the script read from
+	int scriptline;						//line of the script after reading the token
+} cachedtoken_t;
+
+//source file read once with all the tokens stored
+typedef struct cachedsource_s
+{
+	char filename[MAX_PATH];			//file name of the source
+	char basefolder[MAX_PATH];			//base folder the source was loaded from
+	int definesgen;						//global defines the source was read with
+	int numtokens;						//number of tokens
+	cachedtoken_t *tokens;				//the tokens
+	char *strings;						//interned token strings
+	struct cachedsource_s *next;		//next precompiled source
+} cachedsource_t;
+
+//precompiled sources
+cachedsource_t *sourcecache;
+//base folder set with PC_SetBaseFolder
+char sourcebasefolder[MAX_PATH];
+
+//============================================================================
+//
+// Parameter:				-
+// Returns:					-
+// Changes Globals:		-
+//============================================================================
+void PC_SourcePosition(source_t *source, char **filename, int *line)
+{
+	cachedtoken_t *ct;
+
+	if (source->cachedsource)
+	{
+		*filename = source->filename;
+		*line = 0;
+		if (source->cachedtoken > 0)
+		{
+			ct = &source->cachedsource->tokens[source->cachedtoken-1];
+			*filename = source->cachedsource->strings + ct->filename;
+			*line = ct->scriptline;
+		} //end if
+	} //end if
+	else
+	{
+		*filename = source->scriptstack->filename;
+		*line = source->scriptstack->line;
+	} //end else
+} //end of the function PC_SourcePosition
 
 //============================================================================
 //
@@ -127,20 +193,22 @@ define_t *globaldefines;
 //============================================================================
 void QDECL SourceError(source_t *source, char *str, ...)
 {
-	char text[1024];
+	char text[1024], *filename;
+	int line;
 	va_list ap;
 
 	va_start(ap, str);
 	Q_vsnprintf(text, sizeof(text), str, ap);
 	va_end(ap);
+	PC_SourcePosition(source, &filename, &line);
 #ifdef BOTLIB
-	botimport.Print(PRT_ERROR, "file %s, line %d: %s\n", source->scriptstack->filename, source->scriptstack->line, text);
+	botimport.Print(PRT_ERROR, "file %s, line %d: %s\n", filename, line, text);
 #endif	//BOTLIB
 #ifdef MEQCC
-	printf("error: file %s, line %d: %s\n", source->scriptstack->filename, source->scriptstack->line, text);
+	printf("error: file %s, line %d: %s\n", filename, line, text);
 #endif //MEQCC
 #ifdef BSPC
-	Log_Print("error: file %s, line %d: %s\n", source->scriptstack->filename, source->scriptstack->line, text);
+	Log_Print("error: file %s, line %d: %s\n", filename, line, text);
 #endif //BSPC
 } //end of the function SourceError
 //===========================================================================
@@ -151,20 +219,22 @@ void QDECL SourceError(source_t *source, char *str, ...)
 //===========================================================================
 void QDECL SourceWarning(source_t *source, char *str, ...)
 {
-	char text[1024];
+	char text[1024], *filename;
+	int line;
 	va_list ap;
 
 	va_start(ap, str);
 	Q_vsnprintf(text, sizeof(text), str, ap);
 	va_end(ap);
+	PC_SourcePosition(source, &filename, &line);
 #ifdef BOTLIB
-	botimport.Print(PRT_WARNING, "file %s, line %d: %s\n", source->scriptstack->filename, source->scriptstack->line, text);
+	botimport.Print(PRT_WARNING, "file %s, line %d: %s\n", filename, line, text);
 #endif //BOTLIB
 #ifdef MEQCC
-	printf("warning: file %s, line %d: %s\n", source->scriptstack->filename, source->scriptstack->line, text);
+	printf("warning: file %s, line %d: %s\n", filename, line, text);
 #endif //MEQCC
 #ifdef BSPC
-	Log_Print("warning: file %s, line %d: %s\n", source->scriptstack->filename, source->scriptstack->line, text);
+	Log_Print("warning: file %s, line %d: %s\n", filename, line, text);
 #endif //BSPC
 } //end of the function ScriptWarning
 //============================================================================
@@ -1404,6 +1474,7 @@ int PC_AddGlobalDefine(char *string)
 	if (!define) return qfalse;
 	define->next = globaldefines;
 	globaldefines = define;
+	globaldefinesgen++;
 	return qtrue;
 } //end of the function PC_AddGlobalDefine
 //============================================================================
@@ -1421,6 +1492,7 @@ int PC_RemoveGlobalDefine(char *name)
 	if (define)
 	{
 		PC_FreeDefine(define);
+		globaldefinesgen++;
 		return qtrue;
 	} //end if
 	return qfalse;
@@ -1441,6 +1513,7 @@ void PC_RemoveAllGlobalDefines(void)
 		globaldefines = globaldefines->next;
 		PC_FreeDefine(define);
 	} //end for
+	globaldefinesgen++;
 } //end of the function PC_RemoveAllGlobalDefines
 //============================================================================
 //
@@ -2704,6 +2777,56 @@ int QuakeCMacro(source_t *source)
 } //end of the function QuakeCMacro
 #endif //QUAKEC
 //============================================================================
+// precompiled tokens are already expanded and concatenated
+//
+// Parameter:				-
+// Returns:					-
+// Changes Globals:		-
+//============================================================================
+int PC_ReadCachedToken(source_t *source, token_t *token)
+{
+	cachedsource_t *cs;
+	cachedtoken_t *ct;
+
+	//first read the tokens that were read back
+	if (source->tokens)
+	{
+		PC_ReadSourceToken(source, token);
+	} //end if
+	else
+	{
+		cs = source->cachedsource;
+		if (source->cachedtoken >= cs->numtokens)
+		{
+			//no token left, leave an empty token
+			token->string[0] = 0;
+			token->type = 0;
+			token->subtype = 0;
+#ifdef NUMBERVALUE
+			token->intvalue = 0;
+			token->floatvalue = 0;
+#endif //NUMBERVALUE
+			return qfalse;
+		} //end if
+		ct = &cs->tokens[source->cachedtoken++];
+		strcpy(token->string, cs->strings + ct->string);
+		token->type = ct->type;
+		token->subtype = ct->subtype;
+#ifdef NUMBERVALUE
+		token->intvalue = ct->intvalue;
+		token->floatvalue = ct->floatvalue;
+#endif //NUMBERVALUE
+		token->whitespace_p = NULL;
+		token->endwhitespace_p = NULL;
+		token->line = ct->line;
+		token->linescrossed = ct->linescrossed;
+		token->next = NULL;
+	} //end else
+	//copy token for unreading
+	Com_Memcpy(&source->token, token, sizeof(token_t));
+	return qtrue;
+} //end of the function PC_ReadCachedToken
+//============================================================================
 //
 // Parameter:				-
 // Returns:					-
@@ -2713,6 +2836,7 @@ int PC_ReadToken(source_t *source, token_t *token)
 {
 	define_t *define;
 
+	if (source->cachedsource) return PC_ReadCachedToken(source, token);
 	while(1)
 	{
 		if (!PC_ReadSourceToken(source, token)) return qfalse;
@@ -3049,6 +3173,181 @@ source_t *LoadSourceMemory(char *ptr, int length, char *name)
 	return source;
 } //end of the function LoadSourceMemory
 //============================================================================
+// returns the offset of the string in the string block, equal strings that
+// hash to the same slot share their storage
+//
+// Parameter:			-
+// Returns:				-
+// Changes Globals:		-
+//============================================================================
+int PC_InternSourceString(char *string, char **strings, int *stringsize,
+									int *maxstringsize, int *stringhash)
+{
+	int hash, len, offset;
+	char *newstrings;
+
+	hash = PC_NameHash(string) & (SOURCESTRINGHASHSIZE-1);
+	offset = stringhash[hash];
+	if (offset >= 0 && !strcmp(*strings + offset, string)) return offset;
+	//
+	len = strlen(string) + 1;
+	if (*stringsize + len > *maxstringsize)
+	{
+		while(*stringsize + len > *maxstringsize) *maxstringsize *= 2;
+		newstrings = (char *) GetMemory(*maxstringsize);
+		Com_Memcpy(newstrings, *strings, *stringsize);
+		FreeMemory(*strings);
+		*strings = newstrings;
+	} //end if
+	offset = *stringsize;
+	Com_Memcpy(*strings + offset, string, len);
+	*stringsize += len;
+	stringhash[hash] = offset;
+	return offset;
+} //end of the function PC_InternSourceString
+//============================================================================
+// reads all tokens from the source file as PC_ReadToken returns them,
+// precompiler errors are printed once and the tokens read before the
+// error are kept
+//
+// Parameter:			-
+// Returns:				-
+// Changes Globals:		-
+//============================================================================
+cachedsource_t *PC_PrecompileSource(const char *filename)
+{
+	int i, numtokens, maxtokens, stringsize, maxstringsize;
+	int stringhash[SOURCESTRINGHASHSIZE];
+	char *strings;
+	cachedtoken_t *tokens, *newtokens, *ct;
+	cachedsource_t *cs;
+	source_t *source;
+	token_t token;
+#ifdef BOTLIB
+	int starttime;
+
+	starttime = Sys_MilliSeconds();
+#endif //BOTLIB
+
+	source = LoadSourceFile(filename);
+	if (!source) return NULL;
+	//
+	numtokens = 0;
+	maxtokens = 256;
+	tokens = (cachedtoken_t *) GetMemory(maxtokens * sizeof(cachedtoken_t));
+	stringsize = 0;
+	maxstringsize = 4096;
+	strings = (char *) GetMemory(maxstringsize);
+	for (i = 0; i < SOURCESTRINGHASHSIZE; i++) stringhash[i] = -1;
+	//
+	while(PC_ReadToken(source, &token))
+	{
+		if (numtokens >= maxtokens)
+		{
+			maxtokens *= 2;
+			newtokens = (cachedtoken_t *) GetMemory(maxtokens * sizeof(cachedtoken_t));
+			Com_Memcpy(newtokens, tokens, numtokens * sizeof(cachedtoken_t));
+			FreeMemory(tokens);
+			tokens = newtokens;
+		} //end if
+		ct = &tokens[numtokens++];
+		ct->string = PC_InternSourceString(token.string, &strings, &stringsize, &maxstringsize, stringhash);
+		ct->type = token.type;
+		ct->subtype = token.subtype;
+#ifdef NUMBERVALUE
+		ct->intvalue = token.intvalue;
+		ct->floatvalue = token.floatvalue;
+#endif //NUMBERVALUE
+		ct->line = token.line;
+		ct->linescrossed = token.linescrossed;
+		//remember where the script was for errors and warnings
+		ct->filename = PC_InternSourceString(source->scriptstack->filename, &strings, &stringsize, &maxstringsize, stringhash);
+		ct->scriptline = source->scriptstack->line;
+	} //end while
+	FreeSource(source);
+	//store the tokens and strings in one block
+	cs = (cachedsource_t *) GetMemory(sizeof(cachedsource_t) +
+					numtokens * sizeof(cachedtoken_t) + stringsize);
+	Com_Memset(cs, 0, sizeof(cachedsource_t));
+	Q_strncpyz(cs->filename, filename, sizeof(cs->filename));
+	Q_strncpyz(cs->basefolder, sourcebasefolder, sizeof(cs->basefolder));
+	cs->definesgen = globaldefinesgen;
+	cs->numtokens = numtokens;
+	cs->tokens = (cachedtoken_t *) (cs + 1);
+	cs->strings = (char *) (cs->tokens + numtokens);
+	Com_Memcpy(cs->tokens, tokens, numtokens * sizeof(cachedtoken_t));
+	Com_Memcpy(cs->strings, strings, stringsize);
+	FreeMemory(tokens);
+	FreeMemory(strings);
+#ifdef BOTLIB
+	if (botDeveloper)
+	{
+		botimport.Print(PRT_MESSAGE, "precompiled %s, %d tokens, %d bytes of strings in %d msec\n",
+							filename, numtokens, stringsize, Sys_MilliSeconds() - starttime);
+	} //end if
+#endif //BOTLIB
+	return cs;
+} //end of the function PC_PrecompileSource
+//============================================================================
+//
+// Parameter:			-
+// Returns:				-
+// Changes Globals:		-
+//============================================================================
+source_t *LoadCachedSourceFile(const char *filename)
+{
+	cachedsource_t *cs, **prev;
+	source_t *source;
+
+#ifdef BOTLIB
+	//always read the file from disk when reloading the bot files
+	if (LibVarGetValue("bot_reloadcharacters")) return LoadSourceFile(filename);
+#endif //BOTLIB
+	//find the precompiled source
+	for (prev = &sourcecache, cs = sourcecache; cs; prev = &cs->next, cs = cs->next)
+	{
+		if (!Q_stricmp(cs->filename, filename) &&
+			!Q_stricmp(cs->basefolder, sourcebasefolder)) break;
+	} //end for
+	//remove the precompiled source if the global defines changed
+	if (cs && cs->definesgen != globaldefinesgen)
+	{
+		*prev = cs->next;
+		FreeMemory(cs);
+		cs = NULL;
+	} //end if
+	if (!cs)
+	{
+		cs = PC_PrecompileSource(filename);
+		if (!cs) return NULL;
+		cs->next = sourcecache;
+		sourcecache = cs;
+	} //end if
+	//
+	source = (source_t *) GetMemory(sizeof(source_t));
+	Com_Memset(source, 0, sizeof(source_t));
+	strncpy(source->filename, filename, MAX_PATH);
+	source->cachedsource = cs;
+	source->cachedtoken = 0;
+	return source;
+} //end of the function LoadCachedSourceFile
+//============================================================================
+//
+// Parameter:			-
+// Returns:				-
+// Changes Globals:		-
+//============================================================================
+void PC_FreeSourceCache(void)
+{
+	cachedsource_t *cs;
+
+	for (cs = sourcecache; cs; cs = sourcecache)
+	{
+		sourcecache = sourcecache->next;
+		FreeMemory(cs);
+	} //end for
+} //end of the function PC_FreeSourceCache
+//============================================================================
 //
 // Parameter:				-
 // Returns:					-
@@ -3078,7 +3377,7 @@ void FreeSource(source_t *source)
 		PC_FreeToken(token);
 	} //end for
 #if DEFINEHASHING
-	for (i = 0; i < DEFINEHASHSIZE; i++)
+	for (i = 0; source->definehash && i < DEFINEHASHSIZE; i++)
 	{
 		while(source->definehash[i])
 		{
@@ -3212,6 +3511,7 @@ int PC_SourceFileAndLine(int handle, char *filename, int *line)
 void PC_SetBaseFolder(char *path)
 {
 	PS_SetBaseFolder(path);
+	Q_strncpyz(sourcebasefolder, path, sizeof(sourcebasefolder));
 } //end of the function PC_SetBaseFolder
 //============================================================================
 //
@@ -104,6 +104,8 @@ typedef struct source_s
 	indent_t *indentstack;					//stack with indents
 	int skip;								// > 0 if skipping conditional code
 	token_t token;							//last read token
+	struct cachedsource_s *cachedsource;	//precompiled tokens to read from
+	int cachedtoken;						//next precompiled token to read
 } source_t;
 
 
@@ -149,6 +151,10 @@ void PC_SetBaseFolder(char *path);
 source_t *LoadSourceFile(const char *filename);
 //load a source from memory
 source_t *LoadSourceMemory(char *ptr, int length, char *name);
+//load a source file precompiled once and kept in the source cache
+source_t *LoadCachedSourceFile(const char *filename);
+//free all precompiled sources in the source cache
+void PC_FreeSourceCache(void);
 //free the given source
 void FreeSource(source_t *source);
 //print a source error
@@ -418,6 +418,7 @@ int BotChat_EnterGame(bot_state_t *bs) {
 	float rnd;
 
 	if (bot_nochat.integer) return qfalse;
+	if (bs->thinkdeferred) return qfalse;
 	if (bs->lastchat_time > FloatTime() - TIME_BETWEENCHATTING) return qfalse;
 	//don't chat in teamplay
 	if (TeamPlayIsOn()) return qfalse;
@@ -451,6 +452,7 @@ int BotChat_ExitGame(bot_state_t *bs) {
 	float rnd;
 
 	if (bot_nochat.integer) return qfalse;
+	if (bs->thinkdeferred) return qfalse;
 	if (bs->lastchat_time > FloatTime() - TIME_BETWEENCHATTING) return qfalse;
 	//don't chat in teamplay
 	if (TeamPlayIsOn()) return qfalse;
@@ -484,6 +486,7 @@ int BotChat_StartLevel(bot_state_t *bs) {
 	float rnd;
 
 	if (bot_nochat.integer) return qfalse;
+	if (bs->thinkdeferred) return qfalse;
 	if (BotIsObserver(bs)) return qfalse;
 	if (bs->lastchat_time > FloatTime() - TIME_BETWEENCHATTING) return qfalse;
 	//don't chat in teamplay
@@ -518,6 +521,7 @@ int BotChat_EndLevel(bot_state_t *bs) {
 	float rnd;
 
 	if (bot_nochat.integer) return qfalse;
+	if (bs->thinkdeferred) return qfalse;
 	if (BotIsObserver(bs)) return qfalse;
 	if (bs->lastchat_time > FloatTime() - TIME_BETWEENCHATTING) return qfalse;
 	// teamplay
@@ -580,6 +584,7 @@ int BotChat_Death(bot_state_t *bs) {
 	float rnd;
 
 	if (bot_nochat.integer) return qfalse;
+	if (bs->thinkdeferred) return qfalse;
 	if (bs->lastchat_time > FloatTime() - TIME_BETWEENCHATTING) return qfalse;
 	rnd = trap_Characteristic_BFloat(bs->character, CHARACTERISTIC_CHAT_DEATH, 0, 1);
 	// don't chat in tournament mode
@@ -683,6 +688,7 @@ int BotChat_Kill(bot_state_t *bs) {
 	float rnd;
 
 	if (bot_nochat.integer) return qfalse;
+	if (bs->thinkdeferred) return qfalse;
 	if (bs->lastchat_time > FloatTime() - TIME_BETWEENCHATTING) return qfalse;
 	rnd = trap_Characteristic_BFloat(bs->character, CHARACTERISTIC_CHAT_KILL, 0, 1);
 	// don't chat in tournament mode
@@ -749,6 +755,7 @@ int BotChat_EnemySuicide(bot_state_t *bs) {
 	float rnd;
 
 	if (bot_nochat.integer) return qfalse;
+	if (bs->thinkdeferred) return qfalse;
 	if (bs->lastchat_time > FloatTime() - TIME_BETWEENCHATTING) return qfalse;
 	if (BotNumActivePlayers() <= 1) return qfalse;
 	//
@@ -784,6 +791,7 @@ int BotChat_HitTalking(bot_state_t *bs) {
 	float rnd;
 
 	if (bot_nochat.integer) return qfalse;
+	if (bs->thinkdeferred) return qfalse;
 	if (bs->lastchat_time > FloatTime() - TIME_BETWEENCHATTING) return qfalse;
 	if (BotNumActivePlayers() <= 1) return qfalse;
 	lasthurt_client = g_entities[bs->client].client->lasthurt_client;
@@ -830,6 +838,7 @@ int BotChat_HitNoDeath(bot_state_t *bs) {
 	if (lasthurt_client < 0 || lasthurt_client >= MAX_CLIENTS) return qfalse;
 	//
 	if (bot_nochat.integer) return qfalse;
+	if (bs->thinkdeferred) return qfalse;
 	if (bs->lastchat_time > FloatTime() - TIME_BETWEENCHATTING) return qfalse;
 	if (BotNumActivePlayers() <= 1) return qfalse;
 	rnd = trap_Characteristic_BFloat(bs->character, CHARACTERISTIC_CHAT_HITNODEATH, 0, 1);
@@ -868,6 +877,7 @@ int BotChat_HitNoKill(bot_state_t *bs) {
 	aas_entityinfo_t entinfo;
 
 	if (bot_nochat.integer) return qfalse;
+	if (bs->thinkdeferred) return qfalse;
 	if (bs->lastchat_time > FloatTime() - TIME_BETWEENCHATTING) return qfalse;
 	if (BotNumActivePlayers() <= 1) return qfalse;
 	rnd = trap_Characteristic_BFloat(bs->character, CHARACTERISTIC_CHAT_HITNOKILL, 0, 1);
@@ -905,6 +915,7 @@ int BotChat_Random(bot_state_t *bs) {
 	char name[32];
 
 	if (bot_nochat.integer) return qfalse;
+	if (bs->thinkdeferred) return qfalse;
 	if (BotIsObserver(bs)) return qfalse;
 	if (bs->lastchat_time > FloatTime() - TIME_BETWEENCHATTING) return qfalse;
 	// don't chat in tournament mode
@@ -290,8 +290,9 @@ int BotGetItemLongTermGoal(bot_state_t *bs, int tfl, bot_goal_t *goal) {
 		BotChooseWeapon(bs);
 		bs->ltg_time = 0;
 	}
-	//if it is time to find a new long term goal
-	if (bs->ltg_time < FloatTime()) {
+	//if it is time to find a new long term goal, an expired goal is kept
+	//while the bot is over the think budget
+	if (bs->ltg_time < FloatTime() && !(bs->ltg_time && bs->thinkdeferred)) {
 		//pop the current goal from the stack
 		trap_BotPopGoal(bs->gs);
 		//BotAI_Print(PRT_MESSAGE, "%s: choosing new ltg\n", ClientName(bs->client, netname, sizeof(netname)));
@@ -1868,8 +1869,8 @@ int AINode_Seek_LTG(bot_state_t *bs)
 	if (!BotLongTermGoal(bs, bs->tfl, qfalse, &goal)) {
 		return qtrue;
 	}
-	//check for nearby goals periodicly
-	if (bs->check_time < FloatTime()) {
+	//check for nearby goals periodicly, not while over the think budget
+	if (bs->check_time < FloatTime() && !bs->thinkdeferred) {
 		bs->check_time = FloatTime() + 0.5;
 		//check if the bot wants to camp
 		BotWantsToCamp(bs);
@@ -2820,6 +2820,40 @@ qboolean InFieldOfVision(vec3_t viewangles, float fov, vec3_t angles)
 	return qtrue;
 }
 
+/*
+==================
+BotEntitySightLine
+
+sets up the line of sight trace from the eye to the given point of the entity,
+returns the contents mask of the trace
+==================
+*/
+int BotEntitySightLine(int viewer, vec3_t eye, int ent, vec3_t point, int inwater,
+						vec3_t start, vec3_t end, int *passent, int *hitent) {
+	int contents_mask;
+
+	contents_mask = CONTENTS_SOLID|CONTENTS_PLAYERCLIP;
+	*passent = viewer;
+	*hitent = ent;
+	VectorCopy(eye, start);
+	VectorCopy(point, end);
+	//if the entity is in water, lava or slime
+	if (trap_AAS_PointContents(point) & (CONTENTS_LAVA|CONTENTS_SLIME|CONTENTS_WATER)) {
+		contents_mask |= (CONTENTS_LAVA|CONTENTS_SLIME|CONTENTS_WATER);
+	}
+	//if eye is in water, lava or slime
+	if (inwater) {
+		if (!(contents_mask & (CONTENTS_LAVA|CONTENTS_SLIME|CONTENTS_WATER))) {
+			*passent = ent;
+			*hitent = viewer;
+			VectorCopy(point, start);
+			VectorCopy(eye, end);
+		}
+		contents_mask ^= (CONTENTS_LAVA|CONTENTS_SLIME|CONTENTS_WATER);
+	}
+	return contents_mask;
+}
+
 /*
 ==================
 BotEntityVisible
@@ -2828,6 +2862,18 @@ returns visibility in the range [0, 1] taking fog and water surfaces into accoun
 ==================
 */
 float BotEntityVisible(int viewer, vec3_t eye, vec3_t viewangles, float fov, int ent) {
+	return BotEntityVisibleWithTrace(viewer, eye, viewangles, fov, ent, NULL);
+}
+
+/*
+==================
+BotEntityVisibleWithTrace
+
+same as BotEntityVisible but uses the given trace for the first line of sight,
+to the middle of the entity, when it is not NULL
+==================
+*/
+float BotEntityVisibleWithTrace(int viewer, vec3_t eye, vec3_t viewangles, float fov, int ent, bsp_trace_t *firsttrace) {
 	int i, contents_mask, passent, hitent, infog, inwater, otherinfog, pc;
 	float squaredfogdist, waterfactor, vis, bestvis;
 	bsp_trace_t trace;
@@ -2853,27 +2899,14 @@ float BotEntityVisible(int viewer, vec3_t eye, vec3_t viewangles, float fov, int
 		//if the point is not in potential visible sight
 		//if (!AAS_inPVS(eye, middle)) continue;
 		//
-		contents_mask = CONTENTS_SOLID|CONTENTS_PLAYERCLIP;
-		passent = viewer;
-		hitent = ent;
-		VectorCopy(eye, start);
-		VectorCopy(middle, end);
-		//if the entity is in water, lava or slime
-		if (trap_AAS_PointContents(middle) & (CONTENTS_LAVA|CONTENTS_SLIME|CONTENTS_WATER)) {
-			contents_mask |= (CONTENTS_LAVA|CONTENTS_SLIME|CONTENTS_WATER);
-		}
-		//if eye is in water, lava or slime
-		if (inwater) {
-			if (!(contents_mask & (CONTENTS_LAVA|CONTENTS_SLIME|CONTENTS_WATER))) {
-				passent = ent;
-				hitent = viewer;
-				VectorCopy(middle, start);
-				VectorCopy(eye, end);
-			}
-			contents_mask ^= (CONTENTS_LAVA|CONTENTS_SLIME|CONTENTS_WATER);
-		}
+		contents_mask = BotEntitySightLine(viewer, eye, ent, middle, inwater, start, end, &passent, &hitent);
 		//trace from start to end
-		BotAI_Trace(&trace, start, NULL, NULL, end, passent, contents_mask);
+		if (i == 0 && firsttrace) {
+			trace = *firsttrace;
+		}
+		else {
+			BotAI_Trace(&trace, start, NULL, NULL, end, passent, contents_mask);
+		}
 		//if water was hit
 		waterfactor = 1.0;
 		if (trace.contents & (CONTENTS_LAVA|CONTENTS_SLIME|CONTENTS_WATER)) {
@@ -2932,11 +2965,16 @@ BotFindEnemy
 ==================
 */
 int BotFindEnemy(bot_state_t *bs, int curenemy) {
-	int i, healthdecrease;
+	int i, j, healthdecrease, inwater, hitent, numcandidates;
+	int candidates[MAX_CLIENTS];
 	float f, alertness, easyfragger, vis;
 	float squaredist, cursquaredist;
+	float candidatefov[MAX_CLIENTS];
+	static traceRequest_t requests[MAX_CLIENTS];
+	static bsp_trace_t traces[MAX_CLIENTS];
+	traceRequest_t *req;
 	aas_entityinfo_t entinfo, curenemyinfo;
-	vec3_t dir, angles;
+	vec3_t dir, angles, middle;
 
 	alertness = trap_Characteristic_BFloat(bs->character, CHARACTERISTIC_ALERTNESS, 0, 1);
 	easyfragger = trap_Characteristic_BFloat(bs->character, CHARACTERISTIC_EASY_FRAGGER, 0, 1);
@@ -2981,7 +3019,9 @@ int BotFindEnemy(bot_state_t *bs, int curenemy) {
 		}
 	}
 #endif
-	//
+	//gather the clients that could become the enemy and are in the field of vision
+	numcandidates = 0;
+	inwater = trap_AAS_PointContents(bs->eye) & (CONTENTS_LAVA|CONTENTS_SLIME|CONTENTS_WATER);
 	for (i = 0; i < maxclients && i < MAX_CLIENTS; i++) {
 
 		if (i == bs->client) continue;
@@ -3022,8 +3062,36 @@ int BotFindEnemy(bot_state_t *bs, int curenemy) {
 			f = 360;
 		else
 			f = 90 + 90 - (90 - (squaredist > Square(810) ? Square(810) : squaredist) / (810 * 9));
+		//if not in the field of vision, the same check as BotEntityVisible
+		VectorAdd(entinfo.mins, entinfo.maxs, middle);
+		VectorScale(middle, 0.5, middle);
+		VectorAdd(entinfo.origin, middle, middle);
+		VectorSubtract(middle, bs->eye, dir);
+		vectoangles(dir, angles);
+		if (!InFieldOfVision(bs->viewangles, f, angles)) continue;
+		//the first line of sight BotEntityVisible traces
+		req = &requests[numcandidates];
+		req->contentmask = BotEntitySightLine(bs->entitynum, bs->eye, i, middle, inwater,
+											req->start, req->end, &req->passEntityNum, &hitent);
+		VectorClear(req->mins);
+		VectorClear(req->maxs);
+		req->capsule = qfalse;
+		candidates[numcandidates] = i;
+		candidatefov[numcandidates] = f;
+		numcandidates++;
+	}
+	//trace the lines of sight of all candidates at once
+	if (numcandidates) {
+		BotAI_TraceBatch(traces, requests, numcandidates);
+	}
+	//
+	for (j = 0; j < numcandidates; j++) {
+		i = candidates[j];
+		BotEntityInfo(i, &entinfo);
+		VectorSubtract(entinfo.origin, bs->origin, dir);
+		squaredist = VectorLengthSquared(dir);
 		//check if the enemy is visible
-		vis = BotEntityVisible(bs->entitynum, bs->eye, bs->viewangles, f, i);
+		vis = BotEntityVisibleWithTrace(bs->entitynum, bs->eye, bs->viewangles, candidatefov[j], i, &traces[j]);
 		if (vis <= 0) continue;
 		//if the enemy is quite far away, not shooting and the bot is not damaged
 		if (curenemy < 0 && squaredist > Square(100) && !healthdecrease && !EntityIsShooting(&entinfo))
@@ -5260,19 +5328,22 @@ void BotDeathmatchAI(bot_state_t *bs, float thinktime) {
 		//check for air
 		BotCheckAir(bs);
 	}
-	//check the console messages
-	BotCheckConsoleMessages(bs);
-	//if not in the intermission and not in observer mode
-	if (!BotIntermission(bs) && !BotIsObserver(bs)) {
-		//do team AI
-		BotTeamAI(bs);
+	//the console messages and team AI wait for a think within the frame budget
+	if (!bs->thinkdeferred) {
+		//check the console messages
+		BotCheckConsoleMessages(bs);
+		//if not in the intermission and not in observer mode
+		if (!BotIntermission(bs) && !BotIsObserver(bs)) {
+			//do team AI
+			BotTeamAI(bs);
+		}
 	}
 	//if the bot has no ai node
 	if (!bs->ainode) {
 		AIEnter_Seek_LTG(bs, "BotDeathmatchAI: no ai node");
 	}
 	//if the bot entered the game less than 8 seconds ago
-	if (!bs->entergamechat && bs->entergame_time > FloatTime() - 8) {
+	if (!bs->entergamechat && !bs->thinkdeferred && bs->entergame_time > FloatTime() - 8) {
 		if (BotChat_EnterGame(bs)) {
 			bs->stand_time = FloatTime() + BotChatTime(bs);
 			AIEnter_Stand(bs, "BotDeathmatchAI: chat enter game");
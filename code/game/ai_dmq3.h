@@ -120,6 +120,10 @@ int BotFindEnemy(bot_state_t *bs, int curenemy);
 void BotRoamGoal(bot_state_t *bs, vec3_t goal);
 //returns entity visibility in the range [0, 1]
 float BotEntityVisible(int viewer, vec3_t eye, vec3_t viewangles, float fov, int ent);
+float BotEntityVisibleWithTrace(int viewer, vec3_t eye, vec3_t viewangles, float fov, int ent, bsp_trace_t *firsttrace);
+//sets up the line of sight trace to the given point of the entity, returns the contents mask
+int BotEntitySightLine(int viewer, vec3_t eye, int ent, vec3_t point, int inwater,
+						vec3_t start, vec3_t end, int *passent, int *hitent);
 //the bot will aim at the current enemy
 void BotAimAtEnemy(bot_state_t *bs);
 //check if the bot should attack
@@ -72,9 +72,16 @@ float regularupdate_time;
 int bot_interbreed;
 int bot_interbreedmatchcount;
 //
+//last bot_routingcachestats change passed to the bot library
+int routingcachestatsmodified;
+//
 vmCvar_t bot_thinktime;
+vmCvar_t bot_thinkbudget;
+vmCvar_t bot_thinkreport;
 vmCvar_t bot_memorydump;
 vmCvar_t bot_saveroutingcache;
+vmCvar_t bot_saveroutetable;
+vmCvar_t bot_routingcachestats;
 vmCvar_t bot_pause;
 vmCvar_t bot_report;
 vmCvar_t bot_testsolid;
@@ -131,6 +138,27 @@ void QDECL BotAI_Print(int type, char *fmt, ...) {
 }
 
 
+/*
+==================
+BotAI_CopyTrace
+==================
+*/
+static void BotAI_CopyTrace(bsp_trace_t *bsptrace, trace_t *trace) {
+	bsptrace->allsolid = trace->allsolid;
+	bsptrace->startsolid = trace->startsolid;
+	bsptrace->fraction = trace->fraction;
+	VectorCopy(trace->endpos, bsptrace->endpos);
+	bsptrace->plane.dist = trace->plane.dist;
+	VectorCopy(trace->plane.normal, bsptrace->plane.normal);
+	bsptrace->plane.signbits = trace->plane.signbits;
+	bsptrace->plane.type = trace->plane.type;
+	bsptrace->surface.value = trace->surfaceFlags;
+	bsptrace->ent = trace->entityNum;
+	bsptrace->exp_dist = 0;
+	bsptrace->sidenum = 0;
+	bsptrace->contents = 0;
+}
+
 /*
 ==================
 BotAI_Trace
@@ -141,19 +169,47 @@ void BotAI_Trace(bsp_trace_t *bsptrace, vec3_t start, vec3_t mins, vec3_t maxs,
 
 	trap_Trace(&trace, start, mins, maxs, end, passent, contentmask);
 	//copy the trace information
-	bsptrace->allsolid = trace.allsolid;
-	bsptrace->startsolid = trace.startsolid;
-	bsptrace->fraction = trace.fraction;
-	VectorCopy(trace.endpos, bsptrace->endpos);
-	bsptrace->plane.dist = trace.plane.dist;
-	VectorCopy(trace.plane.normal, bsptrace->plane.normal);
-	bsptrace->plane.signbits = trace.plane.signbits;
-	bsptrace->plane.type = trace.plane.type;
-	bsptrace->surface.value = trace.surfaceFlags;
-	bsptrace->ent = trace.entityNum;
-	bsptrace->exp_dist = 0;
-	bsptrace->sidenum = 0;
-	bsptrace->contents = 0;
+	BotAI_CopyTrace(bsptrace, &trace);
+}
+
+/*
+==================
+BotAI_TraceBatch
+
+traces all requests with one system call, the server can spread
+them over its trace threads
+==================
+*/
+void BotAI_TraceBatch(bsp_trace_t *bsptraces, traceRequest_t *requests, int numrequests) {
+	static trace_t traces[MAX_TRACE_BATCH];
+	int i, num;
+
+	//older engines don't have the batched traces
+	if (!level.batchTraps) {
+		for (i = 0; i < numrequests; i++) {
+			if (requests[i].capsule) {
+				trap_TraceCapsule(&traces[0], requests[i].start, requests[i].mins, requests[i].maxs,
+									requests[i].end, requests[i].passEntityNum, requests[i].contentmask);
+			}
+			else {
+				trap_Trace(&traces[0], requests[i].start, requests[i].mins, requests[i].maxs,
+									requests[i].end, requests[i].passEntityNum, requests[i].contentmask);
+			}
+			BotAI_CopyTrace(&bsptraces[i], &traces[0]);
+		}
+		return;
+	}
+
+	for (; numrequests > 0; numrequests -= num) {
+		num = numrequests > MAX_TRACE_BATCH ? MAX_TRACE_BATCH : numrequests;
+		trap_TraceBatch(traces, requests, num);
+		//copy the trace information
+		for (i = 0; i < num; i++) {
+			BotAI_CopyTrace(&bsptraces[i], &traces[i]);
+		}
+		bsptraces += num;
+		requests += num;
+	}
 }
 
 /*
@@ -1086,6 +1142,52 @@ void BotScheduleBotThink(void) {
 	}
 }
 
+/*
+==================
+BotOrderThinking
+
+the bots that waited longest for a think without deferred AI go first
+so they get the frame budget before the others
+==================
+*/
+void BotOrderThinking(int *thinking, int numthinking) {
+	int i, j, client;
+
+	for (i = 1; i < numthinking; i++) {
+		client = thinking[i];
+		for (j = i; j > 0; j--) {
+			if (botstates[thinking[j-1]]->lastfullthink_time <= botstates[client]->lastfullthink_time) {
+				break;
+			}
+			thinking[j] = thinking[j-1];
+		}
+		thinking[j] = client;
+	}
+}
+
+/*
+==================
+BotThinkReport
+==================
+*/
+void BotThinkReport(void) {
+	int i;
+	char name[32];
+	bot_state_t *bs;
+
+	BotAI_Print(PRT_MESSAGE, "bot think budget %d msec\n", bot_thinkbudget.integer);
+	BotAI_Print(PRT_MESSAGE, "client name             avg msec max msec   thinks deferred\n");
+	for (i = 0; i < MAX_CLIENTS; i++) {
+		bs = botstates[i];
+		if (!bs || !bs->inuse) {
+			continue;
+		}
+		ClientName(i, name, sizeof(name));
+		BotAI_Print(PRT_MESSAGE, "%6d %-16s %8.2f %8d %8d %8d\n", i, name,
+			bs->thinkcost, bs->thinkcostmax, bs->numthinks, bs->numdeferredthinks);
+	}
+}
+
 /*
 ==============
 BotWriteSessionData
@@ -1169,8 +1271,9 @@ BotAISetupClient
 int BotAISetupClient(int client, struct bot_settings_s *settings, qboolean restart) {
 	char filename[MAX_PATH], name[MAX_PATH], gender[MAX_PATH];
 	bot_state_t *bs;
-	int errnum;
+	int errnum, starttime, charactertime, weightstime, endtime;
 
+	starttime = trap_Milliseconds();
 	if (!botstates[client]) botstates[client] = G_Alloc(sizeof(bot_state_t));
 	bs = botstates[client];
 
@@ -1190,6 +1293,7 @@ int BotAISetupClient(int client, struct bot_settings_s *settings, qboolean resta
 		BotAI_Print(PRT_FATAL, "couldn't load skill %f from %s\n", settings->skill, settings->characterfile);
 		return qfalse;
 	}
+	charactertime = trap_Milliseconds();
 	//copy the settings
 	memcpy(&bs->settings, settings, sizeof(bot_settings_t));
 	//allocate a goal state
@@ -1211,6 +1315,7 @@ int BotAISetupClient(int client, struct bot_settings_s *settings, qboolean resta
 		trap_BotFreeWeaponState(bs->ws);
 		return qfalse;
 	}
+	weightstime = trap_Milliseconds();
 	//allocate a chat state
 	bs->cs = trap_BotAllocChatState();
 	//load the chat file
@@ -1253,6 +1358,12 @@ int BotAISetupClient(int client, struct bot_settings_s *settings, qboolean resta
 	if (restart) {
 		BotReadSessionData(bs);
 	}
+	if (bot_developer.integer) {
+		endtime = trap_Milliseconds();
+		BotAI_Print(PRT_MESSAGE, "%s: setup in %d msec (character %d, weights %d, chat and state %d)\n",
+			settings->characterfile, endtime - starttime, charactertime - starttime,
+			weightstime - charactertime, endtime - weightstime);
+	}
 	//bot has been setup succesfully
 	return qtrue;
 }
@@ -1392,10 +1503,13 @@ BotAIStartFrame
 ==================
 */
 int BotAIStartFrame(int time) {
-	int i;
+	int i, j;
 	gentity_t	*ent;
 	bot_entitystate_t state;
 	int elapsed_time, thinktime;
+	int thinking[MAX_CLIENTS], numthinking;
+	int framestart_time, thinkstart_time, cost;
+	bot_state_t *bs;
 	static int local_time;
 	static int botlib_residual;
 	static int lastbotthink_time;
@@ -1408,8 +1522,12 @@ int BotAIStartFrame(int time) {
 	trap_Cvar_Update(&bot_nochat);
 	trap_Cvar_Update(&bot_testrchat);
 	trap_Cvar_Update(&bot_thinktime);
+	trap_Cvar_Update(&bot_thinkbudget);
+	trap_Cvar_Update(&bot_thinkreport);
 	trap_Cvar_Update(&bot_memorydump);
 	trap_Cvar_Update(&bot_saveroutingcache);
+	trap_Cvar_Update(&bot_saveroutetable);
+	trap_Cvar_Update(&bot_routingcachestats);
 	trap_Cvar_Update(&bot_pause);
 	trap_Cvar_Update(&bot_report);
 
@@ -1438,6 +1556,10 @@ int BotAIStartFrame(int time) {
 		return qtrue;
 	}
 
+	if (bot_thinkreport.integer) {
+		BotThinkReport();
+		trap_Cvar_Set("bot_thinkreport", "0");
+	}
 	if (bot_memorydump.integer) {
 		trap_BotLibVarSet("memorydump", "1");
 		trap_Cvar_Set("bot_memorydump", "0");
@@ -1446,6 +1568,14 @@ int BotAIStartFrame(int time) {
 		trap_BotLibVarSet("saveroutingcache", "1");
 		trap_Cvar_Set("bot_saveroutingcache", "0");
 	}
+	if (bot_saveroutetable.integer) {
+		trap_BotLibVarSet("saveroutetable", "1");
+		trap_Cvar_Set("bot_saveroutetable", "0");
+	}
+	if (bot_routingcachestats.modificationCount != routingcachestatsmodified) {
+		trap_BotLibVarSet("routingcachestats", bot_routingcachestats.string);
+		routingcachestatsmodified = bot_routingcachestats.modificationCount;
+	}
 	//check if bot interbreeding is activated
 	BotInterbreeding();
 	//cap the bot think time
@@ -1543,7 +1673,8 @@ int BotAIStartFrame(int time) {
 
 	floattime = trap_AAS_Time();
 
-	// execute scheduled bot AI
+	// find the bots scheduled to think
+	numthinking = 0;
 	for( i = 0; i < MAX_CLIENTS; i++ ) {
 		if( !botstates[i] || !botstates[i]->inuse ) {
 			continue;
@@ -1557,7 +1688,48 @@ int BotAIStartFrame(int time) {
 			if (!trap_AAS_Initialized()) return qfalse;
 
 			if (g_entities[i].client->pers.connected == CON_CONNECTED) {
-				BotAI(i, (float) thinktime / 1000);
+				thinking[numthinking++] = i;
+			}
+		}
+	}
+
+	// execute scheduled bot AI
+	if (bot_thinkbudget.integer > 0) {
+		BotOrderThinking(thinking, numthinking);
+	}
+	framestart_time = trap_Milliseconds();
+	for( j = 0; j < numthinking; j++ ) {
+		i = thinking[j];
+		bs = botstates[i];
+		if( !bs || !bs->inuse ) {
+			continue;
+		}
+		if (g_entities[i].client->pers.connected == CON_CONNECTED) {
+			// defer the non-critical AI of bots that would run over the frame budget,
+			// the first bot of the frame always thinks fully
+			thinkstart_time = trap_Milliseconds();
+			bs->thinkdeferred = j > 0 && bot_thinkbudget.integer > 0 &&
+				thinkstart_time - framestart_time + bs->thinkcost > bot_thinkbudget.integer;
+			BotAI(i, (float) thinktime / 1000);
+			// the bot may have removed itself
+			if (!bs->inuse) {
+				continue;
+			}
+			cost = trap_Milliseconds() - thinkstart_time;
+			if (cost > bs->thinkcostmax) {
+				bs->thinkcostmax = cost;
+			}
+			bs->numthinks++;
+			if (bs->thinkdeferred) {
+				bs->numdeferredthinks++;
+			} else {
+				// only full thinks predict the cost of the next full think
+				if (!bs->lastfullthink_time) {
+					bs->thinkcost = cost;
+				} else {
+					bs->thinkcost += (cost - bs->thinkcost) * 0.1f;
+				}
+				bs->lastfullthink_time = time;
 			}
 		}
 	}
@@ -1599,6 +1771,9 @@ int BotInitLibrary(void) {
 	//maximum number of aas links
 	trap_Cvar_VariableStringBuffer("max_aaslinks", buf, sizeof(buf));
 	if (strlen(buf)) trap_BotLibVarSet("max_aaslinks", buf);
+	//maximum routing cache size in KB
+	trap_Cvar_VariableStringBuffer("max_routingcache", buf, sizeof(buf));
+	if (strlen(buf)) trap_BotLibVarSet("max_routingcache", buf);
 	//maximum number of items in a level
 	trap_Cvar_VariableStringBuffer("max_levelitems", buf, sizeof(buf));
 	if (strlen(buf)) trap_BotLibVarSet("max_levelitems", buf);
@@ -1631,6 +1806,12 @@ int BotInitLibrary(void) {
 	//
 	trap_Cvar_VariableStringBuffer("bot_saveroutingcache", buf, sizeof(buf));
 	if (strlen(buf)) trap_BotLibVarSet("saveroutingcache", buf);
+	//save the routing cache after this many seconds
+	trap_Cvar_VariableStringBuffer("bot_routecachewarmup", buf, sizeof(buf));
+	if (strlen(buf)) trap_BotLibVarSet("routecachewarmup", buf);
+	//use the precomputed route table
+	trap_Cvar_VariableStringBuffer("bot_routetable", buf, sizeof(buf));
+	if (strlen(buf)) trap_BotLibVarSet("routetable", buf);
 	//reload instead of cache bot character files
 	trap_Cvar_VariableStringBuffer("bot_reloadcharacters", buf, sizeof(buf));
 	if (!strlen(buf)) strcpy(buf, "0");
@@ -1661,8 +1842,12 @@ int BotAISetup( int restart ) {
 	int			errnum;
 
 	trap_Cvar_Register(&bot_thinktime, "bot_thinktime", "100", CVAR_CHEAT);
+	trap_Cvar_Register(&bot_thinkbudget, "bot_thinkbudget", "0", 0);
+	trap_Cvar_Register(&bot_thinkreport, "bot_thinkreport", "0", 0);
 	trap_Cvar_Register(&bot_memorydump, "bot_memorydump", "0", CVAR_CHEAT);
 	trap_Cvar_Register(&bot_saveroutingcache, "bot_saveroutingcache", "0", CVAR_CHEAT);
+	trap_Cvar_Register(&bot_saveroutetable, "bot_saveroutetable", "0", CVAR_CHEAT);
+	trap_Cvar_Register(&bot_routingcachestats, "bot_routingcachestats", "0", 0);
 	trap_Cvar_Register(&bot_pause, "bot_pause", "0", CVAR_CHEAT);
 	trap_Cvar_Register(&bot_report, "bot_report", "0", CVAR_CHEAT);
 	trap_Cvar_Register(&bot_testsolid, "bot_testsolid", "0", CVAR_CHEAT);
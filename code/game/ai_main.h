@@ -123,6 +123,12 @@ typedef struct bot_state_s
 {
 	int inuse;										//true if this state is used by a bot client
 	int botthink_residual;							//residual for the bot thinks
+	int thinkdeferred;								//true if the non-critical AI is deferred this think
+	float thinkcost;								//average msec of a full think
+	int thinkcostmax;								//most msec a think ever took
+	int numthinks;									//number of thinks
+	int numdeferredthinks;							//number of thinks with deferred AI
+	int lastfullthink_time;							//time of the last think without deferred AI
 	int client;										//client number of the bot
 	int entitynum;									//entity number of the bot
 	playerState_t cur_ps;							//current player state
@@ -287,6 +293,7 @@ extern float floattime;
 void	QDECL BotAI_Print(int type, char *fmt, ...) __attribute__ ((format (printf, 2, 3)));
 void	QDECL QDECL BotAI_BotInitialChat( bot_state_t *bs, char *type, ... );
 void	BotAI_Trace(bsp_trace_t *bsptrace, vec3_t start, vec3_t mins, vec3_t maxs, vec3_t end, int passent, int contentmask);
+void	BotAI_TraceBatch(bsp_trace_t *bsptraces, traceRequest_t *requests, int numrequests);
 int		BotAI_GetClientState( int clientNum, playerState_t *state );
 int		BotAI_GetEntityState( int entityNum, entityState_t *state );
 int		BotAI_GetSnapshotEntity( int clientNum, int sequence, entityState_t *state );
@@ -423,6 +423,9 @@ void G_InitGame( int levelTime, int randomSeed, int restart ) {
 	level.time = levelTime;
 	level.startTime = levelTime;
 
+	// older engines drop the game on system calls they don't know
+	level.batchTraps = trap_Cvar_VariableIntegerValue( "sv_batchTraps" );
+
 	level.snd_fry = G_SoundIndex("sound/player/fry.wav");	// FIXME standing in lava / slime
 
 	if ( g_gametype.integer != GT_SINGLE_PLAYER && g_logfile.string[0] ) {
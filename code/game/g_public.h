@@ -71,6 +71,9 @@ typedef struct {
 	vec3_t		mins, maxs;
 	int			contents;			// CONTENTS_TRIGGER, CONTENTS_SOLID, CONTENTS_BODY, etc
 									// a non-solid entity should set to 0
+									// contents added to a linked entity reach the
+									// traces at the next frame or client command,
+									// relink it for traces before then
 
 	vec3_t		absmin, absmax;		// derived from mins/maxs and origin + rotation
 
@@ -98,6 +101,22 @@ typedef struct {
 } sharedEntity_t;
 
 
+// a single trace for G_TRACE_BATCH, all vectors are stored inline
+// so that the whole array can be passed through the VM boundary
+typedef struct {
+	vec3_t		start;
+	vec3_t		mins, maxs;
+	vec3_t		end;
+	int			passEntityNum;
+	int			contentmask;
+	int			capsule;		// qtrue to trace a capsule instead of a bbox
+} traceRequest_t;
+
+#define	MAX_TRACE_BATCH		256
+
+#define	MAX_PVS_BATCH		256
+
+
 
 //===============================================================
 
@@ -230,6 +249,14 @@ typedef enum {
 	// 1.32
 	G_FS_SEEK,
 
+	G_TRACE_BATCH,	// ( trace_t *results, const traceRequest_t *requests, int numRequests );
+	// performs up to MAX_TRACE_BATCH independent traces with a single
+	// system call, results[i] is filled in for requests[i]
+
+	G_IN_PVS_BATCH,	// ( const vec3_t viewer, const vec3_t *points, int numPoints, qboolean *visible );
+	// checks up to MAX_PVS_BATCH points against a single viewer like G_IN_PVS,
+	// visible[i] is set for points[i], returns the number of visible points
+
 	BOTLIB_SETUP = 200,				// ( void );
 	BOTLIB_SHUTDOWN,				// ( void );
 	BOTLIB_LIBVAR_SET,
@@ -157,6 +157,10 @@ void trap_TraceCapsule( trace_t *results, const vec3_t start, const vec3_t mins,
 	syscall( G_TRACECAPSULE, results, start, mins, maxs, end, passEntityNum, contentmask );
 }
 
+void trap_TraceBatch( trace_t *results, const traceRequest_t *requests, int numRequests ) {
+	syscall( G_TRACE_BATCH, results, requests, numRequests );
+}
+
 int trap_PointContents( const vec3_t point, int passEntityNum ) {
 	return syscall( G_POINT_CONTENTS, point, passEntityNum );
 }
@@ -170,6 +174,10 @@ qboolean trap_InPVSIgnorePortals( const vec3_t p1, const vec3_t p2 ) {
 	return syscall( G_IN_PVS_IGNORE_PORTALS, p1, p2 );
 }
 
+int trap_InPVSBatch( const vec3_t viewer, const vec3_t *points, int numPoints, qboolean *visible ) {
+	return syscall( G_IN_PVS_BATCH, viewer, points, numPoints, visible );
+}
+
 void trap_AdjustAreaPortalState( gentity_t *ent, qboolean open ) {
 	syscall( G_ADJUST_AREA_PORTAL_STATE, ent, open );
 }
@@ -907,29 +907,56 @@ Report a location for the player. Uses placed nearby target_location entities
 gentity_t *Team_GetLocation(gentity_t *ent)
 {
 	gentity_t		*eloc, *best;
+	gentity_t		*locs[MAX_PVS_BATCH];
+	vec3_t			points[MAX_PVS_BATCH];
+	float			lens[MAX_PVS_BATCH];
+	qboolean		visible[MAX_PVS_BATCH];
 	float			bestlen, len;
 	vec3_t			origin;
+	int				i, numLocs;
 
 	best = NULL;
 	bestlen = 3*8192.0*8192.0;
 
 	VectorCopy( ent->r.currentOrigin, origin );
 
-	for (eloc = level.locationHead; eloc; eloc = eloc->nextTrain) {
-		len = ( origin[0] - eloc->r.currentOrigin[0] ) * ( origin[0] - eloc->r.currentOrigin[0] )
-			+ ( origin[1] - eloc->r.currentOrigin[1] ) * ( origin[1] - eloc->r.currentOrigin[1] )
-			+ ( origin[2] - eloc->r.currentOrigin[2] ) * ( origin[2] - eloc->r.currentOrigin[2] );
+	eloc = level.locationHead;
+	while ( eloc ) {
+		// gather the locations that could still be closer and check
+		// them against the pvs with a single system call if possible
+		for ( numLocs = 0 ; eloc && numLocs < MAX_PVS_BATCH ; eloc = eloc->nextTrain ) {
+			len = ( origin[0] - eloc->r.currentOrigin[0] ) * ( origin[0] - eloc->r.currentOrigin[0] )
+				+ ( origin[1] - eloc->r.currentOrigin[1] ) * ( origin[1] - eloc->r.currentOrigin[1] )
+				+ ( origin[2] - eloc->r.currentOrigin[2] ) * ( origin[2] - eloc->r.currentOrigin[2] );
 
-		if ( len > bestlen ) {
-			continue;
+			if ( len > bestlen ) {
+				continue;
+			}
+
+			locs[numLocs] = eloc;
+			lens[numLocs] = len;
+			VectorCopy( eloc->r.currentOrigin, points[numLocs] );
+			numLocs++;
 		}
 
-		if ( !trap_InPVS( origin, eloc->r.currentOrigin ) ) {
-			continue;
+		if ( level.batchTraps ) {
+			if ( !trap_InPVSBatch( origin, (const vec3_t *)points, numLocs, visible ) ) {
+				continue;
+			}
+		} else {
+			for ( i = 0 ; i < numLocs ; i++ ) {
+				visible[i] = trap_InPVS( origin, points[i] );
+			}
 		}
 
-		bestlen = len;
-		best = eloc;
+		for ( i = 0 ; i < numLocs ; i++ ) {
+			if ( lens[i] > bestlen || !visible[i] ) {
+				continue;
+			}
+
+			bestlen = lens[i];
+			best = locs[i];
+		}
 	}
 
 	return best;
@@ -22,6 +22,7 @@ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
 // cmodel.c -- model loading
 
 #include "cm_local.h"
+#include "cm_patch.h"
 
 #ifdef BSPC
 
@@ -42,11 +43,12 @@ void SetPlaneSignbits (cplane_t *out) {
 #endif //BSPC
 
 // to allow boxes to be treated as brush models, we allocate
-// some extra indexes along with those needed by the map
-#define	BOX_BRUSHES		1
-#define	BOX_SIDES		6
+// some extra indexes along with those needed by the map, one
+// box for each trace context
+#define	BOX_BRUSHES		CM_MAX_TRACE_CONTEXTS
+#define	BOX_SIDES		(6 * CM_MAX_TRACE_CONTEXTS)
 #define	BOX_LEAFS		2
-#define	BOX_PLANES		12
+#define	BOX_PLANES		(12 * CM_MAX_TRACE_CONTEXTS)
 
 #define	LL(x) x=LittleLong(x)
 
@@ -62,12 +64,10 @@ byte		*cmod_base;
 cvar_t		*cm_noAreas;
 cvar_t		*cm_noCurves;
 cvar_t		*cm_playerCurveClip;
+cvar_t		*cm_noBrushTrees;
+cvar_t		*cm_cache;
 #endif
 
-cmodel_t	box_model;
-cplane_t	*box_planes;
-cbrush_t	*box_brush;
-
 
 
 void	CM_InitBoxHull (void);
@@ -302,6 +302,8 @@ void CMod_LoadLeafs (lump_t *l)
 
 	cm.areas = Hunk_Alloc( cm.numAreas * sizeof( *cm.areas ), h_high );
 	cm.areaPortals = Hunk_Alloc( cm.numAreas * cm.numAreas * sizeof( *cm.areaPortals ), h_high );
+	cm.areaBytes = ( cm.numAreas + 7 ) >> 3;
+	cm.areaFloods = Hunk_Alloc( cm.numAreas * cm.areaBytes, h_high );
 }
 
 /*
@@ -372,6 +374,166 @@ void CMod_LoadLeafBrushes (lump_t *l)
 	}
 }
 
+/*
+=================
+CM_CountBrushNodes
+
+Number of nodes CM_BuildBrushTree needs for the given number of brushes
+=================
+*/
+static int CM_CountBrushNodes( int numBrushes ) {
+	int		i, count, first, size;
+
+	count = 1;
+	if ( numBrushes <= 4 ) {
+		return count;
+	}
+	for ( i = 0, first = 0 ; i < 4 ; i++, first += size ) {
+		size = ( numBrushes * ( i + 1 ) ) / 4 - first;
+		if ( size > 1 ) {
+			count += CM_CountBrushNodes( size );
+		}
+	}
+	return count;
+}
+
+static int	sortAxis;
+
+static int CM_CompareBrushCenters( const void *a, const void *b ) {
+	cbrush_t	*ba, *bb;
+	float		ca, cb;
+
+	ba = &cm.brushes[*(const int *)a];
+	bb = &cm.brushes[*(const int *)b];
+	ca = ba->bounds[0][sortAxis] + ba->bounds[1][sortAxis];
+	cb = bb->bounds[0][sortAxis] + bb->bounds[1][sortAxis];
+	if ( ca < cb ) {
+		return -1;
+	}
+	if ( ca > cb ) {
+		return 1;
+	}
+	return *(const int *)a - *(const int *)b;
+}
+
+/*
+=================
+CM_BuildBrushTree
+
+Sorts the given run of leafbrushes along the longest axis of their centers
+and splits it in four. The leafbrushes are reordered in place so the
+tree is walked in the same order as the leaf's brush list, which keeps
+traces with and without the tree identical.
+=================
+*/
+static int CM_BuildBrushTree( int firstLeafBrush, int numBrushes ) {
+	int				i, j, num, first, size, brushnum;
+	cBrushNode_t	*node;
+	cbrush_t		*b;
+	vec3_t			mins, maxs;
+
+	num = cm.numBrushNodes++;
+	node = &cm.brushNodes[num];
+
+	// unused children can never be hit
+	for ( i = 0 ; i < 4 ; i++ ) {
+		for ( j = 0 ; j < 3 ; j++ ) {
+			node->mins[j][i] = MAX_WORLD_COORD;
+			node->maxs[j][i] = MIN_WORLD_COORD;
+		}
+		node->children[i] = -1;
+	}
+
+	if ( numBrushes > 4 ) {
+		ClearBounds( mins, maxs );
+		for ( i = 0 ; i < numBrushes ; i++ ) {
+			b = &cm.brushes[cm.leafbrushes[firstLeafBrush + i]];
+			for ( j = 0 ; j < 3 ; j++ ) {
+				mins[j] = MIN( mins[j], b->bounds[0][j] + b->bounds[1][j] );
+				maxs[j] = MAX( maxs[j], b->bounds[0][j] + b->bounds[1][j] );
+			}
+		}
+		sortAxis = 0;
+		for ( j = 1 ; j < 3 ; j++ ) {
+			if ( maxs[j] - mins[j] > maxs[sortAxis] - mins[sortAxis] ) {
+				sortAxis = j;
+			}
+		}
+		qsort( &cm.leafbrushes[firstLeafBrush], numBrushes, sizeof( int ), CM_CompareBrushCenters );
+	}
+
+	for ( i = 0, first = 0 ; i < 4 && first < numBrushes ; i++, first += size ) {
+		if ( numBrushes <= 4 ) {
+			size = 1;
+		} else {
+			size = ( numBrushes * ( i + 1 ) ) / 4 - first;
+		}
+
+		ClearBounds( mins, maxs );
+		for ( j = 0 ; j < size ; j++ ) {
+			brushnum = cm.leafbrushes[firstLeafBrush + first + j];
+			AddPointToBounds( cm.brushes[brushnum].bounds[0], mins, maxs );
+			AddPointToBounds( cm.brushes[brushnum].bounds[1], mins, maxs );
+		}
+		// same epsilon as CM_BoundsIntersect
+		for ( j = 0 ; j < 3 ; j++ ) {
+			node->mins[j][i] = mins[j] - SURFACE_CLIP_EPSILON;
+			node->maxs[j][i] = maxs[j] + SURFACE_CLIP_EPSILON;
+		}
+
+		// the sorted leafbrushes can live below cm.leafbrushes on the
+		// hunk, so their index could be negative
+		if ( size == 1 ) {
+			node->children[i] = -1 - cm.leafbrushes[firstLeafBrush + first];
+		} else {
+			node->children[i] = CM_BuildBrushTree( firstLeafBrush + first, size );
+		}
+	}
+
+	return num;
+}
+
+/*
+=================
+CM_BuildBrushTrees
+=================
+*/
+void CM_BuildBrushTrees( void ) {
+	int			i, count, numSorted;
+	int			*sorted;
+	cLeaf_t		*leaf;
+
+	count = 0;
+	numSorted = 0;
+	for ( i = 0, leaf = cm.leafs ; i < cm.numLeafs ; i++, leaf++ ) {
+		if ( leaf->numLeafBrushes >= BRUSH_TREE_MIN_BRUSHES ) {
+			count += CM_CountBrushNodes( leaf->numLeafBrushes );
+			numSorted += leaf->numLeafBrushes;
+		}
+	}
+	if ( !count ) {
+		return;
+	}
+
+	cm.brushNodes = Hunk_Alloc( count * sizeof( *cm.brushNodes ), h_high );
+	cm.numBrushNodes = 0;
+
+	// leafs could share their brush lists, so each tree gets a copy it can
+	// reorder, referenced the same way as the submodel brush lists
+	sorted = Hunk_Alloc( numSorted * sizeof( *sorted ), h_high );
+
+	for ( i = 0, leaf = cm.leafs ; i < cm.numLeafs ; i++, leaf++ ) {
+		if ( leaf->numLeafBrushes < BRUSH_TREE_MIN_BRUSHES ) {
+			continue;
+		}
+		Com_Memcpy( sorted, &cm.leafbrushes[leaf->firstLeafBrush], leaf->numLeafBrushes * sizeof( *sorted ) );
+		leaf->firstLeafBrush = sorted - cm.leafbrushes;
+		sorted += leaf->numLeafBrushes;
+
+		leaf->brushTree = &cm.brushNodes[CM_BuildBrushTree( leaf->firstLeafBrush, leaf->numLeafBrushes )];
+	}
+}
+
 /*
 =================
 CMod_LoadLeafSurfaces
@@ -466,10 +628,15 @@ void CMod_LoadVisibility( lump_t *l ) {
 	buf = cmod_base + l->fileofs;
 
 	cm.vised = qtrue;
-	cm.visibility = Hunk_Alloc( len, h_high );
 	cm.numClusters = LittleLong( ((int *)buf)[0] );
 	cm.clusterBytes = LittleLong( ((int *)buf)[1] );
-	Com_Memcpy (cm.visibility, buf + VIS_HEADER, len - VIS_HEADER );
+	if ( cm.numClusters < 0 || cm.clusterBytes < ( cm.numClusters + 7 ) >> 3
+		|| cm.numClusters * cm.clusterBytes > len - VIS_HEADER ) {
+		Com_Error (ERR_DROP, "CMod_LoadVisibility: funny lump size");
+	}
+
+	cm.visibility = Hunk_Alloc( cm.numClusters * cm.clusterBytes, h_high );
+	Com_Memcpy (cm.visibility, buf + VIS_HEADER, cm.numClusters * cm.clusterBytes );
 }
 
 //==================================================================
@@ -481,7 +648,7 @@ CMod_LoadPatches
 =================
 */
 #define	MAX_PATCH_VERTS		1024
-void CMod_LoadPatches( lump_t *surfs, lump_t *verts ) {
+void CMod_LoadPatches( lump_t *surfs, lump_t *verts, patchCollide_t **cached ) {
 	drawVert_t	*dv, *dv_p;
 	dsurface_t	*in;
 	int			count;
@@ -512,6 +679,15 @@ void CMod_LoadPatches( lump_t *surfs, lump_t *verts ) {
 
 		cm.surfaces[ i ] = patch = Hunk_Alloc( sizeof( *patch ), h_high );
 
+		shaderNum = LittleLong( in->shaderNum );
+		patch->contents = cm.shaders[shaderNum].contentFlags;
+		patch->surfaceFlags = cm.shaders[shaderNum].surfaceFlags;
+
+		if ( cached && cached[ i ] ) {
+			patch->pc = cached[ i ];
+			continue;
+		}
+
 		// load the full drawverts onto the stack
 		width = LittleLong( in->patchWidth );
 		height = LittleLong( in->patchHeight );
@@ -527,15 +703,320 @@ void CMod_LoadPatches( lump_t *surfs, lump_t *verts ) {
 			points[j][2] = LittleFloat( dv_p->xyz[2] );
 		}
 
-		shaderNum = LittleLong( in->shaderNum );
-		patch->contents = cm.shaders[shaderNum].contentFlags;
-		patch->surfaceFlags = cm.shaders[shaderNum].surfaceFlags;
-
 		// create the internal facet structure
 		patch->pc = CM_GeneratePatchCollide( width, height, points );
 	}
 }
 
+/*
+===============================================================================
+
+COLLISION CACHE
+
+Generating the patch collision data takes most of the time of loading a map,
+so it is written to maps/<mapname>.cmc in the homepath the first time a map is
+loaded. The file holds the patchCollide_t structures and their arrays laid out
+exactly as they are in memory, with every pointer stored as an offset into the
+data, so loading it again is a single copy followed by a pointer fixup. The
+header names the engine version and compiler that wrote it, a cache written
+by any other build is regenerated.
+
+===============================================================================
+*/
+
+#ifndef BSPC
+
+#define	CM_CACHE_IDENT		(('1'<<24)+('C'<<16)+('M'<<8)+'C')
+#define	CM_CACHE_VERSION	2		// bump when the patch collision generation changes
+
+// the generated patches depend on how the float math was compiled,
+// so a cache is only used by the same engine version and compiler
+#if defined( __GNUC__ )
+#define	CM_CACHE_COMPILER	"gcc " __VERSION__
+#elif defined( _MSC_VER )
+#define	CM_CACHE_COMPILER	"msvc " XSTRING( _MSC_VER )
+#else
+#define	CM_CACHE_COMPILER	"cc"
+#endif
+
+#ifdef __FAST_MATH__
+#define	CM_CACHE_MATH		" fast-math"
+#else
+#define	CM_CACHE_MATH		""
+#endif
+
+#define	CM_CACHE_BUILD		Q3_VERSION " " ARCH_STRING " " CM_CACHE_COMPILER CM_CACHE_MATH
+
+// the header is followed by an offset into the data for each surface,
+// -1 for surfaces that aren't patches, and then the data itself
+typedef struct {
+	int		ident;				// native byte order, like everything else
+	int		version;
+	int		checksum;			// of the whole bsp file
+	char	build[64];			// CM_CACHE_BUILD, zero padded
+	int		sizes[4];			// patchCollide_t, facet_t, patchPlane_t, patchBounds_t
+	int		numSurfaces;
+	int		dataSize;
+} cmCacheHeader_t;
+
+/*
+=================
+CM_CacheName
+=================
+*/
+static void CM_CacheName( const char *name, char *cacheName, int size ) {
+	COM_StripExtension( name, cacheName, size );
+	Q_strcat( cacheName, size, ".cmc" );
+}
+
+/*
+=================
+CM_SetCacheBuild
+=================
+*/
+static void CM_SetCacheBuild( char *build, int size ) {
+	Com_Memset( build, 0, size );
+	Q_strncpyz( build, CM_CACHE_BUILD, size );
+}
+
+/*
+=================
+CM_SetCacheSizes
+=================
+*/
+static void CM_SetCacheSizes( int *sizes ) {
+	sizes[0] = sizeof( patchCollide_t );
+	sizes[1] = sizeof( facet_t );
+	sizes[2] = sizeof( patchPlane_t );
+	sizes[3] = sizeof( patchBounds_t );
+}
+
+/*
+=================
+CM_CacheArray
+
+Turns an offset read from the cache back into a pointer,
+returns NULL if the array doesn't fit in the data
+=================
+*/
+static void *CM_CacheArray( byte *data, int dataSize, void *offset, int count, int size ) {
+	intptr_t	ofs;
+
+	ofs = (intptr_t)offset;
+	if ( count < 0 || count > dataSize / size || ofs < 0 || ofs > dataSize - count * size ) {
+		return NULL;
+	}
+	return data + ofs;
+}
+
+/*
+=================
+CM_FixupCachedPatch
+
+Resolves the offsets of a cached patch and checks all of its
+plane and border numbers, so a damaged cache can't crash traces
+=================
+*/
+static qboolean CM_FixupCachedPatch( byte *data, int dataSize, patchCollide_t *pc ) {
+	facet_t	*facet;
+	int		i, j;
+
+	pc->planes = CM_CacheArray( data, dataSize, pc->planes, pc->numPlanes, sizeof( *pc->planes ) );
+	pc->facets = CM_CacheArray( data, dataSize, pc->facets, pc->numFacets, sizeof( *pc->facets ) );
+	pc->facetBounds = CM_CacheArray( data, dataSize, pc->facetBounds, pc->numFacets, sizeof( *pc->facetBounds ) );
+	pc->groupBounds = CM_CacheArray( data, dataSize, pc->groupBounds, pc->numGroups, sizeof( *pc->groupBounds ) );
+	pc->borders = CM_CacheArray( data, dataSize, pc->borders, pc->numBorders, sizeof( *pc->borders ) );
+	if ( !pc->planes || !pc->facets || !pc->facetBounds || !pc->groupBounds || !pc->borders ) {
+		return qfalse;
+	}
+	if ( pc->numGroups != ( pc->numFacets + PATCH_FACET_GROUP - 1 ) / PATCH_FACET_GROUP ) {
+		return qfalse;
+	}
+
+	for ( i = 0, facet = pc->facets ; i < pc->numFacets ; i++, facet++ ) {
+		if ( facet->surfacePlane < 0 || facet->surfacePlane >= pc->numPlanes ) {
+			return qfalse;
+		}
+		if ( facet->numBorders < 0 || facet->numBorders > (int)ARRAY_LEN( facet->borderPlanes ) ) {
+			return qfalse;
+		}
+		if ( facet->firstBorder < 0 || facet->firstBorder > pc->numBorders - facet->numBorders ) {
+			return qfalse;
+		}
+		for ( j = 0 ; j < facet->numBorders ; j++ ) {
+			if ( facet->borderPlanes[j] < -1 || facet->borderPlanes[j] >= pc->numPlanes ) {
+				return qfalse;
+			}
+		}
+	}
+	return qtrue;
+}
+
+/*
+=================
+CM_LoadPatchCache
+
+Returns the cached patch collision data of every surface, or NULL
+if there is no usable cache. rebuild is set if a new cache should
+be written once the patches have been generated.
+=================
+*/
+static patchCollide_t **CM_LoadPatchCache( const char *name, int checksum, int numSurfaces, qboolean *rebuild ) {
+	char			cacheName[MAX_QPATH];
+	cmCacheHeader_t	header;
+	patchCollide_t	**cached;
+	byte			*buf, *data;
+	int				*offsets;
+	char			build[sizeof( header.build )];
+	int				sizes[4];
+	int				length, i;
+
+	*rebuild = qfalse;
+	if ( !cm_cache->integer ) {
+		return NULL;
+	}
+
+	CM_CacheName( name, cacheName, sizeof( cacheName ) );
+	length = FS_ReadFile( cacheName, (void **)&buf );
+	if ( !buf ) {
+		// a pure server hides the file without it being missing
+		*rebuild = !FS_FileExists( cacheName );
+		return NULL;
+	}
+
+	*rebuild = qtrue;
+	if ( length < (int)sizeof( header ) ) {
+		FS_FreeFile( buf );
+		return NULL;
+	}
+	Com_Memcpy( &header, buf, sizeof( header ) );
+	CM_SetCacheBuild( build, sizeof( build ) );
+	CM_SetCacheSizes( sizes );
+	if ( header.ident != CM_CACHE_IDENT || header.version != CM_CACHE_VERSION
+		|| header.checksum != checksum || memcmp( header.build, build, sizeof( build ) )
+		|| memcmp( header.sizes, sizes, sizeof( sizes ) )
+		|| header.numSurfaces != numSurfaces || header.dataSize < 0
+		|| length != (int)sizeof( header ) + numSurfaces * (int)sizeof( int ) + header.dataSize ) {
+		Com_DPrintf( "%s is out of date\n", cacheName );
+		FS_FreeFile( buf );
+		return NULL;
+	}
+
+	offsets = (int *)( buf + sizeof( header ) );
+	data = Hunk_Alloc( header.dataSize, h_high );
+	Com_Memcpy( data, offsets + numSurfaces, header.dataSize );
+
+	cached = Z_Malloc( numSurfaces * sizeof( *cached ) );
+	for ( i = 0 ; i < numSurfaces ; i++ ) {
+		if ( offsets[i] == -1 ) {
+			continue;
+		}
+		cached[i] = CM_CacheArray( data, header.dataSize, (void *)(intptr_t)offsets[i], 1, sizeof( patchCollide_t ) );
+		if ( !cached[i] || ( offsets[i] & 7 ) || !CM_FixupCachedPatch( data, header.dataSize, cached[i] ) ) {
+			// the hunk memory is lost until the next map, but
+			// this only happens if the file has been damaged
+			Com_Printf( S_COLOR_YELLOW "WARNING: %s is damaged\n", cacheName );
+			Z_Free( cached );
+			FS_FreeFile( buf );
+			return NULL;
+		}
+	}
+
+	FS_FreeFile( buf );
+	*rebuild = qfalse;
+	return cached;
+}
+
+/*
+=================
+CM_WriteCacheArray
+
+Appends an array to the cache data and returns its offset
+=================
+*/
+static void *CM_WriteCacheArray( byte *data, int *dataSize, const void *array, int size ) {
+	int		ofs;
+
+	ofs = *dataSize;
+	if ( data ) {
+		Com_Memcpy( data + ofs, array, size );
+	}
+	*dataSize += PAD( size, 8 );
+	return (void *)(intptr_t)ofs;
+}
+
+/*
+=================
+CM_WriteCachePatches
+
+Lays out all the patches, only measuring the size if data is NULL
+=================
+*/
+static int CM_WriteCachePatches( byte *data, int *offsets ) {
+	patchCollide_t	*pc, *out, size;
+	int				dataSize;
+	int				i;
+
+	dataSize = 0;
+	for ( i = 0 ; i < cm.numSurfaces ; i++ ) {
+		if ( !cm.surfaces[i] ) {
+			if ( offsets ) {
+				offsets[i] = -1;
+			}
+			continue;
+		}
+		pc = cm.surfaces[i]->pc;
+		out = data ? (patchCollide_t *)( data + dataSize ) : &size;
+		if ( offsets ) {
+			offsets[i] = dataSize;
+		}
+		CM_WriteCacheArray( data, &dataSize, pc, sizeof( *pc ) );
+
+		// the arrays go right after the patch, with their offsets in its pointers
+		out->planes = CM_WriteCacheArray( data, &dataSize, pc->planes, pc->numPlanes * sizeof( *pc->planes ) );
+		out->facets = CM_WriteCacheArray( data, &dataSize, pc->facets, pc->numFacets * sizeof( *pc->facets ) );
+		out->facetBounds = CM_WriteCacheArray( data, &dataSize, pc->facetBounds, pc->numFacets * sizeof( *pc->facetBounds ) );
+		out->groupBounds = CM_WriteCacheArray( data, &dataSize, pc->groupBounds, pc->numGroups * sizeof( *pc->groupBounds ) );
+		out->borders = CM_WriteCacheArray( data, &dataSize, pc->borders, pc->numBorders * sizeof( *pc->borders ) );
+	}
+	return dataSize;
+}
+
+/*
+=================
+CM_WritePatchCache
+=================
+*/
+static void CM_WritePatchCache( const char *name, int checksum ) {
+	char			cacheName[MAX_QPATH];
+	cmCacheHeader_t	*header;
+	byte			*buf;
+	int				*offsets;
+	int				dataSize, length;
+
+	dataSize = CM_WriteCachePatches( NULL, NULL );
+	length = sizeof( *header ) + cm.numSurfaces * sizeof( int ) + dataSize;
+	buf = Z_Malloc( length );
+
+	header = (cmCacheHeader_t *)buf;
+	header->ident = CM_CACHE_IDENT;
+	header->version = CM_CACHE_VERSION;
+	header->checksum = checksum;
+	CM_SetCacheBuild( header->build, sizeof( header->build ) );
+	CM_SetCacheSizes( header->sizes );
+	header->numSurfaces = cm.numSurfaces;
+	header->dataSize = dataSize;
+
+	offsets = (int *)( header + 1 );
+	CM_WriteCachePatches( (byte *)( offsets + cm.numSurfaces ), offsets );
+
+	CM_CacheName( name, cacheName, sizeof( cacheName ) );
+	FS_WriteFile( cacheName, buf, length );
+	Z_Free( buf );
+}
+
+#endif
+
 //==================================================================
 
 unsigned CM_LumpChecksum(lump_t *lump) {
@@ -575,6 +1056,10 @@ void CM_LoadMap( const char *name, qboolean clientload, int *checksum ) {
 	dheader_t		header;
 	int				length;
 	static unsigned	last_checksum;
+	patchCollide_t	**cached;
+#ifndef BSPC
+	qboolean		rebuild;
+#endif
 
 	if ( !name || !name[0] ) {
 		Com_Error( ERR_DROP, "CM_LoadMap: NULL name" );
@@ -584,6 +1069,8 @@ void CM_LoadMap( const char *name, qboolean clientload, int *checksum ) {
 	cm_noAreas = Cvar_Get ("cm_noAreas", "0", CVAR_CHEAT);
 	cm_noCurves = Cvar_Get ("cm_noCurves", "0", CVAR_CHEAT);
 	cm_playerCurveClip = Cvar_Get ("cm_playerCurveClip", "1", CVAR_ARCHIVE|CVAR_CHEAT );
+	cm_noBrushTrees = Cvar_Get ("cm_noBrushTrees", "0", CVAR_CHEAT);
+	cm_cache = Cvar_Get ("cm_cache", "1", CVAR_ARCHIVE);
 #endif
 	Com_DPrintf( "CM_LoadMap( %s, %i )\n", name, clientload );
 
@@ -641,11 +1128,24 @@ void CM_LoadMap( const char *name, qboolean clientload, int *checksum ) {
 	CMod_LoadPlanes (&header.lumps[LUMP_PLANES]);
 	CMod_LoadBrushSides (&header.lumps[LUMP_BRUSHSIDES]);
 	CMod_LoadBrushes (&header.lumps[LUMP_BRUSHES]);
+	CM_BuildBrushTrees ();
 	CMod_LoadSubmodels (&header.lumps[LUMP_MODELS]);
 	CMod_LoadNodes (&header.lumps[LUMP_NODES]);
 	CMod_LoadEntityString (&header.lumps[LUMP_ENTITIES]);
 	CMod_LoadVisibility( &header.lumps[LUMP_VISIBILITY] );
-	CMod_LoadPatches( &header.lumps[LUMP_SURFACES], &header.lumps[LUMP_DRAWVERTS] );
+#ifndef BSPC
+	cached = CM_LoadPatchCache( name, last_checksum, header.lumps[LUMP_SURFACES].filelen / sizeof( dsurface_t ), &rebuild );
+#else
+	cached = NULL;
+#endif
+	CMod_LoadPatches( &header.lumps[LUMP_SURFACES], &header.lumps[LUMP_DRAWVERTS], cached );
+#ifndef BSPC
+	if ( cached ) {
+		Z_Free( cached );
+	} else if ( rebuild ) {
+		CM_WritePatchCache( name, last_checksum );
+	}
+#endif
 
 	// we are NOT freeing the file, because it is cached for the ref
 	FS_FreeFile (buf.v);
@@ -682,8 +1182,8 @@ cmodel_t	*CM_ClipHandleToModel( clipHandle_t handle ) {
 	if ( handle < cm.numSubModels ) {
 		return &cm.cmodels[handle];
 	}
-	if ( handle == BOX_MODEL_HANDLE ) {
-		return &box_model;
+	if ( handle == BOX_MODEL_HANDLE || handle == CAPSULE_MODEL_HANDLE ) {
+		return &cm.contexts[0].boxModel;
 	}
 	if ( handle < MAX_SUBMODELS ) {
 		Com_Error( ERR_DROP, "CM_ClipHandleToModel: bad handle %i < %i < %i", 
@@ -695,6 +1195,32 @@ cmodel_t	*CM_ClipHandleToModel( clipHandle_t handle ) {
 
 }
 
+/*
+==================
+CM_ContextClipHandleToModel
+
+Same as CM_ClipHandleToModel, but resolves the temp box of the given context
+==================
+*/
+cmodel_t	*CM_ContextClipHandleToModel( cmTraceContext_t *ctx, clipHandle_t handle ) {
+	if ( handle == BOX_MODEL_HANDLE || handle == CAPSULE_MODEL_HANDLE ) {
+		return &ctx->boxModel;
+	}
+	return CM_ClipHandleToModel( handle );
+}
+
+/*
+==================
+CM_GetTraceContext
+==================
+*/
+cmTraceContext_t	*CM_GetTraceContext( int context ) {
+	if ( context < 0 || context >= CM_MAX_TRACE_CONTEXTS ) {
+		Com_Error( ERR_DROP, "CM_GetTraceContext: bad context %i", context );
+	}
+	return &cm.contexts[context];
+}
+
 /*
 ==================
 CM_InlineModel
@@ -746,47 +1272,57 @@ can just be stored out and get a proper clipping hull structure.
 */
 void CM_InitBoxHull (void)
 {
-	int			i;
+	int			i, c;
 	int			side;
 	cplane_t	*p;
 	cbrushside_t	*s;
+	cmTraceContext_t	*ctx;
 
-	box_planes = &cm.planes[cm.numPlanes];
-
-	box_brush = &cm.brushes[cm.numBrushes];
-	box_brush->numsides = 6;
-	box_brush->sides = cm.brushsides + cm.numBrushSides;
-	box_brush->contents = CONTENTS_BODY;
-
-	box_model.leaf.numLeafBrushes = 1;
-//	box_model.leaf.firstLeafBrush = cm.numBrushes;
-	box_model.leaf.firstLeafBrush = cm.numLeafBrushes;
-	cm.leafbrushes[cm.numLeafBrushes] = cm.numBrushes;
-
-	for (i=0 ; i<6 ; i++)
+	for (c=0 ; c<CM_MAX_TRACE_CONTEXTS ; c++)
 	{
-		side = i&1;
+		ctx = &cm.contexts[c];
+		ctx->index = c;
+		ctx->brushChecks = Hunk_Alloc( ( cm.numBrushes + BOX_BRUSHES ) * sizeof( *ctx->brushChecks ), h_high );
+		if ( cm.numSurfaces ) {
+			ctx->patchChecks = Hunk_Alloc( cm.numSurfaces * sizeof( *ctx->patchChecks ), h_high );
+		}
 
-		// brush sides
-		s = &cm.brushsides[cm.numBrushSides+i];
-		s->plane = 	cm.planes + (cm.numPlanes+i*2+side);
-		s->surfaceFlags = 0;
+		ctx->boxPlanes = &cm.planes[cm.numPlanes+c*12];
 
-		// planes
-		p = &box_planes[i*2];
-		p->type = i>>1;
-		p->signbits = 0;
-		VectorClear (p->normal);
-		p->normal[i>>1] = 1;
+		ctx->boxBrush = &cm.brushes[cm.numBrushes+c];
+		ctx->boxBrush->numsides = 6;
+		ctx->boxBrush->sides = cm.brushsides + cm.numBrushSides + c*6;
+		ctx->boxBrush->contents = CONTENTS_BODY;
 
-		p = &box_planes[i*2+1];
-		p->type = 3 + (i>>1);
-		p->signbits = 0;
-		VectorClear (p->normal);
-		p->normal[i>>1] = -1;
+		ctx->boxModel.leaf.numLeafBrushes = 1;
+		ctx->boxModel.leaf.firstLeafBrush = cm.numLeafBrushes+c;
+		cm.leafbrushes[cm.numLeafBrushes+c] = cm.numBrushes+c;
 
-		SetPlaneSignbits( p );
-	}	
+		for (i=0 ; i<6 ; i++)
+		{
+			side = i&1;
+
+			// brush sides
+			s = &ctx->boxBrush->sides[i];
+			s->plane = 	ctx->boxPlanes + (i*2+side);
+			s->surfaceFlags = 0;
+
+			// planes
+			p = &ctx->boxPlanes[i*2];
+			p->type = i>>1;
+			p->signbits = 0;
+			VectorClear (p->normal);
+			p->normal[i>>1] = 1;
+
+			p = &ctx->boxPlanes[i*2+1];
+			p->type = 3 + (i>>1);
+			p->signbits = 0;
+			VectorClear (p->normal);
+			p->normal[i>>1] = -1;
+
+			SetPlaneSignbits( p );
+		}
+	}
 }
 
 /*
@@ -799,14 +1335,34 @@ Capsules are handled differently though.
 ===================
 */
 clipHandle_t CM_TempBoxModel( const vec3_t mins, const vec3_t maxs, int capsule ) {
+	return CM_ContextTempBoxModel( &cm.contexts[0], mins, maxs, capsule );
+}
+
+/*
+===================
+CM_TempBoxModelContext
+===================
+*/
+clipHandle_t CM_TempBoxModelContext( int context, const vec3_t mins, const vec3_t maxs, int capsule ) {
+	return CM_ContextTempBoxModel( CM_GetTraceContext( context ), mins, maxs, capsule );
+}
+
+/*
+===================
+CM_ContextTempBoxModel
+===================
+*/
+clipHandle_t CM_ContextTempBoxModel( cmTraceContext_t *ctx, const vec3_t mins, const vec3_t maxs, int capsule ) {
+	cplane_t	*box_planes;
 
-	VectorCopy( mins, box_model.mins );
-	VectorCopy( maxs, box_model.maxs );
+	VectorCopy( mins, ctx->boxModel.mins );
+	VectorCopy( maxs, ctx->boxModel.maxs );
 
 	if ( capsule ) {
 		return CAPSULE_MODEL_HANDLE;
 	}
 
+	box_planes = ctx->boxPlanes;
 	box_planes[0].dist = maxs[0];
 	box_planes[1].dist = -maxs[0];
 	box_planes[2].dist = mins[0];
@@ -820,8 +1376,8 @@ clipHandle_t CM_TempBoxModel( const vec3_t mins, const vec3_t maxs, int capsule
 	box_planes[10].dist = mins[2];
 	box_planes[11].dist = -mins[2];
 
-	VectorCopy( mins, box_brush->bounds[0] );
-	VectorCopy( maxs, box_brush->bounds[1] );
+	VectorCopy( mins, ctx->boxBrush->bounds[0] );
+	VectorCopy( maxs, ctx->boxBrush->bounds[1] );
 
 	return BOX_MODEL_HANDLE;
 }
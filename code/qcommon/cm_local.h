@@ -34,6 +34,16 @@ typedef struct {
 	int			children[2];		// negative numbers are leafs
 } cNode_t;
 
+// leafs with a lot of brushes get a four wide bounding volume hierarchy
+// over them, so a trace can skip whole groups of brushes at once
+#define	BRUSH_TREE_MIN_BRUSHES	8
+
+typedef struct {
+	float		mins[3][4];		// bounds of the four children, stored per axis
+	float		maxs[3][4];		// so they can all be tested at once
+	int			children[4];	// node number, or -1 - brush number
+} cBrushNode_t;
+
 typedef struct {
 	int			cluster;
 	int			area;
@@ -43,6 +53,8 @@ typedef struct {
 
 	int			firstLeafSurface;
 	int			numLeafSurfaces;
+
+	cBrushNode_t	*brushTree;		// NULL if the brushes are only tested one by one
 } cLeaf_t;
 
 typedef struct cmodel_s {
@@ -62,12 +74,10 @@ typedef struct {
 	vec3_t		bounds[2];
 	int			numsides;
 	cbrushside_t	*sides;
-	int			checkcount;		// to avoid repeated testings
 } cbrush_t;
 
 
 typedef struct {
-	int			checkcount;				// to avoid repeated testings
 	int			surfaceFlags;
 	int			contents;
 	struct patchCollide_s	*pc;
@@ -79,6 +89,19 @@ typedef struct {
 	int			floodvalid;
 } cArea_t;
 
+// everything a trace writes while it runs lives in a context, so traces
+// issued through different contexts can run at the same time
+typedef struct {
+	int			index;
+	int			checkcount;		// incremented on each trace
+	int			*brushChecks;	// [numBrushes + CM_MAX_TRACE_CONTEXTS], to avoid repeated testings
+	int			*patchChecks;	// [numSurfaces]
+
+	cmodel_t	boxModel;		// temp box hull, see CM_TempBoxModel
+	cplane_t	*boxPlanes;
+	cbrush_t	*boxBrush;
+} cmTraceContext_t;
+
 typedef struct {
 	char		name[MAX_QPATH];
 
@@ -109,6 +132,9 @@ typedef struct {
 	int			numBrushes;
 	cbrush_t	*brushes;
 
+	int			numBrushNodes;
+	cBrushNode_t	*brushNodes;
+
 	int			numClusters;
 	int			clusterBytes;
 	byte		*visibility;
@@ -120,12 +146,16 @@ typedef struct {
 	int			numAreas;
 	cArea_t		*areas;
 	int			*areaPortals;	// [ numAreas*numAreas ] reference counts
+	int			areaBytes;
+	byte		*areaFloods;	// [ numAreas*areaBytes ] bit vectors of the areas
+								// in the same flood, rebuilt on every flood
 
 	int			numSurfaces;
 	cPatch_t	**surfaces;			// non-patches will be NULL
 
 	int			floodvalid;
-	int			checkcount;					// incremented on each trace
+
+	cmTraceContext_t	contexts[CM_MAX_TRACE_CONTEXTS];
 } clipMap_t;
 
 
@@ -139,6 +169,8 @@ extern	int			c_traces, c_brush_traces, c_patch_traces;
 extern	cvar_t		*cm_noAreas;
 extern	cvar_t		*cm_noCurves;
 extern	cvar_t		*cm_playerCurveClip;
+extern	cvar_t		*cm_noBrushTrees;
+extern	cvar_t		*cm_cache;
 
 // cm_test.c
 
@@ -164,6 +196,7 @@ typedef struct {
 	qboolean	isPoint;	// optimized case
 	trace_t		trace;		// returned from trace call
 	sphere_t	sphere;		// sphere for oriendted capsule collision
+	cmTraceContext_t	*ctx;	// visited marks and temp box of this trace
 } traceWork_t;
 
 typedef struct leafList_s {
@@ -173,6 +206,7 @@ typedef struct leafList_s {
 	int		*list;
 	vec3_t	bounds[2];
 	int		lastLeaf;		// for overflows where each leaf can't be stored individually
+	cmTraceContext_t	*ctx;	// only used by CM_StoreBrushes
 	void	(*storeLeafs)( struct leafList_s *ll, int nodenum );
 } leafList_t;
 
@@ -185,6 +219,9 @@ void CM_StoreBrushes( leafList_t *ll, int nodenum );
 void CM_BoxLeafnums_r( leafList_t *ll, int nodenum );
 
 cmodel_t	*CM_ClipHandleToModel( clipHandle_t handle );
+cmTraceContext_t	*CM_GetTraceContext( int context );
+cmodel_t	*CM_ContextClipHandleToModel( cmTraceContext_t *ctx, clipHandle_t handle );
+clipHandle_t CM_ContextTempBoxModel( cmTraceContext_t *ctx, const vec3_t mins, const vec3_t maxs, int capsule );
 qboolean CM_BoundsIntersect( const vec3_t mins, const vec3_t maxs, const vec3_t mins2, const vec3_t maxs2 );
 qboolean CM_BoundsIntersectPoint( const vec3_t mins, const vec3_t maxs, const vec3_t point );
 
@@ -419,6 +419,7 @@ static	patchPlane_t	planes[MAX_PATCH_PLANES];
 
 static	int				numFacets;
 static	facet_t			facets[MAX_PATCH_PLANES]; //maybe MAX_FACETS ??
+static	patchBounds_t	facetBounds[MAX_PATCH_PLANES];
 
 #define	NORMAL_EPSILON	0.0001
 #define	DIST_EPSILON	0.02
@@ -803,9 +804,11 @@ static qboolean CM_ValidateFacet( facet_t *facet ) {
 /*
 ==================
 CM_AddFacetBevels
+
+Also sets the bounds of the facet, which its axial bevels keep it in
 ==================
 */
-void CM_AddFacetBevels( facet_t *facet ) {
+void CM_AddFacetBevels( facet_t *facet, patchBounds_t *fb ) {
 
 	int i, j, k, l;
 	int axis, dir, order, flipped;
@@ -828,11 +831,21 @@ void CM_AddFacetBevels( facet_t *facet ) {
 		ChopWindingInPlace( &w, plane, plane[3], 0.1f );
 	}
 	if ( !w ) {
+		// no bevels to bound it
+		VectorSet( fb->bounds[0], -MAX_MAP_BOUNDS, -MAX_MAP_BOUNDS, -MAX_MAP_BOUNDS );
+		VectorSet( fb->bounds[1], MAX_MAP_BOUNDS, MAX_MAP_BOUNDS, MAX_MAP_BOUNDS );
 		return;
 	}
 
 	WindingBounds(w, mins, maxs);
 
+	// expand by one unit for epsilon purposes, a bevel may have been
+	// merged with a plane that is only nearly axial
+	for ( i = 0 ; i < 3 ; i++ ) {
+		fb->bounds[0][i] = mins[i] - 1;
+		fb->bounds[1][i] = maxs[i] + 1;
+	}
+
 	// add the axial planes
 	order = 0;
 	for ( axis = 0 ; axis < 3 ; axis++ )
@@ -973,6 +986,69 @@ typedef enum {
 	EN_LEFT
 } edgeName_t;
 
+/*
+==================
+CM_SetPatchFacetGroups
+==================
+*/
+static void CM_SetPatchFacetGroups( patchCollide_t *pf ) {
+	int				i, j, first, last;
+	patchBounds_t	*group;
+
+	pf->numGroups = ( pf->numFacets + PATCH_FACET_GROUP - 1 ) / PATCH_FACET_GROUP;
+	pf->groupBounds = Hunk_Alloc( pf->numGroups * sizeof( *pf->groupBounds ), h_high );
+
+	for ( i = 0, group = pf->groupBounds ; i < pf->numGroups ; i++, group++ ) {
+		first = i * PATCH_FACET_GROUP;
+		last = first + PATCH_FACET_GROUP;
+		if ( last > pf->numFacets ) {
+			last = pf->numFacets;
+		}
+
+		ClearBounds( group->bounds[0], group->bounds[1] );
+		for ( j = first ; j < last ; j++ ) {
+			AddPointToBounds( pf->facetBounds[j].bounds[0], group->bounds[0], group->bounds[1] );
+			AddPointToBounds( pf->facetBounds[j].bounds[1], group->bounds[0], group->bounds[1] );
+		}
+	}
+}
+
+/*
+==================
+CM_SetPatchBorders
+
+The signbits are left those of the unflipped plane, the box offset
+along a border is only ever used through fabs
+==================
+*/
+static void CM_SetPatchBorders( patchCollide_t *pf ) {
+	int				i, j;
+	facet_t			*facet;
+	patchPlane_t	*border;
+	const patchPlane_t	*plane;
+
+	pf->numBorders = 0;
+	for ( i = 0, facet = pf->facets ; i < pf->numFacets ; i++, facet++ ) {
+		facet->firstBorder = pf->numBorders;
+		pf->numBorders += facet->numBorders;
+	}
+	pf->borders = Hunk_Alloc( pf->numBorders * sizeof( *pf->borders ), h_high );
+
+	for ( i = 0, facet = pf->facets ; i < pf->numFacets ; i++, facet++ ) {
+		border = &pf->borders[facet->firstBorder];
+		for ( j = 0 ; j < facet->numBorders ; j++, border++ ) {
+			plane = &pf->planes[facet->borderPlanes[j]];
+			if ( facet->borderInward[j] ) {
+				VectorNegate( plane->plane, border->plane );
+				border->plane[3] = -plane->plane[3];
+			} else {
+				Vector4Copy( plane->plane, border->plane );
+			}
+			border->signbits = plane->signbits;
+		}
+	}
+}
+
 /*
 ==================
 CM_PatchCollideFromGrid
@@ -1074,7 +1150,7 @@ static void CM_PatchCollideFromGrid( cGrid_t *grid, patchCollide_t *pf ) {
 				facet->borderNoAdjust[3] = noAdjust[EN_LEFT];
 				CM_SetBorderInward( facet, grid, gridPlanes, i, j, -1 );
 				if ( CM_ValidateFacet( facet ) ) {
-					CM_AddFacetBevels( facet );
+					CM_AddFacetBevels( facet, &facetBounds[numFacets] );
 					numFacets++;
 				}
 			} else {
@@ -1094,7 +1170,7 @@ static void CM_PatchCollideFromGrid( cGrid_t *grid, patchCollide_t *pf ) {
 				}
  				CM_SetBorderInward( facet, grid, gridPlanes, i, j, 0 );
 				if ( CM_ValidateFacet( facet ) ) {
-					CM_AddFacetBevels( facet );
+					CM_AddFacetBevels( facet, &facetBounds[numFacets] );
 					numFacets++;
 				}
 
@@ -1119,7 +1195,7 @@ static void CM_PatchCollideFromGrid( cGrid_t *grid, patchCollide_t *pf ) {
 				}
 				CM_SetBorderInward( facet, grid, gridPlanes, i, j, 1 );
 				if ( CM_ValidateFacet( facet ) ) {
-					CM_AddFacetBevels( facet );
+					CM_AddFacetBevels( facet, &facetBounds[numFacets] );
 					numFacets++;
 				}
 			}
@@ -1133,6 +1209,11 @@ static void CM_PatchCollideFromGrid( cGrid_t *grid, patchCollide_t *pf ) {
 	Com_Memcpy( pf->facets, facets, numFacets * sizeof( *pf->facets ) );
 	pf->planes = Hunk_Alloc( numPlanes * sizeof( *pf->planes ), h_high );
 	Com_Memcpy( pf->planes, planes, numPlanes * sizeof( *pf->planes ) );
+	pf->facetBounds = Hunk_Alloc( numFacets * sizeof( *pf->facetBounds ), h_high );
+	Com_Memcpy( pf->facetBounds, facetBounds, numFacets * sizeof( *pf->facetBounds ) );
+
+	CM_SetPatchFacetGroups( pf );
+	CM_SetPatchBorders( pf );
 }
 
 
@@ -1222,6 +1303,33 @@ TRACE TESTING
 ================================================================================
 */
 
+/*
+====================
+CM_NextPatchFacet
+
+Returns the first facet from i on that the trace bounds touch, or numFacets
+====================
+*/
+static int CM_NextPatchFacet( const traceWork_t *tw, const patchCollide_t *pc, int i ) {
+	const patchBounds_t	*b;
+
+	for ( ; i < pc->numFacets ; i++ ) {
+		if ( !( i % PATCH_FACET_GROUP ) ) {
+			b = &pc->groupBounds[i / PATCH_FACET_GROUP];
+			if ( !CM_BoundsIntersect( tw->bounds[0], tw->bounds[1], b->bounds[0], b->bounds[1] ) ) {
+				i += PATCH_FACET_GROUP - 1;
+				continue;
+			}
+		}
+		b = &pc->facetBounds[i];
+		if ( CM_BoundsIntersect( tw->bounds[0], tw->bounds[1], b->bounds[0], b->bounds[1] ) ) {
+			break;
+		}
+	}
+
+	return i;
+}
+
 /*
 ====================
 CM_TracePointThroughPatchCollide
@@ -1232,6 +1340,7 @@ CM_TracePointThroughPatchCollide
 void CM_TracePointThroughPatchCollide( traceWork_t *tw, const struct patchCollide_s *pc ) {
 	qboolean	frontFacing[MAX_PATCH_PLANES];
 	float		intersection[MAX_PATCH_PLANES];
+	byte		planeTested[MAX_PATCH_PLANES];
 	float		intersect;
 	const patchPlane_t	*planes;
 	const facet_t	*facet;
@@ -1248,31 +1357,40 @@ void CM_TracePointThroughPatchCollide( traceWork_t *tw, const struct patchCollid
 	}
 #endif
 
-	// determine the trace's relationship to all planes
-	planes = pc->planes;
-	for ( i = 0 ; i < pc->numPlanes ; i++, planes++ ) {
-		offset = DotProduct( tw->offsets[ planes->signbits ], planes->plane );
-		d1 = DotProduct( tw->start, planes->plane ) - planes->plane[3] + offset;
-		d2 = DotProduct( tw->end, planes->plane ) - planes->plane[3] + offset;
-		if ( d1 <= 0 ) {
-			frontFacing[i] = qfalse;
-		} else {
-			frontFacing[i] = qtrue;
-		}
-		if ( d1 == d2 ) {
-			intersection[i] = 99999;
-		} else {
-			intersection[i] = d1 / ( d1 - d2 );
-			if ( intersection[i] <= 0 ) {
-				intersection[i] = 99999;
+	// the trace's relationship to a plane is only worked
+	// out once a facet the trace touches needs it
+	Com_Memset( planeTested, 0, pc->numPlanes );
+
+	// see if any of the surface planes are intersected
+	for ( i = CM_NextPatchFacet( tw, pc, 0 ) ; i < pc->numFacets ; i = CM_NextPatchFacet( tw, pc, i + 1 ) ) {
+		facet = &pc->facets[i];
+
+		for ( j = -1 ; j < facet->numBorders ; j++ ) {
+			k = j == -1 ? facet->surfacePlane : facet->borderPlanes[j];
+			if ( planeTested[k] ) {
+				continue;
 			}
-		}
-	}
+			planeTested[k] = qtrue;
 
+			planes = &pc->planes[k];
+			offset = DotProduct( tw->offsets[ planes->signbits ], planes->plane );
+			d1 = DotProduct( tw->start, planes->plane ) - planes->plane[3] + offset;
+			d2 = DotProduct( tw->end, planes->plane ) - planes->plane[3] + offset;
+			if ( d1 <= 0 ) {
+				frontFacing[k] = qfalse;
+			} else {
+				frontFacing[k] = qtrue;
+			}
+			if ( d1 == d2 ) {
+				intersection[k] = 99999;
+			} else {
+				intersection[k] = d1 / ( d1 - d2 );
+				if ( intersection[k] <= 0 ) {
+					intersection[k] = 99999;
+				}
+			}
+		}
 
-	// see if any of the surface planes are intersected
-	facet = pc->facets;
-	for ( i = 0 ; i < pc->numFacets ; i++, facet++ ) {
 		if ( !frontFacing[facet->surfacePlane] ) {
 			continue;
 		}
@@ -1298,12 +1416,15 @@ void CM_TracePointThroughPatchCollide( traceWork_t *tw, const struct patchCollid
 		if ( j == facet->numBorders ) {
 			// we hit this facet
 #ifndef BSPC
-			if (!cv) {
-				cv = Cvar_Get( "r_debugSurfaceUpdate", "1", 0 );
-			}
-			if (cv->integer) {
-				debugPatchCollide = pc;
-				debugFacet = facet;
+			// the debug surface is only tracked for the main trace context
+			if ( !tw->ctx->index ) {
+				if (!cv) {
+					cv = Cvar_Get( "r_debugSurfaceUpdate", "1", 0 );
+				}
+				if (cv->integer) {
+					debugPatchCollide = pc;
+					debugFacet = facet;
+				}
 			}
 #endif //BSPC
 			planes = &pc->planes[facet->surfacePlane];
@@ -1378,8 +1499,8 @@ CM_TraceThroughPatchCollide
 void CM_TraceThroughPatchCollide( traceWork_t *tw, const struct patchCollide_s *pc ) {
 	int i, j, hit, hitnum;
 	float offset, enterFrac, leaveFrac, t;
-	patchPlane_t *planes;
-	facet_t	*facet;
+	const patchPlane_t *planes;
+	const facet_t	*facet;
 	float plane[4] = {0, 0, 0, 0}, bestplane[4] = {0, 0, 0, 0};
 	vec3_t startp, endp;
 #ifndef BSPC
@@ -1396,8 +1517,8 @@ void CM_TraceThroughPatchCollide( traceWork_t *tw, const struct patchCollide_s *
 		return;
 	}
 
-	facet = pc->facets;
-	for ( i = 0 ; i < pc->numFacets ; i++, facet++ ) {
+	for ( i = CM_NextPatchFacet( tw, pc, 0 ) ; i < pc->numFacets ; i = CM_NextPatchFacet( tw, pc, i + 1 ) ) {
+		facet = &pc->facets[i];
 		enterFrac = -1.0;
 		leaveFrac = 1.0;
 		hitnum = -1;
@@ -1434,16 +1555,9 @@ void CM_TraceThroughPatchCollide( traceWork_t *tw, const struct patchCollide_s *
 			Vector4Copy(plane, bestplane);
 		}
 
-		for ( j = 0; j < facet->numBorders; j++ ) {
-			planes = &pc->planes[ facet->borderPlanes[j] ];
-			if (facet->borderInward[j]) {
-				VectorNegate(planes->plane, plane);
-				plane[3] = -planes->plane[3];
-			}
-			else {
-				VectorCopy(planes->plane, plane);
-				plane[3] = planes->plane[3];
-			}
+		planes = &pc->borders[ facet->firstBorder ];
+		for ( j = 0; j < facet->numBorders; j++, planes++ ) {
+			Vector4Copy(planes->plane, plane);
 			if ( tw->sphere.use ) {
 				// adjust the plane distance apropriately for radius
 				plane[3] += tw->sphere.radius;
@@ -1485,12 +1599,14 @@ void CM_TraceThroughPatchCollide( traceWork_t *tw, const struct patchCollide_s *
 					enterFrac = 0;
 				}
 #ifndef BSPC
-				if (!cv) {
-					cv = Cvar_Get( "r_debugSurfaceUpdate", "1", 0 );
-				}
-				if (cv && cv->integer) {
-					debugPatchCollide = pc;
-					debugFacet = facet;
+				if ( !tw->ctx->index ) {
+					if (!cv) {
+						cv = Cvar_Get( "r_debugSurfaceUpdate", "1", 0 );
+					}
+					if (cv && cv->integer) {
+						debugPatchCollide = pc;
+						debugFacet = facet;
+					}
 				}
 #endif //BSPC
 
@@ -1519,8 +1635,8 @@ CM_PositionTestInPatchCollide
 qboolean CM_PositionTestInPatchCollide( traceWork_t *tw, const struct patchCollide_s *pc ) {
 	int i, j;
 	float offset, t;
-	patchPlane_t *planes;
-	facet_t	*facet;
+	const patchPlane_t *planes;
+	const facet_t	*facet;
 	float plane[4];
 	vec3_t startp;
 
@@ -1528,8 +1644,8 @@ qboolean CM_PositionTestInPatchCollide( traceWork_t *tw, const struct patchColli
 		return qfalse;
 	}
 	//
-	facet = pc->facets;
-	for ( i = 0 ; i < pc->numFacets ; i++, facet++ ) {
+	for ( i = CM_NextPatchFacet( tw, pc, 0 ) ; i < pc->numFacets ; i = CM_NextPatchFacet( tw, pc, i + 1 ) ) {
+		facet = &pc->facets[i];
 		planes = &pc->planes[ facet->surfacePlane ];
 		VectorCopy(planes->plane, plane);
 		plane[3] = planes->plane[3];
@@ -1556,16 +1672,9 @@ qboolean CM_PositionTestInPatchCollide( traceWork_t *tw, const struct patchColli
 			continue;
 		}
 
-		for ( j = 0; j < facet->numBorders; j++ ) {
-			planes = &pc->planes[ facet->borderPlanes[j] ];
-			if (facet->borderInward[j]) {
-				VectorNegate(planes->plane, plane);
-				plane[3] = -planes->plane[3];
-			}
-			else {
-				VectorCopy(planes->plane, plane);
-				plane[3] = planes->plane[3];
-			}
+		planes = &pc->borders[ facet->firstBorder ];
+		for ( j = 0; j < facet->numBorders; j++, planes++ ) {
+			Vector4Copy(planes->plane, plane);
 			if ( tw->sphere.use ) {
 				// adjust the plane distance apropriately for radius
 				plane[3] += tw->sphere.radius;
@@ -74,14 +74,34 @@ typedef struct {
 	int			borderPlanes[4+6+16];
 	int			borderInward[4+6+16];
 	qboolean	borderNoAdjust[4+6+16];
+	int			firstBorder;	// in patchCollide_t->borders
 } facet_t;
 
+typedef struct {
+	vec3_t	bounds[2];
+} patchBounds_t;
+
+// the bounds of this many neighbouring facets are tested before their own
+#define	PATCH_FACET_GROUP	8
+
 typedef struct patchCollide_s {
 	vec3_t	bounds[2];
 	int		numPlanes;			// surface planes plus edge planes
 	patchPlane_t	*planes;
 	int		numFacets;
 	facet_t	*facets;
+
+	// the facets' axial bevels keep each of them inside its bounds, which
+	// are kept apart from the facets so rejecting them stays in the cache
+	patchBounds_t	*facetBounds;
+	int		numGroups;
+	patchBounds_t	*groupBounds;
+
+	// the border planes of every facet in order, already flipped
+	// to face out of the facet, so the trace tests run straight
+	// through them instead of looking each one up in planes
+	int		numBorders;
+	patchPlane_t	*borders;
 } patchCollide_t;
 
 
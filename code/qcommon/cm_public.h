@@ -46,6 +46,31 @@ void		CM_TransformedBoxTrace( trace_t *results, const vec3_t start, const vec3_t
 						  clipHandle_t model, int brushmask,
 						  const vec3_t origin, const vec3_t angles, int capsule );
 
+// same result as CM_TransformedBoxTrace against an unrotated
+// CM_TempBoxModel( boxMins, boxMaxs, boxCapsule ), computed directly
+// instead of through the temp box hull, so it is also reentrant;
+// capsule and boxCapsule can't both be set
+void		CM_TraceAgainstBox( trace_t *results, const vec3_t start, const vec3_t end,
+						  const vec3_t mins, const vec3_t maxs,
+						  const vec3_t boxMins, const vec3_t boxMaxs,
+						  int brushmask, const vec3_t origin, int capsule, int boxCapsule );
+
+// Reentrant versions of the above for use from worker threads. A context
+// holds the visited marks and the temp box hull of a trace, so each thread
+// must use a context of its own. Context 0 is the one used by the plain
+// functions and belongs to the main thread. Point contents queries against
+// the world and inline models don't need a context.
+#define		CM_MAX_TRACE_CONTEXTS	8
+
+clipHandle_t CM_TempBoxModelContext( int context, const vec3_t mins, const vec3_t maxs, int capsule );
+void		CM_BoxTraceContext( int context, trace_t *results, const vec3_t start, const vec3_t end,
+						  vec3_t mins, vec3_t maxs,
+						  clipHandle_t model, int brushmask, int capsule );
+void		CM_TransformedBoxTraceContext( int context, trace_t *results, const vec3_t start, const vec3_t end,
+						  vec3_t mins, vec3_t maxs,
+						  clipHandle_t model, int brushmask,
+						  const vec3_t origin, const vec3_t angles, int capsule );
+
 byte		*CM_ClusterPVS (int cluster);
 
 int			CM_PointLeafnum( const vec3_t p );
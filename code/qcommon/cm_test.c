@@ -101,10 +101,10 @@ void CM_StoreBrushes( leafList_t *ll, int nodenum ) {
 	for ( k = 0 ; k < leaf->numLeafBrushes ; k++ ) {
 		brushnum = cm.leafbrushes[leaf->firstLeafBrush+k];
 		b = &cm.brushes[brushnum];
-		if ( b->checkcount == cm.checkcount ) {
+		if ( ll->ctx->brushChecks[brushnum] == ll->ctx->checkcount ) {
 			continue;	// already checked this brush in another leaf
 		}
-		b->checkcount = cm.checkcount;
+		ll->ctx->brushChecks[brushnum] = ll->ctx->checkcount;
 		for ( i = 0 ; i < 3 ; i++ ) {
 			if ( b->bounds[0][i] >= ll->bounds[1][i] || b->bounds[1][i] <= ll->bounds[0][i] ) {
 				break;
@@ -172,8 +172,6 @@ CM_BoxLeafnums
 int	CM_BoxLeafnums( const vec3_t mins, const vec3_t maxs, int *list, int listsize, int *lastLeaf) {
 	leafList_t	ll;
 
-	cm.checkcount++;
-
 	VectorCopy( mins, ll.bounds[0] );
 	VectorCopy( maxs, ll.bounds[1] );
 	ll.count = 0;
@@ -182,6 +180,7 @@ int	CM_BoxLeafnums( const vec3_t mins, const vec3_t maxs, int *list, int listsiz
 	ll.storeLeafs = CM_StoreLeafs;
 	ll.lastLeaf = 0;
 	ll.overflowed = qfalse;
+	ll.ctx = NULL;
 
 	CM_BoxLeafnums_r( &ll, 0 );
 
@@ -197,7 +196,8 @@ CM_BoxBrushes
 int CM_BoxBrushes( const vec3_t mins, const vec3_t maxs, cbrush_t **list, int listsize ) {
 	leafList_t	ll;
 
-	cm.checkcount++;
+	ll.ctx = &cm.contexts[0];
+	ll.ctx->checkcount++;
 
 	VectorCopy( mins, ll.bounds[0] );
 	VectorCopy( maxs, ll.bounds[1] );
@@ -354,6 +354,44 @@ void CM_FloodArea_r( int areaNum, int floodnum) {
 	}
 }
 
+/*
+====================
+CM_SetAreaFloods
+
+Builds the bit vector of connected areas for every area, so
+CM_WriteAreaBits doesn't have to compare the flood numbers
+of all the areas for every snapshot
+====================
+*/
+static void CM_SetAreaFloods( void ) {
+	int		i, j;
+	byte	*row;
+
+	if ( !cm.areaFloods ) {
+		return;
+	}
+
+	Com_Memset( cm.areaFloods, 0, cm.numAreas * cm.areaBytes );
+	for ( i = 0 ; i < cm.numAreas ; i++ ) {
+		row = cm.areaFloods + i * cm.areaBytes;
+		for ( j = 0 ; j < i ; j++ ) {
+			if ( cm.areas[j].floodnum == cm.areas[i].floodnum ) {
+				break;
+			}
+		}
+		if ( j < i ) {
+			// same flood as an area that is already done
+			Com_Memcpy( row, cm.areaFloods + j * cm.areaBytes, cm.areaBytes );
+			continue;
+		}
+		for ( j = i ; j < cm.numAreas ; j++ ) {
+			if ( cm.areas[j].floodnum == cm.areas[i].floodnum ) {
+				row[j>>3] |= 1<<(j&7);
+			}
+		}
+	}
+}
+
 /*
 ====================
 CM_FloodAreaConnections
@@ -378,6 +416,7 @@ void	CM_FloodAreaConnections( void ) {
 		CM_FloodArea_r (i, floodnum);
 	}
 
+	CM_SetAreaFloods ();
 }
 
 /*
@@ -454,8 +493,8 @@ This is used to cull non-visible entities from snapshots
 int CM_WriteAreaBits (byte *buffer, int area)
 {
 	int		i;
-	int		floodnum;
 	int		bytes;
+	byte	*flood;
 
 	bytes = (cm.numAreas+7)>>3;
 
@@ -469,11 +508,10 @@ int CM_WriteAreaBits (byte *buffer, int area)
 	}
 	else
 	{
-		floodnum = cm.areas[area].floodnum;
-		for (i=0 ; i<cm.numAreas ; i++)
+		flood = cm.areaFloods + area * cm.areaBytes;
+		for (i=0 ; i<bytes ; i++)
 		{
-			if (cm.areas[i].floodnum == floodnum || area == -1)
-				buffer[i>>3] |= 1<<(i&7);
+			buffer[i] |= flood[i];
 		}
 	}
 
@@ -241,7 +241,7 @@ CM_TestInLeaf
 */
 void CM_TestInLeaf( traceWork_t *tw, cLeaf_t *leaf ) {
 	int			k;
-	int			brushnum;
+	int			brushnum, patchnum;
 	cbrush_t	*b;
 	cPatch_t	*patch;
 
@@ -249,10 +249,10 @@ void CM_TestInLeaf( traceWork_t *tw, cLeaf_t *leaf ) {
 	for (k=0 ; k<leaf->numLeafBrushes ; k++) {
 		brushnum = cm.leafbrushes[leaf->firstLeafBrush+k];
 		b = &cm.brushes[brushnum];
-		if (b->checkcount == cm.checkcount) {
+		if ( tw->ctx->brushChecks[brushnum] == tw->ctx->checkcount ) {
 			continue;	// already checked this brush in another leaf
 		}
-		b->checkcount = cm.checkcount;
+		tw->ctx->brushChecks[brushnum] = tw->ctx->checkcount;
 
 		if ( !(b->contents & tw->contents)) {
 			continue;
@@ -271,14 +271,15 @@ void CM_TestInLeaf( traceWork_t *tw, cLeaf_t *leaf ) {
 	if ( !cm_noCurves->integer ) {
 #endif //BSPC
 		for ( k = 0 ; k < leaf->numLeafSurfaces ; k++ ) {
-			patch = cm.surfaces[ cm.leafsurfaces[ leaf->firstLeafSurface + k ] ];
+			patchnum = cm.leafsurfaces[ leaf->firstLeafSurface + k ];
+			patch = cm.surfaces[ patchnum ];
 			if ( !patch ) {
 				continue;
 			}
-			if ( patch->checkcount == cm.checkcount ) {
+			if ( tw->ctx->patchChecks[patchnum] == tw->ctx->checkcount ) {
 				continue;	// already checked this brush in another leaf
 			}
-			patch->checkcount = cm.checkcount;
+			tw->ctx->patchChecks[patchnum] = tw->ctx->checkcount;
 
 			if ( !(patch->contents & tw->contents)) {
 				continue;
@@ -308,8 +309,11 @@ void CM_TestCapsuleInCapsule( traceWork_t *tw, clipHandle_t model ) {
 	vec3_t p1, p2, tmp;
 	vec3_t offset, symetricSize[2];
 	float radius, halfwidth, halfheight, offs, r;
+	cmodel_t *cmod;
 
-	CM_ModelBounds(model, mins, maxs);
+	cmod = CM_ContextClipHandleToModel( tw->ctx, model );
+	VectorCopy( cmod->mins, mins );
+	VectorCopy( cmod->maxs, maxs );
 
 	VectorAdd(tw->start, tw->sphere.offset, top);
 	VectorSubtract(tw->start, tw->sphere.offset, bottom);
@@ -377,7 +381,9 @@ void CM_TestBoundingBoxInCapsule( traceWork_t *tw, clipHandle_t model ) {
 	int i;
 
 	// mins maxs of the capsule
-	CM_ModelBounds(model, mins, maxs);
+	cmod = CM_ContextClipHandleToModel( tw->ctx, model );
+	VectorCopy( cmod->mins, mins );
+	VectorCopy( cmod->maxs, maxs );
 
 	// offset for capsule center
 	for ( i = 0 ; i < 3 ; i++ ) {
@@ -395,9 +401,9 @@ void CM_TestBoundingBoxInCapsule( traceWork_t *tw, clipHandle_t model ) {
 	VectorSet( tw->sphere.offset, 0, 0, size[1][2] - tw->sphere.radius );
 
 	// replace the capsule with the bounding box
-	h = CM_TempBoxModel(tw->size[0], tw->size[1], qfalse);
+	h = CM_ContextTempBoxModel(tw->ctx, tw->size[0], tw->size[1], qfalse);
 	// calculate collision
-	cmod = CM_ClipHandleToModel( h );
+	cmod = CM_ContextClipHandleToModel( tw->ctx, h );
 	CM_TestInLeaf( tw, &cmod->leaf );
 }
 
@@ -427,13 +433,12 @@ void CM_PositionTest( traceWork_t *tw ) {
 	ll.storeLeafs = CM_StoreLeafs;
 	ll.lastLeaf = 0;
 	ll.overflowed = qfalse;
-
-	cm.checkcount++;
+	ll.ctx = tw->ctx;
 
 	CM_BoxLeafnums_r( &ll, 0 );
 
 
-	cm.checkcount++;
+	tw->ctx->checkcount++;
 
 	// test the contents of the leafs
 	for (i=0 ; i < ll.count ; i++) {
@@ -462,7 +467,9 @@ CM_TraceThroughPatch
 void CM_TraceThroughPatch( traceWork_t *tw, cPatch_t *patch ) {
 	float		oldFrac;
 
-	c_patch_traces++;
+	if ( !tw->ctx->index ) {
+		c_patch_traces++;	// statistics are only kept for the main context
+	}
 
 	oldFrac = tw->trace.fraction;
 
@@ -500,7 +507,9 @@ void CM_TraceThroughBrush( traceWork_t *tw, cbrush_t *brush ) {
 		return;
 	}
 
-	c_brush_traces++;
+	if ( !tw->ctx->index ) {
+		c_brush_traces++;
+	}
 
 	getout = qfalse;
 	startout = qfalse;
@@ -657,6 +666,57 @@ void CM_TraceThroughBrush( traceWork_t *tw, cbrush_t *brush ) {
 	}
 }
 
+/*
+================
+CM_TraceThroughBrushTree
+
+Returns qtrue if the trace was stopped by a brush
+================
+*/
+static qboolean CM_TraceThroughBrushTree( traceWork_t *tw, const cBrushNode_t *node ) {
+	int			i;
+	int			hit[4];
+	int			brushnum;
+	cbrush_t	*b;
+
+	// test all four children at once
+	for ( i = 0 ; i < 4 ; i++ ) {
+		hit[i] = ( tw->bounds[1][0] >= node->mins[0][i] ) & ( tw->bounds[0][0] <= node->maxs[0][i] )
+			& ( tw->bounds[1][1] >= node->mins[1][i] ) & ( tw->bounds[0][1] <= node->maxs[1][i] )
+			& ( tw->bounds[1][2] >= node->mins[2][i] ) & ( tw->bounds[0][2] <= node->maxs[2][i] );
+	}
+
+	for ( i = 0 ; i < 4 ; i++ ) {
+		if ( !hit[i] ) {
+			continue;
+		}
+		if ( node->children[i] >= 0 ) {
+			if ( CM_TraceThroughBrushTree( tw, &cm.brushNodes[node->children[i]] ) ) {
+				return qtrue;
+			}
+			continue;
+		}
+
+		brushnum = -1 - node->children[i];
+
+		b = &cm.brushes[brushnum];
+		if ( tw->ctx->brushChecks[brushnum] == tw->ctx->checkcount ) {
+			continue;	// already checked this brush in another leaf
+		}
+		tw->ctx->brushChecks[brushnum] = tw->ctx->checkcount;
+
+		if ( !(b->contents & tw->contents) ) {
+			continue;
+		}
+
+		CM_TraceThroughBrush( tw, b );
+		if ( !tw->trace.fraction ) {
+			return qtrue;
+		}
+	}
+	return qfalse;
+}
+
 /*
 ================
 CM_TraceThroughLeaf
@@ -664,19 +724,26 @@ CM_TraceThroughLeaf
 */
 void CM_TraceThroughLeaf( traceWork_t *tw, cLeaf_t *leaf ) {
 	int			k;
-	int			brushnum;
+	int			brushnum, patchnum;
 	cbrush_t	*b;
 	cPatch_t	*patch;
 
 	// trace line against all brushes in the leaf
+#ifndef BSPC
+	if ( leaf->brushTree && !cm_noBrushTrees->integer ) {
+		if ( CM_TraceThroughBrushTree( tw, leaf->brushTree ) ) {
+			return;
+		}
+	} else
+#endif
 	for ( k = 0 ; k < leaf->numLeafBrushes ; k++ ) {
 		brushnum = cm.leafbrushes[leaf->firstLeafBrush+k];
 
 		b = &cm.brushes[brushnum];
-		if ( b->checkcount == cm.checkcount ) {
+		if ( tw->ctx->brushChecks[brushnum] == tw->ctx->checkcount ) {
 			continue;	// already checked this brush in another leaf
 		}
-		b->checkcount = cm.checkcount;
+		tw->ctx->brushChecks[brushnum] = tw->ctx->checkcount;
 
 		if ( !(b->contents & tw->contents) ) {
 			continue;
@@ -700,14 +767,15 @@ void CM_TraceThroughLeaf( traceWork_t *tw, cLeaf_t *leaf ) {
 	if ( !cm_noCurves->integer ) {
 #endif
 		for ( k = 0 ; k < leaf->numLeafSurfaces ; k++ ) {
-			patch = cm.surfaces[ cm.leafsurfaces[ leaf->firstLeafSurface + k ] ];
+			patchnum = cm.leafsurfaces[ leaf->firstLeafSurface + k ];
+			patch = cm.surfaces[ patchnum ];
 			if ( !patch ) {
 				continue;
 			}
-			if ( patch->checkcount == cm.checkcount ) {
+			if ( tw->ctx->patchChecks[patchnum] == tw->ctx->checkcount ) {
 				continue;	// already checked this patch in another leaf
 			}
-			patch->checkcount = cm.checkcount;
+			tw->ctx->patchChecks[patchnum] = tw->ctx->checkcount;
 
 			if ( !(patch->contents & tw->contents) ) {
 				continue;
@@ -929,8 +997,11 @@ void CM_TraceCapsuleThroughCapsule( traceWork_t *tw, clipHandle_t model ) {
 	vec3_t top, bottom, starttop, startbottom, endtop, endbottom;
 	vec3_t offset, symetricSize[2];
 	float radius, halfwidth, halfheight, offs, h;
+	cmodel_t *cmod;
 
-	CM_ModelBounds(model, mins, maxs);
+	cmod = CM_ContextClipHandleToModel( tw->ctx, model );
+	VectorCopy( cmod->mins, mins );
+	VectorCopy( cmod->maxs, maxs );
 	// test trace bounds vs. capsule bounds
 	if ( tw->bounds[0][0] > maxs[0] + RADIUS_EPSILON
 		|| tw->bounds[0][1] > maxs[1] + RADIUS_EPSILON
@@ -992,7 +1063,9 @@ void CM_TraceBoundingBoxThroughCapsule( traceWork_t *tw, clipHandle_t model ) {
 	int i;
 
 	// mins maxs of the capsule
-	CM_ModelBounds(model, mins, maxs);
+	cmod = CM_ContextClipHandleToModel( tw->ctx, model );
+	VectorCopy( cmod->mins, mins );
+	VectorCopy( cmod->maxs, maxs );
 
 	// offset for capsule center
 	for ( i = 0 ; i < 3 ; i++ ) {
@@ -1010,9 +1083,9 @@ void CM_TraceBoundingBoxThroughCapsule( traceWork_t *tw, clipHandle_t model ) {
 	VectorSet( tw->sphere.offset, 0, 0, size[1][2] - tw->sphere.radius );
 
 	// replace the capsule with the bounding box
-	h = CM_TempBoxModel(tw->size[0], tw->size[1], qfalse);
+	h = CM_ContextTempBoxModel(tw->ctx, tw->size[0], tw->size[1], qfalse);
 	// calculate collision
-	cmod = CM_ClipHandleToModel( h );
+	cmod = CM_ContextClipHandleToModel( tw->ctx, h );
 	CM_TraceThroughLeaf( tw, &cmod->leaf );
 }
 
@@ -1141,23 +1214,26 @@ void CM_TraceThroughTree( traceWork_t *tw, int num, float p1f, float p2f, vec3_t
 CM_Trace
 ==================
 */
-void CM_Trace( trace_t *results, const vec3_t start, const vec3_t end, vec3_t mins, vec3_t maxs,
+void CM_Trace( cmTraceContext_t *ctx, trace_t *results, const vec3_t start, const vec3_t end, vec3_t mins, vec3_t maxs,
 						  clipHandle_t model, const vec3_t origin, int brushmask, int capsule, sphere_t *sphere ) {
 	int			i;
 	traceWork_t	tw;
 	vec3_t		offset;
 	cmodel_t	*cmod;
 
-	cmod = CM_ClipHandleToModel( model );
+	cmod = CM_ContextClipHandleToModel( ctx, model );
 
-	cm.checkcount++;		// for multi-check avoidance
+	ctx->checkcount++;		// for multi-check avoidance
 
-	c_traces++;				// for statistics, may be zeroed
+	if ( !ctx->index ) {
+		c_traces++;			// for statistics, may be zeroed
+	}
 
 	// fill in a default trace
 	Com_Memset( &tw, 0, sizeof(tw) );
 	tw.trace.fraction = 1;	// assume it goes the entire distance until shown otherwise
 	VectorCopy(origin, tw.modelOrigin);
+	tw.ctx = ctx;
 
 	if (!cm.numNodes) {
 		*results = tw.trace;
@@ -1362,18 +1438,41 @@ CM_BoxTrace
 void CM_BoxTrace( trace_t *results, const vec3_t start, const vec3_t end,
 						  vec3_t mins, vec3_t maxs,
 						  clipHandle_t model, int brushmask, int capsule ) {
-	CM_Trace( results, start, end, mins, maxs, model, vec3_origin, brushmask, capsule, NULL );
+	CM_Trace( &cm.contexts[0], results, start, end, mins, maxs, model, vec3_origin, brushmask, capsule, NULL );
+}
+
+/*
+==================
+CM_BoxTraceContext
+==================
+*/
+void CM_BoxTraceContext( int context, trace_t *results, const vec3_t start, const vec3_t end,
+						  vec3_t mins, vec3_t maxs,
+						  clipHandle_t model, int brushmask, int capsule ) {
+	CM_Trace( CM_GetTraceContext( context ), results, start, end, mins, maxs, model, vec3_origin, brushmask, capsule, NULL );
 }
 
 /*
 ==================
 CM_TransformedBoxTrace
+==================
+*/
+void CM_TransformedBoxTrace( trace_t *results, const vec3_t start, const vec3_t end,
+						  vec3_t mins, vec3_t maxs,
+						  clipHandle_t model, int brushmask,
+						  const vec3_t origin, const vec3_t angles, int capsule ) {
+	CM_TransformedBoxTraceContext( 0, results, start, end, mins, maxs, model, brushmask, origin, angles, capsule );
+}
+
+/*
+==================
+CM_TransformedBoxTraceContext
 
 Handles offseting and rotation of the end points for moving and
 rotating entities
 ==================
 */
-void CM_TransformedBoxTrace( trace_t *results, const vec3_t start, const vec3_t end,
+void CM_TransformedBoxTraceContext( int context, trace_t *results, const vec3_t start, const vec3_t end,
 						  vec3_t mins, vec3_t maxs,
 						  clipHandle_t model, int brushmask,
 						  const vec3_t origin, const vec3_t angles, int capsule ) {
@@ -1447,7 +1546,7 @@ void CM_TransformedBoxTrace( trace_t *results, const vec3_t start, const vec3_t
 	}
 
 	// sweep the box through the model
-	CM_Trace( &trace, start_l, end_l, symetricSize[0], symetricSize[1], model, origin, brushmask, capsule, &sphere );
+	CM_Trace( CM_GetTraceContext( context ), &trace, start_l, end_l, symetricSize[0], symetricSize[1], model, origin, brushmask, capsule, &sphere );
 
 	// if the bmodel was rotated and there was a collision
 	if ( rotated && trace.fraction != 1.0 ) {
@@ -1464,3 +1563,261 @@ void CM_TransformedBoxTrace( trace_t *results, const vec3_t start, const vec3_t
 
 	*results = trace;
 }
+
+/*
+==================
+CM_TraceThroughAxialBrush
+
+CM_TestBoxInBrush or CM_TraceThroughBrush for a six sided axial brush like
+the temp box one, with the sides in the same order: +x, -x, +y, -y, +z, -z.
+start, end, size, bounds and sphere are what the traceWork_t would hold.
+==================
+*/
+static void CM_TraceThroughAxialBrush( trace_t *trace, const vec3_t start, const vec3_t end,
+						  vec3_t size[2], const sphere_t *sphere, vec3_t bounds[2],
+						  const vec3_t boxMins, const vec3_t boxMaxs, qboolean position ) {
+	int			side, axis, leadSide;
+	float		planeDist, dist, d1, d2, f, t;
+	float		startp, endp;
+	float		enterFrac, leaveFrac;
+	qboolean	getout, startout;
+
+	if ( position ) {
+		// CM_TestBoxInBrush, the brush has no planes beyond the axial ones
+		if ( bounds[0][0] > boxMaxs[0] || bounds[0][1] > boxMaxs[1] || bounds[0][2] > boxMaxs[2]
+			|| bounds[1][0] < boxMins[0] || bounds[1][1] < boxMins[1] || bounds[1][2] < boxMins[2] ) {
+			return;
+		}
+		trace->startsolid = trace->allsolid = qtrue;
+		trace->fraction = 0;
+		trace->contents = CONTENTS_BODY;
+		return;
+	}
+
+	// CM_TraceThroughLeaf
+	if ( !CM_BoundsIntersect( bounds[0], bounds[1], boxMins, boxMaxs ) ) {
+		return;
+	}
+
+	enterFrac = -1.0;
+	leaveFrac = 1.0;
+	leadSide = -1;
+	getout = qfalse;
+	startout = qfalse;
+
+	for ( side = 0 ; side < 6 ; side++ ) {
+		axis = side >> 1;
+		planeDist = ( side & 1 ) ? -boxMins[axis] : boxMaxs[axis];
+
+		if ( sphere->use ) {
+			// adjust the plane distance apropriately for radius
+			dist = planeDist + sphere->radius;
+
+			// find the closest point on the capsule to the plane,
+			// the offset is vertical so only its own axis counts
+			t = ( side & 1 ) ? -sphere->offset[axis] : sphere->offset[axis];
+			if ( t > 0 ) {
+				startp = start[axis] - sphere->offset[axis];
+				endp = end[axis] - sphere->offset[axis];
+			} else {
+				startp = start[axis] + sphere->offset[axis];
+				endp = end[axis] + sphere->offset[axis];
+			}
+		} else {
+			// the plane signbits pick the mins corner for the positive
+			// sides and the maxs corner for the negative ones
+			dist = ( side & 1 ) ? planeDist + size[1][axis] : planeDist - size[0][axis];
+			startp = start[axis];
+			endp = end[axis];
+		}
+
+		if ( side & 1 ) {
+			d1 = -startp - dist;
+			d2 = -endp - dist;
+		} else {
+			d1 = startp - dist;
+			d2 = endp - dist;
+		}
+
+		if ( d2 > 0 ) {
+			getout = qtrue;	// endpoint is not in solid
+		}
+		if ( d1 > 0 ) {
+			startout = qtrue;
+		}
+
+		// if completely in front of face, no intersection with the entire brush
+		if ( d1 > 0 && ( d2 >= SURFACE_CLIP_EPSILON || d2 >= d1 ) ) {
+			return;
+		}
+
+		// if it doesn't cross the plane, the plane isn't relevent
+		if ( d1 <= 0 && d2 <= 0 ) {
+			continue;
+		}
+
+		// crosses face
+		if ( d1 > d2 ) {	// enter
+			f = ( d1 - SURFACE_CLIP_EPSILON ) / ( d1 - d2 );
+			if ( f < 0 ) {
+				f = 0;
+			}
+			if ( f > enterFrac ) {
+				enterFrac = f;
+				leadSide = side;
+			}
+		} else {	// leave
+			f = ( d1 + SURFACE_CLIP_EPSILON ) / ( d1 - d2 );
+			if ( f > 1 ) {
+				f = 1;
+			}
+			if ( f < leaveFrac ) {
+				leaveFrac = f;
+			}
+		}
+	}
+
+	if ( !startout ) {	// original point was inside brush
+		trace->startsolid = qtrue;
+		if ( !getout ) {
+			trace->allsolid = qtrue;
+			trace->fraction = 0;
+			trace->contents = CONTENTS_BODY;
+		}
+	} else if ( enterFrac < leaveFrac && enterFrac > -1 && enterFrac < trace->fraction ) {
+		if ( enterFrac < 0 ) {
+			enterFrac = 0;
+		}
+		trace->fraction = enterFrac;
+		axis = leadSide >> 1;
+		trace->plane.normal[axis] = ( leadSide & 1 ) ? -1 : 1;
+		trace->plane.dist = ( leadSide & 1 ) ? -boxMins[axis] : boxMaxs[axis];
+		trace->plane.type = ( leadSide & 1 ) ? 3 + axis : axis;
+		trace->plane.signbits = ( leadSide & 1 ) ? 1 << axis : 0;
+		trace->contents = CONTENTS_BODY;
+	}
+}
+
+/*
+==================
+CM_TraceAgainstBox
+
+Clips a box or capsule trace against an unrotated bounding box or capsule
+entity, doing the same arithmetic in the same order as the temp box hull
+path through CM_TransformedBoxTrace and CM_Trace, so the results are
+identical (up to the last bit when the compiler is allowed to reassociate
+float math).  A capsule entity hit by a box trace is handled the way
+CM_TraceBoundingBoxThroughCapsule does it, by sweeping a capsule of the
+entity's size through a box of the trace's size.  This saves building the
+temp box hull and setting up a full trace for every entity a move is
+clipped against.  Capsule against capsule is already analytic and still
+has to go through CM_TempBoxModel.
+==================
+*/
+void CM_TraceAgainstBox( trace_t *results, const vec3_t start, const vec3_t end,
+						  const vec3_t mins, const vec3_t maxs,
+						  const vec3_t boxMins, const vec3_t boxMaxs,
+						  int brushmask, const vec3_t origin, int capsule, int boxCapsule ) {
+	trace_t		trace;
+	vec3_t		offset, symetricSize[2];
+	vec3_t		start_l, end_l;
+	vec3_t		size[2], tstart, tend;
+	vec3_t		bounds[2];
+	sphere_t	sphere;
+	float		halfwidth, halfheight;
+	qboolean	position;
+	int			i;
+
+	Com_Memset( &trace, 0, sizeof( trace ) );
+	trace.fraction = 1;
+
+	// the temp box brush is CONTENTS_BODY
+	if ( !( brushmask & CONTENTS_BODY ) ) {
+		goto done;
+	}
+
+	// CM_TransformedBoxTrace
+	for ( i = 0 ; i < 3 ; i++ ) {
+		offset[i] = ( mins[i] + maxs[i] ) * 0.5;
+		symetricSize[0][i] = mins[i] - offset[i];
+		symetricSize[1][i] = maxs[i] - offset[i];
+		start_l[i] = start[i] + offset[i];
+		end_l[i] = end[i] + offset[i];
+	}
+	VectorSubtract( start_l, origin, start_l );
+	VectorSubtract( end_l, origin, end_l );
+
+	halfwidth = symetricSize[ 1 ][ 0 ];
+	halfheight = symetricSize[ 1 ][ 2 ];
+
+	sphere.use = capsule;
+	sphere.radius = ( halfwidth > halfheight ) ? halfheight : halfwidth;
+	sphere.halfheight = halfheight;
+	VectorSet( sphere.offset, 0, 0, halfheight - sphere.radius );
+
+	// CM_Trace
+	for ( i = 0 ; i < 3 ; i++ ) {
+		offset[i] = ( symetricSize[0][i] + symetricSize[1][i] ) * 0.5;
+		size[0][i] = symetricSize[0][i] - offset[i];
+		size[1][i] = symetricSize[1][i] - offset[i];
+		tstart[i] = start_l[i] + offset[i];
+		tend[i] = end_l[i] + offset[i];
+	}
+
+	if ( sphere.use ) {
+		for ( i = 0 ; i < 3 ; i++ ) {
+			if ( tstart[i] < tend[i] ) {
+				bounds[0][i] = tstart[i] - fabs( sphere.offset[i] ) - sphere.radius;
+				bounds[1][i] = tend[i] + fabs( sphere.offset[i] ) + sphere.radius;
+			} else {
+				bounds[0][i] = tend[i] - fabs( sphere.offset[i] ) - sphere.radius;
+				bounds[1][i] = tstart[i] + fabs( sphere.offset[i] ) + sphere.radius;
+			}
+		}
+	} else {
+		for ( i = 0 ; i < 3 ; i++ ) {
+			if ( tstart[i] < tend[i] ) {
+				bounds[0][i] = tstart[i] + size[0][i];
+				bounds[1][i] = tend[i] + size[1][i];
+			} else {
+				bounds[0][i] = tend[i] + size[0][i];
+				bounds[1][i] = tstart[i] + size[1][i];
+			}
+		}
+	}
+
+	position = ( start_l[0] == end_l[0] && start_l[1] == end_l[1] && start_l[2] == end_l[2] );
+
+	if ( !boxCapsule ) {
+		CM_TraceThroughAxialBrush( &trace, tstart, tend, size, &sphere, bounds, boxMins, boxMaxs, position );
+		goto done;
+	}
+
+	if ( capsule ) {
+		Com_Error( ERR_DROP, "CM_TraceAgainstBox: capsule against capsule" );
+	}
+
+	// CM_TraceBoundingBoxThroughCapsule and CM_TestBoundingBoxInCapsule
+	// swap the shapes, the bounds are left as they were
+	for ( i = 0 ; i < 3 ; i++ ) {
+		offset[i] = ( boxMins[i] + boxMaxs[i] ) * 0.5;
+		symetricSize[0][i] = boxMins[i] - offset[i];
+		symetricSize[1][i] = boxMaxs[i] - offset[i];
+		tstart[i] -= offset[i];
+		tend[i] -= offset[i];
+	}
+
+	sphere.use = qtrue;
+	sphere.radius = ( symetricSize[1][0] > symetricSize[1][2] ) ? symetricSize[1][2] : symetricSize[1][0];
+	sphere.halfheight = symetricSize[1][2];
+	VectorSet( sphere.offset, 0, 0, symetricSize[1][2] - sphere.radius );
+
+	CM_TraceThroughAxialBrush( &trace, tstart, tend, size, &sphere, bounds, size[0], size[1], position );
+
+done:
+	trace.endpos[0] = start[0] + trace.fraction * ( end[0] - start[0] );
+	trace.endpos[1] = start[1] + trace.fraction * ( end[1] - start[1] );
+	trace.endpos[2] = start[2] + trace.fraction * ( end[2] - start[2] );
+
+	*results = trace;
+}
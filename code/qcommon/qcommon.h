@@ -377,6 +377,11 @@ void	VM_Debug( int level );
 
 void	*VM_ArgPtr( intptr_t intValue );
 void	*VM_ExplicitArgPtr( vm_t *vm, intptr_t intValue );
+void	VM_CheckBlock( intptr_t vmAddr, size_t n, const char *operation );
+
+#define	MAX_VM_SHARED	2
+void	VM_ShareData( vm_t *vm, int region, intptr_t vmAddr, int length );
+// tells vmrecord about data the engine keeps a pointer to, like the game entities
 
 #define	VMA(x) VM_ArgPtr(args[x])
 static ID_INLINE float _vmf(intptr_t x)
@@ -1134,6 +1139,16 @@ char **Sys_ListFiles( const char *directory, const char *extension, char *filter
 void	Sys_FreeFileList( char **list );
 void	Sys_Sleep(int msec);
 
+// worker threads for work that can be split into independent jobs,
+// the calling thread runs jobs as worker 0 and Sys_RunJobs returns
+// once all of them are done, so they can't touch anything else
+#define	MAX_WORKER_THREADS	16
+
+typedef void (*sysJob_t)( void *data, int job, int worker );
+
+int		Sys_StartWorkers( int count );	// returns the number of threads running
+void	Sys_RunJobs( sysJob_t func, void *data, int numJobs );
+
 qboolean Sys_LowPhysicalMemory( void );
 
 void Sys_SetEnv(const char *name, const char *value);
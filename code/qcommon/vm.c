@@ -49,6 +49,15 @@ vm_t	vmTable[MAX_VM];
 
 void VM_VmInfo_f( void );
 void VM_VmProfile_f( void );
+void VM_Record_f( void );
+void VM_StopRecord_f( void );
+
+static void VM_RecordCall( vm_t *vm, int *args );
+static void VM_RecordReturn( vm_t *vm, intptr_t r );
+static void VM_StopRecord( void );
+static void VM_RecordPointer( void );
+
+static vm_t		*recordVM;
 
 
 
@@ -76,6 +85,8 @@ void VM_Init( void ) {
 
 	Cmd_AddCommand ("vmprofile", VM_VmProfile_f );
 	Cmd_AddCommand ("vminfo", VM_VmInfo_f );
+	Cmd_AddCommand ("vmrecord", VM_Record_f );
+	Cmd_AddCommand ("vmstoprecord", VM_StopRecord_f );
 
 	Com_Memset( vmTable, 0, sizeof( vmTable ) );
 }
@@ -704,6 +715,10 @@ void VM_Free( vm_t *vm ) {
 		}
 	}
 
+	if ( vm == recordVM ) {
+		VM_StopRecord();
+	}
+
 	if(vm->destroy)
 		vm->destroy(vm);
 
@@ -755,6 +770,9 @@ void *VM_ArgPtr( intptr_t intValue ) {
 		return (void *)(currentVM->dataBase + intValue);
 	}
 	else {
+		if ( recordVM ) {
+			VM_RecordPointer();
+		}
 		return (void *)(currentVM->dataBase + (intValue & currentVM->dataMask));
 	}
 }
@@ -773,6 +791,9 @@ void *VM_ExplicitArgPtr( vm_t *vm, intptr_t intValue ) {
 		return (void *)(vm->dataBase + intValue);
 	}
 	else {
+		if ( vm == recordVM ) {
+			VM_RecordPointer();
+		}
 		return (void *)(vm->dataBase + (intValue & vm->dataMask));
 	}
 }
@@ -836,6 +857,8 @@ intptr_t QDECL VM_Call( vm_t *vm, int callnum, ... )
                             args[8],  args[9]);
 	} else {
 #if ( id386 || idsparc ) && !defined __clang__ // calling convention doesn't need conversion in some cases
+		if ( vm == recordVM )
+			VM_RecordCall( vm, (int*)&callnum );
 #ifndef NO_VM_COMPILED
 		if ( vm->compiled )
 			r = VM_CallCompiled( vm, (int*)&callnum );
@@ -855,6 +878,8 @@ intptr_t QDECL VM_Call( vm_t *vm, int callnum, ... )
 			a.args[i] = va_arg(ap, int);
 		}
 		va_end(ap);
+		if ( vm == recordVM )
+			VM_RecordCall( vm, &a.callnum );
 #ifndef NO_VM_COMPILED
 		if ( vm->compiled )
 			r = VM_CallCompiled( vm, &a.callnum );
@@ -865,6 +890,9 @@ intptr_t QDECL VM_Call( vm_t *vm, int callnum, ... )
 	}
 	--vm->callLevel;
 
+	if ( vm == recordVM )
+		VM_RecordReturn( vm, r );
+
 	if ( oldVM != NULL )
 	  currentVM = oldVM;
 	return r;
@@ -985,6 +1013,32 @@ void VM_LogSyscalls( int *args ) {
 		args[0], args[1], args[2], args[3], args[4] );
 }
 
+/*
+=================
+VM_CheckBlock
+Makes sure a block passed to a system call lies entirely within the
+currentVM data space
+=================
+*/
+
+void VM_CheckBlock( intptr_t vmAddr, size_t n, const char *operation )
+{
+	unsigned int dataMask;
+
+	// native libraries are trusted anyway
+	if ( !currentVM || currentVM->entryPoint ) {
+		return;
+	}
+
+	dataMask = currentVM->dataMask;
+
+	if ( ( vmAddr & dataMask ) != vmAddr
+	|| ( ( vmAddr + n ) & dataMask ) != vmAddr + n )
+	{
+		Com_Error( ERR_DROP, "%s out of range!", operation );
+	}
+}
+
 /*
 =================
 VM_BlockCopy
@@ -1006,3 +1060,412 @@ void VM_BlockCopy(unsigned int dest, unsigned int src, size_t n)
 
 	Com_Memcpy(currentVM->dataBase + dest, currentVM->dataBase + src, n);
 }
+
+/*
+==============================================================================
+
+VM CAPTURE
+
+vmrecord logs every VM_Call into one vm together with everything the engine
+hands back to it: system call results and the bytes of the data segment the
+engine changed.  The qvmreplay tool feeds such a capture to each vm backend.
+
+A system call writes vm memory through VM_ArgPtr or through data the engine
+keeps a pointer to, like the game entities SV_LinkEntity fills in.  The
+shared data from VM_ShareData is copied before every system call, the rest
+of the data segment when a pointer is first handed out, and both are
+compared after the call returns.  That makes recording slow for pointer
+heavy calls like traces.
+
+==============================================================================
+*/
+
+#define	MAX_RECORD_DEPTH	8
+
+static fileHandle_t	recordFile;
+static intptr_t		(*recordSystemCall)( intptr_t *parms );
+static byte			*recordShadow[MAX_RECORD_DEPTH + 1];	// [0] follows the data between calls
+static qboolean		recordShadowValid[MAX_RECORD_DEPTH + 1];
+static int			recordDepth;
+
+/*
+=================
+VM_DataChecksum
+
+Covers the data segment up to the stack, stack contents legitimately
+differ between the interpreter and the compilers.  Runs after every call,
+so it is a plain fletcher style sum rather than Com_BlockChecksum.
+=================
+*/
+unsigned VM_DataChecksum( vm_t *vm ) {
+	unsigned	*data;
+	unsigned	sum1, sum2;
+	int			i, numWords;
+
+	data = (unsigned *)vm->dataBase;
+	numWords = vm->stackBottom >> 2;
+
+	sum1 = sum2 = 0;
+	for ( i = 0 ; i < numWords ; i++ ) {
+		sum1 += data[i];
+		sum2 += sum1;
+	}
+
+	return sum1 ^ ( sum2 << 1 ) ^ ( sum2 >> 31 );
+}
+
+static void VM_RecordInt( int value ) {
+	FS_Write( &value, sizeof( value ), recordFile );
+}
+
+static void VM_RecordInt64( int64_t value ) {
+	FS_Write( &value, sizeof( value ), recordFile );
+}
+
+/*
+=================
+VM_ShareData
+
+The shared regions are kept even when not recording, the game passes its
+entities once and vmrecord can be started later
+=================
+*/
+void VM_ShareData( vm_t *vm, int region, intptr_t vmAddr, int length ) {
+	int		ofs, end;
+
+	if ( region < 0 || region >= MAX_VM_SHARED ) {
+		Com_Error( ERR_FATAL, "VM_ShareData: bad region %i", region );
+	}
+
+	if ( !vm || vm->dllHandle ) {
+		return;
+	}
+
+	// whole words, the patches are compared a word at a time
+	ofs = ( vmAddr & vm->dataMask ) & ~3;
+	end = ofs + ( ( ( vmAddr & 3 ) + length + 3 ) & ~3 );
+	if ( length <= 0 ) {
+		end = ofs;
+	}
+	if ( end > vm->dataMask + 1 ) {
+		end = vm->dataMask + 1;
+	}
+
+	vm->sharedOfs[region] = ofs;
+	vm->sharedLength[region] = end - ofs;
+}
+
+/*
+=================
+VM_RecordCopy
+
+Brings shadow up to date with the data segment, leaving out the shared
+regions if they were already copied before the system call
+=================
+*/
+static void VM_RecordCopy( byte *shadow, qboolean skipShared ) {
+	int		ofs, next, nextEnd, length;
+	int		i;
+
+	length = recordVM->dataMask + 1;
+
+	for ( ofs = 0 ; ofs < length ; ofs = nextEnd ) {
+		next = nextEnd = length;
+		for ( i = 0 ; skipShared && i < MAX_VM_SHARED ; i++ ) {
+			if ( !recordVM->sharedLength[i] ) {
+				continue;
+			}
+			if ( recordVM->sharedOfs[i] + recordVM->sharedLength[i] <= ofs
+				|| recordVM->sharedOfs[i] >= next ) {
+				continue;
+			}
+			next = recordVM->sharedOfs[i] > ofs ? recordVM->sharedOfs[i] : ofs;
+			nextEnd = recordVM->sharedOfs[i] + recordVM->sharedLength[i];
+		}
+		Com_Memcpy( shadow + ofs, recordVM->dataBase + ofs, next - ofs );
+	}
+}
+
+static void VM_RecordCopyShared( byte *shadow ) {
+	int		i;
+
+	for ( i = 0 ; i < MAX_VM_SHARED ; i++ ) {
+		Com_Memcpy( shadow + recordVM->sharedOfs[i], recordVM->dataBase + recordVM->sharedOfs[i],
+			recordVM->sharedLength[i] );
+	}
+}
+
+/*
+=================
+VM_RecordRange
+
+Writes the runs where the bytes from ofs to end differ from shadow and
+brings shadow up to date
+=================
+*/
+static void VM_RecordRange( byte *shadow, int ofs, int end ) {
+	int		*data, *old;
+	int		numWords;
+	int		start, stop, gap;
+
+	data = (int *)recordVM->dataBase;
+	old = (int *)shadow;
+	numWords = end >> 2;
+
+	for ( start = ofs >> 2 ; start < numWords ; ) {
+		if ( data[start] == old[start] ) {
+			start++;
+			continue;
+		}
+
+		// merge runs separated by only a few unchanged words
+		for ( stop = start + 1, gap = 0 ; stop < numWords && gap < 4 ; stop++ ) {
+			if ( data[stop] == old[stop] ) {
+				gap++;
+			} else {
+				gap = 0;
+			}
+		}
+		stop -= gap;
+
+		VM_RecordInt( start * 4 );
+		VM_RecordInt( ( stop - start ) * 4 );
+		FS_Write( data + start, ( stop - start ) * 4, recordFile );
+		Com_Memcpy( old + start, data + start, ( stop - start ) * 4 );
+
+		start = stop;
+	}
+}
+
+/*
+=================
+VM_RecordPatches
+
+Writes the changes to the whole data segment, or only to the shared
+regions if the rest of shadow isn't valid
+=================
+*/
+static void VM_RecordPatches( byte *shadow, qboolean sharedOnly ) {
+	int		i;
+
+	if ( !sharedOnly ) {
+		VM_RecordRange( shadow, 0, recordVM->dataMask + 1 );
+	} else {
+		for ( i = 0 ; i < MAX_VM_SHARED ; i++ ) {
+			VM_RecordRange( shadow, recordVM->sharedOfs[i],
+				recordVM->sharedOfs[i] + recordVM->sharedLength[i] );
+		}
+	}
+
+	VM_RecordInt( 0 );
+	VM_RecordInt( 0 );
+}
+
+/*
+=================
+VM_RecordPointer
+
+Called whenever a system call of the recorded vm asks for a pointer into its
+data segment, before anything can be written through it
+=================
+*/
+static void VM_RecordPointer( void ) {
+	vm_t	*vm;
+
+	vm = recordVM;
+
+	if ( currentVM != vm || !recordDepth || recordShadowValid[recordDepth] ) {
+		return;
+	}
+
+	// the shared regions were copied when the system call was made, the
+	// engine may have written to them since
+	VM_RecordCopy( recordShadow[recordDepth], qtrue );
+	recordShadowValid[recordDepth] = qtrue;
+}
+
+/*
+=================
+VM_RecordSyscall
+
+Stands in for the system call handler of the recorded vm
+=================
+*/
+static intptr_t VM_RecordSyscall( intptr_t *args ) {
+	vm_t		*vm;
+	intptr_t	r;
+	int			i;
+
+	vm = recordVM;
+
+	if ( recordDepth == MAX_RECORD_DEPTH ) {
+		Com_Error( ERR_DROP, "VM_RecordSyscall: system calls nested too deep" );
+	}
+
+	recordDepth++;
+	recordShadowValid[recordDepth] = qfalse;
+	if ( !recordShadow[recordDepth] ) {
+		recordShadow[recordDepth] = Z_Malloc( vm->dataMask + 1 );
+	}
+	VM_RecordCopyShared( recordShadow[recordDepth] );
+
+	r = recordSystemCall( args );
+
+	// the handler may have stopped the recording
+	if ( vm != recordVM ) {
+		return r;
+	}
+
+	VM_RecordInt( VMR_SYSCALL );
+	for ( i = 0 ; i < VM_RECORD_SYSCALL_ARGS ; i++ ) {
+		VM_RecordInt( args[i] );
+	}
+	VM_RecordInt64( r );
+	VM_RecordPatches( recordShadow[recordDepth], !recordShadowValid[recordDepth] );
+
+	recordDepth--;
+
+	return r;
+}
+
+/*
+=================
+VM_RecordCall
+
+The patches cover what the engine wrote since the vm last ran, for the
+first call of a recording that is the complete data segment
+=================
+*/
+static void VM_RecordCall( vm_t *vm, int *args ) {
+	int		i;
+
+	if ( vm->callLevel == 1 ) {
+		recordDepth = 0;
+		recordShadowValid[0] = qtrue;
+	}
+
+	VM_RecordInt( VMR_CALL );
+	VM_RecordInt( vm->programStack );
+	for ( i = 0 ; i < VM_RECORD_CALL_ARGS ; i++ ) {
+		VM_RecordInt( args[i] );
+	}
+
+	// a call made from within a system call that has not handed out any
+	// pointers yet can only have been preceded by writes to the shared data
+	VM_RecordPatches( recordShadow[recordDepth], !recordShadowValid[recordDepth] );
+}
+
+static void VM_RecordReturn( vm_t *vm, intptr_t r ) {
+	VM_RecordInt( VMR_RETURN );
+	VM_RecordInt64( r );
+	VM_RecordInt( VM_DataChecksum( vm ) );
+
+	if ( !vm->callLevel ) {
+		Com_Memcpy( recordShadow[0], vm->dataBase, vm->dataMask + 1 );
+	}
+}
+
+static void VM_StopRecord( void ) {
+	int		i;
+
+	if ( !recordVM ) {
+		return;
+	}
+
+	recordVM->systemCall = recordSystemCall;
+	recordVM = NULL;
+
+	FS_FCloseFile( recordFile );
+	recordFile = 0;
+
+	for ( i = 0 ; i <= MAX_RECORD_DEPTH ; i++ ) {
+		if ( recordShadow[i] ) {
+			Z_Free( recordShadow[i] );
+			recordShadow[i] = NULL;
+		}
+	}
+	recordDepth = 0;
+
+	Com_Printf( "Stopped vm recording.\n" );
+}
+
+/*
+==============
+VM_Record_f
+
+vmrecord <vm> <filename>
+==============
+*/
+void VM_Record_f( void ) {
+	vm_t	*vm;
+	char	name[MAX_QPATH];
+	int		i;
+
+	if ( Cmd_Argc() != 3 ) {
+		Com_Printf( "usage: vmrecord <vm> <filename>\n" );
+		return;
+	}
+
+	if ( recordVM ) {
+		Com_Printf( "Already recording %s.\n", recordVM->name );
+		return;
+	}
+
+	vm = NULL;
+	for ( i = 0 ; i < MAX_VM ; i++ ) {
+		if ( vmTable[i].name[0] && !Q_stricmp( vmTable[i].name, Cmd_Argv( 1 ) ) ) {
+			vm = &vmTable[i];
+			break;
+		}
+	}
+
+	if ( !vm ) {
+		Com_Printf( "No vm named %s is loaded.\n", Cmd_Argv( 1 ) );
+		return;
+	}
+
+	if ( vm->dllHandle ) {
+		Com_Printf( "Can't record %s, it is a native library.\n", vm->name );
+		return;
+	}
+
+	if ( vm->callLevel ) {
+		Com_Printf( "Can't start recording %s while it is running.\n", vm->name );
+		return;
+	}
+
+	recordFile = FS_FOpenFileWrite( Cmd_Argv( 2 ) );
+	if ( !recordFile ) {
+		Com_Printf( "Couldn't open %s for writing.\n", Cmd_Argv( 2 ) );
+		return;
+	}
+
+	VM_RecordInt( VM_RECORD_MAGIC );
+	VM_RecordInt( vm->dataMask + 1 );
+	Com_Memset( name, 0, sizeof( name ) );
+	Q_strncpyz( name, vm->name, sizeof( name ) );
+	FS_Write( name, sizeof( name ), recordFile );
+
+	recordShadow[0] = Z_Malloc( vm->dataMask + 1 );
+	recordDepth = 0;
+
+	recordSystemCall = vm->systemCall;
+	vm->systemCall = VM_RecordSyscall;
+	recordVM = vm;
+
+	Com_Printf( "Recording %s to %s.\n", vm->name, Cmd_Argv( 2 ) );
+}
+
+/*
+==============
+VM_StopRecord_f
+==============
+*/
+void VM_StopRecord_f( void ) {
+	if ( !recordVM ) {
+		Com_Printf( "Not recording a vm.\n" );
+		return;
+	}
+
+	VM_StopRecord();
+}
@@ -0,0 +1,869 @@
+/*
+===========================================================================
+Copyright (C) 1999-2005 Id Software, Inc.
+
+This file is part of Quake III Arena source code.
+
+Quake III Arena source code is free software; you can redistribute it
+and/or modify it under the terms of the GNU General Public License as
+published by the Free Software Foundation; either version 2 of the License,
+or (at your option) any later version.
+
+Quake III Arena source code is distributed in the hope that it will be
+useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Quake III Arena source code; if not, write to the Free Software
+Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+===========================================================================
+*/
+// vm_aarch64.c -- load time compiler and execution environment for AArch64
+
+#include "vm_local.h"
+#include <sys/types.h>
+#include <sys/mman.h>
+#include <sys/time.h>
+#include <time.h>
+
+#include <inttypes.h>
+
+/*
+
+  Instructions are encoded directly, no assembler is involved.  Every
+  bytecode instruction expands to a sequence whose length does not depend
+  on branch distances or code addresses, so the first pass only has to
+  count words and the second pass writes them out with all instruction
+  offsets already known.
+
+  x19		pointer data (vm->dataBase)
+  x20		opStack base (opStack)
+  w21		opStack index, always wrapped to 0..255
+  w22		program frame pointer (programStack)
+  w23		dataMask
+  w24		dataMask & ~1
+  w25		dataMask & ~3
+  x30		native return address, pushed by OP_ENTER and popped by OP_LEAVE
+  w0-w3		scratch
+  x9		address of the current opStack slot
+  x16		scratch for calls into C
+  s0, s1	scratch
+
+*/
+
+#define R_DATABASE	19
+#define R_OPSTACK	20
+#define R_OPSTACKIDX	21
+#define R_PSTACK	22
+#define R_MASK		23
+#define R_MASK2		24
+#define R_MASK4		25
+#define R_SLOT		9
+#define R_CALL		16
+#define R_ZR		31
+#define R_SP		31
+
+// condition codes
+#define CC_EQ	0x0
+#define CC_NE	0x1
+#define CC_HS	0x2
+#define CC_LO	0x3
+#define CC_MI	0x4
+#define CC_HI	0x8
+#define CC_LS	0x9
+#define CC_GE	0xa
+#define CC_LT	0xb
+#define CC_GT	0xc
+#define CC_LE	0xd
+
+// data processing, 32 bit
+#define ADD(rd, rn, rm)		(0x0b000000 | ((rm) << 16) | ((rn) << 5) | (rd))
+#define SUB(rd, rn, rm)		(0x4b000000 | ((rm) << 16) | ((rn) << 5) | (rd))
+#define AND(rd, rn, rm)		(0x0a000000 | ((rm) << 16) | ((rn) << 5) | (rd))
+#define ORR(rd, rn, rm)		(0x2a000000 | ((rm) << 16) | ((rn) << 5) | (rd))
+#define EOR(rd, rn, rm)		(0x4a000000 | ((rm) << 16) | ((rn) << 5) | (rd))
+#define ORN(rd, rn, rm)		(0x2a200000 | ((rm) << 16) | ((rn) << 5) | (rd))
+#define MUL(rd, rn, rm)		(0x1b007c00 | ((rm) << 16) | ((rn) << 5) | (rd))
+#define MSUB(rd, rn, rm, ra)	(0x1b008000 | ((rm) << 16) | ((ra) << 10) | ((rn) << 5) | (rd))
+#define SDIV(rd, rn, rm)	(0x1ac00c00 | ((rm) << 16) | ((rn) << 5) | (rd))
+#define UDIV(rd, rn, rm)	(0x1ac00800 | ((rm) << 16) | ((rn) << 5) | (rd))
+#define LSLV(rd, rn, rm)	(0x1ac02000 | ((rm) << 16) | ((rn) << 5) | (rd))
+#define LSRV(rd, rn, rm)	(0x1ac02400 | ((rm) << 16) | ((rn) << 5) | (rd))
+#define ASRV(rd, rn, rm)	(0x1ac02800 | ((rm) << 16) | ((rn) << 5) | (rd))
+#define ADDI(rd, rn, imm)	(0x11000000 | ((imm) << 10) | ((rn) << 5) | (rd))
+#define SUBI(rd, rn, imm)	(0x51000000 | ((imm) << 10) | ((rn) << 5) | (rd))
+#define CMP(rn, rm)		(0x6b00001f | ((rm) << 16) | ((rn) << 5))
+#define CMPI(rn, imm)		(0x7100001f | ((imm) << 10) | ((rn) << 5))
+#define UXTB(rd, rn)		(0x53001c00 | ((rn) << 5) | (rd))
+#define SXTB(rd, rn)		(0x13001c00 | ((rn) << 5) | (rd))
+#define SXTH(rd, rn)		(0x13003c00 | ((rn) << 5) | (rd))
+#define MOV(rd, rm)		ORR(rd, R_ZR, rm)
+#define NEG(rd, rm)		SUB(rd, R_ZR, rm)
+#define MVN(rd, rm)		ORN(rd, R_ZR, rm)
+#define MOVZ(rd, imm)		(0x52800000 | ((imm) << 5) | (rd))
+#define MOVK16(rd, imm)		(0x72a00000 | ((imm) << 5) | (rd))
+
+// data processing, 64 bit
+#define MOVX(rd, rm)		(0xaa0003e0 | ((rm) << 16) | (rd))
+#define MOVZX(rd, imm, hw)	(0xd2800000 | ((hw) << 21) | ((imm) << 5) | (rd))
+#define MOVKX(rd, imm, hw)	(0xf2800000 | ((hw) << 21) | ((imm) << 5) | (rd))
+#define ADDX(rd, rn, rm)	(0x8b000000 | ((rm) << 16) | ((rn) << 5) | (rd))
+#define ADDX_UXTW2(rd, rn, rm)	(0x8b204800 | ((rm) << 16) | ((rn) << 5) | (rd))
+#define MOVFROMSP(rd)		(0x910003e0 | (rd))
+
+// loads and stores; the register offset forms zero extend a w index
+#define LDRI(rt, rn, ofs)	(0xb9400000 | (((ofs) >> 2) << 10) | ((rn) << 5) | (rt))
+#define STRI(rt, rn, ofs)	(0xb9000000 | (((ofs) >> 2) << 10) | ((rn) << 5) | (rt))
+#define LDRXI(rt, rn, ofs)	(0xf9400000 | (((ofs) >> 3) << 10) | ((rn) << 5) | (rt))
+#define STRXI(rt, rn, ofs)	(0xf9000000 | (((ofs) >> 3) << 10) | ((rn) << 5) | (rt))
+#define LDRSI(rt, rn, ofs)	(0xbd400000 | (((ofs) >> 2) << 10) | ((rn) << 5) | (rt))
+#define STRSI(rt, rn, ofs)	(0xbd000000 | (((ofs) >> 2) << 10) | ((rn) << 5) | (rt))
+#define LDR(rt, rn, rm)		(0xb8604800 | ((rm) << 16) | ((rn) << 5) | (rt))
+#define LDRH(rt, rn, rm)	(0x78604800 | ((rm) << 16) | ((rn) << 5) | (rt))
+#define LDRB(rt, rn, rm)	(0x38604800 | ((rm) << 16) | ((rn) << 5) | (rt))
+#define STR(rt, rn, rm)		(0xb8204800 | ((rm) << 16) | ((rn) << 5) | (rt))
+#define STRH(rt, rn, rm)	(0x78204800 | ((rm) << 16) | ((rn) << 5) | (rt))
+#define STRB(rt, rn, rm)	(0x38204800 | ((rm) << 16) | ((rn) << 5) | (rt))
+#define LDRX_UXTW3(rt, rn, rm)	(0xf8605800 | ((rm) << 16) | ((rn) << 5) | (rt))
+#define PUSH_LR			0xf81f0ffe	// str x30, [sp, #-16]!
+#define POP_LR			0xf84107fe	// ldr x30, [sp], #16
+#define STP_PRE(rt, rt2, rn, ofs)	(0xa9800000 | ((((ofs) >> 3) & 0x7f) << 15) | ((rt2) << 10) | ((rn) << 5) | (rt))
+#define STP(rt, rt2, rn, ofs)		(0xa9000000 | ((((ofs) >> 3) & 0x7f) << 15) | ((rt2) << 10) | ((rn) << 5) | (rt))
+#define LDP(rt, rt2, rn, ofs)		(0xa9400000 | ((((ofs) >> 3) & 0x7f) << 15) | ((rt2) << 10) | ((rn) << 5) | (rt))
+#define LDP_POST(rt, rt2, rn, ofs)	(0xa8c00000 | ((((ofs) >> 3) & 0x7f) << 15) | ((rt2) << 10) | ((rn) << 5) | (rt))
+
+// branches, offsets are in bytes
+#define B(ofs)			(0x14000000 | (((ofs) >> 2) & 0x3ffffff))
+#define BL(ofs)			(0x94000000 | (((ofs) >> 2) & 0x3ffffff))
+#define BCOND(cc, ofs)		(0x54000000 | ((((ofs) >> 2) & 0x7ffff) << 5) | (cc))
+#define BR(rn)			(0xd61f0000 | ((rn) << 5))
+#define BLR(rn)			(0xd63f0000 | ((rn) << 5))
+#define RET			0xd65f03c0
+#define BRK			0xd4200000
+#define NOP			0xd503201f
+
+// single precision floating point
+#define FADD(rd, rn, rm)	(0x1e202800 | ((rm) << 16) | ((rn) << 5) | (rd))
+#define FSUB(rd, rn, rm)	(0x1e203800 | ((rm) << 16) | ((rn) << 5) | (rd))
+#define FMUL(rd, rn, rm)	(0x1e200800 | ((rm) << 16) | ((rn) << 5) | (rd))
+#define FDIV(rd, rn, rm)	(0x1e201800 | ((rm) << 16) | ((rn) << 5) | (rd))
+#define FNEG(rd, rn)		(0x1e214000 | ((rn) << 5) | (rd))
+#define FCMP(rn, rm)		(0x1e202000 | ((rm) << 16) | ((rn) << 5))
+#define SCVTF(rd, rn)		(0x1e220000 | ((rn) << 5) | (rd))
+#define FCVTZS(rd, rn)		(0x1e380000 | ((rn) << 5) | (rd))
+
+typedef int (*vmEntry_t)(byte *dataBase, int *opStack, int programStack,
+	int *programStackRet, int mask, int mask2, int mask4);
+
+static unsigned int *out;	// NULL while sizing
+static int compiledOfs;		// in bytes
+
+static void Emit(unsigned int insn)
+{
+	if(out)
+		out[compiledOfs >> 2] = insn;
+	compiledOfs += 4;
+}
+
+// reserve room for an instruction whose offset is only known later
+static int EmitFixup(void)
+{
+	int ofs = compiledOfs;
+
+	Emit(NOP);
+	return ofs;
+}
+
+static void Patch(int ofs, unsigned int insn)
+{
+	if(out)
+		out[ofs >> 2] = insn;
+}
+
+// always two words so both passes agree on the code size
+static void EmitMovW(int rd, unsigned int value)
+{
+	Emit(MOVZ(rd, value & 0xffff));
+	Emit(MOVK16(rd, value >> 16));
+}
+
+static void EmitMovX(int rd, uint64_t value)
+{
+	Emit(MOVZX(rd, value & 0xffff, 0));
+	Emit(MOVKX(rd, (value >> 16) & 0xffff, 1));
+	Emit(MOVKX(rd, (value >> 32) & 0xffff, 2));
+	Emit(MOVKX(rd, (value >> 48) & 0xffff, 3));
+}
+
+static void EmitCallC(void *func)
+{
+	EmitMovX(R_CALL, (intptr_t) func);
+	Emit(BLR(R_CALL));
+}
+
+static void EmitPush(int count)
+{
+	Emit(ADDI(R_OPSTACKIDX, R_OPSTACKIDX, count));
+	Emit(UXTB(R_OPSTACKIDX, R_OPSTACKIDX));
+}
+
+static void EmitPop(int count)
+{
+	Emit(SUBI(R_OPSTACKIDX, R_OPSTACKIDX, count));
+	Emit(UXTB(R_OPSTACKIDX, R_OPSTACKIDX));
+}
+
+static void EmitSlot(void)
+{
+	Emit(ADDX_UXTW2(R_SLOT, R_OPSTACK, R_OPSTACKIDX));
+}
+
+static intptr_t callAsmCall(intptr_t callProgramStack, int callSyscallNum)
+{
+	vm_t *savedVM;
+	intptr_t ret;
+	intptr_t args[16];
+	int i;
+
+	savedVM = currentVM;
+
+	// save the stack to allow recursive VM entry
+	currentVM->programStack = callProgramStack - 4;
+
+	args[0] = callSyscallNum;
+	for(i = 0; i < ARRAY_LEN(args)-1; ++i)
+		args[i+1] = *(int *)((byte *)currentVM->dataBase + callProgramStack + 8 + 4*i);
+
+	ret = currentVM->systemCall(args);
+
+	currentVM = savedVM;
+
+	return ret;
+}
+
+static __attribute__ ((noreturn)) void eop(void)
+{
+	Com_Error(ERR_DROP, "End of program reached without return!");
+	exit(1);
+}
+
+static __attribute__ ((noreturn)) void jmpviolation(void)
+{
+	Com_Error(ERR_DROP, "Program tried to execute code outside VM");
+	exit(1);
+}
+
+static unsigned char op_argsize[256] =
+{
+	[OP_ENTER]      = 4,
+	[OP_LEAVE]      = 4,
+	[OP_CONST]      = 4,
+	[OP_LOCAL]      = 4,
+	[OP_EQ]         = 4,
+	[OP_NE]         = 4,
+	[OP_LTI]        = 4,
+	[OP_LEI]        = 4,
+	[OP_GTI]        = 4,
+	[OP_GEI]        = 4,
+	[OP_LTU]        = 4,
+	[OP_LEU]        = 4,
+	[OP_GTU]        = 4,
+	[OP_GEU]        = 4,
+	[OP_EQF]        = 4,
+	[OP_NEF]        = 4,
+	[OP_LTF]        = 4,
+	[OP_LEF]        = 4,
+	[OP_GTF]        = 4,
+	[OP_GEF]        = 4,
+	[OP_ARG]        = 1,
+	[OP_BLOCK_COPY] = 4,
+};
+
+/*
+=================
+EmitSyscall
+
+w1 holds the system call number, the result ends up on the opStack
+=================
+*/
+static void EmitSyscall(void)
+{
+	Emit(MOV(0, R_PSTACK));
+	EmitCallC(callAsmCall);
+	EmitPush(1);
+	EmitSlot();
+	Emit(STRI(0, R_SLOT, 0));
+}
+
+/*
+=================
+EmitJumpTarget
+
+Turns the instruction number in w0 into a code address in x0, bailing out
+through jmpviolation if it is out of range
+=================
+*/
+static void EmitJumpTarget(vm_t *vm)
+{
+	int fixup;
+
+	EmitMovW(1, vm->instructionCount);
+	Emit(CMP(0, 1));
+	fixup = EmitFixup();
+	EmitCallC(jmpviolation);
+	Patch(fixup, BCOND(CC_LO, compiledOfs - fixup));
+
+	EmitMovX(1, (intptr_t) vm->instructionPointers);
+	Emit(LDRX_UXTW3(0, 1, 0));
+	EmitMovX(1, (intptr_t) vm->codeBase);
+	Emit(ADDX(0, 1, 0));
+}
+
+#define NOTIMPL(x) \
+	do { Com_Printf(S_COLOR_RED "instruction not implemented: %x\n", x); VM_Destroy_Compiled(vm); vm->compiled = qfalse; return; } while(0)
+
+#define CHECK_INSTR(nr) \
+	do { if((int)(nr) < 0 || (nr) >= header->instructionCount) { \
+		VM_Destroy_Compiled(vm); \
+		Com_Error( ERR_DROP, \
+			"%s: jump target 0x%x out of range at offset %d", __func__, nr, pc ); \
+	} } while(0)
+
+// branch to instruction iarg if the condition holds
+#define JUMP_IF(cc) \
+	do { \
+		CHECK_INSTR(iarg); \
+		Emit(BCOND((cc) ^ 1, 8)); \
+		Emit(B(vm->instructionPointers[iarg] - compiledOfs)); \
+	} while(0)
+
+static void VM_Destroy_Compiled(vm_t* self);
+
+/*
+=================
+EmitEntry
+
+Native entry point at the start of the code buffer, see vmEntry_t
+=================
+*/
+static void EmitEntry(void)
+{
+	int fixup;
+
+	Emit(STP_PRE(29, 30, R_SP, -80));
+	Emit(MOVFROMSP(29));
+	Emit(STP(19, 20, R_SP, 16));
+	Emit(STP(21, 22, R_SP, 32));
+	Emit(STP(23, 24, R_SP, 48));
+	Emit(STP(25, 3, R_SP, 64));
+
+	Emit(MOVX(R_DATABASE, 0));
+	Emit(MOVX(R_OPSTACK, 1));
+	Emit(MOV(R_OPSTACKIDX, R_ZR));
+	Emit(MOV(R_PSTACK, 2));
+	Emit(MOV(R_MASK, 4));
+	Emit(MOV(R_MASK2, 5));
+	Emit(MOV(R_MASK4, 6));
+
+	fixup = EmitFixup();
+
+	Emit(LDRXI(3, R_SP, 72));
+	Emit(STRI(R_PSTACK, 3, 0));
+	Emit(MOV(0, R_OPSTACKIDX));
+	Emit(LDRXI(25, R_SP, 64));
+	Emit(LDP(23, 24, R_SP, 48));
+	Emit(LDP(21, 22, R_SP, 32));
+	Emit(LDP(19, 20, R_SP, 16));
+	Emit(LDP_POST(29, 30, R_SP, 80));
+	Emit(RET);
+
+	// instruction 0 directly follows the entry code
+	Patch(fixup, BL(compiledOfs - fixup));
+}
+
+/*
+=================
+VM_Compile
+=================
+*/
+void VM_Compile( vm_t *vm, vmHeader_t *header ) {
+	unsigned char op;
+	int pc;
+	unsigned instruction;
+	byte *code;
+	unsigned iarg = 0;
+	unsigned char barg = 0;
+	struct timeval tvstart =  {0, 0};
+	int pass;
+	int fixup, skip;
+
+	// const optimization
+	unsigned got_const = 0, const_value = 0;
+
+	vm->codeBase = NULL;
+
+	gettimeofday(&tvstart, NULL);
+
+	for (pass = 0; pass < 2; ++pass) {
+
+	if(pass)
+	{
+		vm->codeLength = compiledOfs;
+		vm->codeBase = mmap(NULL, compiledOfs, PROT_READ|PROT_WRITE, MAP_PRIVATE|MAP_ANONYMOUS, -1, 0);
+		if(vm->codeBase == MAP_FAILED)
+		{
+			vm->codeBase = NULL;
+			Com_Error(ERR_FATAL, "VM_CompileAArch64: can't mmap memory");
+		}
+
+		out = (unsigned int *) vm->codeBase;
+	}
+	else
+		out = NULL;
+
+	compiledOfs = 0;
+	got_const = 0;
+
+	EmitEntry();
+
+	// translate all instructions
+	pc = 0;
+	code = (byte *)header + header->codeOffset;
+
+	for ( instruction = 0; instruction < header->instructionCount; ++instruction )
+	{
+		op = code[ pc ];
+		++pc;
+
+		vm->instructionPointers[instruction] = compiledOfs;
+
+		if(op_argsize[op] == 4)
+		{
+			iarg = *(int*)(code+pc);
+			pc += 4;
+		}
+		else if(op_argsize[op] == 1)
+		{
+			barg = code[pc++];
+		}
+
+		if(got_const && op != OP_CALL && op != OP_JUMP)
+		{
+			VM_Destroy_Compiled(vm);
+			Com_Error(ERR_DROP, "leftover const");
+		}
+
+		switch ( op )
+		{
+			case OP_UNDEF:
+				NOTIMPL(op);
+				break;
+			case OP_IGNORE:
+				Emit(NOP);
+				break;
+			case OP_BREAK:
+				Emit(BRK);
+				break;
+			case OP_ENTER:
+				Emit(PUSH_LR);
+				EmitMovW(0, iarg);
+				Emit(SUB(R_PSTACK, R_PSTACK, 0));
+				break;
+			case OP_LEAVE:
+				EmitMovW(0, iarg);
+				Emit(ADD(R_PSTACK, R_PSTACK, 0));	// get rid of stack frame
+				Emit(POP_LR);
+				Emit(RET);
+				break;
+			case OP_CALL:
+				if(got_const)
+				{
+					got_const = 0;
+
+					if ((int) const_value >= 0)
+					{
+						CHECK_INSTR(const_value);
+						Emit(BL(vm->instructionPointers[const_value] - compiledOfs));
+					}
+					else
+					{
+						EmitMovW(1, ~const_value);
+						EmitSyscall();
+					}
+					break;
+				}
+
+				EmitSlot();
+				Emit(LDRI(0, R_SLOT, 0));	// get instr from stack
+				EmitPop(1);
+
+				Emit(CMPI(0, 0));
+				fixup = EmitFixup();
+
+				EmitJumpTarget(vm);
+				Emit(BLR(0));
+				skip = EmitFixup();
+
+				Patch(fixup, BCOND(CC_LT, compiledOfs - fixup));
+				Emit(MVN(1, 0));
+				EmitSyscall();
+				Patch(skip, B(compiledOfs - skip));
+				break;
+			case OP_PUSH:
+				EmitPush(1);
+				break;
+			case OP_POP:
+				EmitPop(1);
+				break;
+			case OP_CONST:
+				// calls and jumps to constant targets are resolved at compile time
+				if(instruction + 1 < header->instructionCount &&
+					(code[pc] == OP_CALL || code[pc] == OP_JUMP))
+				{
+					got_const = 1;
+					const_value = iarg;
+					break;
+				}
+
+				EmitPush(1);
+				EmitSlot();
+				EmitMovW(0, iarg);
+				Emit(STRI(0, R_SLOT, 0));
+				break;
+			case OP_LOCAL:
+				EmitPush(1);
+				EmitSlot();
+				EmitMovW(0, iarg);
+				Emit(ADD(0, R_PSTACK, 0));
+				Emit(STRI(0, R_SLOT, 0));
+				break;
+			case OP_JUMP:
+				if(got_const)
+				{
+					got_const = 0;
+					iarg = const_value;
+					CHECK_INSTR(iarg);
+					Emit(B(vm->instructionPointers[iarg] - compiledOfs));
+					break;
+				}
+
+				EmitSlot();
+				Emit(LDRI(0, R_SLOT, 0));	// get instr from stack
+				EmitPop(1);
+				EmitJumpTarget(vm);
+				Emit(BR(0));
+				break;
+			case OP_EQ:
+			case OP_NE:
+			case OP_LTI:
+			case OP_LEI:
+			case OP_GTI:
+			case OP_GEI:
+			case OP_LTU:
+			case OP_LEU:
+			case OP_GTU:
+			case OP_GEU:
+				EmitPop(2);
+				EmitSlot();
+				Emit(LDRI(0, R_SLOT, 4));
+				Emit(LDRI(1, R_SLOT, 8));
+				Emit(CMP(0, 1));
+				switch(op)
+				{
+					case OP_EQ: JUMP_IF(CC_EQ); break;
+					case OP_NE: JUMP_IF(CC_NE); break;
+					case OP_LTI: JUMP_IF(CC_LT); break;
+					case OP_LEI: JUMP_IF(CC_LE); break;
+					case OP_GTI: JUMP_IF(CC_GT); break;
+					case OP_GEI: JUMP_IF(CC_GE); break;
+					case OP_LTU: JUMP_IF(CC_LO); break;
+					case OP_LEU: JUMP_IF(CC_LS); break;
+					case OP_GTU: JUMP_IF(CC_HI); break;
+					default: JUMP_IF(CC_HS); break;
+				}
+				break;
+			case OP_EQF:
+			case OP_NEF:
+			case OP_LTF:
+			case OP_LEF:
+			case OP_GTF:
+			case OP_GEF:
+				EmitPop(2);
+				EmitSlot();
+				Emit(LDRSI(0, R_SLOT, 4));
+				Emit(LDRSI(1, R_SLOT, 8));
+				Emit(FCMP(0, 1));
+				// the conditions below are false for unordered operands,
+				// except NE which is true
+				switch(op)
+				{
+					case OP_EQF: JUMP_IF(CC_EQ); break;
+					case OP_NEF: JUMP_IF(CC_NE); break;
+					case OP_LTF: JUMP_IF(CC_MI); break;
+					case OP_LEF: JUMP_IF(CC_LS); break;
+					case OP_GTF: JUMP_IF(CC_GT); break;
+					default: JUMP_IF(CC_GE); break;
+				}
+				break;
+			case OP_LOAD1:
+				EmitSlot();
+				Emit(LDRI(0, R_SLOT, 0));
+				Emit(AND(0, 0, R_MASK));
+				Emit(LDRB(0, R_DATABASE, 0));
+				Emit(STRI(0, R_SLOT, 0));
+				break;
+			case OP_LOAD2:
+				EmitSlot();
+				Emit(LDRI(0, R_SLOT, 0));
+				Emit(AND(0, 0, R_MASK2));
+				Emit(LDRH(0, R_DATABASE, 0));
+				Emit(STRI(0, R_SLOT, 0));
+				break;
+			case OP_LOAD4:
+				EmitSlot();
+				Emit(LDRI(0, R_SLOT, 0));
+				Emit(AND(0, 0, R_MASK4));
+				Emit(LDR(0, R_DATABASE, 0));
+				Emit(STRI(0, R_SLOT, 0));
+				break;
+			case OP_STORE1:
+			case OP_STORE2:
+			case OP_STORE4:
+				EmitPop(2);
+				EmitSlot();
+				Emit(LDRI(0, R_SLOT, 8));	// value
+				Emit(LDRI(1, R_SLOT, 4));	// pointer
+				if(op == OP_STORE1)
+				{
+					Emit(AND(1, 1, R_MASK));
+					Emit(STRB(0, R_DATABASE, 1));
+				}
+				else if(op == OP_STORE2)
+				{
+					Emit(AND(1, 1, R_MASK2));
+					Emit(STRH(0, R_DATABASE, 1));
+				}
+				else
+				{
+					Emit(AND(1, 1, R_MASK4));
+					Emit(STR(0, R_DATABASE, 1));
+				}
+				break;
+			case OP_ARG:
+				EmitSlot();
+				Emit(LDRI(0, R_SLOT, 0));
+				EmitPop(1);
+				Emit(ADDI(1, R_PSTACK, barg));
+				Emit(AND(1, 1, R_MASK4));
+				Emit(STR(0, R_DATABASE, 1));
+				break;
+			case OP_BLOCK_COPY:
+				EmitPop(2);
+				EmitSlot();
+				Emit(LDRI(0, R_SLOT, 4));	// dest
+				Emit(LDRI(1, R_SLOT, 8));	// src
+				EmitMovW(2, iarg);
+				EmitCallC(VM_BlockCopy);
+				break;
+			case OP_SEX8:
+			case OP_SEX16:
+			case OP_NEGI:
+			case OP_BCOM:
+				EmitSlot();
+				Emit(LDRI(0, R_SLOT, 0));
+				if(op == OP_SEX8)
+					Emit(SXTB(0, 0));
+				else if(op == OP_SEX16)
+					Emit(SXTH(0, 0));
+				else if(op == OP_NEGI)
+					Emit(NEG(0, 0));
+				else
+					Emit(MVN(0, 0));
+				Emit(STRI(0, R_SLOT, 0));
+				break;
+			case OP_ADD:
+			case OP_SUB:
+			case OP_DIVI:
+			case OP_DIVU:
+			case OP_MODI:
+			case OP_MODU:
+			case OP_MULI:
+			case OP_MULU:
+			case OP_BAND:
+			case OP_BOR:
+			case OP_BXOR:
+			case OP_LSH:
+			case OP_RSHI:
+			case OP_RSHU:
+				EmitPop(1);
+				EmitSlot();
+				Emit(LDRI(0, R_SLOT, 0));
+				Emit(LDRI(1, R_SLOT, 4));
+				switch(op)
+				{
+					case OP_ADD: Emit(ADD(0, 0, 1)); break;
+					case OP_SUB: Emit(SUB(0, 0, 1)); break;
+					case OP_DIVI: Emit(SDIV(0, 0, 1)); break;
+					case OP_DIVU: Emit(UDIV(0, 0, 1)); break;
+					case OP_MODI:
+						Emit(SDIV(2, 0, 1));
+						Emit(MSUB(0, 2, 1, 0));
+						break;
+					case OP_MODU:
+						Emit(UDIV(2, 0, 1));
+						Emit(MSUB(0, 2, 1, 0));
+						break;
+					case OP_MULI:
+					case OP_MULU: Emit(MUL(0, 0, 1)); break;
+					case OP_BAND: Emit(AND(0, 0, 1)); break;
+					case OP_BOR: Emit(ORR(0, 0, 1)); break;
+					case OP_BXOR: Emit(EOR(0, 0, 1)); break;
+					case OP_LSH: Emit(LSLV(0, 0, 1)); break;
+					case OP_RSHI: Emit(ASRV(0, 0, 1)); break;
+					default: Emit(LSRV(0, 0, 1)); break;
+				}
+				Emit(STRI(0, R_SLOT, 0));
+				break;
+			case OP_NEGF:
+				EmitSlot();
+				Emit(LDRSI(0, R_SLOT, 0));
+				Emit(FNEG(0, 0));
+				Emit(STRSI(0, R_SLOT, 0));
+				break;
+			case OP_ADDF:
+			case OP_SUBF:
+			case OP_DIVF:
+			case OP_MULF:
+				EmitPop(1);
+				EmitSlot();
+				Emit(LDRSI(0, R_SLOT, 0));
+				Emit(LDRSI(1, R_SLOT, 4));
+				switch(op)
+				{
+					case OP_ADDF: Emit(FADD(0, 0, 1)); break;
+					case OP_SUBF: Emit(FSUB(0, 0, 1)); break;
+					case OP_DIVF: Emit(FDIV(0, 0, 1)); break;
+					default: Emit(FMUL(0, 0, 1)); break;
+				}
+				Emit(STRSI(0, R_SLOT, 0));
+				break;
+			case OP_CVIF:
+				EmitSlot();
+				Emit(LDRI(0, R_SLOT, 0));
+				Emit(SCVTF(0, 0));
+				Emit(STRSI(0, R_SLOT, 0));
+				break;
+			case OP_CVFI:
+				EmitSlot();
+				Emit(LDRSI(0, R_SLOT, 0));
+				Emit(FCVTZS(0, 0));
+				Emit(STRI(0, R_SLOT, 0));
+				break;
+			default:
+				NOTIMPL(op);
+				break;
+		}
+	}
+
+	if(got_const)
+	{
+		VM_Destroy_Compiled(vm);
+		Com_Error(ERR_DROP, "leftover const");
+	}
+
+	EmitCallC(eop);
+
+	} // pass loop
+
+	out = NULL;
+
+	if(mprotect(vm->codeBase, compiledOfs, PROT_READ|PROT_EXEC))
+	{
+		VM_Destroy_Compiled(vm);
+		Com_Error(ERR_FATAL, "VM_CompileAArch64: mprotect failed");
+	}
+
+	__builtin___clear_cache((char *)vm->codeBase, (char *)vm->codeBase + compiledOfs);
+
+	vm->destroy = VM_Destroy_Compiled;
+
+	{
+		struct timeval tvdone =  {0, 0};
+		struct timeval dur =  {0, 0};
+		Com_Printf( "VM file %s compiled to %i bytes of code (%p - %p)\n", vm->name, vm->codeLength, vm->codeBase, vm->codeBase+vm->codeLength );
+
+		gettimeofday(&tvdone, NULL);
+		timersub(&tvdone, &tvstart, &dur);
+		Com_Printf( "compilation took %"PRIu64".%06"PRIu64" seconds\n", (uint64_t)dur.tv_sec, (uint64_t)dur.tv_usec );
+	}
+}
+
+
+static void VM_Destroy_Compiled(vm_t* self)
+{
+	if(self && self->codeBase)
+	{
+		munmap(self->codeBase, self->codeLength);
+		self->codeBase = NULL;
+	}
+}
+
+/*
+==============
+VM_CallCompiled
+==============
+*/
+int VM_CallCompiled(vm_t *vm, int *args)
+{
+	int		stack[OPSTACK_SIZE + 15];
+	int		programStack;
+	int		stackOnEntry;
+	int		opStackRet;
+	byte	*image;
+	int		*opStack;
+	vmEntry_t	entry;
+
+	currentVM = vm;
+
+	// we might be called recursively, so this might not be the very top
+	programStack = vm->programStack;
+	stackOnEntry = programStack;
+
+	// set up the stack frame
+	image = vm->dataBase;
+
+	programStack -= 48;
+
+	*(int *)&image[ programStack + 44] = args[9];
+	*(int *)&image[ programStack + 40] = args[8];
+	*(int *)&image[ programStack + 36] = args[7];
+	*(int *)&image[ programStack + 32] = args[6];
+	*(int *)&image[ programStack + 28] = args[5];
+	*(int *)&image[ programStack + 24] = args[4];
+	*(int *)&image[ programStack + 20] = args[3];
+	*(int *)&image[ programStack + 16] = args[2];
+	*(int *)&image[ programStack + 12] = args[1];
+	*(int *)&image[ programStack + 8 ] = args[0];
+	*(int *)&image[ programStack + 4 ] = 0x77777777;	// return stack
+	*(int *)&image[ programStack ] = -1;	// will terminate the loop on return
+
+	opStack = PADP(stack, 16);
+	*opStack = 0xDEADBEEF;
+
+	// off we go into generated code...
+	entry = (vmEntry_t) vm->codeBase;
+	opStackRet = entry(image, opStack, programStack, &programStack,
+		vm->dataMask, vm->dataMask & ~1, vm->dataMask & ~3);
+
+	if(opStackRet != 1 || *opStack != 0xDEADBEEF)
+		Com_Error(ERR_DROP, "opStack corrupted in compiled code (offset %d)", opStackRet);
+
+	if ( programStack != stackOnEntry - 48 ) {
+		Com_Error( ERR_DROP, "programStack corrupted in compiled code" );
+	}
+
+	vm->programStack = stackOnEntry;
+
+	return opStack[1];
+}
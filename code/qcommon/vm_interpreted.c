@@ -315,6 +315,26 @@ locals from sp
 
 #define	DEBUGSTR va("%s%i", VM_Indent(vm), opStackOfs)
 
+// With gcc the interpreter uses direct threaded dispatch: every handler
+// jumps straight to the handler of the next instruction through a label
+// table instead of going back through the switch. The switch is kept
+// for other compilers and for DEBUG_VM, which needs the checks at the
+// top of the loop. VM_SWITCH_DISPATCH forces the switch, qvmreplay
+// builds a second interpreter that way to time one against the other.
+#if defined( __GNUC__ ) && !defined( DEBUG_VM ) && !defined( VM_SWITCH_DISPATCH )
+#define VM_COMPUTED_GOTO
+#endif
+
+#ifdef VM_COMPUTED_GOTO
+#define	VM_CASE( op )	case op: lbl_##op
+#define	DISPATCH2()		do { opcode = codeImage[ programCounter++ ]; goto *dispatchTable[ opcode ]; } while ( 0 )
+#define	DISPATCH()		do { r0 = opStack[opStackOfs]; r1 = opStack[(uint8_t) (opStackOfs - 1)]; DISPATCH2(); } while ( 0 )
+#else
+#define	VM_CASE( op )	case op
+#define	DISPATCH2()		goto nextInstruction2
+#define	DISPATCH()		goto nextInstruction
+#endif
+
 int	VM_CallInterpreted( vm_t *vm, int *args ) {
 	byte		stack[OPSTACK_SIZE + 15];
 	register int		*opStack;
@@ -329,6 +349,71 @@ int	VM_CallInterpreted( vm_t *vm, int *args ) {
 #ifdef DEBUG_VM
 	vmSymbol_t	*profileSymbol;
 #endif
+#ifdef VM_COMPUTED_GOTO
+	// opcodes not handled below behave like the switch and simply
+	// fall through to the next instruction
+	static const void * const dispatchTable[256] = {
+		[0 ... 255] = &&nextInstruction,
+		[OP_BREAK] = &&lbl_OP_BREAK,
+		[OP_CONST] = &&lbl_OP_CONST,
+		[OP_LOCAL] = &&lbl_OP_LOCAL,
+		[OP_LOAD4] = &&lbl_OP_LOAD4,
+		[OP_LOAD2] = &&lbl_OP_LOAD2,
+		[OP_LOAD1] = &&lbl_OP_LOAD1,
+		[OP_STORE4] = &&lbl_OP_STORE4,
+		[OP_STORE2] = &&lbl_OP_STORE2,
+		[OP_STORE1] = &&lbl_OP_STORE1,
+		[OP_ARG] = &&lbl_OP_ARG,
+		[OP_BLOCK_COPY] = &&lbl_OP_BLOCK_COPY,
+		[OP_CALL] = &&lbl_OP_CALL,
+		[OP_PUSH] = &&lbl_OP_PUSH,
+		[OP_POP] = &&lbl_OP_POP,
+		[OP_ENTER] = &&lbl_OP_ENTER,
+		[OP_LEAVE] = &&lbl_OP_LEAVE,
+		[OP_JUMP] = &&lbl_OP_JUMP,
+		[OP_EQ] = &&lbl_OP_EQ,
+		[OP_NE] = &&lbl_OP_NE,
+		[OP_LTI] = &&lbl_OP_LTI,
+		[OP_LEI] = &&lbl_OP_LEI,
+		[OP_GTI] = &&lbl_OP_GTI,
+		[OP_GEI] = &&lbl_OP_GEI,
+		[OP_LTU] = &&lbl_OP_LTU,
+		[OP_LEU] = &&lbl_OP_LEU,
+		[OP_GTU] = &&lbl_OP_GTU,
+		[OP_GEU] = &&lbl_OP_GEU,
+		[OP_EQF] = &&lbl_OP_EQF,
+		[OP_NEF] = &&lbl_OP_NEF,
+		[OP_LTF] = &&lbl_OP_LTF,
+		[OP_LEF] = &&lbl_OP_LEF,
+		[OP_GTF] = &&lbl_OP_GTF,
+		[OP_GEF] = &&lbl_OP_GEF,
+		[OP_NEGI] = &&lbl_OP_NEGI,
+		[OP_ADD] = &&lbl_OP_ADD,
+		[OP_SUB] = &&lbl_OP_SUB,
+		[OP_DIVI] = &&lbl_OP_DIVI,
+		[OP_DIVU] = &&lbl_OP_DIVU,
+		[OP_MODI] = &&lbl_OP_MODI,
+		[OP_MODU] = &&lbl_OP_MODU,
+		[OP_MULI] = &&lbl_OP_MULI,
+		[OP_MULU] = &&lbl_OP_MULU,
+		[OP_BAND] = &&lbl_OP_BAND,
+		[OP_BOR] = &&lbl_OP_BOR,
+		[OP_BXOR] = &&lbl_OP_BXOR,
+		[OP_BCOM] = &&lbl_OP_BCOM,
+		[OP_LSH] = &&lbl_OP_LSH,
+		[OP_RSHI] = &&lbl_OP_RSHI,
+		[OP_RSHU] = &&lbl_OP_RSHU,
+		[OP_NEGF] = &&lbl_OP_NEGF,
+		[OP_ADDF] = &&lbl_OP_ADDF,
+		[OP_SUBF] = &&lbl_OP_SUBF,
+		[OP_DIVF] = &&lbl_OP_DIVF,
+		[OP_MULF] = &&lbl_OP_MULF,
+		[OP_CVIF] = &&lbl_OP_CVIF,
+		[OP_CVFI] = &&lbl_OP_CVFI,
+		[OP_SEX8] = &&lbl_OP_SEX8,
+		[OP_SEX16] = &&lbl_OP_SEX16,
+	};
+#endif
 
 	// interpret the code
 	vm->currentlyInterpreting = qtrue;
@@ -386,7 +471,9 @@ int	VM_CallInterpreted( vm_t *vm, int *args ) {
 nextInstruction:
 		r0 = opStack[opStackOfs];
 		r1 = opStack[(uint8_t) (opStackOfs - 1)];
+#ifndef VM_COMPUTED_GOTO
 nextInstruction2:
+#endif
 #ifdef DEBUG_VM
 		if ( (unsigned)programCounter >= vm->codeLength ) {
 			Com_Error( ERR_DROP, "VM pc out of range" );
@@ -410,31 +497,34 @@ nextInstruction2:
 #endif
 		opcode = codeImage[ programCounter++ ];
 
+#ifdef VM_COMPUTED_GOTO
+		goto *dispatchTable[ opcode ];
+#endif
 		switch ( opcode ) {
 #ifdef DEBUG_VM
 		default:
 			Com_Error( ERR_DROP, "Bad VM instruction" );  // this should be scanned on load!
 			return 0;
 #endif
-		case OP_BREAK:
+		VM_CASE(OP_BREAK):
 			vm->breakCount++;
-			goto nextInstruction2;
-		case OP_CONST:
+			DISPATCH2();
+		VM_CASE(OP_CONST):
 			opStackOfs++;
 			r1 = r0;
 			r0 = opStack[opStackOfs] = r2;
 			
 			programCounter += 1;
-			goto nextInstruction2;
-		case OP_LOCAL:
+			DISPATCH2();
+		VM_CASE(OP_LOCAL):
 			opStackOfs++;
 			r1 = r0;
 			r0 = opStack[opStackOfs] = r2+programStack;
 
 			programCounter += 1;
-			goto nextInstruction2;
+			DISPATCH2();
 
-		case OP_LOAD4:
+		VM_CASE(OP_LOAD4):
 #ifdef DEBUG_VM
 			if(opStack[opStackOfs] & 3)
 			{
@@ -443,41 +533,41 @@ nextInstruction2:
 			}
 #endif
 			r0 = opStack[opStackOfs] = *(int *) &image[r0 & dataMask & ~3 ];
-			goto nextInstruction2;
-		case OP_LOAD2:
+			DISPATCH2();
+		VM_CASE(OP_LOAD2):
 			r0 = opStack[opStackOfs] = *(unsigned short *)&image[ r0&dataMask&~1 ];
-			goto nextInstruction2;
-		case OP_LOAD1:
+			DISPATCH2();
+		VM_CASE(OP_LOAD1):
 			r0 = opStack[opStackOfs] = image[ r0&dataMask ];
-			goto nextInstruction2;
+			DISPATCH2();
 
-		case OP_STORE4:
+		VM_CASE(OP_STORE4):
 			*(int *)&image[ r1&(dataMask & ~3) ] = r0;
 			opStackOfs -= 2;
-			goto nextInstruction;
-		case OP_STORE2:
+			DISPATCH();
+		VM_CASE(OP_STORE2):
 			*(short *)&image[ r1&(dataMask & ~1) ] = r0;
 			opStackOfs -= 2;
-			goto nextInstruction;
-		case OP_STORE1:
+			DISPATCH();
+		VM_CASE(OP_STORE1):
 			image[ r1&dataMask ] = r0;
 			opStackOfs -= 2;
-			goto nextInstruction;
+			DISPATCH();
 
-		case OP_ARG:
+		VM_CASE(OP_ARG):
 			// single byte offset from programStack
 			*(int *)&image[ (codeImage[programCounter] + programStack)&dataMask&~3 ] = r0;
 			opStackOfs--;
 			programCounter += 1;
-			goto nextInstruction;
+			DISPATCH();
 
-		case OP_BLOCK_COPY:
+		VM_CASE(OP_BLOCK_COPY):
 			VM_BlockCopy(r1, r0, r2);
 			programCounter += 1;
 			opStackOfs -= 2;
-			goto nextInstruction;
+			DISPATCH();
 
-		case OP_CALL:
+		VM_CASE(OP_CALL):
 			// save current program counter
 			*(int *)&image[ programStack ] = programCounter;
 			
@@ -543,17 +633,17 @@ nextInstruction2:
 			} else {
 				programCounter = vm->instructionPointers[ programCounter ];
 			}
-			goto nextInstruction;
+			DISPATCH();
 
 		// push and pop are only needed for discarded or bad function return values
-		case OP_PUSH:
+		VM_CASE(OP_PUSH):
 			opStackOfs++;
-			goto nextInstruction;
-		case OP_POP:
+			DISPATCH();
+		VM_CASE(OP_POP):
 			opStackOfs--;
-			goto nextInstruction;
+			DISPATCH();
 
-		case OP_ENTER:
+		VM_CASE(OP_ENTER):
 #ifdef DEBUG_VM
 			profileSymbol = VM_ValueToFunctionSymbol( vm, programCounter );
 #endif
@@ -576,8 +666,8 @@ nextInstruction2:
 //				vm->callLevel++;
 			}
 #endif
-			goto nextInstruction;
-		case OP_LEAVE:
+			DISPATCH();
+		VM_CASE(OP_LEAVE):
 			// remove our stack frame
 			v1 = r2;
 
@@ -599,7 +689,7 @@ nextInstruction2:
 				Com_Error( ERR_DROP, "VM program counter out of range in OP_LEAVE" );
 				return 0;
 			}
-			goto nextInstruction;
+			DISPATCH();
 
 		/*
 		===================================================================
@@ -607,7 +697,7 @@ nextInstruction2:
 		===================================================================
 		*/
 
-		case OP_JUMP:
+		VM_CASE(OP_JUMP):
 			if ( (unsigned)r0 >= vm->instructionCount )
 			{
 				Com_Error( ERR_DROP, "VM program counter out of range in OP_JUMP" );
@@ -617,280 +707,280 @@ nextInstruction2:
 			programCounter = vm->instructionPointers[ r0 ];
 
 			opStackOfs--;
-			goto nextInstruction;
+			DISPATCH();
 
-		case OP_EQ:
+		VM_CASE(OP_EQ):
 			opStackOfs -= 2;
 			if ( r1 == r0 ) {
 				programCounter = r2;	//vm->instructionPointers[r2];
-				goto nextInstruction;
+				DISPATCH();
 			} else {
 				programCounter += 1;
-				goto nextInstruction;
+				DISPATCH();
 			}
 
-		case OP_NE:
+		VM_CASE(OP_NE):
 			opStackOfs -= 2;
 			if ( r1 != r0 ) {
 				programCounter = r2;	//vm->instructionPointers[r2];
-				goto nextInstruction;
+				DISPATCH();
 			} else {
 				programCounter += 1;
-				goto nextInstruction;
+				DISPATCH();
 			}
 
-		case OP_LTI:
+		VM_CASE(OP_LTI):
 			opStackOfs -= 2;
 			if ( r1 < r0 ) {
 				programCounter = r2;	//vm->instructionPointers[r2];
-				goto nextInstruction;
+				DISPATCH();
 			} else {
 				programCounter += 1;
-				goto nextInstruction;
+				DISPATCH();
 			}
 
-		case OP_LEI:
+		VM_CASE(OP_LEI):
 			opStackOfs -= 2;
 			if ( r1 <= r0 ) {
 				programCounter = r2;	//vm->instructionPointers[r2];
-				goto nextInstruction;
+				DISPATCH();
 			} else {
 				programCounter += 1;
-				goto nextInstruction;
+				DISPATCH();
 			}
 
-		case OP_GTI:
+		VM_CASE(OP_GTI):
 			opStackOfs -= 2;
 			if ( r1 > r0 ) {
 				programCounter = r2;	//vm->instructionPointers[r2];
-				goto nextInstruction;
+				DISPATCH();
 			} else {
 				programCounter += 1;
-				goto nextInstruction;
+				DISPATCH();
 			}
 
-		case OP_GEI:
+		VM_CASE(OP_GEI):
 			opStackOfs -= 2;
 			if ( r1 >= r0 ) {
 				programCounter = r2;	//vm->instructionPointers[r2];
-				goto nextInstruction;
+				DISPATCH();
 			} else {
 				programCounter += 1;
-				goto nextInstruction;
+				DISPATCH();
 			}
 
-		case OP_LTU:
+		VM_CASE(OP_LTU):
 			opStackOfs -= 2;
 			if ( ((unsigned)r1) < ((unsigned)r0) ) {
 				programCounter = r2;	//vm->instructionPointers[r2];
-				goto nextInstruction;
+				DISPATCH();
 			} else {
 				programCounter += 1;
-				goto nextInstruction;
+				DISPATCH();
 			}
 
-		case OP_LEU:
+		VM_CASE(OP_LEU):
 			opStackOfs -= 2;
 			if ( ((unsigned)r1) <= ((unsigned)r0) ) {
 				programCounter = r2;	//vm->instructionPointers[r2];
-				goto nextInstruction;
+				DISPATCH();
 			} else {
 				programCounter += 1;
-				goto nextInstruction;
+				DISPATCH();
 			}
 
-		case OP_GTU:
+		VM_CASE(OP_GTU):
 			opStackOfs -= 2;
 			if ( ((unsigned)r1) > ((unsigned)r0) ) {
 				programCounter = r2;	//vm->instructionPointers[r2];
-				goto nextInstruction;
+				DISPATCH();
 			} else {
 				programCounter += 1;
-				goto nextInstruction;
+				DISPATCH();
 			}
 
-		case OP_GEU:
+		VM_CASE(OP_GEU):
 			opStackOfs -= 2;
 			if ( ((unsigned)r1) >= ((unsigned)r0) ) {
 				programCounter = r2;	//vm->instructionPointers[r2];
-				goto nextInstruction;
+				DISPATCH();
 			} else {
 				programCounter += 1;
-				goto nextInstruction;
+				DISPATCH();
 			}
 
-		case OP_EQF:
+		VM_CASE(OP_EQF):
 			opStackOfs -= 2;
 			
 			if(((float *) opStack)[(uint8_t) (opStackOfs + 1)] == ((float *) opStack)[(uint8_t) (opStackOfs + 2)])
 			{
 				programCounter = r2;	//vm->instructionPointers[r2];
-				goto nextInstruction;
+				DISPATCH();
 			} else {
 				programCounter += 1;
-				goto nextInstruction;
+				DISPATCH();
 			}
 
-		case OP_NEF:
+		VM_CASE(OP_NEF):
 			opStackOfs -= 2;
 
 			if(((float *) opStack)[(uint8_t) (opStackOfs + 1)] != ((float *) opStack)[(uint8_t) (opStackOfs + 2)])
 			{
 				programCounter = r2;	//vm->instructionPointers[r2];
-				goto nextInstruction;
+				DISPATCH();
 			} else {
 				programCounter += 1;
-				goto nextInstruction;
+				DISPATCH();
 			}
 
-		case OP_LTF:
+		VM_CASE(OP_LTF):
 			opStackOfs -= 2;
 
 			if(((float *) opStack)[(uint8_t) (opStackOfs + 1)] < ((float *) opStack)[(uint8_t) (opStackOfs + 2)])
 			{
 				programCounter = r2;	//vm->instructionPointers[r2];
-				goto nextInstruction;
+				DISPATCH();
 			} else {
 				programCounter += 1;
-				goto nextInstruction;
+				DISPATCH();
 			}
 
-		case OP_LEF:
+		VM_CASE(OP_LEF):
 			opStackOfs -= 2;
 
 			if(((float *) opStack)[(uint8_t) ((uint8_t) (opStackOfs + 1))] <= ((float *) opStack)[(uint8_t) ((uint8_t) (opStackOfs + 2))])
 			{
 				programCounter = r2;	//vm->instructionPointers[r2];
-				goto nextInstruction;
+				DISPATCH();
 			} else {
 				programCounter += 1;
-				goto nextInstruction;
+				DISPATCH();
 			}
 
-		case OP_GTF:
+		VM_CASE(OP_GTF):
 			opStackOfs -= 2;
 
 			if(((float *) opStack)[(uint8_t) (opStackOfs + 1)] > ((float *) opStack)[(uint8_t) (opStackOfs + 2)])
 			{
 				programCounter = r2;	//vm->instructionPointers[r2];
-				goto nextInstruction;
+				DISPATCH();
 			} else {
 				programCounter += 1;
-				goto nextInstruction;
+				DISPATCH();
 			}
 
-		case OP_GEF:
+		VM_CASE(OP_GEF):
 			opStackOfs -= 2;
 
 			if(((float *) opStack)[(uint8_t) (opStackOfs + 1)] >= ((float *) opStack)[(uint8_t) (opStackOfs + 2)])
 			{
 				programCounter = r2;	//vm->instructionPointers[r2];
-				goto nextInstruction;
+				DISPATCH();
 			} else {
 				programCounter += 1;
-				goto nextInstruction;
+				DISPATCH();
 			}
 
 
 		//===================================================================
 
-		case OP_NEGI:
+		VM_CASE(OP_NEGI):
 			opStack[opStackOfs] = -r0;
-			goto nextInstruction;
-		case OP_ADD:
+			DISPATCH();
+		VM_CASE(OP_ADD):
 			opStackOfs--;
 			opStack[opStackOfs] = r1 + r0;
-			goto nextInstruction;
-		case OP_SUB:
+			DISPATCH();
+		VM_CASE(OP_SUB):
 			opStackOfs--;
 			opStack[opStackOfs] = r1 - r0;
-			goto nextInstruction;
-		case OP_DIVI:
+			DISPATCH();
+		VM_CASE(OP_DIVI):
 			opStackOfs--;
 			opStack[opStackOfs] = r1 / r0;
-			goto nextInstruction;
-		case OP_DIVU:
+			DISPATCH();
+		VM_CASE(OP_DIVU):
 			opStackOfs--;
 			opStack[opStackOfs] = ((unsigned) r1) / ((unsigned) r0);
-			goto nextInstruction;
-		case OP_MODI:
+			DISPATCH();
+		VM_CASE(OP_MODI):
 			opStackOfs--;
 			opStack[opStackOfs] = r1 % r0;
-			goto nextInstruction;
-		case OP_MODU:
+			DISPATCH();
+		VM_CASE(OP_MODU):
 			opStackOfs--;
 			opStack[opStackOfs] = ((unsigned) r1) % ((unsigned) r0);
-			goto nextInstruction;
-		case OP_MULI:
+			DISPATCH();
+		VM_CASE(OP_MULI):
 			opStackOfs--;
 			opStack[opStackOfs] = r1 * r0;
-			goto nextInstruction;
-		case OP_MULU:
+			DISPATCH();
+		VM_CASE(OP_MULU):
 			opStackOfs--;
 			opStack[opStackOfs] = ((unsigned) r1) * ((unsigned) r0);
-			goto nextInstruction;
+			DISPATCH();
 
-		case OP_BAND:
+		VM_CASE(OP_BAND):
 			opStackOfs--;
 			opStack[opStackOfs] = ((unsigned) r1) & ((unsigned) r0);
-			goto nextInstruction;
-		case OP_BOR:
+			DISPATCH();
+		VM_CASE(OP_BOR):
 			opStackOfs--;
 			opStack[opStackOfs] = ((unsigned) r1) | ((unsigned) r0);
-			goto nextInstruction;
-		case OP_BXOR:
+			DISPATCH();
+		VM_CASE(OP_BXOR):
 			opStackOfs--;
 			opStack[opStackOfs] = ((unsigned) r1) ^ ((unsigned) r0);
-			goto nextInstruction;
-		case OP_BCOM:
+			DISPATCH();
+		VM_CASE(OP_BCOM):
 			opStack[opStackOfs] = ~((unsigned) r0);
-			goto nextInstruction;
+			DISPATCH();
 
-		case OP_LSH:
+		VM_CASE(OP_LSH):
 			opStackOfs--;
 			opStack[opStackOfs] = r1 << r0;
-			goto nextInstruction;
-		case OP_RSHI:
+			DISPATCH();
+		VM_CASE(OP_RSHI):
 			opStackOfs--;
 			opStack[opStackOfs] = r1 >> r0;
-			goto nextInstruction;
-		case OP_RSHU:
+			DISPATCH();
+		VM_CASE(OP_RSHU):
 			opStackOfs--;
 			opStack[opStackOfs] = ((unsigned) r1) >> r0;
-			goto nextInstruction;
+			DISPATCH();
 
-		case OP_NEGF:
+		VM_CASE(OP_NEGF):
 			((float *) opStack)[opStackOfs] =  -((float *) opStack)[opStackOfs];
-			goto nextInstruction;
-		case OP_ADDF:
+			DISPATCH();
+		VM_CASE(OP_ADDF):
 			opStackOfs--;
 			((float *) opStack)[opStackOfs] = ((float *) opStack)[opStackOfs] + ((float *) opStack)[(uint8_t) (opStackOfs + 1)];
-			goto nextInstruction;
-		case OP_SUBF:
+			DISPATCH();
+		VM_CASE(OP_SUBF):
 			opStackOfs--;
 			((float *) opStack)[opStackOfs] = ((float *) opStack)[opStackOfs] - ((float *) opStack)[(uint8_t) (opStackOfs + 1)];
-			goto nextInstruction;
-		case OP_DIVF:
+			DISPATCH();
+		VM_CASE(OP_DIVF):
 			opStackOfs--;
 			((float *) opStack)[opStackOfs] = ((float *) opStack)[opStackOfs] / ((float *) opStack)[(uint8_t) (opStackOfs + 1)];
-			goto nextInstruction;
-		case OP_MULF:
+			DISPATCH();
+		VM_CASE(OP_MULF):
 			opStackOfs--;
 			((float *) opStack)[opStackOfs] = ((float *) opStack)[opStackOfs] * ((float *) opStack)[(uint8_t) (opStackOfs + 1)];
-			goto nextInstruction;
+			DISPATCH();
 
-		case OP_CVIF:
+		VM_CASE(OP_CVIF):
 			((float *) opStack)[opStackOfs] = (float) opStack[opStackOfs];
-			goto nextInstruction;
-		case OP_CVFI:
+			DISPATCH();
+		VM_CASE(OP_CVFI):
 			opStack[opStackOfs] = Q_ftol(((float *) opStack)[opStackOfs]);
-			goto nextInstruction;
-		case OP_SEX8:
+			DISPATCH();
+		VM_CASE(OP_SEX8):
 			opStack[opStackOfs] = (signed char) opStack[opStackOfs];
-			goto nextInstruction;
-		case OP_SEX16:
+			DISPATCH();
+		VM_CASE(OP_SEX16):
 			opStack[opStackOfs] = (short) opStack[opStackOfs];
-			goto nextInstruction;
+			DISPATCH();
 		}
 	}
 
@@ -174,6 +174,10 @@ struct vm_s {
 
 	byte		*jumpTableTargets;
 	int			numJumpTableTargets;
+
+	// data the engine writes without VM_ArgPtr, see VM_ShareData
+	int			sharedOfs[MAX_VM_SHARED];
+	int			sharedLength[MAX_VM_SHARED];
 };
 
 
@@ -192,3 +196,27 @@ const char *VM_ValueToSymbol( vm_t *vm, int value );
 void VM_LogSyscalls( int *args );
 
 void VM_BlockCopy(unsigned int dest, unsigned int src, size_t n);
+
+/*
+vm capture files, written by vmrecord and read by the qvmreplay tool.
+Everything is stored in host byte order.
+
+header			VM_RECORD_MAGIC, data length, vm name (MAX_QPATH chars)
+VMR_CALL		programStack, callnum and 10 args, patches
+VMR_SYSCALL		syscall number and the first 4 args, 64 bit return value, patches
+VMR_RETURN		64 bit return value, checksum of the data below the stack
+
+patches are (offset, length, bytes) runs ended by a zero length run, they
+carry whatever the engine wrote into the data segment
+*/
+#define	VM_RECORD_MAGIC			(('1'<<24)+('R'<<16)+('M'<<8)+'V')
+#define	VM_RECORD_CALL_ARGS		11
+#define	VM_RECORD_SYSCALL_ARGS	5
+
+typedef enum {
+	VMR_CALL = 1,
+	VMR_SYSCALL,
+	VMR_RETURN
+} vmRecordType_t;
+
+unsigned VM_DataChecksum( vm_t *vm );
@@ -51,6 +51,7 @@ typedef struct voipServerPacket_s
 typedef struct svEntity_s {
 	struct worldSector_s *worldSector;
 	struct svEntity_s *nextEntityInWorldSector;
+	int			worldSectorList;	// which of the sector's entity chains it is in
 	
 	entityState_t	baseline;		// for delta compression of initial sighting
 	int			numClusters;		// if -1, use headnode instead
@@ -296,6 +297,8 @@ extern	cvar_t	*sv_strictAuth;
 #endif
 extern	cvar_t	*sv_public;
 extern	cvar_t	*sv_banFile;
+extern	cvar_t	*sv_noBoxSweeps;
+extern	cvar_t	*sv_traceThreads;
 
 extern	serverBan_t serverBans[SERVER_MAXBANS];
 extern	int serverBansCount;
@@ -391,6 +394,7 @@ void		SV_InitGameProgs ( void );
 void		SV_ShutdownGameProgs ( void );
 void		SV_RestartGameProgs( void );
 qboolean	SV_inPVS (const vec3_t p1, const vec3_t p2);
+int			SV_inPVSBatch( const vec3_t viewer, const vec3_t *points, int numPoints, qboolean *visible );
 
 //
 // sv_bot.c
@@ -426,6 +430,10 @@ void SV_LinkEntity( sharedEntity_t *ent );
 // Needs to be called any time an entity changes origin, mins, maxs,
 // or solid.  Automatically unlinks if needed.
 // sets ent->r.absmin and ent->r.absmax
+
+void SV_UpdateSectorLists( void );
+// moves linked entities whose contents changed to the matching sector chain,
+// call before the game runs
 // sets ent->leafnums[] for pvs determination even if the entity
 // is not solid
 
@@ -434,6 +442,12 @@ clipHandle_t SV_ClipHandleForEntity( const sharedEntity_t *ent );
 
 
 void SV_SectorList_f( void );
+void SV_TraceRecord_f( void );
+void SV_TraceStopRecord_f( void );
+void SV_TraceReplay_f( void );
+void SV_TraceStopRecord( void );
+// tracerecord captures world queries and the entities they see,
+// tracereplay runs them again against the same map
 
 
 int SV_AreaEntities( const vec3_t mins, const vec3_t maxs, int *entityList, int maxcount );
@@ -461,6 +475,10 @@ void SV_Trace( trace_t *results, const vec3_t start, vec3_t mins, vec3_t maxs, c
 // passEntityNum is explicitly excluded from clipping checks (normally ENTITYNUM_NONE)
 
 
+void SV_TraceBatch( trace_t *results, const traceRequest_t *requests, int numRequests );
+// performs numRequests independent SV_Trace calls
+
+
 void SV_ClipToEntity( trace_t *trace, const vec3_t start, const vec3_t mins, const vec3_t maxs, const vec3_t end, int entityNum, int contentmask, int capsule );
 // clip to a specific entity
 
@@ -433,6 +433,7 @@ void SV_BotFrame( int time ) {
 	if (!bot_enable) return;
 	//NOTE: maybe the game is already shutdown
 	if (!gvm) return;
+	SV_UpdateSectorLists();
 	VM_Call( gvm, BOTAI_START_FRAME, time );
 }
 
@@ -490,6 +491,10 @@ void SV_BotInitCvars(void) {
 	Cvar_Get("bot_forcewrite", "0", 0);					//force writing aas file
 	Cvar_Get("bot_aasoptimize", "0", 0);				//no aas file optimisation
 	Cvar_Get("bot_saveroutingcache", "0", 0);			//save routing cache
+	Cvar_Get("bot_routecachewarmup", "0", 0);			//save routing cache after this many seconds, 0 = never
+	Cvar_Get("bot_saveroutetable", "0", 0);				//build and save the route table
+	Cvar_Get("bot_routetable", "1", 0);					//use the precomputed route table
+	Cvar_Get("bot_routingcachestats", "0", 0);			//print routing cache statistics every frame
 	Cvar_Get("bot_thinktime", "100", CVAR_CHEAT);		//msec the bots thinks
 	Cvar_Get("bot_reloadcharacters", "0", 0);			//reload the bot characters each time
 	Cvar_Get("bot_testichat", "0", 0);					//test ichats
@@ -306,6 +306,7 @@ static void SV_MapRestart_f( void ) {
 	// run a few frames to allow everything to settle
 	for (i = 0; i < 3; i++)
 	{
+		SV_UpdateSectorLists();
 		VM_Call (gvm, GAME_RUN_FRAME, sv.time);
 		sv.time += 100;
 		svs.time += 100;
@@ -354,6 +355,7 @@ static void SV_MapRestart_f( void ) {
 	}	
 
 	// run another frame to allow things to look at all the players
+	SV_UpdateSectorLists();
 	VM_Call (gvm, GAME_RUN_FRAME, sv.time);
 	sv.time += 100;
 	svs.time += 100;
@@ -1393,6 +1395,9 @@ void SV_AddOperatorCommands( void ) {
 	Cmd_AddCommand ("dumpuser", SV_DumpUser_f);
 	Cmd_AddCommand ("map_restart", SV_MapRestart_f);
 	Cmd_AddCommand ("sectorlist", SV_SectorList_f);
+	Cmd_AddCommand ("tracerecord", SV_TraceRecord_f);
+	Cmd_AddCommand ("tracestoprecord", SV_TraceStopRecord_f);
+	Cmd_AddCommand ("tracereplay", SV_TraceReplay_f);
 	Cmd_AddCommand ("map", SV_Map_f);
 	Cmd_SetCommandCompletionFunc( "map", SV_CompleteMapName );
 #ifndef PRE_RELEASE_DEMO
@@ -1440,6 +1445,9 @@ void SV_RemoveOperatorCommands( void ) {
 	Cmd_RemoveCommand ("dumpuser");
 	Cmd_RemoveCommand ("map_restart");
 	Cmd_RemoveCommand ("sectorlist");
+	Cmd_RemoveCommand ("tracerecord");
+	Cmd_RemoveCommand ("tracestoprecord");
+	Cmd_RemoveCommand ("tracereplay");
 	Cmd_RemoveCommand ("say");
 #endif
 }
@@ -1644,6 +1644,7 @@ void SV_ClientThink (client_t *cl, usercmd_t *cmd) {
 		return;		// may have been kicked during the last usercmd
 	}
 
+	SV_UpdateSectorLists();
 	VM_Call( gvm, GAME_CLIENT_THINK, cl - svs.clients );
 }
 
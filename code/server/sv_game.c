@@ -166,6 +166,46 @@ qboolean SV_inPVS (const vec3_t p1, const vec3_t p2)
 }
 
 
+/*
+=================
+SV_inPVSBatch
+
+Checks a number of points against a single viewer like SV_inPVS,
+looking up the viewer's cluster and area only once
+=================
+*/
+int SV_inPVSBatch( const vec3_t viewer, const vec3_t *points, int numPoints, qboolean *visible )
+{
+	int		i, count;
+	int		leafnum;
+	int		cluster;
+	int		area1, area2;
+	byte	*mask;
+
+	leafnum = CM_PointLeafnum (viewer);
+	cluster = CM_LeafCluster (leafnum);
+	area1 = CM_LeafArea (leafnum);
+	mask = CM_ClusterPVS (cluster);
+
+	count = 0;
+	for ( i = 0 ; i < numPoints ; i++ ) {
+		leafnum = CM_PointLeafnum (points[i]);
+		cluster = CM_LeafCluster (leafnum);
+		area2 = CM_LeafArea (leafnum);
+
+		visible[i] = qfalse;
+		if ( mask && (!(mask[cluster>>3] & (1<<(cluster&7)) ) ) )
+			continue;
+		if (!CM_AreasConnected (area1, area2))
+			continue;		// a door blocks sight
+		visible[i] = qtrue;
+		count++;
+	}
+
+	return count;
+}
+
+
 /*
 =================
 SV_inPVSIgnorePortals
@@ -340,6 +380,8 @@ intptr_t SV_GameSystemCalls( intptr_t *args ) {
 
 	case G_LOCATE_GAME_DATA:
 		SV_LocateGameData( VMA(1), args[2], args[3], VMA(4), args[5] );
+		VM_ShareData( gvm, 0, args[1], args[2] * args[3] );
+		VM_ShareData( gvm, 1, args[4], sv_maxclients->integer * args[5] );
 		return 0;
 	case G_DROP_CLIENT:
 		SV_GameDropClient( args[1], VMA(2) );
@@ -365,6 +407,14 @@ intptr_t SV_GameSystemCalls( intptr_t *args ) {
 	case G_TRACECAPSULE:
 		SV_Trace( VMA(1), VMA(2), VMA(3), VMA(4), VMA(5), args[6], args[7], /*int capsule*/ qtrue );
 		return 0;
+	case G_TRACE_BATCH:
+		if ( args[3] < 0 || args[3] > MAX_TRACE_BATCH ) {
+			Com_Error( ERR_DROP, "G_TRACE_BATCH: bad numRequests %i", (int)args[3] );
+		}
+		VM_CheckBlock( args[1], args[3] * sizeof( trace_t ), "G_TRACE_BATCH" );
+		VM_CheckBlock( args[2], args[3] * sizeof( traceRequest_t ), "G_TRACE_BATCH" );
+		SV_TraceBatch( VMA(1), VMA(2), args[3] );
+		return 0;
 	case G_POINT_CONTENTS:
 		return SV_PointContents( VMA(1), args[2] );
 	case G_SET_BRUSH_MODEL:
@@ -374,6 +424,13 @@ intptr_t SV_GameSystemCalls( intptr_t *args ) {
 		return SV_inPVS( VMA(1), VMA(2) );
 	case G_IN_PVS_IGNORE_PORTALS:
 		return SV_inPVSIgnorePortals( VMA(1), VMA(2) );
+	case G_IN_PVS_BATCH:
+		if ( args[3] < 0 || args[3] > MAX_PVS_BATCH ) {
+			Com_Error( ERR_DROP, "G_IN_PVS_BATCH: bad numPoints %i", (int)args[3] );
+		}
+		VM_CheckBlock( args[2], args[3] * sizeof( vec3_t ), "G_IN_PVS_BATCH" );
+		VM_CheckBlock( args[4], args[3] * sizeof( qboolean ), "G_IN_PVS_BATCH" );
+		return SV_inPVSBatch( VMA(1), VMA(2), args[3], VMA(4) );
 
 	case G_SET_CONFIGSTRING:
 		SV_SetConfigstring( args[1], VMA(2) );
@@ -506,6 +506,7 @@ void SV_SpawnServer( char *server, qboolean killBots ) {
 	// run a few frames to allow everything to settle
 	for (i = 0;i < 3; i++)
 	{
+		SV_UpdateSectorLists();
 		VM_Call (gvm, GAME_RUN_FRAME, sv.time);
 		SV_BotFrame (sv.time);
 		sv.time += 100;
@@ -563,6 +564,7 @@ void SV_SpawnServer( char *server, qboolean killBots ) {
 	}	
 
 	// run another frame to allow things to look at all the players
+	SV_UpdateSectorLists();
 	VM_Call (gvm, GAME_RUN_FRAME, sv.time);
 	SV_BotFrame (sv.time);
 	sv.time += 100;
@@ -689,6 +691,11 @@ void SV_Init (void)
 #endif
 	sv_public = Cvar_Get( "sv_public", "0", 0);
 	sv_banFile = Cvar_Get("sv_banFile", "serverbans.dat", CVAR_ARCHIVE);
+	sv_noBoxSweeps = Cvar_Get ("sv_noBoxSweeps", "0", CVAR_CHEAT);
+	sv_traceThreads = Cvar_Get ("sv_traceThreads", "0", CVAR_ARCHIVE);
+	Cvar_CheckRange( sv_traceThreads, 0, CM_MAX_TRACE_CONTEXTS - 1, qtrue );
+	// tells the game that G_TRACE_BATCH and G_IN_PVS_BATCH can be called
+	Cvar_Get ("sv_batchTraps", "1", CVAR_ROM);
 
 	// initialize bot cvars so they are listed and can be set before loading the botlib
 	SV_BotInitCvars();
@@ -756,8 +763,13 @@ void SV_Shutdown( char *finalmsg ) {
 
 	SV_RemoveOperatorCommands();
 	SV_MasterShutdown();
+	SV_TraceStopRecord();
 	SV_ShutdownGameProgs();
 
+	// stop the trace workers, they are started again by the next batch
+	Sys_StartWorkers( 0 );
+	sv_traceThreads->modified = qtrue;
+
 	// free current level
 	SV_ClearServer();
 
@@ -63,6 +63,8 @@ cvar_t	*sv_strictAuth;
 #endif
 cvar_t	*sv_public;
 cvar_t	*sv_banFile;
+cvar_t	*sv_noBoxSweeps;	// clip against bounding box entities through the temp box hull
+cvar_t	*sv_traceThreads;	// worker threads for the traces of a batch
 
 serverBan_t serverBans[SERVER_MAXBANS];
 int serverBansCount = 0;
@@ -1155,6 +1157,7 @@ void SV_Frame( int msec ) {
 		sv.time += frameMsec;
 
 		// let everything in the world think and move
+		SV_UpdateSectorLists();
 		VM_Call (gvm, GAME_RUN_FRAME, sv.time);
 	}
 
@@ -23,6 +23,18 @@ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
 
 #include "server.h"
 
+static fileHandle_t	traceRecordFile;
+static int			traceRecordNest;
+
+static void SV_RecordLink( const sharedEntity_t *gEnt );
+static void SV_RecordUnlink( const sharedEntity_t *gEnt );
+static void SV_RecordSync( int entityNum );
+static void SV_RecordSectorList( const sharedEntity_t *gEnt );
+static void SV_RecordTrace( const trace_t *results, const vec3_t start, const vec3_t mins, const vec3_t maxs, const vec3_t end, int passEntityNum, int contentmask, int capsule );
+static void SV_RecordPointContents( const vec3_t p, int passEntityNum, int contents );
+static void SV_RecordAreaEntities( const vec3_t mins, const vec3_t maxs, const int *entityList, int maxcount, int count );
+static clipHandle_t SV_ClipHandleForEntityContext( int context, const sharedEntity_t *ent );
+
 /*
 ================
 SV_ClipHandleForEntity
@@ -33,20 +45,44 @@ be returned, otherwise a custom box tree will be constructed.
 ================
 */
 clipHandle_t SV_ClipHandleForEntity( const sharedEntity_t *ent ) {
+	return SV_ClipHandleForEntityContext( 0, ent );
+}
+
+/*
+================
+SV_ClipHandleForEntityContext
+
+Same as above, but any temp box is built in the given trace context
+================
+*/
+static clipHandle_t SV_ClipHandleForEntityContext( int context, const sharedEntity_t *ent ) {
 	if ( ent->r.bmodel ) {
 		// explicit hulls in the BSP model
 		return CM_InlineModel( ent->s.modelindex );
 	}
 	if ( ent->r.svFlags & SVF_CAPSULE ) {
 		// create a temp capsule from bounding box sizes
-		return CM_TempBoxModel( ent->r.mins, ent->r.maxs, qtrue );
+		return CM_TempBoxModelContext( context, ent->r.mins, ent->r.maxs, qtrue );
 	}
 
 	// create a temp tree from bounding box sizes
-	return CM_TempBoxModel( ent->r.mins, ent->r.maxs, qfalse );
+	return CM_TempBoxModelContext( context, ent->r.mins, ent->r.maxs, qfalse );
 }
 
 
+/*
+================
+SV_SweepEntityBox
+
+Bounding box and capsule entities don't rotate, so a move can be clipped
+against them directly instead of through a temp box hull, unless both the
+move and the entity are capsules
+================
+*/
+static qboolean SV_SweepEntityBox( const sharedEntity_t *ent, int capsule ) {
+	return !ent->r.bmodel && !( ( ent->r.svFlags & SVF_CAPSULE ) && capsule ) && !sv_noBoxSweeps->integer;
+}
+
 
 /*
 ===============================================================================
@@ -54,26 +90,63 @@ clipHandle_t SV_ClipHandleForEntity( const sharedEntity_t *ent ) {
 ENTITY CHECKING
 
 To avoid linearly searching through lists of entities during environment testing,
-the world is carved up with an evenly spaced, axially aligned bsp tree.  Entities
-are kept in chains either at the final leafs, or at the first node that splits
-them, which prevents having to deal with multiple fragments of a single entity.
+the world is carved up with an axially aligned bsp tree.  Entities are kept in
+chains either at the final leafs, or at the first node that splits them, which
+prevents having to deal with multiple fragments of a single entity.
+
+The tree starts as a single sector and a leaf is split in two whenever more than
+SECTOR_MAX_ENTITIES are linked into it, so it only gets deep where entities
+gather.  The children of a node are loose: an entity can cross the split by
+up to a quarter of the child's size and still go down, otherwise everything
+sitting on a split would pile up in the node above.
+
+Each sector keeps a separate chain for every class of contents, picked when
+the entity is linked, so a trace only walks the chains its contentmask can
+hit.  Most traces are shots and player moves, which never look at the
+items, triggers and missiles that make up most of the entities.
 
 ===============================================================================
 */
 
+typedef enum {
+	SECTOR_SOLID,		// anything not in the other chains, brush models
+	SECTOR_BODY,		// players and corpses
+	SECTOR_TRIGGER,		// items and trigger brushes
+	SECTOR_NONSOLID,	// missiles and effects, nothing can clip against them
+	NUM_SECTOR_LISTS
+} sectorList_t;
+
+// the contents a trace has to look for to walk each chain
+static const int sectorListContents[NUM_SECTOR_LISTS] = {
+	-1,
+	CONTENTS_BODY | CONTENTS_CORPSE,
+	CONTENTS_TRIGGER,
+	0
+};
+
 typedef struct worldSector_s {
 	int		axis;		// -1 = leaf node
 	float	dist;
+	float	loose;		// how far entities in the children may cross dist
 	struct worldSector_s	*children[2];
-	svEntity_t	*entities;
+	svEntity_t	*entities[NUM_SECTOR_LISTS];
+	int		numEntities;
+	int		depth;
+	vec3_t	mins, maxs;
 } worldSector_t;
 
-#define	AREA_DEPTH	4
-#define	AREA_NODES	64
+#define	MAX_WORLD_SECTORS	1024
+#define	SECTOR_MAX_ENTITIES	8		// a leaf with more entities is split
+#define	SECTOR_MIN_SIZE		128		// unless its halves would get smaller than this
 
-worldSector_t	sv_worldSectors[AREA_NODES];
+worldSector_t	sv_worldSectors[MAX_WORLD_SECTORS];
 int			sv_numworldSectors;
 
+// SV_AreaEntities statistics for sectorlist
+static int		sv_numAreaQueries;
+static int		sv_numAreaSectors;
+static int		sv_numAreaChecks;
+
 
 /*
 ===============
@@ -81,61 +154,250 @@ SV_SectorList_f
 ===============
 */
 void SV_SectorList_f( void ) {
-	int				i, c;
+	int				i, j, c;
+	int				maxDepth, numLeafs, numEntities, numChains, longestChain;
+	int				listEntities[NUM_SECTOR_LISTS], listCount[NUM_SECTOR_LISTS];
 	worldSector_t	*sec;
 	svEntity_t		*ent;
 
-	for ( i = 0 ; i < AREA_NODES ; i++ ) {
+	maxDepth = numLeafs = numEntities = numChains = longestChain = 0;
+	Com_Memset( listEntities, 0, sizeof( listEntities ) );
+
+	for ( i = 0 ; i < sv_numworldSectors ; i++ ) {
 		sec = &sv_worldSectors[i];
 
 		c = 0;
-		for ( ent = sec->entities ; ent ; ent = ent->nextEntityInWorldSector ) {
-			c++;
+		for ( j = 0 ; j < NUM_SECTOR_LISTS ; j++ ) {
+			listCount[j] = 0;
+			for ( ent = sec->entities[j] ; ent ; ent = ent->nextEntityInWorldSector ) {
+				listCount[j]++;
+			}
+			listEntities[j] += listCount[j];
+			c += listCount[j];
+		}
+		if ( c ) {
+			Com_Printf( "sector %i: depth %i, %s, %i entities (%i solid, %i body, %i trigger, %i nonsolid)\n",
+				i, sec->depth, sec->axis == -1 ? "leaf" : "node", c, listCount[SECTOR_SOLID],
+				listCount[SECTOR_BODY], listCount[SECTOR_TRIGGER], listCount[SECTOR_NONSOLID] );
+			numChains++;
+		}
+
+		numEntities += c;
+		if ( c > longestChain ) {
+			longestChain = c;
+		}
+		if ( sec->depth > maxDepth ) {
+			maxDepth = sec->depth;
+		}
+		if ( sec->axis == -1 ) {
+			numLeafs++;
 		}
-		Com_Printf( "sector %i: %i entities\n", i, c );
 	}
+
+	Com_Printf( "%i sectors, %i leafs, depth %i\n", sv_numworldSectors, numLeafs, maxDepth );
+	Com_Printf( "%i entities in %i chains, longest chain %i\n", numEntities, numChains, longestChain );
+	Com_Printf( "%i solid, %i body, %i trigger, %i nonsolid\n", listEntities[SECTOR_SOLID],
+		listEntities[SECTOR_BODY], listEntities[SECTOR_TRIGGER], listEntities[SECTOR_NONSOLID] );
+	if ( sv_numAreaQueries ) {
+		Com_Printf( "%i area queries since the last sectorlist, %.1f sectors and %.1f entities checked per query\n",
+			sv_numAreaQueries, (float)sv_numAreaSectors / sv_numAreaQueries,
+			(float)sv_numAreaChecks / sv_numAreaQueries );
+	}
+	sv_numAreaQueries = sv_numAreaSectors = sv_numAreaChecks = 0;
 }
 
 /*
 ===============
 SV_CreateworldSector
 
-Builds a uniformly subdivided tree for the given world size
+Allocates an empty leaf covering the given bounds
 ===============
 */
 static worldSector_t *SV_CreateworldSector( int depth, vec3_t mins, vec3_t maxs ) {
 	worldSector_t	*anode;
-	vec3_t		size;
-	vec3_t		mins1, maxs1, mins2, maxs2;
 
 	anode = &sv_worldSectors[sv_numworldSectors];
 	sv_numworldSectors++;
 
-	if (depth == AREA_DEPTH) {
-		anode->axis = -1;
-		anode->children[0] = anode->children[1] = NULL;
-		return anode;
+	anode->axis = -1;
+	anode->children[0] = anode->children[1] = NULL;
+	Com_Memset( anode->entities, 0, sizeof( anode->entities ) );
+	anode->numEntities = 0;
+	anode->depth = depth;
+	VectorCopy( mins, anode->mins );
+	VectorCopy( maxs, anode->maxs );
+
+	return anode;
+}
+
+/*
+===============
+SV_SectorForBounds
+
+Finds the deepest sector below node whose loose bounds hold the given box
+===============
+*/
+static worldSector_t *SV_SectorForBounds( worldSector_t *node, const vec3_t absmin, const vec3_t absmax ) {
+	while ( node->axis != -1 ) {
+		if ( absmin[node->axis] + absmax[node->axis] > 2 * node->dist ) {
+			if ( absmin[node->axis] < node->dist - node->loose ) {
+				break;		// crosses the node
+			}
+			node = node->children[0];
+		} else {
+			if ( absmax[node->axis] > node->dist + node->loose ) {
+				break;		// crosses the node
+			}
+			node = node->children[1];
+		}
 	}
-	
-	VectorSubtract (maxs, mins, size);
-	if (size[0] > size[1]) {
-		anode->axis = 0;
+
+	return node;
+}
+
+/*
+===============
+SV_SectorListForContents
+
+The game can change the contents of a linked entity without relinking it,
+so SV_UpdateSectorLists checks the chains against the contents again
+===============
+*/
+static sectorList_t SV_SectorListForContents( int contents ) {
+	if ( !contents ) {
+		return SECTOR_NONSOLID;
+	}
+	if ( contents == CONTENTS_TRIGGER ) {
+		return SECTOR_TRIGGER;
+	}
+	if ( !( contents & ~( CONTENTS_BODY | CONTENTS_CORPSE ) ) ) {
+		return SECTOR_BODY;
+	}
+	return SECTOR_SOLID;
+}
+
+static void SV_AddEntityToSector( worldSector_t *node, svEntity_t *ent ) {
+	ent->worldSector = node;
+	ent->nextEntityInWorldSector = node->entities[ent->worldSectorList];
+	node->entities[ent->worldSectorList] = ent;
+	node->numEntities++;
+}
+
+static qboolean SV_RemoveEntityFromSector( svEntity_t *ent ) {
+	svEntity_t		*scan;
+	worldSector_t	*ws;
+
+	ws = ent->worldSector;
+	ent->worldSector = NULL;
+	ws->numEntities--;
+
+	if ( ws->entities[ent->worldSectorList] == ent ) {
+		ws->entities[ent->worldSectorList] = ent->nextEntityInWorldSector;
+		return qtrue;
+	}
+
+	for ( scan = ws->entities[ent->worldSectorList] ; scan ; scan = scan->nextEntityInWorldSector ) {
+		if ( scan->nextEntityInWorldSector == ent ) {
+			scan->nextEntityInWorldSector = ent->nextEntityInWorldSector;
+			return qtrue;
+		}
+	}
+
+	return qfalse;
+}
+
+/*
+===============
+SV_UpdateSectorList
+
+Moves a linked entity to the chain of its sector that matches its contents
+===============
+*/
+static qboolean SV_UpdateSectorList( svEntity_t *ent, const sharedEntity_t *gEnt ) {
+	worldSector_t	*ws;
+	sectorList_t	list;
+
+	ws = ent->worldSector;
+	if ( !ws ) {
+		return qfalse;
+	}
+
+	list = SV_SectorListForContents( gEnt->r.contents );
+	if ( list == ent->worldSectorList ) {
+		return qfalse;
+	}
+
+	if ( !SV_RemoveEntityFromSector( ent ) ) {
+		Com_Printf( "WARNING: SV_UpdateSectorList: not found in worldSector\n" );
+	}
+	ent->worldSectorList = list;
+	SV_AddEntityToSector( ws, ent );
+	return qtrue;
+}
+
+/*
+===============
+SV_SplitWorldSector
+
+Turns a crowded leaf into a node and moves its entities down as far as they go
+===============
+*/
+static void SV_SplitWorldSector( worldSector_t *node ) {
+	vec3_t			size;
+	vec3_t			mins1, maxs1, mins2, maxs2;
+	svEntity_t		*chains[NUM_SECTOR_LISTS];
+	svEntity_t		*ent, *next;
+	sharedEntity_t	*gEnt;
+	int				axis, i;
+
+	if ( sv_numworldSectors + 2 > MAX_WORLD_SECTORS ) {
+		return;
+	}
+
+	VectorSubtract( node->maxs, node->mins, size );
+	if ( size[0] >= size[1] && size[0] >= size[2] ) {
+		axis = 0;
+	} else if ( size[1] >= size[2] ) {
+		axis = 1;
 	} else {
-		anode->axis = 1;
+		axis = 2;
+	}
+	if ( size[axis] < 2 * SECTOR_MIN_SIZE ) {
+		return;
 	}
 
-	anode->dist = 0.5 * (maxs[anode->axis] + mins[anode->axis]);
-	VectorCopy (mins, mins1);	
-	VectorCopy (mins, mins2);	
-	VectorCopy (maxs, maxs1);	
-	VectorCopy (maxs, maxs2);	
-	
-	maxs1[anode->axis] = mins2[anode->axis] = anode->dist;
-	
-	anode->children[0] = SV_CreateworldSector (depth+1, mins2, maxs2);
-	anode->children[1] = SV_CreateworldSector (depth+1, mins1, maxs1);
+	node->axis = axis;
+	node->dist = 0.5 * ( node->maxs[axis] + node->mins[axis] );
+	node->loose = 0.125 * size[axis];
 
-	return anode;
+	VectorCopy( node->mins, mins1 );
+	VectorCopy( node->mins, mins2 );
+	VectorCopy( node->maxs, maxs1 );
+	VectorCopy( node->maxs, maxs2 );
+
+	maxs1[axis] = mins2[axis] = node->dist;
+
+	node->children[0] = SV_CreateworldSector( node->depth + 1, mins2, maxs2 );
+	node->children[1] = SV_CreateworldSector( node->depth + 1, mins1, maxs1 );
+
+	Com_Memcpy( chains, node->entities, sizeof( chains ) );
+	Com_Memset( node->entities, 0, sizeof( node->entities ) );
+	node->numEntities = 0;
+	for ( i = 0 ; i < NUM_SECTOR_LISTS ; i++ ) {
+		for ( ent = chains[i] ; ent ; ent = next ) {
+			next = ent->nextEntityInWorldSector;
+			gEnt = SV_GEntityForSvEntity( ent );
+			SV_AddEntityToSector( SV_SectorForBounds( node, gEnt->r.absmin, gEnt->r.absmax ), ent );
+		}
+	}
+
+	// everything may have ended up on one side
+	if ( node->children[0]->numEntities > SECTOR_MAX_ENTITIES ) {
+		SV_SplitWorldSector( node->children[0] );
+	}
+	if ( node->children[1]->numEntities > SECTOR_MAX_ENTITIES ) {
+		SV_SplitWorldSector( node->children[1] );
+	}
 }
 
 /*
@@ -148,6 +410,9 @@ void SV_ClearWorld( void ) {
 	clipHandle_t	h;
 	vec3_t			mins, maxs;
 
+	// a capture only makes sense against the map it was started on
+	SV_TraceStopRecord();
+
 	Com_Memset( sv_worldSectors, 0, sizeof(sv_worldSectors) );
 	sv_numworldSectors = 0;
 
@@ -166,32 +431,22 @@ SV_UnlinkEntity
 */
 void SV_UnlinkEntity( sharedEntity_t *gEnt ) {
 	svEntity_t		*ent;
-	svEntity_t		*scan;
-	worldSector_t	*ws;
 
 	ent = SV_SvEntityForGentity( gEnt );
 
+	if ( traceRecordFile ) {
+		SV_RecordUnlink( gEnt );
+	}
+
 	gEnt->r.linked = qfalse;
 
-	ws = ent->worldSector;
-	if ( !ws ) {
+	if ( !ent->worldSector ) {
 		return;		// not linked in anywhere
 	}
-	ent->worldSector = NULL;
 
-	if ( ws->entities == ent ) {
-		ws->entities = ent->nextEntityInWorldSector;
-		return;
+	if ( !SV_RemoveEntityFromSector( ent ) ) {
+		Com_Printf( "WARNING: SV_UnlinkEntity: not found in worldSector\n" );
 	}
-
-	for ( scan = ws->entities ; scan ; scan = scan->nextEntityInWorldSector ) {
-		if ( scan->nextEntityInWorldSector == ent ) {
-			scan->nextEntityInWorldSector = ent->nextEntityInWorldSector;
-			return;
-		}
-	}
-
-	Com_Printf( "WARNING: SV_UnlinkEntity: not found in worldSector\n" );
 }
 
 
@@ -292,6 +547,9 @@ void SV_LinkEntity( sharedEntity_t *gEnt ) {
 	// if none of the leafs were inside the map, the
 	// entity is outside the world and can be considered unlinked
 	if ( !num_leafs ) {
+		if ( traceRecordFile ) {
+			SV_RecordLink( gEnt );
+		}
 		return;
 	}
 
@@ -333,26 +591,46 @@ void SV_LinkEntity( sharedEntity_t *gEnt ) {
 
 	gEnt->r.linkcount++;
 
-	// find the first world sector node that the ent's box crosses
-	node = sv_worldSectors;
-	while (1)
-	{
-		if (node->axis == -1)
-			break;
-		if ( gEnt->r.absmin[node->axis] > node->dist)
-			node = node->children[0];
-		else if ( gEnt->r.absmax[node->axis] < node->dist)
-			node = node->children[1];
-		else
-			break;		// crosses the node
-	}
-	
+	// find the deepest world sector that holds the ent's box
+	node = SV_SectorForBounds( sv_worldSectors, gEnt->r.absmin, gEnt->r.absmax );
+
 	// link it in
-	ent->worldSector = node;
-	ent->nextEntityInWorldSector = node->entities;
-	node->entities = ent;
+	ent->worldSectorList = SV_SectorListForContents( gEnt->r.contents );
+	SV_AddEntityToSector( node, ent );
+	if ( node->axis == -1 && node->numEntities > SECTOR_MAX_ENTITIES ) {
+		SV_SplitWorldSector( node );
+	}
 
 	gEnt->r.linked = qtrue;
+
+	if ( traceRecordFile ) {
+		SV_RecordLink( gEnt );
+	}
+}
+
+/*
+===============
+SV_UpdateSectorLists
+
+Traces only walk the chains their contentmask can hit, so an entity whose
+contents the game changed without relinking it has to change chains before
+the game traces again. Called before the game runs a frame or a command.
+===============
+*/
+void SV_UpdateSectorLists( void ) {
+	svEntity_t		*ent;
+	sharedEntity_t	*gEnt;
+	int				i;
+
+	for ( i = 0, ent = sv.svEntities ; i < sv.num_entities ; i++, ent++ ) {
+		if ( !ent->worldSector ) {
+			continue;
+		}
+		gEnt = SV_GentityNum( i );
+		if ( SV_UpdateSectorList( ent, gEnt ) && traceRecordFile ) {
+			SV_RecordSectorList( gEnt );
+		}
+	}
 }
 
 /*
@@ -362,6 +640,8 @@ AREA QUERY
 
 Fills in a list of all entities who's absmin / absmax intersects the given
 bounds.  This does NOT mean that they actually touch in the case of bmodels.
+Clipping asks only for the entities a trace could hit, which lets whole
+chains of the sectors be skipped.
 ============================================================================
 */
 
@@ -370,6 +650,12 @@ typedef struct {
 	const float	*maxs;
 	int			*list;
 	int			count, maxcount;
+	int			lists;			// bits of the sector chains to walk
+	qboolean	filter;			// apply the rules below
+	int			contentmask;
+	int			passEntityNum;
+	int			passOwnerNum;
+	int			sectors, checks;	// for sectorlist, only kept on the main thread
 } areaParms_t;
 
 
@@ -382,39 +668,75 @@ SV_AreaEntities_r
 static void SV_AreaEntities_r( worldSector_t *node, areaParms_t *ap ) {
 	svEntity_t	*check, *next;
 	sharedEntity_t *gcheck;
+	int			i;
 
-	for ( check = node->entities  ; check ; check = next ) {
-		next = check->nextEntityInWorldSector;
-
-		gcheck = SV_GEntityForSvEntity( check );
+	ap->sectors++;
 
-		if ( gcheck->r.absmin[0] > ap->maxs[0]
-		|| gcheck->r.absmin[1] > ap->maxs[1]
-		|| gcheck->r.absmin[2] > ap->maxs[2]
-		|| gcheck->r.absmax[0] < ap->mins[0]
-		|| gcheck->r.absmax[1] < ap->mins[1]
-		|| gcheck->r.absmax[2] < ap->mins[2]) {
+	for ( i = 0 ; i < NUM_SECTOR_LISTS ; i++ ) {
+		if ( !( ap->lists & ( 1 << i ) ) ) {
 			continue;
 		}
 
-		if ( ap->count == ap->maxcount ) {
-			Com_Printf ("SV_AreaEntities: MAXCOUNT\n");
-			return;
-		}
+		for ( check = node->entities[i] ; check ; check = next ) {
+			next = check->nextEntityInWorldSector;
+			ap->checks++;
+
+			gcheck = SV_GEntityForSvEntity( check );
+
+			if ( gcheck->r.absmin[0] > ap->maxs[0]
+			|| gcheck->r.absmin[1] > ap->maxs[1]
+			|| gcheck->r.absmin[2] > ap->maxs[2]
+			|| gcheck->r.absmax[0] < ap->mins[0]
+			|| gcheck->r.absmax[1] < ap->mins[1]
+			|| gcheck->r.absmax[2] < ap->mins[2]) {
+				continue;
+			}
 
-		ap->list[ap->count] = check - sv.svEntities;
-		ap->count++;
+			// anything the caller can look at has to be current in the capture
+			if ( traceRecordFile ) {
+				SV_RecordSync( check - sv.svEntities );
+			}
+
+			if ( ap->filter ) {
+				// if it doesn't have any brushes of a type we
+				// are looking for, ignore it
+				if ( !( ap->contentmask & gcheck->r.contents ) ) {
+					continue;
+				}
+
+				// see if we should ignore this entity
+				if ( ap->passEntityNum != ENTITYNUM_NONE ) {
+					if ( check - sv.svEntities == ap->passEntityNum ) {
+						continue;	// don't clip against the pass entity
+					}
+					if ( gcheck->r.ownerNum == ap->passEntityNum ) {
+						continue;	// don't clip against own missiles
+					}
+					if ( gcheck->r.ownerNum == ap->passOwnerNum ) {
+						continue;	// don't clip against other missiles from our owner
+					}
+				}
+			}
+
+			if ( ap->count == ap->maxcount ) {
+				Com_Printf ("SV_AreaEntities: MAXCOUNT\n");
+				return;
+			}
+
+			ap->list[ap->count] = check - sv.svEntities;
+			ap->count++;
+		}
 	}
 	
 	if (node->axis == -1) {
 		return;		// terminal node
 	}
 
-	// recurse down both sides
-	if ( ap->maxs[node->axis] > node->dist ) {
+	// recurse down both sides, the children are loose
+	if ( ap->maxs[node->axis] >= node->dist - node->loose ) {
 		SV_AreaEntities_r ( node->children[0], ap );
 	}
-	if ( ap->mins[node->axis] < node->dist ) {
+	if ( ap->mins[node->axis] <= node->dist + node->loose ) {
 		SV_AreaEntities_r ( node->children[1], ap );
 	}
 }
@@ -427,13 +749,66 @@ SV_AreaEntities
 int SV_AreaEntities( const vec3_t mins, const vec3_t maxs, int *entityList, int maxcount ) {
 	areaParms_t		ap;
 
+	Com_Memset( &ap, 0, sizeof( ap ) );
 	ap.mins = mins;
 	ap.maxs = maxs;
 	ap.list = entityList;
-	ap.count = 0;
 	ap.maxcount = maxcount;
+	ap.lists = ( 1 << NUM_SECTOR_LISTS ) - 1;
 
 	SV_AreaEntities_r( sv_worldSectors, &ap );
+	sv_numAreaQueries++;
+	sv_numAreaSectors += ap.sectors;
+	sv_numAreaChecks += ap.checks;
+
+	if ( traceRecordFile && !traceRecordNest ) {
+		SV_RecordAreaEntities( mins, maxs, entityList, maxcount, ap.count );
+	}
+
+	return ap.count;
+}
+
+/*
+================
+SV_ClipEntities
+
+Like SV_AreaEntities, but only returns the entities a trace with the given
+contentmask and pass entity could hit. Safe to call from the trace workers.
+================
+*/
+static int SV_ClipEntities( int context, const vec3_t mins, const vec3_t maxs, int *entityList, int maxcount, int contentmask, int passEntityNum ) {
+	areaParms_t		ap;
+	int				i;
+
+	Com_Memset( &ap, 0, sizeof( ap ) );
+	ap.mins = mins;
+	ap.maxs = maxs;
+	ap.list = entityList;
+	ap.maxcount = maxcount;
+	ap.filter = qtrue;
+	ap.contentmask = contentmask;
+	ap.passEntityNum = passEntityNum;
+	ap.passOwnerNum = -1;
+
+	if ( passEntityNum != ENTITYNUM_NONE ) {
+		ap.passOwnerNum = ( SV_GentityNum( passEntityNum ) )->r.ownerNum;
+		if ( ap.passOwnerNum == ENTITYNUM_NONE ) {
+			ap.passOwnerNum = -1;
+		}
+	}
+
+	for ( i = 0 ; i < NUM_SECTOR_LISTS ; i++ ) {
+		if ( contentmask & sectorListContents[i] ) {
+			ap.lists |= 1 << i;
+		}
+	}
+
+	SV_AreaEntities_r( sv_worldSectors, &ap );
+	if ( !context ) {
+		sv_numAreaQueries++;
+		sv_numAreaSectors += ap.sectors;
+		sv_numAreaChecks += ap.checks;
+	}
 
 	return ap.count;
 }
@@ -453,6 +828,7 @@ typedef struct {
 	int			passEntityNum;
 	int			contentmask;
 	int			capsule;
+	int			context;	// collision model trace context
 } moveclip_t;
 
 
@@ -478,19 +854,24 @@ void SV_ClipToEntity( trace_t *trace, const vec3_t start, const vec3_t mins, con
 		return;
 	}
 
-	// might intersect, so do an exact clip
-	clipHandle = SV_ClipHandleForEntity (touch);
-
 	origin = touch->r.currentOrigin;
 	angles = touch->r.currentAngles;
 
-	if ( !touch->r.bmodel ) {
-		angles = vec3_origin;	// boxes don't rotate
-	}
+	// might intersect, so do an exact clip
+	if ( SV_SweepEntityBox( touch, capsule ) ) {
+		CM_TraceAgainstBox( trace, start, end, mins, maxs, touch->r.mins, touch->r.maxs,
+			contentmask, origin, capsule, touch->r.svFlags & SVF_CAPSULE );
+	} else {
+		clipHandle = SV_ClipHandleForEntity (touch);
+
+		if ( !touch->r.bmodel ) {
+			angles = vec3_origin;	// boxes don't rotate
+		}
 
-	CM_TransformedBoxTrace ( trace, (float *)start, (float *)end,
-		(float *)mins, (float *)maxs, clipHandle,  contentmask,
-		origin, angles, capsule);
+		CM_TransformedBoxTrace ( trace, (float *)start, (float *)end,
+			(float *)mins, (float *)maxs, clipHandle,  contentmask,
+			origin, angles, capsule);
+	}
 
 	if ( trace->fraction < 1 ) {
 		trace->entityNum = touch->s.number;
@@ -508,21 +889,13 @@ static void SV_ClipMoveToEntities( moveclip_t *clip ) {
 	int			i, num;
 	int			touchlist[MAX_GENTITIES];
 	sharedEntity_t *touch;
-	int			passOwnerNum;
 	trace_t		trace;
 	clipHandle_t	clipHandle;
 	float		*origin, *angles;
 
-	num = SV_AreaEntities( clip->boxmins, clip->boxmaxs, touchlist, MAX_GENTITIES);
-
-	if ( clip->passEntityNum != ENTITYNUM_NONE ) {
-		passOwnerNum = ( SV_GentityNum( clip->passEntityNum ) )->r.ownerNum;
-		if ( passOwnerNum == ENTITYNUM_NONE ) {
-			passOwnerNum = -1;
-		}
-	} else {
-		passOwnerNum = -1;
-	}
+	// the pass entity and contentmask rules are applied by the query
+	num = SV_ClipEntities( clip->context, clip->boxmins, clip->boxmaxs, touchlist, MAX_GENTITIES,
+		clip->contentmask, clip->passEntityNum );
 
 	for ( i=0 ; i<num ; i++ ) {
 		if ( clip->trace.allsolid ) {
@@ -530,39 +903,25 @@ static void SV_ClipMoveToEntities( moveclip_t *clip ) {
 		}
 		touch = SV_GentityNum( touchlist[i] );
 
-		// see if we should ignore this entity
-		if ( clip->passEntityNum != ENTITYNUM_NONE ) {
-			if ( touchlist[i] == clip->passEntityNum ) {
-				continue;	// don't clip against the pass entity
-			}
-			if ( touch->r.ownerNum == clip->passEntityNum ) {
-				continue;	// don't clip against own missiles
-			}
-			if ( touch->r.ownerNum == passOwnerNum ) {
-				continue;	// don't clip against other missiles from our owner
-			}
-		}
-
-		// if it doesn't have any brushes of a type we
-		// are looking for, ignore it
-		if ( ! ( clip->contentmask & touch->r.contents ) ) {
-			continue;
-		}
-
-		// might intersect, so do an exact clip
-		clipHandle = SV_ClipHandleForEntity (touch);
-
 		origin = touch->r.currentOrigin;
 		angles = touch->r.currentAngles;
 
+		// might intersect, so do an exact clip
+		if ( SV_SweepEntityBox( touch, clip->capsule ) ) {
+			CM_TraceAgainstBox( &trace, clip->start, clip->end, clip->mins, clip->maxs,
+				touch->r.mins, touch->r.maxs, clip->contentmask, origin, clip->capsule,
+				touch->r.svFlags & SVF_CAPSULE );
+		} else {
+			clipHandle = SV_ClipHandleForEntityContext( clip->context, touch );
 
-		if ( !touch->r.bmodel ) {
-			angles = vec3_origin;	// boxes don't rotate
-		}
+			if ( !touch->r.bmodel ) {
+				angles = vec3_origin;	// boxes don't rotate
+			}
 
-		CM_TransformedBoxTrace ( &trace, (float *)clip->start, (float *)clip->end,
-			(float *)clip->mins, (float *)clip->maxs, clipHandle,  clip->contentmask,
-			origin, angles, clip->capsule);
+			CM_TransformedBoxTraceContext( clip->context, &trace, clip->start, clip->end,
+				(float *)clip->mins, (float *)clip->maxs, clipHandle,  clip->contentmask,
+				origin, angles, clip->capsule);
+		}
 
 		if ( trace.allsolid ) {
 			clip->trace.allsolid = qtrue;
@@ -588,27 +947,22 @@ static void SV_ClipMoveToEntities( moveclip_t *clip ) {
 
 /*
 ==================
-SV_Trace
+SV_TraceContext
 
-Moves the given mins/maxs volume through the world from start to end.
-passEntityNum and entities owned by passEntityNum are explicitly not checked.
+SV_Trace through the given collision model trace context, so traces in
+different contexts can run at the same time as long as nothing is linked
+or unlinked meanwhile.
 ==================
 */
-void SV_Trace( trace_t *results, const vec3_t start, vec3_t mins, vec3_t maxs, const vec3_t end, int passEntityNum, int contentmask, int capsule ) {
+static void SV_TraceContext( int context, trace_t *results, const vec3_t start, vec3_t mins, vec3_t maxs, const vec3_t end, int passEntityNum, int contentmask, int capsule ) {
 	moveclip_t	clip;
 	int			i;
 
-	if ( !mins ) {
-		mins = vec3_origin;
-	}
-	if ( !maxs ) {
-		maxs = vec3_origin;
-	}
-
 	Com_Memset ( &clip, 0, sizeof ( moveclip_t ) );
+	clip.context = context;
 
 	// clip to world
-	CM_BoxTrace( &clip.trace, start, end, mins, maxs, 0, contentmask, capsule );
+	CM_BoxTraceContext( context, &clip.trace, start, end, mins, maxs, 0, contentmask, capsule );
 	clip.trace.entityNum = clip.trace.fraction != 1.0 ? ENTITYNUM_WORLD : ENTITYNUM_NONE;
 	if ( clip.trace.fraction == 0 ) {
 		*results = clip.trace;
@@ -644,6 +998,95 @@ void SV_Trace( trace_t *results, const vec3_t start, vec3_t mins, vec3_t maxs, c
 	*results = clip.trace;
 }
 
+/*
+==================
+SV_Trace
+
+Moves the given mins/maxs volume through the world from start to end.
+passEntityNum and entities owned by passEntityNum are explicitly not checked.
+==================
+*/
+void SV_Trace( trace_t *results, const vec3_t start, vec3_t mins, vec3_t maxs, const vec3_t end, int passEntityNum, int contentmask, int capsule ) {
+	if ( !mins ) {
+		mins = vec3_origin;
+	}
+	if ( !maxs ) {
+		maxs = vec3_origin;
+	}
+
+	if ( traceRecordFile && !traceRecordNest ) {
+		if ( passEntityNum >= 0 && passEntityNum < ENTITYNUM_NONE ) {
+			SV_RecordSync( passEntityNum );	// its owner is checked
+		}
+		traceRecordNest++;
+		SV_Trace( results, start, mins, maxs, end, passEntityNum, contentmask, capsule );
+		traceRecordNest--;
+		SV_RecordTrace( results, start, mins, maxs, end, passEntityNum, contentmask, capsule );
+		return;
+	}
+
+	SV_TraceContext( 0, results, start, mins, maxs, end, passEntityNum, contentmask, capsule );
+}
+
+/*
+==================
+SV_TraceBatch
+
+Runs a number of independent traces for a single G_TRACE_BATCH system call,
+so the cost of crossing the VM boundary is paid only once. With sv_traceThreads
+set the traces are split across worker threads, each tracing through a
+collision model context of its own; the entities can't move during the call.
+==================
+*/
+#define	TRACES_PER_JOB	8
+
+typedef struct {
+	trace_t					*results;
+	const traceRequest_t	*requests;
+	int						numRequests;
+} traceBatch_t;
+
+static void SV_TraceBatchJob( void *data, int job, int worker ) {
+	traceBatch_t			*batch = data;
+	const traceRequest_t	*req;
+	int						i, end;
+
+	i = job * TRACES_PER_JOB;
+	end = i + TRACES_PER_JOB;
+	if ( end > batch->numRequests ) {
+		end = batch->numRequests;
+	}
+
+	for ( req = batch->requests + i ; i < end ; i++, req++ ) {
+		SV_TraceContext( worker, &batch->results[i], req->start, (float *)req->mins, (float *)req->maxs,
+			req->end, req->passEntityNum, req->contentmask, req->capsule );
+	}
+}
+
+void SV_TraceBatch( trace_t *results, const traceRequest_t *requests, int numRequests ) {
+	int						i;
+	const traceRequest_t	*req;
+	traceBatch_t			batch;
+
+	if ( sv_traceThreads->modified ) {
+		sv_traceThreads->modified = qfalse;
+		Sys_StartWorkers( sv_traceThreads->integer );
+	}
+
+	// a capture has to see the traces in order
+	if ( !sv_traceThreads->integer || traceRecordFile || numRequests <= TRACES_PER_JOB ) {
+		for ( i = 0, req = requests ; i < numRequests ; i++, req++ ) {
+			SV_Trace( &results[i], req->start, (float *)req->mins, (float *)req->maxs, req->end,
+				req->passEntityNum, req->contentmask, req->capsule );
+		}
+		return;
+	}
+
+	batch.results = results;
+	batch.requests = requests;
+	batch.numRequests = numRequests;
+	Sys_RunJobs( SV_TraceBatchJob, &batch, ( numRequests + TRACES_PER_JOB - 1 ) / TRACES_PER_JOB );
+}
 
 
 /*
@@ -659,6 +1102,14 @@ int SV_PointContents( const vec3_t p, int passEntityNum ) {
 	clipHandle_t	clipHandle;
 	float		*angles;
 
+	if ( traceRecordFile && !traceRecordNest ) {
+		traceRecordNest++;
+		contents = SV_PointContents( p, passEntityNum );
+		traceRecordNest--;
+		SV_RecordPointContents( p, passEntityNum, contents );
+		return contents;
+	}
+
 	// get base contents from world
 	contents = CM_PointContents( p, 0 );
 
@@ -686,3 +1137,590 @@ int SV_PointContents( const vec3_t p, int passEntityNum ) {
 }
 
 
+/*
+===============================================================================
+
+TRACE CAPTURE
+
+tracerecord logs every SV_Trace, SV_PointContents and SV_AreaEntities call
+together with the entity state they depend on, so the same collision
+workload can be run again with tracereplay on the same map.
+
+Entities are written when they are linked or unlinked.  The game also
+changes contents and owners without relinking, so the entities a query
+looks at are compared against what was last written and rewritten if
+they differ, and so are the moves SV_UpdateSectorLists makes between the
+sector chains.  Queries made from inside another query are not written,
+replaying the outer one repeats them.
+
+===============================================================================
+*/
+
+#define	TRACE_CAPTURE_IDENT		(('P'<<24)+('C'<<16)+('R'<<8)+'T')
+#define	TRACE_CAPTURE_VERSION	2
+
+typedef enum {
+	TR_LINK,
+	TR_UNLINK,
+	TR_STATE,			// changed without being relinked
+	TR_TRACE,
+	TR_POINTCONTENTS,
+	TR_AREAENTITIES,
+	TR_SECTORLIST		// moved to the chain of its new contents
+} traceRecordType_t;
+
+// the parts of a sharedEntity_t the world queries read
+typedef struct {
+	int			number;
+	int			capsule;
+	int			bmodel;
+	int			modelindex;
+	int			contents;
+	int			ownerNum;
+	vec3_t		mins, maxs;
+	vec3_t		absmin, absmax;
+	vec3_t		currentOrigin, currentAngles;
+} traceEntity_t;
+
+typedef struct {
+	vec3_t		start, mins, maxs, end;
+	int			passEntityNum;
+	int			contentmask;
+	int			capsule;
+	trace_t		results;
+} traceQuery_t;
+
+typedef struct {
+	vec3_t		p;
+	int			passEntityNum;
+	int			contents;
+} contentsQuery_t;
+
+typedef struct {
+	vec3_t		mins, maxs;
+	int			maxcount;
+	int			count;		// followed by count entity numbers
+} areaQuery_t;
+
+static traceEntity_t	*traceRecordEntities;	// as last written
+
+static void SV_GetTraceEntity( const sharedEntity_t *gEnt, traceEntity_t *te ) {
+	Com_Memset( te, 0, sizeof( *te ) );
+	te->number = gEnt->s.number;
+	te->capsule = ( gEnt->r.svFlags & SVF_CAPSULE ) != 0;
+	te->bmodel = gEnt->r.bmodel;
+	te->modelindex = gEnt->s.modelindex;
+	te->contents = gEnt->r.contents;
+	te->ownerNum = gEnt->r.ownerNum;
+	VectorCopy( gEnt->r.mins, te->mins );
+	VectorCopy( gEnt->r.maxs, te->maxs );
+	VectorCopy( gEnt->r.absmin, te->absmin );
+	VectorCopy( gEnt->r.absmax, te->absmax );
+	VectorCopy( gEnt->r.currentOrigin, te->currentOrigin );
+	VectorCopy( gEnt->r.currentAngles, te->currentAngles );
+}
+
+static void SV_SetTraceEntity( sharedEntity_t *gEnt, const traceEntity_t *te ) {
+	if ( te->capsule ) {
+		gEnt->r.svFlags |= SVF_CAPSULE;
+	} else {
+		gEnt->r.svFlags &= ~SVF_CAPSULE;
+	}
+	gEnt->r.bmodel = te->bmodel;
+	gEnt->s.modelindex = te->modelindex;
+	gEnt->r.contents = te->contents;
+	gEnt->r.ownerNum = te->ownerNum;
+	VectorCopy( te->mins, gEnt->r.mins );
+	VectorCopy( te->maxs, gEnt->r.maxs );
+	VectorCopy( te->absmin, gEnt->r.absmin );
+	VectorCopy( te->absmax, gEnt->r.absmax );
+	VectorCopy( te->currentOrigin, gEnt->r.currentOrigin );
+	VectorCopy( te->currentAngles, gEnt->r.currentAngles );
+}
+
+static void SV_RecordType( traceRecordType_t type ) {
+	byte	b;
+
+	b = type;
+	FS_Write( &b, 1, traceRecordFile );
+}
+
+static void SV_RecordEntity( traceRecordType_t type, const sharedEntity_t *gEnt ) {
+	traceEntity_t	*te;
+
+	te = &traceRecordEntities[gEnt->s.number];
+	SV_GetTraceEntity( gEnt, te );
+
+	SV_RecordType( type );
+	FS_Write( te, sizeof( *te ), traceRecordFile );
+}
+
+static void SV_RecordLink( const sharedEntity_t *gEnt ) {
+	SV_RecordEntity( TR_LINK, gEnt );
+}
+
+static void SV_RecordUnlink( const sharedEntity_t *gEnt ) {
+	int		number;
+
+	number = gEnt->s.number;
+	SV_RecordType( TR_UNLINK );
+	FS_Write( &number, sizeof( number ), traceRecordFile );
+}
+
+/*
+=================
+SV_RecordSync
+
+Writes an entity again if the game changed it since it was last written
+=================
+*/
+static void SV_RecordSync( int entityNum ) {
+	sharedEntity_t	*gEnt;
+	traceEntity_t	te;
+
+	gEnt = SV_GentityNum( entityNum );
+	SV_GetTraceEntity( gEnt, &te );
+	if ( !memcmp( &te, &traceRecordEntities[entityNum], sizeof( te ) ) ) {
+		return;
+	}
+
+	SV_RecordEntity( TR_STATE, gEnt );
+}
+
+static void SV_RecordSectorList( const sharedEntity_t *gEnt ) {
+	SV_RecordEntity( TR_SECTORLIST, gEnt );
+}
+
+static void SV_RecordTrace( const trace_t *results, const vec3_t start, const vec3_t mins, const vec3_t maxs, const vec3_t end, int passEntityNum, int contentmask, int capsule ) {
+	traceQuery_t	q;
+
+	Com_Memset( &q, 0, sizeof( q ) );
+	VectorCopy( start, q.start );
+	VectorCopy( mins, q.mins );
+	VectorCopy( maxs, q.maxs );
+	VectorCopy( end, q.end );
+	q.passEntityNum = passEntityNum;
+	q.contentmask = contentmask;
+	q.capsule = capsule;
+	q.results = *results;
+
+	SV_RecordType( TR_TRACE );
+	FS_Write( &q, sizeof( q ), traceRecordFile );
+}
+
+static void SV_RecordPointContents( const vec3_t p, int passEntityNum, int contents ) {
+	contentsQuery_t	q;
+
+	VectorCopy( p, q.p );
+	q.passEntityNum = passEntityNum;
+	q.contents = contents;
+
+	SV_RecordType( TR_POINTCONTENTS );
+	FS_Write( &q, sizeof( q ), traceRecordFile );
+}
+
+static void SV_RecordAreaEntities( const vec3_t mins, const vec3_t maxs, const int *entityList, int maxcount, int count ) {
+	areaQuery_t		q;
+
+	VectorCopy( mins, q.mins );
+	VectorCopy( maxs, q.maxs );
+	q.maxcount = maxcount;
+	q.count = count;
+
+	SV_RecordType( TR_AREAENTITIES );
+	FS_Write( &q, sizeof( q ), traceRecordFile );
+	FS_Write( entityList, count * sizeof( int ), traceRecordFile );
+}
+
+/*
+=================
+SV_TraceStopRecord
+=================
+*/
+void SV_TraceStopRecord( void ) {
+	if ( !traceRecordFile ) {
+		return;
+	}
+
+	FS_FCloseFile( traceRecordFile );
+	traceRecordFile = 0;
+
+	Z_Free( traceRecordEntities );
+	traceRecordEntities = NULL;
+
+	Com_Printf( "Stopped trace capture.\n" );
+}
+
+/*
+=================
+SV_TraceRecord_f
+
+tracerecord <filename>
+=================
+*/
+void SV_TraceRecord_f( void ) {
+	svEntity_t		*list[MAX_GENTITIES];
+	svEntity_t		*ent;
+	int				i, j, count;
+	int				header[2];
+	char			mapname[MAX_QPATH];
+	int				checksum;
+
+	if ( Cmd_Argc() != 2 ) {
+		Com_Printf( "usage: tracerecord <filename>\n" );
+		return;
+	}
+
+	if ( sv.state != SS_GAME ) {
+		Com_Printf( "Server is not running.\n" );
+		return;
+	}
+
+	if ( traceRecordFile ) {
+		Com_Printf( "Already capturing traces.\n" );
+		return;
+	}
+
+	// the chains have to match the contents written below
+	SV_UpdateSectorLists();
+
+	traceRecordFile = FS_FOpenFileWrite( Cmd_Argv( 1 ) );
+	if ( !traceRecordFile ) {
+		Com_Printf( "Couldn't open %s for writing.\n", Cmd_Argv( 1 ) );
+		return;
+	}
+
+	traceRecordEntities = Z_Malloc( MAX_GENTITIES * sizeof( traceEntity_t ) );
+
+	header[0] = TRACE_CAPTURE_IDENT;
+	header[1] = TRACE_CAPTURE_VERSION;
+	FS_Write( header, sizeof( header ), traceRecordFile );
+	Com_Memset( mapname, 0, sizeof( mapname ) );
+	Q_strncpyz( mapname, sv_mapname->string, sizeof( mapname ) );
+	FS_Write( mapname, sizeof( mapname ), traceRecordFile );
+	checksum = sv_mapChecksum->integer;
+	FS_Write( &checksum, sizeof( checksum ), traceRecordFile );
+
+	// write what is already linked so that replaying rebuilds
+	// every sector list in the same order
+	for ( i = 0 ; i < sv_numworldSectors ; i++ ) {
+		for ( j = 0 ; j < NUM_SECTOR_LISTS ; j++ ) {
+			count = 0;
+			for ( ent = sv_worldSectors[i].entities[j] ; ent ; ent = ent->nextEntityInWorldSector ) {
+				list[count++] = ent;
+			}
+			while ( count-- ) {
+				SV_RecordLink( SV_GEntityForSvEntity( list[count] ) );
+			}
+		}
+	}
+
+	Com_Printf( "Capturing traces on %s to %s.\n", mapname, Cmd_Argv( 1 ) );
+}
+
+/*
+=================
+SV_TraceStopRecord_f
+=================
+*/
+void SV_TraceStopRecord_f( void ) {
+	if ( !traceRecordFile ) {
+		Com_Printf( "Not capturing traces.\n" );
+		return;
+	}
+
+	SV_TraceStopRecord();
+}
+
+
+/*
+===============================================================================
+
+TRACE REPLAY
+
+tracereplay runs a capture against the loaded map with its own set of
+entities and compares every result.  The live world is put back afterwards,
+so it can be used on a running server.
+
+===============================================================================
+*/
+
+#define	REPLAY_BUFFER_SIZE	0x10000
+#define	REPLAY_MAX_REPORTS	8
+
+typedef struct {
+	fileHandle_t	f;
+	int				remaining;		// bytes not yet read from the file
+	byte			buffer[REPLAY_BUFFER_SIZE];
+	int				pos, size;
+	int				ioMsec;
+} traceReader_t;
+
+static qboolean SV_ReplayRead( traceReader_t *r, void *data, int len ) {
+	int		start, n;
+
+	if ( r->pos + len > r->size ) {
+		if ( len > REPLAY_BUFFER_SIZE ) {
+			return qfalse;
+		}
+		memmove( r->buffer, r->buffer + r->pos, r->size - r->pos );
+		r->size -= r->pos;
+		r->pos = 0;
+
+		n = REPLAY_BUFFER_SIZE - r->size;
+		if ( n > r->remaining ) {
+			n = r->remaining;
+		}
+		start = Sys_Milliseconds();
+		FS_Read( r->buffer + r->size, n, r->f );
+		r->ioMsec += Sys_Milliseconds() - start;
+		r->size += n;
+		r->remaining -= n;
+
+		if ( len > r->size ) {
+			return qfalse;
+		}
+	}
+
+	Com_Memcpy( data, r->buffer + r->pos, len );
+	r->pos += len;
+	return qtrue;
+}
+
+/*
+=================
+SV_TracesEqual
+
+The plane is left undefined by allsolid traces
+=================
+*/
+static qboolean SV_TracesEqual( const trace_t *a, const trace_t *b ) {
+	if ( a->allsolid != b->allsolid || a->startsolid != b->startsolid
+		|| a->fraction != b->fraction || !VectorCompare( a->endpos, b->endpos )
+		|| a->surfaceFlags != b->surfaceFlags || a->contents != b->contents
+		|| a->entityNum != b->entityNum ) {
+		return qfalse;
+	}
+	if ( a->fraction < 1.0 && !a->allsolid ) {
+		if ( !VectorCompare( a->plane.normal, b->plane.normal ) || a->plane.dist != b->plane.dist ) {
+			return qfalse;
+		}
+	}
+	return qtrue;
+}
+
+static int SV_CompareEntityNums( const void *a, const void *b ) {
+	return *(const int *)a - *(const int *)b;
+}
+
+/*
+=================
+SV_TraceReplay_f
+
+tracereplay <filename>
+=================
+*/
+void SV_TraceReplay_f( void ) {
+	traceReader_t		*r;
+	svEntity_t			*savedEntities;
+	worldSector_t		*savedSectors;
+	int					savedNumSectors;
+	sharedEntity_t		*savedGentities;
+	int					savedGentitySize, savedNumEntities;
+	sharedEntity_t		*entities;
+	int					*list;
+	int					header[2];
+	char				mapname[MAX_QPATH];
+	int					checksum;
+	byte				type;
+	traceEntity_t		te;
+	traceQuery_t		tq;
+	trace_t				trace;
+	contentsQuery_t		cq;
+	areaQuery_t			aq;
+	int					number, count;
+	int					numRecords, numQueries, numMismatches;
+	int					start, msec;
+	qboolean			mismatch;
+
+	if ( Cmd_Argc() != 2 ) {
+		Com_Printf( "usage: tracereplay <filename>\n" );
+		return;
+	}
+
+	if ( sv.state != SS_GAME ) {
+		Com_Printf( "Server is not running.\n" );
+		return;
+	}
+
+	if ( traceRecordFile ) {
+		Com_Printf( "Can't replay while capturing traces.\n" );
+		return;
+	}
+
+	r = Z_Malloc( sizeof( *r ) );
+	r->remaining = FS_FOpenFileRead( Cmd_Argv( 1 ), &r->f, qtrue );
+	if ( !r->f ) {
+		Com_Printf( "Couldn't open %s.\n", Cmd_Argv( 1 ) );
+		Z_Free( r );
+		return;
+	}
+
+	if ( !SV_ReplayRead( r, header, sizeof( header ) ) || !SV_ReplayRead( r, mapname, sizeof( mapname ) )
+		|| !SV_ReplayRead( r, &checksum, sizeof( checksum ) )
+		|| header[0] != TRACE_CAPTURE_IDENT || header[1] != TRACE_CAPTURE_VERSION ) {
+		Com_Printf( "%s is not a version %i trace capture.\n", Cmd_Argv( 1 ), TRACE_CAPTURE_VERSION );
+		FS_FCloseFile( r->f );
+		Z_Free( r );
+		return;
+	}
+	mapname[sizeof( mapname ) - 1] = 0;
+
+	if ( Q_stricmp( mapname, sv_mapname->string ) || checksum != sv_mapChecksum->integer ) {
+		Com_Printf( "%s was captured on %s, not on the loaded map.\n", Cmd_Argv( 1 ), mapname );
+		FS_FCloseFile( r->f );
+		Z_Free( r );
+		return;
+	}
+
+	// set the live world aside
+	savedEntities = Z_Malloc( sizeof( sv.svEntities ) );
+	Com_Memcpy( savedEntities, sv.svEntities, sizeof( sv.svEntities ) );
+	savedSectors = Z_Malloc( sizeof( sv_worldSectors ) );
+	Com_Memcpy( savedSectors, sv_worldSectors, sizeof( sv_worldSectors ) );
+	savedNumSectors = sv_numworldSectors;
+	savedGentities = sv.gentities;
+	savedGentitySize = sv.gentitySize;
+	savedNumEntities = sv.num_entities;
+
+	entities = Z_Malloc( MAX_GENTITIES * sizeof( sharedEntity_t ) );
+	for ( number = 0 ; number < MAX_GENTITIES ; number++ ) {
+		entities[number].s.number = number;
+		sv.svEntities[number].worldSector = NULL;
+	}
+	sv.gentities = entities;
+	sv.gentitySize = sizeof( sharedEntity_t );
+	sv.num_entities = MAX_GENTITIES;
+	SV_ClearWorld();
+
+	list = Z_Malloc( 2 * MAX_GENTITIES * sizeof( int ) );	// results, then the capture
+
+	numRecords = numQueries = numMismatches = 0;
+	start = Sys_Milliseconds();
+
+	while ( SV_ReplayRead( r, &type, 1 ) ) {
+		numRecords++;
+		mismatch = qfalse;
+
+		switch ( type ) {
+		case TR_LINK:
+		case TR_STATE:
+		case TR_SECTORLIST:
+			if ( !SV_ReplayRead( r, &te, sizeof( te ) ) ) {
+				goto truncated;
+			}
+			if ( te.number < 0 || te.number >= MAX_GENTITIES ) {
+				goto corrupt;
+			}
+			SV_SetTraceEntity( &entities[te.number], &te );
+			if ( type == TR_LINK ) {
+				SV_LinkEntity( &entities[te.number] );
+				// entities written when the capture started may have
+				// changed since they were linked
+				VectorCopy( te.absmin, entities[te.number].r.absmin );
+				VectorCopy( te.absmax, entities[te.number].r.absmax );
+			} else if ( type == TR_SECTORLIST ) {
+				SV_UpdateSectorList( SV_SvEntityForGentity( &entities[te.number] ), &entities[te.number] );
+			}
+			break;
+
+		case TR_UNLINK:
+			if ( !SV_ReplayRead( r, &number, sizeof( number ) ) ) {
+				goto truncated;
+			}
+			if ( number < 0 || number >= MAX_GENTITIES ) {
+				goto corrupt;
+			}
+			SV_UnlinkEntity( &entities[number] );
+			break;
+
+		case TR_TRACE:
+			if ( !SV_ReplayRead( r, &tq, sizeof( tq ) ) ) {
+				goto truncated;
+			}
+			numQueries++;
+			SV_Trace( &trace, tq.start, tq.mins, tq.maxs, tq.end, tq.passEntityNum, tq.contentmask, tq.capsule );
+			mismatch = !SV_TracesEqual( &trace, &tq.results );
+			break;
+
+		case TR_POINTCONTENTS:
+			if ( !SV_ReplayRead( r, &cq, sizeof( cq ) ) ) {
+				goto truncated;
+			}
+			numQueries++;
+			mismatch = SV_PointContents( cq.p, cq.passEntityNum ) != cq.contents;
+			break;
+
+		case TR_AREAENTITIES:
+			if ( !SV_ReplayRead( r, &aq, sizeof( aq ) ) ) {
+				goto truncated;
+			}
+			if ( aq.count < 0 || aq.count > MAX_GENTITIES || aq.maxcount < aq.count || aq.maxcount > MAX_GENTITIES ) {
+				goto corrupt;
+			}
+			if ( !SV_ReplayRead( r, list + MAX_GENTITIES, aq.count * sizeof( int ) ) ) {
+				goto truncated;
+			}
+			numQueries++;
+			count = SV_AreaEntities( aq.mins, aq.maxs, list, aq.maxcount );
+			mismatch = count != aq.count;
+			if ( !mismatch ) {
+				// the order depends on how the sectors were split, which
+				// depends on everything linked before the capture started
+				qsort( list, count, sizeof( int ), SV_CompareEntityNums );
+				qsort( list + MAX_GENTITIES, count, sizeof( int ), SV_CompareEntityNums );
+				mismatch = memcmp( list, list + MAX_GENTITIES, count * sizeof( int ) ) != 0;
+			}
+			break;
+
+		default:
+			goto corrupt;
+		}
+
+		if ( mismatch ) {
+			if ( numMismatches < REPLAY_MAX_REPORTS ) {
+				Com_Printf( "record %i: result differs from the capture\n", numRecords );
+			}
+			numMismatches++;
+		}
+	}
+	goto done;
+
+corrupt:
+	Com_Printf( "record %i: bad record type or entity, stopping.\n", numRecords );
+	goto done;
+
+truncated:
+	Com_Printf( "record %i: capture is truncated.\n", numRecords );
+
+done:
+	msec = Sys_Milliseconds() - start - r->ioMsec;
+
+	Com_Printf( "%i records, %i queries, %i mismatches, %i msec\n",
+		numRecords, numQueries, numMismatches, msec );
+
+	// put the live world back
+	Com_Memcpy( sv.svEntities, savedEntities, sizeof( sv.svEntities ) );
+	Com_Memcpy( sv_worldSectors, savedSectors, sizeof( sv_worldSectors ) );
+	sv_numworldSectors = savedNumSectors;
+	sv.gentities = savedGentities;
+	sv.gentitySize = savedGentitySize;
+	sv.num_entities = savedNumEntities;
+
+	FS_FCloseFile( r->f );
+	Z_Free( list );
+	Z_Free( entities );
+	Z_Free( savedSectors );
+	Z_Free( savedEntities );
+	Z_Free( r );
+}
@@ -38,6 +38,7 @@ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
 #include <fcntl.h>
 #include <fenv.h>
 #include <sys/wait.h>
+#include <pthread.h>
 
 qboolean stdinIsATTY;
 
@@ -483,6 +484,158 @@ void Sys_Sleep( int msec )
 	}
 }
 
+/*
+==============================================================
+
+WORKER THREADS
+
+==============================================================
+*/
+
+static pthread_t		workerThreads[MAX_WORKER_THREADS];
+static int				numWorkerThreads;
+static pthread_mutex_t	workerMutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t	workerStart = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t	workerDone = PTHREAD_COND_INITIALIZER;
+
+// all protected by workerMutex
+static sysJob_t			jobFunc;
+static void				*jobData;
+static int				numJobs;
+static int				nextJob;
+static int				jobsDone;
+static int				jobGeneration;
+static qboolean			workersQuit;
+
+/*
+==================
+Sys_DoJobs
+
+Runs jobs until there are none left, called with workerMutex locked
+==================
+*/
+static void Sys_DoJobs( int worker )
+{
+	int		job;
+
+	while( nextJob < numJobs )
+	{
+		job = nextJob++;
+		pthread_mutex_unlock( &workerMutex );
+		jobFunc( jobData, job, worker );
+		pthread_mutex_lock( &workerMutex );
+		if( ++jobsDone == numJobs )
+			pthread_cond_signal( &workerDone );
+	}
+}
+
+/*
+==================
+Sys_WorkerThread
+==================
+*/
+static void *Sys_WorkerThread( void *arg )
+{
+	int		worker = (intptr_t)arg;
+	int		generation;
+
+	pthread_mutex_lock( &workerMutex );
+	generation = jobGeneration;
+	while( 1 )
+	{
+		while( !workersQuit && generation == jobGeneration )
+			pthread_cond_wait( &workerStart, &workerMutex );
+
+		if( workersQuit )
+			break;
+
+		generation = jobGeneration;
+		Sys_DoJobs( worker );
+	}
+	pthread_mutex_unlock( &workerMutex );
+
+	return NULL;
+}
+
+/*
+==================
+Sys_StartWorkers
+
+Stops the running worker threads and starts count new ones
+==================
+*/
+int Sys_StartWorkers( int count )
+{
+	int		i;
+
+	if( count == numWorkerThreads )
+		return numWorkerThreads;
+
+	if( numWorkerThreads )
+	{
+		pthread_mutex_lock( &workerMutex );
+		workersQuit = qtrue;
+		pthread_cond_broadcast( &workerStart );
+		pthread_mutex_unlock( &workerMutex );
+
+		for( i = 0; i < numWorkerThreads; i++ )
+			pthread_join( workerThreads[i], NULL );
+
+		numWorkerThreads = 0;
+		workersQuit = qfalse;
+	}
+
+	if( count > MAX_WORKER_THREADS )
+		count = MAX_WORKER_THREADS;
+
+	pthread_mutex_lock( &workerMutex );
+	for( i = 0; i < count; i++ )
+	{
+		if( pthread_create( &workerThreads[i], NULL, Sys_WorkerThread,
+			(void *)(intptr_t)( i + 1 ) ) )
+		{
+			Com_Printf( "WARNING: could only start %d worker threads\n", i );
+			break;
+		}
+		numWorkerThreads++;
+	}
+	pthread_mutex_unlock( &workerMutex );
+
+	return numWorkerThreads;
+}
+
+/*
+==================
+Sys_RunJobs
+==================
+*/
+void Sys_RunJobs( sysJob_t func, void *data, int count )
+{
+	int		i;
+
+	if( !numWorkerThreads || count < 2 )
+	{
+		for( i = 0; i < count; i++ )
+			func( data, i, 0 );
+		return;
+	}
+
+	pthread_mutex_lock( &workerMutex );
+	jobFunc = func;
+	jobData = data;
+	numJobs = count;
+	nextJob = 0;
+	jobsDone = 0;
+	jobGeneration++;
+	pthread_cond_broadcast( &workerStart );
+
+	Sys_DoJobs( 0 );
+
+	while( jobsDone < numJobs )
+		pthread_cond_wait( &workerDone, &workerMutex );
+	pthread_mutex_unlock( &workerMutex );
+}
+
 /*
 ==============
 Sys_ErrorDialog
@@ -562,6 +562,172 @@ void Sys_Sleep( int msec )
 #endif
 }
 
+/*
+==============================================================
+
+WORKER THREADS
+
+==============================================================
+*/
+
+static HANDLE			workerThreads[MAX_WORKER_THREADS];
+static int				numWorkerThreads;
+static CRITICAL_SECTION	workerLock;
+static HANDLE			workerStart;	// semaphore, one count per worker per batch
+static HANDLE			workerDone;		// auto reset event
+
+// all protected by workerLock
+static sysJob_t			jobFunc;
+static void				*jobData;
+static int				numJobs;
+static int				nextJob;
+static int				jobsDone;
+static qboolean			workersQuit;
+
+/*
+==================
+Sys_DoJobs
+
+Runs jobs until there are none left, called inside workerLock
+==================
+*/
+static void Sys_DoJobs( int worker )
+{
+	int		job;
+
+	while( nextJob < numJobs )
+	{
+		job = nextJob++;
+		LeaveCriticalSection( &workerLock );
+		jobFunc( jobData, job, worker );
+		EnterCriticalSection( &workerLock );
+		if( ++jobsDone == numJobs )
+			SetEvent( workerDone );
+	}
+}
+
+/*
+==================
+Sys_WorkerThread
+==================
+*/
+static DWORD WINAPI Sys_WorkerThread( LPVOID arg )
+{
+	int		worker = (intptr_t)arg;
+
+	while( 1 )
+	{
+		WaitForSingleObject( workerStart, INFINITE );
+
+		EnterCriticalSection( &workerLock );
+		if( workersQuit )
+		{
+			LeaveCriticalSection( &workerLock );
+			break;
+		}
+
+		// a worker that wakes up late finds no jobs left
+		Sys_DoJobs( worker );
+		LeaveCriticalSection( &workerLock );
+	}
+
+	return 0;
+}
+
+/*
+==================
+Sys_StartWorkers
+
+Stops the running worker threads and starts count new ones
+==================
+*/
+int Sys_StartWorkers( int count )
+{
+	int		i;
+
+	if( count == numWorkerThreads )
+		return numWorkerThreads;
+
+	if( !workerStart )
+	{
+		InitializeCriticalSection( &workerLock );
+		workerStart = CreateSemaphore( NULL, 0, 0x7fffffff, NULL );
+		workerDone = CreateEvent( NULL, FALSE, FALSE, NULL );
+	}
+
+	if( numWorkerThreads )
+	{
+		EnterCriticalSection( &workerLock );
+		workersQuit = qtrue;
+		LeaveCriticalSection( &workerLock );
+		ReleaseSemaphore( workerStart, numWorkerThreads, NULL );
+
+		WaitForMultipleObjects( numWorkerThreads, workerThreads, TRUE, INFINITE );
+		for( i = 0; i < numWorkerThreads; i++ )
+			CloseHandle( workerThreads[i] );
+
+		// drop wakeups nobody took
+		while( WaitForSingleObject( workerStart, 0 ) == WAIT_OBJECT_0 )
+			;
+
+		numWorkerThreads = 0;
+		workersQuit = qfalse;
+	}
+
+	if( count > MAX_WORKER_THREADS )
+		count = MAX_WORKER_THREADS;
+
+	for( i = 0; i < count; i++ )
+	{
+		workerThreads[i] = CreateThread( NULL, 0, Sys_WorkerThread,
+			(LPVOID)(intptr_t)( i + 1 ), 0, NULL );
+		if( !workerThreads[i] )
+		{
+			Com_Printf( "WARNING: could only start %d worker threads\n", i );
+			break;
+		}
+		numWorkerThreads++;
+	}
+
+	return numWorkerThreads;
+}
+
+/*
+==================
+Sys_RunJobs
+==================
+*/
+void Sys_RunJobs( sysJob_t func, void *data, int count )
+{
+	int		i;
+
+	if( !numWorkerThreads || count < 2 )
+	{
+		for( i = 0; i < count; i++ )
+			func( data, i, 0 );
+		return;
+	}
+
+	EnterCriticalSection( &workerLock );
+	jobFunc = func;
+	jobData = data;
+	numJobs = count;
+	nextJob = 0;
+	jobsDone = 0;
+	ResetEvent( workerDone );
+	LeaveCriticalSection( &workerLock );
+
+	ReleaseSemaphore( workerStart, numWorkerThreads, NULL );
+
+	EnterCriticalSection( &workerLock );
+	Sys_DoJobs( 0 );
+	i = ( jobsDone < numJobs );
+	LeaveCriticalSection( &workerLock );
+
+	if( i )
+		WaitForSingleObject( workerDone, INFINITE );
+}
+
 /*
 ==============
 Sys_ErrorDialog
@@ -0,0 +1,541 @@
+/*
+===========================================================================
+Copyright (C) 1999-2005 Id Software, Inc.
+
+This file is part of Quake III Arena source code.
+
+Quake III Arena source code is free software; you can redistribute it
+and/or modify it under the terms of the GNU General Public License as
+published by the Free Software Foundation; either version 2 of the License,
+or (at your option) any later version.
+
+Quake III Arena source code is distributed in the hope that it will be
+useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Quake III Arena source code; if not, write to the Free Software
+Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+===========================================================================
+*/
+// aasbench.c -- loads an aas file with the bot library and times area
+// queries one at a time against the batched versions, checking that both
+// give the same answers
+
+#include "../../qcommon/q_shared.h"
+#include "../../botlib/l_memory.h"
+#include "../../botlib/l_libvar.h"
+#include "../../botlib/aasfile.h"
+#include "../../botlib/botlib.h"
+#include "../../botlib/be_aas.h"
+#include "../../botlib/be_aas_funcs.h"
+#include "../../botlib/be_interface.h"
+#include "../../botlib/be_aas_def.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#ifdef _WIN32
+#include <windows.h>
+#endif
+
+// the same fan of short lines BotFuzzyPointReachabilityArea traces
+#define	FAN_TRACES			9
+#define	FAN_MAXAREAS		10
+
+#define	POINT_BATCH			64
+
+typedef enum {
+	BENCH_POINT,
+	BENCH_POINT_BATCH,
+	BENCH_TRACE,
+	BENCH_TRACE_BATCH,
+
+	BENCH_NUM_KINDS
+} benchKind_t;
+
+static const char *kindNames[BENCH_NUM_KINDS] = {
+	"point",
+	"pointbatch",
+	"trace",
+	"tracebatch"
+};
+
+typedef struct {
+	int			count;
+	int			hits;
+	double		total;		// usec
+	unsigned	checksum;
+} benchStats_t;
+
+static unsigned		seed = 1;
+static unsigned		randSeed;
+
+static FILE			*benchFiles[8];
+
+/*
+==============================================================================
+
+ENGINE STUBS
+
+just enough of the engine for the bot library to load an aas file
+
+==============================================================================
+*/
+
+void QDECL Com_Printf( const char *fmt, ... ) {
+	va_list		argptr;
+
+	va_start( argptr, fmt );
+	vprintf( fmt, argptr );
+	va_end( argptr );
+}
+
+void QDECL Com_Error( int level, const char *fmt, ... ) {
+	va_list		argptr;
+
+	printf( "ERROR: " );
+	va_start( argptr, fmt );
+	vprintf( fmt, argptr );
+	va_end( argptr );
+	printf( "\n" );
+	exit( 1 );
+}
+
+static __attribute__ ((format (printf, 2, 3))) void QDECL BotImport_Print( int type, char *fmt, ... ) {
+	va_list		argptr;
+
+	// only errors, loading the file is chatty
+	if ( type != PRT_ERROR && type != PRT_FATAL ) {
+		return;
+	}
+	va_start( argptr, fmt );
+	vprintf( fmt, argptr );
+	va_end( argptr );
+}
+
+static void *BotImport_GetMemory( int size ) {
+	void	*buf;
+
+	buf = malloc( size );
+	if ( !buf ) {
+		Com_Error( ERR_FATAL, "GetMemory: out of memory" );
+	}
+	return buf;
+}
+
+static void BotImport_FreeMemory( void *ptr ) {
+	free( ptr );
+}
+
+static int BotImport_AvailableMemory( void ) {
+	return 256 * 1024 * 1024;
+}
+
+static void *BotImport_HunkAlloc( int size ) {
+	void	*buf;
+
+	// only one aas file is ever loaded
+	buf = calloc( 1, size );
+	if ( !buf ) {
+		Com_Error( ERR_FATAL, "HunkAlloc: out of memory" );
+	}
+	return buf;
+}
+
+// file names are paths on disk
+static int BotImport_FS_FOpenFile( const char *qpath, fileHandle_t *f, fsMode_t mode ) {
+	FILE	*fp;
+	long	len;
+	int		i;
+
+	*f = 0;
+	for ( i = 1 ; i < ARRAY_LEN( benchFiles ) ; i++ ) {
+		if ( !benchFiles[i] ) {
+			break;
+		}
+	}
+	if ( i == ARRAY_LEN( benchFiles ) ) {
+		return -1;
+	}
+	fp = fopen( qpath, mode == FS_READ ? "rb" : "wb" );
+	if ( !fp ) {
+		return -1;
+	}
+	benchFiles[i] = fp;
+	*f = i;
+	if ( mode != FS_READ ) {
+		return 0;
+	}
+	fseek( fp, 0, SEEK_END );
+	len = ftell( fp );
+	fseek( fp, 0, SEEK_SET );
+	return len;
+}
+
+static int BotImport_FS_Read( void *buffer, int len, fileHandle_t f ) {
+	return fread( buffer, 1, len, benchFiles[f] );
+}
+
+static int BotImport_FS_Write( const void *buffer, int len, fileHandle_t f ) {
+	return fwrite( buffer, 1, len, benchFiles[f] );
+}
+
+static void BotImport_FS_FCloseFile( fileHandle_t f ) {
+	fclose( benchFiles[f] );
+	benchFiles[f] = NULL;
+}
+
+static int BotImport_FS_Seek( fileHandle_t f, long offset, int origin ) {
+	switch ( origin ) {
+	case FS_SEEK_CUR:
+		return fseek( benchFiles[f], offset, SEEK_CUR );
+	case FS_SEEK_END:
+		return fseek( benchFiles[f], offset, SEEK_END );
+	default:
+		return fseek( benchFiles[f], offset, SEEK_SET );
+	}
+}
+
+// be_aas_file.c
+void AAS_DData( unsigned char *data, int size );
+
+/*
+=================
+LoadAAS
+
+The aas file is checked against the checksum of its bsp, take it from the
+aas header itself since there is no bsp here
+=================
+*/
+static void LoadAAS( char *fileName ) {
+	aas_header_t	header;
+	FILE			*f;
+
+	f = fopen( fileName, "rb" );
+	if ( !f ) {
+		Com_Error( ERR_FATAL, "couldn't open %s", fileName );
+	}
+	if ( fread( &header, sizeof( header ), 1, f ) != 1 ) {
+		Com_Error( ERR_FATAL, "couldn't read %s", fileName );
+	}
+	fclose( f );
+	if ( LittleLong( header.version ) == AASVERSION ) {
+		AAS_DData( (unsigned char *)&header + 8, sizeof( header ) - 8 );
+	}
+	LibVarSet( "sv_mapChecksum", va( "%i", LittleLong( header.bspchecksum ) ) );
+
+	if ( AAS_LoadAASFile( fileName ) != BLERR_NOERROR ) {
+		Com_Error( ERR_FATAL, "couldn't load %s", fileName );
+	}
+}
+
+/*
+==============================================================================
+
+WORKLOAD
+
+==============================================================================
+*/
+
+static double Microseconds( void ) {
+#ifdef _WIN32
+	static LARGE_INTEGER	freq;
+	LARGE_INTEGER			now;
+
+	if ( !freq.QuadPart ) {
+		QueryPerformanceFrequency( &freq );
+	}
+	QueryPerformanceCounter( &now );
+	return (double)now.QuadPart * 1000000.0 / freq.QuadPart;
+#else
+	struct timespec	now;
+
+	clock_gettime( CLOCK_MONOTONIC, &now );
+	return now.tv_sec * 1000000.0 + now.tv_nsec / 1000.0;
+#endif
+}
+
+// the workload must not depend on the c library's rand()
+static float Random( void ) {
+	randSeed = randSeed * 1664525 + 1013904223;
+	return ( randSeed >> 8 ) / (float)( 1 << 24 );
+}
+
+static float RandomRange( float min, float max ) {
+	return min + ( max - min ) * Random();
+}
+
+/*
+=================
+GeneratePoints
+
+The points come in blocks of POINT_BATCH, every other block is gathered
+around one area like the goals and bots in a room. In the other blocks half
+the points are near area centers and half are anywhere in the bounds of
+the areas.
+=================
+*/
+static vec3_t *GeneratePoints( int count ) {
+	vec3_t		*points;
+	vec3_t		mins, maxs;
+	aas_area_t	*area;
+	int			i, j;
+
+	points = calloc( count, sizeof( *points ) );
+	if ( !points ) {
+		Com_Error( ERR_FATAL, "out of memory" );
+	}
+
+	ClearBounds( mins, maxs );
+	for ( i = 1 ; i < aasworld.numareas ; i++ ) {
+		AddPointToBounds( aasworld.areas[i].mins, mins, maxs );
+		AddPointToBounds( aasworld.areas[i].maxs, mins, maxs );
+	}
+
+	randSeed = seed;
+	area = NULL;
+	for ( i = 0 ; i < count ; i++ ) {
+		if ( aasworld.numareas > 1 && ( ( i & 1 ) || ( i / POINT_BATCH ) & 1 ) ) {
+			if ( !( ( i / POINT_BATCH ) & 1 ) || !( i % POINT_BATCH ) ) {
+				area = &aasworld.areas[1 + (int)( Random() * ( aasworld.numareas - 1 ) ) % ( aasworld.numareas - 1 )];
+			}
+			for ( j = 0 ; j < 3 ; j++ ) {
+				points[i][j] = area->center[j] + RandomRange( -64, 64 );
+			}
+		} else {
+			for ( j = 0 ; j < 3 ; j++ ) {
+				points[i][j] = RandomRange( mins[j], maxs[j] );
+			}
+		}
+	}
+	return points;
+}
+
+static void FanEnds( const vec3_t origin, int z, vec3_t *ends ) {
+	int		x, y, i;
+
+	i = 0;
+	for ( x = 1 ; x >= -1 ; x-- ) {
+		for ( y = 1 ; y >= -1 ; y-- ) {
+			VectorCopy( origin, ends[i] );
+			ends[i][0] += x * 8;
+			ends[i][1] += y * 8;
+			ends[i][2] += z * 12;
+			i++;
+		}
+	}
+}
+
+/*
+==============================================================================
+
+BENCHMARK
+
+==============================================================================
+*/
+
+static unsigned ChecksumInts( unsigned checksum, const void *data, int count ) {
+	const int	*ints = data;
+	int			i;
+
+	// FNV-1a over whole ints
+	for ( i = 0 ; i < count ; i++ ) {
+		checksum ^= ints[i];
+		checksum *= 16777619;
+	}
+	return checksum;
+}
+
+static void RunPoints( vec3_t *points, int numPoints, int rounds, benchStats_t *stats ) {
+	int			areas[POINT_BATCH];
+	double		start;
+	int			i, j, n, r;
+
+	for ( r = 0 ; r < rounds ; r++ ) {
+		start = Microseconds();
+		for ( i = 0 ; i < numPoints ; i++ ) {
+			areas[0] = AAS_PointAreaNum( points[i] );
+			if ( r ) {
+				continue;
+			}
+			stats[BENCH_POINT].count++;
+			stats[BENCH_POINT].hits += areas[0] != 0;
+			stats[BENCH_POINT].checksum = ChecksumInts( stats[BENCH_POINT].checksum, areas, 1 );
+		}
+		stats[BENCH_POINT].total += Microseconds() - start;
+
+		start = Microseconds();
+		for ( i = 0 ; i < numPoints ; i += POINT_BATCH ) {
+			n = numPoints - i;
+			if ( n > POINT_BATCH ) {
+				n = POINT_BATCH;
+			}
+			AAS_PointAreaNums( &points[i], n, areas );
+			if ( r ) {
+				continue;
+			}
+			for ( j = 0 ; j < n ; j++ ) {
+				stats[BENCH_POINT_BATCH].count++;
+				stats[BENCH_POINT_BATCH].hits += areas[j] != 0;
+				stats[BENCH_POINT_BATCH].checksum = ChecksumInts( stats[BENCH_POINT_BATCH].checksum, &areas[j], 1 );
+			}
+		}
+		stats[BENCH_POINT_BATCH].total += Microseconds() - start;
+	}
+}
+
+// the entry points are left out, with -ffast-math the single and batched
+// traces may split a line in a different last bit
+static unsigned ChecksumAreas( unsigned checksum, int *areas, int numAreas ) {
+	checksum = ChecksumInts( checksum, &numAreas, 1 );
+	return ChecksumInts( checksum, areas, numAreas );
+}
+
+static void RunTraces( vec3_t *points, int numPoints, int rounds, benchStats_t *stats ) {
+	vec3_t		starts[FAN_TRACES], ends[FAN_TRACES];
+	int			areas[FAN_TRACES][FAN_MAXAREAS], numAreas[FAN_TRACES];
+	vec3_t		areaPoints[FAN_TRACES][FAN_MAXAREAS];
+	benchStats_t	*s;
+	double		start;
+	int			i, j, z, r;
+
+	for ( r = 0 ; r < rounds ; r++ ) {
+		s = &stats[BENCH_TRACE];
+		start = Microseconds();
+		for ( i = 0 ; i < numPoints ; i++ ) {
+			for ( z = 1 ; z >= -1 ; z-- ) {
+				FanEnds( points[i], z, ends );
+				for ( j = 0 ; j < FAN_TRACES ; j++ ) {
+					numAreas[j] = AAS_TraceAreas( points[i], ends[j], areas[j], areaPoints[j], FAN_MAXAREAS );
+					if ( r ) {
+						continue;
+					}
+					s->count++;
+					s->hits += numAreas[j] > 1;
+					s->checksum = ChecksumAreas( s->checksum, areas[j], numAreas[j] );
+				}
+			}
+		}
+		s->total += Microseconds() - start;
+
+		s = &stats[BENCH_TRACE_BATCH];
+		start = Microseconds();
+		for ( i = 0 ; i < numPoints ; i++ ) {
+			for ( j = 0 ; j < FAN_TRACES ; j++ ) {
+				VectorCopy( points[i], starts[j] );
+			}
+			for ( z = 1 ; z >= -1 ; z-- ) {
+				FanEnds( points[i], z, ends );
+				AAS_TraceAreasBatch( starts, ends, FAN_TRACES, areas[0], areaPoints[0], FAN_MAXAREAS, numAreas );
+				if ( r ) {
+					continue;
+				}
+				for ( j = 0 ; j < FAN_TRACES ; j++ ) {
+					s->count++;
+					s->hits += numAreas[j] > 1;
+					s->checksum = ChecksumAreas( s->checksum, areas[j], numAreas[j] );
+				}
+			}
+		}
+		s->total += Microseconds() - start;
+	}
+}
+
+static void PrintStats( benchStats_t *stats, int rounds ) {
+	benchStats_t	*s;
+	int				i;
+
+	printf( "  kind         count     hits    total ms   queries/sec  usec/query   checksum\n" );
+	for ( i = 0 ; i < BENCH_NUM_KINDS ; i++ ) {
+		s = &stats[i];
+		if ( !s->count ) {
+			continue;
+		}
+		printf( "  %-10s %7i  %7i %11.3f %13.0f %11.4f   %08x\n", kindNames[i], s->count, s->hits,
+			s->total / 1000.0, s->count * rounds / ( s->total / 1000000.0 ),
+			s->total / ( s->count * rounds ), s->checksum );
+	}
+}
+
+static void Usage( void ) {
+	printf( "usage: aasbench [options] <map.aas>\n"
+		"  -n <count>            number of query points (default 20000)\n"
+		"  -rounds <count>       run the workload this many times (default 5)\n"
+		"  -seed <seed>          workload random seed (default 1)\n" );
+	exit( 1 );
+}
+
+int main( int argc, char **argv ) {
+	botlib_import_t	import;
+	char			*aasName;
+	vec3_t			*points;
+	benchStats_t	stats[BENCH_NUM_KINDS];
+	double			start;
+	int				count, rounds;
+	int				i;
+
+	aasName = NULL;
+	count = 20000;
+	rounds = 5;
+
+	for ( i = 1 ; i < argc ; i++ ) {
+		if ( !strcmp( argv[i], "-n" ) && i + 1 < argc ) {
+			count = atoi( argv[++i] );
+		} else if ( !strcmp( argv[i], "-rounds" ) && i + 1 < argc ) {
+			rounds = atoi( argv[++i] );
+		} else if ( !strcmp( argv[i], "-seed" ) && i + 1 < argc ) {
+			seed = strtoul( argv[++i], NULL, 0 );
+		} else if ( argv[i][0] == '-' || aasName ) {
+			Usage();
+		} else {
+			aasName = argv[i];
+		}
+	}
+	if ( !aasName || count <= 0 || rounds <= 0 ) {
+		Usage();
+	}
+
+	Com_Memset( &import, 0, sizeof( import ) );
+	import.Print = BotImport_Print;
+	import.GetMemory = BotImport_GetMemory;
+	import.FreeMemory = BotImport_FreeMemory;
+	import.AvailableMemory = BotImport_AvailableMemory;
+	import.HunkAlloc = BotImport_HunkAlloc;
+	import.FS_FOpenFile = BotImport_FS_FOpenFile;
+	import.FS_Read = BotImport_FS_Read;
+	import.FS_Write = BotImport_FS_Write;
+	import.FS_FCloseFile = BotImport_FS_FCloseFile;
+	import.FS_Seek = BotImport_FS_Seek;
+	botimport = import;
+
+	start = Microseconds();
+	LoadAAS( aasName );
+	printf( "%s: loaded in %.1f ms, %i areas, %i nodes, %i planes\n", aasName,
+		( Microseconds() - start ) / 1000.0, aasworld.numareas, aasworld.numnodes, aasworld.numplanes );
+
+	points = GeneratePoints( count );
+
+	// warm the caches once
+	Com_Memset( stats, 0, sizeof( stats ) );
+	RunPoints( points, count, 1, stats );
+	RunTraces( points, count, 1, stats );
+
+	Com_Memset( stats, 0, sizeof( stats ) );
+	for ( i = 0 ; i < BENCH_NUM_KINDS ; i++ ) {
+		stats[i].checksum = 2166136261u;
+	}
+	RunPoints( points, count, rounds, stats );
+	RunTraces( points, count, rounds, stats );
+	printf( "%i points x %i rounds, seed %u\n", count, rounds, seed );
+	PrintStats( stats, rounds );
+
+	free( points );
+
+	if ( stats[BENCH_POINT].checksum != stats[BENCH_POINT_BATCH].checksum ||
+		stats[BENCH_TRACE].checksum != stats[BENCH_TRACE_BATCH].checksum ) {
+		printf( "batched queries gave different results\n" );
+		return 1;
+	}
+	return 0;
+}
@@ -0,0 +1,972 @@
+/*
+===========================================================================
+Copyright (C) 1999-2005 Id Software, Inc.
+
+This file is part of Quake III Arena source code.
+
+Quake III Arena source code is free software; you can redistribute it
+and/or modify it under the terms of the GNU General Public License as
+published by the Free Software Foundation; either version 2 of the License,
+or (at your option) any later version.
+
+Quake III Arena source code is distributed in the hope that it will be
+useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Quake III Arena source code; if not, write to the Free Software
+Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+===========================================================================
+*/
+// cmbench.c -- loads a bsp with the collision code of the engine and
+// times generated trace workloads against it, printing result checksums
+// so changes to cm_*.c can be checked for both speed and behaviour
+
+#include "../../qcommon/cm_local.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <pthread.h>
+#endif
+
+#define	MAX_BENCH_CVARS		16
+
+#define	BENCH_MASK_SOLID		(CONTENTS_SOLID|CONTENTS_PLAYERCLIP|CONTENTS_BODY)
+#define	BENCH_MASK_SHOT			(CONTENTS_SOLID|CONTENTS_BODY|CONTENTS_CORPSE)
+
+typedef enum {
+	BENCH_POINT,
+	BENCH_BOX,
+	BENCH_CAPSULE,
+	BENCH_POSITION,
+	BENCH_BMODEL,
+	BENCH_TEMPBOX,
+
+	BENCH_NUM_KINDS
+} benchKind_t;
+
+static const char *kindNames[BENCH_NUM_KINDS] = {
+	"point",
+	"box",
+	"capsule",
+	"position",
+	"bmodel",
+	"tempbox"
+};
+
+typedef struct {
+	benchKind_t	kind;
+	vec3_t		start, end;
+	vec3_t		mins, maxs;
+	clipHandle_t	model;
+	vec3_t		origin, angles;
+	vec3_t		boxMins, boxMaxs;	// BENCH_TEMPBOX
+	int			brushmask;
+} benchTrace_t;
+
+typedef struct {
+	int			count;
+	int			hits;
+	double		total;		// usec
+	unsigned	checksum;
+} benchStats_t;
+
+// a slice of the workload run on a trace context of its own
+typedef struct {
+	const benchTrace_t	*traces;
+	trace_t			*results;
+	int				numTraces;
+	int				rounds;
+	int				context;
+} benchThread_t;
+
+static struct {
+	char		name[MAX_CVAR_VALUE_STRING];
+	char		value[MAX_CVAR_VALUE_STRING];
+	cvar_t		cvar;
+} benchCvars[MAX_BENCH_CVARS];
+static int			numBenchCvars;
+
+static unsigned		seed = 1;
+static unsigned		randSeed;
+
+/*
+==============================================================================
+
+ENGINE STUBS
+
+just enough of qcommon for the collision code
+
+==============================================================================
+*/
+
+void QDECL Com_Printf( const char *fmt, ... ) {
+	va_list		argptr;
+
+	va_start( argptr, fmt );
+	vprintf( fmt, argptr );
+	va_end( argptr );
+}
+
+void QDECL Com_DPrintf( const char *fmt, ... ) {
+}
+
+void QDECL Com_Error( int level, const char *fmt, ... ) {
+	va_list		argptr;
+
+	printf( "ERROR: " );
+	va_start( argptr, fmt );
+	vprintf( fmt, argptr );
+	va_end( argptr );
+	printf( "\n" );
+	exit( 1 );
+}
+
+#ifdef HUNK_DEBUG
+void *Hunk_AllocDebug( int size, ha_pref preference, char *label, char *file, int line ) {
+#else
+void *Hunk_Alloc( int size, ha_pref preference ) {
+#endif
+	void	*buf;
+
+	// only one map is ever loaded
+	buf = calloc( 1, size );
+	if ( !buf ) {
+		Com_Error( ERR_FATAL, "Hunk_Alloc: out of memory" );
+	}
+	return buf;
+}
+
+#ifdef ZONE_DEBUG
+void *Z_MallocDebug( int size, char *label, char *file, int line ) {
+#else
+void *Z_Malloc( int size ) {
+#endif
+	void	*buf;
+
+	buf = calloc( 1, size );
+	if ( !buf ) {
+		Com_Error( ERR_FATAL, "Z_Malloc: out of memory" );
+	}
+	return buf;
+}
+
+void Z_Free( void *ptr ) {
+	free( ptr );
+}
+
+static int FindCvar( const char *var_name, const char *value ) {
+	int		i;
+
+	for ( i = 0 ; i < numBenchCvars ; i++ ) {
+		if ( !Q_stricmp( benchCvars[i].name, var_name ) ) {
+			return i;
+		}
+	}
+
+	if ( numBenchCvars == MAX_BENCH_CVARS ) {
+		Com_Error( ERR_FATAL, "too many cvars" );
+	}
+	numBenchCvars++;
+	Q_strncpyz( benchCvars[i].name, var_name, sizeof( benchCvars[i].name ) );
+	Q_strncpyz( benchCvars[i].value, value, sizeof( benchCvars[i].value ) );
+	return i;
+}
+
+static void SetCvar( const char *var_name, const char *value ) {
+	int		i;
+
+	i = FindCvar( var_name, value );
+	Q_strncpyz( benchCvars[i].value, value, sizeof( benchCvars[i].value ) );
+}
+
+/*
+=================
+Cvar_Get
+
+Values given with -set on the command line override the defaults
+=================
+*/
+cvar_t *Cvar_Get( const char *var_name, const char *value, int flags ) {
+	int		i;
+
+	i = FindCvar( var_name, value );
+
+	benchCvars[i].cvar.name = benchCvars[i].name;
+	benchCvars[i].cvar.string = benchCvars[i].value;
+	benchCvars[i].cvar.value = atof( benchCvars[i].value );
+	benchCvars[i].cvar.integer = atoi( benchCvars[i].value );
+	return &benchCvars[i].cvar;
+}
+
+long FS_ReadFile( const char *qpath, void **buffer ) {
+	FILE	*f;
+	long	len;
+	byte	*buf;
+
+	// the map name is a path on disk
+	*buffer = NULL;
+
+	f = fopen( qpath, "rb" );
+	if ( !f ) {
+		return -1;
+	}
+
+	fseek( f, 0, SEEK_END );
+	len = ftell( f );
+	fseek( f, 0, SEEK_SET );
+
+	buf = malloc( len + 1 );
+	if ( fread( buf, 1, len, f ) != len ) {
+		free( buf );
+		fclose( f );
+		return -1;
+	}
+	buf[len] = 0;
+	fclose( f );
+
+	*buffer = buf;
+	return len;
+}
+
+void FS_FreeFile( void *buffer ) {
+	free( buffer );
+}
+
+void FS_WriteFile( const char *qpath, const void *buffer, int size ) {
+	FILE	*f;
+
+	f = fopen( qpath, "wb" );
+	if ( !f ) {
+		printf( "Failed to open %s\n", qpath );
+		return;
+	}
+	fwrite( buffer, 1, size, f );
+	fclose( f );
+}
+
+qboolean FS_FileExists( const char *file ) {
+	FILE	*f;
+
+	f = fopen( file, "rb" );
+	if ( !f ) {
+		return qfalse;
+	}
+	fclose( f );
+	return qtrue;
+}
+
+void BotDrawDebugPolygons( void (*drawPoly)(int color, int numPoints, float *points), int value ) {
+}
+
+/*
+==============================================================================
+
+WORKLOAD
+
+==============================================================================
+*/
+
+static double Microseconds( void ) {
+#ifdef _WIN32
+	static LARGE_INTEGER	freq;
+	LARGE_INTEGER			now;
+
+	if ( !freq.QuadPart ) {
+		QueryPerformanceFrequency( &freq );
+	}
+	QueryPerformanceCounter( &now );
+	return (double)now.QuadPart * 1000000.0 / freq.QuadPart;
+#else
+	struct timespec	now;
+
+	clock_gettime( CLOCK_MONOTONIC, &now );
+	return now.tv_sec * 1000000.0 + now.tv_nsec / 1000.0;
+#endif
+}
+
+// the workload must not depend on the c library's rand()
+static float Random( void ) {
+	randSeed = randSeed * 1664525 + 1013904223;
+	return ( randSeed >> 8 ) / (float)( 1 << 24 );
+}
+
+static float RandomRange( float min, float max ) {
+	return min + ( max - min ) * Random();
+}
+
+/*
+=================
+RandomOpenPoint
+
+Somewhere in the world that isn't inside a solid brush, most of the time
+=================
+*/
+static void RandomOpenPoint( const vec3_t mins, const vec3_t maxs, vec3_t point ) {
+	int		i, j;
+
+	for ( i = 0 ; i < 64 ; i++ ) {
+		for ( j = 0 ; j < 3 ; j++ ) {
+			point[j] = RandomRange( mins[j], maxs[j] );
+		}
+		if ( !( CM_PointContents( point, 0 ) & CONTENTS_SOLID ) ) {
+			return;
+		}
+	}
+}
+
+static void RandomEnd( const vec3_t start, float maxLength, vec3_t end ) {
+	vec3_t	dir;
+	int		i;
+
+	for ( i = 0 ; i < 3 ; i++ ) {
+		dir[i] = RandomRange( -1, 1 );
+	}
+	VectorNormalize( dir );
+	VectorMA( start, RandomRange( 0, maxLength ), dir, end );
+}
+
+static void PlayerBox( benchTrace_t *t ) {
+	VectorSet( t->mins, -15, -15, -24 );
+	VectorSet( t->maxs, 15, 15, 32 );
+}
+
+/*
+=================
+GenerateTraces
+
+The same mix of queries the game issues: shots and sight checks as point
+traces, player movement as box or capsule traces and position tests,
+movers as rotated inline models and other entities as temp boxes.
+=================
+*/
+static benchTrace_t *GenerateTraces( int count, int *numTraces ) {
+	benchTrace_t	*traces, *t;
+	vec3_t			worldMins, worldMaxs;
+	vec3_t			modelMins, modelMaxs;
+	int				numModels;
+	int				i, j;
+
+	traces = calloc( count * BENCH_NUM_KINDS, sizeof( *traces ) );
+	if ( !traces ) {
+		Com_Error( ERR_FATAL, "out of memory" );
+	}
+
+	randSeed = seed;
+	CM_ModelBounds( 0, worldMins, worldMaxs );
+	numModels = CM_NumInlineModels();
+
+	t = traces;
+	for ( i = 0 ; i < count ; i++ ) {
+		t->kind = BENCH_POINT;
+		RandomOpenPoint( worldMins, worldMaxs, t->start );
+		RandomEnd( t->start, 4096, t->end );
+		t->brushmask = BENCH_MASK_SHOT;
+		t++;
+
+		t->kind = BENCH_BOX;
+		RandomOpenPoint( worldMins, worldMaxs, t->start );
+		RandomEnd( t->start, 256, t->end );
+		PlayerBox( t );
+		t->brushmask = BENCH_MASK_SOLID;
+		t++;
+
+		t->kind = BENCH_CAPSULE;
+		RandomOpenPoint( worldMins, worldMaxs, t->start );
+		RandomEnd( t->start, 256, t->end );
+		PlayerBox( t );
+		t->brushmask = BENCH_MASK_SOLID;
+		t++;
+
+		t->kind = BENCH_POSITION;
+		RandomOpenPoint( worldMins, worldMaxs, t->start );
+		VectorCopy( t->start, t->end );
+		PlayerBox( t );
+		t->brushmask = BENCH_MASK_SOLID;
+		t++;
+
+		// maps without movers have no inline models to trace against
+		if ( numModels > 1 ) {
+			t->kind = BENCH_BMODEL;
+			t->model = CM_InlineModel( 1 + i % ( numModels - 1 ) );
+			CM_ModelBounds( t->model, modelMins, modelMaxs );
+			RandomOpenPoint( worldMins, worldMaxs, t->origin );
+			for ( j = 0 ; j < 3 ; j++ ) {
+				t->start[j] = t->origin[j] + RandomRange( modelMins[j] - 64, modelMaxs[j] + 64 );
+				t->end[j] = t->origin[j] + RandomRange( modelMins[j] - 64, modelMaxs[j] + 64 );
+			}
+			if ( i & 1 ) {
+				for ( j = 0 ; j < 3 ; j++ ) {
+					t->angles[j] = RandomRange( 0, 360 );
+				}
+			}
+			PlayerBox( t );
+			t->brushmask = BENCH_MASK_SOLID;
+			t++;
+		}
+
+		t->kind = BENCH_TEMPBOX;
+		RandomOpenPoint( worldMins, worldMaxs, t->origin );
+		for ( j = 0 ; j < 3 ; j++ ) {
+			t->boxMins[j] = -RandomRange( 8, 48 );
+			t->boxMaxs[j] = RandomRange( 8, 48 );
+			t->start[j] = t->origin[j] + RandomRange( -128, 128 );
+			t->end[j] = t->origin[j] + RandomRange( -128, 128 );
+		}
+		if ( i & 1 ) {
+			PlayerBox( t );
+		}
+		t->brushmask = BENCH_MASK_SHOT;
+		t++;
+	}
+
+	*numTraces = t - traces;
+	return traces;
+}
+
+/*
+==============================================================================
+
+BENCHMARK
+
+==============================================================================
+*/
+
+static void RunTrace( int context, const benchTrace_t *t, trace_t *result ) {
+	clipHandle_t	h;
+
+	// context 0 is the one behind the plain CM_BoxTrace and friends
+	switch ( t->kind ) {
+	case BENCH_POINT:
+		CM_BoxTraceContext( context, result, t->start, t->end, NULL, NULL, 0, t->brushmask, qfalse );
+		break;
+	case BENCH_BOX:
+	case BENCH_POSITION:
+		CM_BoxTraceContext( context, result, t->start, t->end, (float *)t->mins, (float *)t->maxs,
+			0, t->brushmask, qfalse );
+		break;
+	case BENCH_CAPSULE:
+		CM_BoxTraceContext( context, result, t->start, t->end, (float *)t->mins, (float *)t->maxs,
+			0, t->brushmask, qtrue );
+		break;
+	case BENCH_BMODEL:
+		CM_TransformedBoxTraceContext( context, result, t->start, t->end, (float *)t->mins, (float *)t->maxs,
+			t->model, t->brushmask, t->origin, t->angles, qfalse );
+		break;
+	case BENCH_TEMPBOX:
+		h = CM_TempBoxModelContext( context, t->boxMins, t->boxMaxs, qfalse );
+		CM_TransformedBoxTraceContext( context, result, t->start, t->end, (float *)t->mins, (float *)t->maxs,
+			h, t->brushmask, t->origin, vec3_origin, qfalse );
+		break;
+	default:
+		break;
+	}
+}
+
+static unsigned ChecksumInts( unsigned checksum, const void *data, int count ) {
+	const int	*ints = data;
+	int			i;
+
+	// FNV-1a over whole ints
+	for ( i = 0 ; i < count ; i++ ) {
+		checksum = ( checksum ^ (unsigned)ints[i] ) * 16777619;
+	}
+	return checksum;
+}
+
+/*
+=================
+ChecksumTrace
+
+The plane of an allsolid trace is not valid, so it is left out
+=================
+*/
+static unsigned ChecksumTrace( unsigned checksum, const trace_t *tr ) {
+	int		flags[4];
+
+	flags[0] = tr->allsolid;
+	flags[1] = tr->startsolid;
+	flags[2] = tr->surfaceFlags;
+	flags[3] = tr->contents;
+	checksum = ChecksumInts( checksum, flags, 4 );
+	checksum = ChecksumInts( checksum, &tr->fraction, 1 );
+	checksum = ChecksumInts( checksum, tr->endpos, 3 );
+	if ( !tr->allsolid && tr->fraction < 1 ) {
+		checksum = ChecksumInts( checksum, tr->plane.normal, 3 );
+		checksum = ChecksumInts( checksum, &tr->plane.dist, 1 );
+	}
+	return checksum;
+}
+
+static void RunBenchmark( const benchTrace_t *traces, int numTraces, int rounds, FILE *dump, benchStats_t *stats ) {
+	const benchTrace_t	*t;
+	trace_t			result;
+	benchStats_t	*s;
+	double			start;
+	int				i, r;
+
+	Com_Memset( stats, 0, BENCH_NUM_KINDS * sizeof( *stats ) );
+	for ( i = 0 ; i < BENCH_NUM_KINDS ; i++ ) {
+		stats[i].checksum = 2166136261u;
+	}
+
+	for ( r = 0 ; r < rounds ; r++ ) {
+		for ( i = 0, t = traces ; i < numTraces ; i++, t++ ) {
+			s = &stats[t->kind];
+
+			start = Microseconds();
+			RunTrace( 0, t, &result );
+			s->total += Microseconds() - start;
+
+			// every round has to give the same answers, only check the first
+			if ( r ) {
+				continue;
+			}
+			s->count++;
+			if ( result.fraction < 1 || result.startsolid ) {
+				s->hits++;
+			}
+			s->checksum = ChecksumTrace( s->checksum, &result );
+
+			if ( dump ) {
+				fprintf( dump, "%i %s %i %i %.6f %.3f %.3f %.3f %.4f %.4f %.4f %.3f %i %i\n",
+					i, kindNames[t->kind], result.allsolid, result.startsolid, result.fraction,
+					result.endpos[0], result.endpos[1], result.endpos[2],
+					result.plane.normal[0], result.plane.normal[1], result.plane.normal[2],
+					result.plane.dist, result.contents, result.surfaceFlags );
+			}
+		}
+	}
+}
+
+/*
+==============================================================================
+
+THREADS
+
+==============================================================================
+*/
+
+#ifdef _WIN32
+static DWORD WINAPI BenchThread( LPVOID data ) {
+#else
+static void *BenchThread( void *data ) {
+#endif
+	benchThread_t	*bt = data;
+	int				i, r;
+
+	for ( r = 0 ; r < bt->rounds ; r++ ) {
+		for ( i = 0 ; i < bt->numTraces ; i++ ) {
+			RunTrace( bt->context, &bt->traces[i], &bt->results[i] );
+		}
+	}
+	return 0;
+}
+
+/*
+=================
+RunThreaded
+
+Splits the workload into one contiguous slice per thread, each tracing on
+its own context, and checks the results against the serial run in stats
+=================
+*/
+static qboolean RunThreaded( const benchTrace_t *traces, int numTraces, int rounds, int numThreads,
+							benchStats_t *stats ) {
+	benchThread_t	threads[CM_MAX_TRACE_CONTEXTS];
+#ifdef _WIN32
+	HANDLE			handles[CM_MAX_TRACE_CONTEXTS];
+#else
+	pthread_t		handles[CM_MAX_TRACE_CONTEXTS];
+#endif
+	trace_t			*results;
+	unsigned		checksums[BENCH_NUM_KINDS];
+	double			start, total, serial;
+	qboolean		match;
+	int				first, i;
+
+	results = calloc( numTraces, sizeof( *results ) );
+	if ( !results ) {
+		Com_Error( ERR_FATAL, "out of memory" );
+	}
+
+	for ( i = 0, first = 0 ; i < numThreads ; i++ ) {
+		threads[i].traces = traces + first;
+		threads[i].results = results + first;
+		threads[i].numTraces = numTraces * ( i + 1 ) / numThreads - first;
+		threads[i].rounds = rounds;
+		threads[i].context = i;
+		first += threads[i].numTraces;
+	}
+
+	start = Microseconds();
+	for ( i = 0 ; i < numThreads ; i++ ) {
+#ifdef _WIN32
+		handles[i] = CreateThread( NULL, 0, BenchThread, &threads[i], 0, NULL );
+		if ( !handles[i] ) {
+#else
+		if ( pthread_create( &handles[i], NULL, BenchThread, &threads[i] ) ) {
+#endif
+			Com_Error( ERR_FATAL, "couldn't start thread %i", i );
+		}
+	}
+	for ( i = 0 ; i < numThreads ; i++ ) {
+#ifdef _WIN32
+		WaitForSingleObject( handles[i], INFINITE );
+		CloseHandle( handles[i] );
+#else
+		pthread_join( handles[i], NULL );
+#endif
+	}
+	total = Microseconds() - start;
+
+	// fold the results in workload order, the same way the serial run did
+	for ( i = 0 ; i < BENCH_NUM_KINDS ; i++ ) {
+		checksums[i] = 2166136261u;
+	}
+	for ( i = 0 ; i < numTraces ; i++ ) {
+		checksums[traces[i].kind] = ChecksumTrace( checksums[traces[i].kind], &results[i] );
+	}
+
+	serial = 0;
+	match = qtrue;
+	for ( i = 0 ; i < BENCH_NUM_KINDS ; i++ ) {
+		serial += stats[i].total;
+		if ( stats[i].count && checksums[i] != stats[i].checksum ) {
+			printf( "  %-9s checksum %08x, serial run %08x\n", kindNames[i], checksums[i], stats[i].checksum );
+			match = qfalse;
+		}
+	}
+
+	printf( "%i threads: %.3f ms, %.0f traces/sec, %.2fx the serial run, %s\n", numThreads,
+		total / 1000.0, numTraces * rounds / ( total / 1000000.0 ), serial / total,
+		match ? "results match" : "RESULTS DIFFER" );
+
+	free( results );
+	return match;
+}
+
+/*
+==============================================================================
+
+BOX SWEEPS
+
+==============================================================================
+*/
+
+typedef enum {
+	SWEEP_BOX_BOX,
+	SWEEP_CAPSULE_BOX,
+	SWEEP_BOX_CAPSULE,
+
+	SWEEP_NUM_KINDS
+} sweepKind_t;
+
+static const char *sweepNames[SWEEP_NUM_KINDS] = {
+	"box vs box",
+	"capsule vs box",
+	"box vs capsule"
+};
+
+typedef struct {
+	int			count;
+	int			hits;
+	int			lastBit;		// fraction or endpos differ by rounding only
+	int			differ;
+} sweepStats_t;
+
+static void RandomSweepBox( vec3_t mins, vec3_t maxs ) {
+	int		j;
+
+	for ( j = 0 ; j < 3 ; j++ ) {
+		mins[j] = -RandomRange( 0, 48 );
+		maxs[j] = RandomRange( 0, 48 );
+	}
+}
+
+static qboolean NearlyEqual( float a, float b ) {
+	return fabs( a - b ) <= 0.0001f * ( 1 + fabs( a ) );
+}
+
+/*
+=================
+CompareTraces
+
+Returns 0 for identical results, 1 if only the fraction or endpos
+differ in rounding and 2 if the traces disagree
+=================
+*/
+static int CompareTraces( const trace_t *a, const trace_t *b ) {
+	int		j;
+
+	if ( a->allsolid != b->allsolid || a->startsolid != b->startsolid || a->contents != b->contents
+		|| a->surfaceFlags != b->surfaceFlags ) {
+		return 2;
+	}
+	if ( !a->allsolid && ( a->fraction < 1 || b->fraction < 1 ) ) {
+		if ( !VectorCompare( a->plane.normal, b->plane.normal ) || a->plane.dist != b->plane.dist
+			|| a->plane.type != b->plane.type || a->plane.signbits != b->plane.signbits ) {
+			return 2;
+		}
+	}
+	if ( a->fraction == b->fraction && VectorCompare( a->endpos, b->endpos ) ) {
+		return 0;
+	}
+	if ( !NearlyEqual( a->fraction, b->fraction ) ) {
+		return 2;
+	}
+	for ( j = 0 ; j < 3 ; j++ ) {
+		if ( !NearlyEqual( a->endpos[j], b->endpos[j] ) ) {
+			return 2;
+		}
+	}
+	return 1;
+}
+
+/*
+=================
+CompareBoxSweeps
+
+Clips random box and capsule moves against random box and capsule entities
+both through the temp box hull and with CM_TraceAgainstBox.  Half of them
+are snapped to whole units, like most entity positions in the game, and a
+quarter are position tests.
+=================
+*/
+static qboolean CompareBoxSweeps( int count ) {
+	benchTrace_t	*traces, *t;
+	trace_t			*hull, *sweep;
+	sweepStats_t	stats[SWEEP_NUM_KINDS], *s;
+	double			start, hullTime, sweepTime;
+	qboolean		match;
+	int				capsule, boxCapsule;
+	int				i, j, n;
+
+	traces = calloc( count, sizeof( *traces ) );
+	hull = calloc( count, sizeof( *hull ) );
+	sweep = calloc( count, sizeof( *sweep ) );
+	if ( !traces || !hull || !sweep ) {
+		Com_Error( ERR_FATAL, "out of memory" );
+	}
+
+	// kind is the sweepKind_t here
+	randSeed = seed;
+	for ( i = 0, t = traces ; i < count ; i++, t++ ) {
+		t->kind = i % SWEEP_NUM_KINDS;
+		for ( j = 0 ; j < 3 ; j++ ) {
+			t->origin[j] = RandomRange( -2048, 2048 );
+			t->start[j] = t->origin[j] + RandomRange( -128, 128 );
+			t->end[j] = t->origin[j] + RandomRange( -128, 128 );
+		}
+		if ( i & 4 ) {
+			VectorCopy( t->start, t->end );
+		}
+		if ( i & 8 ) {
+			for ( j = 0 ; j < 3 ; j++ ) {
+				t->origin[j] = floor( t->origin[j] );
+				t->start[j] = floor( t->start[j] );
+				t->end[j] = floor( t->end[j] );
+			}
+		}
+		if ( i & 16 ) {
+			PlayerBox( t );
+		} else {
+			RandomSweepBox( t->mins, t->maxs );
+		}
+		RandomSweepBox( t->boxMins, t->boxMaxs );
+		t->brushmask = BENCH_MASK_SOLID;
+	}
+
+	Com_Memset( stats, 0, sizeof( stats ) );
+
+	// the temp box hull path the server used for all of them
+	start = Microseconds();
+	for ( i = 0, t = traces ; i < count ; i++, t++ ) {
+		capsule = ( (int)t->kind == SWEEP_CAPSULE_BOX );
+		boxCapsule = ( (int)t->kind == SWEEP_BOX_CAPSULE );
+		n = CM_TempBoxModel( t->boxMins, t->boxMaxs, boxCapsule );
+		CM_TransformedBoxTrace( &hull[i], t->start, t->end, t->mins, t->maxs, n,
+			t->brushmask, t->origin, vec3_origin, capsule );
+	}
+	hullTime = Microseconds() - start;
+
+	start = Microseconds();
+	for ( i = 0, t = traces ; i < count ; i++, t++ ) {
+		capsule = ( (int)t->kind == SWEEP_CAPSULE_BOX );
+		boxCapsule = ( (int)t->kind == SWEEP_BOX_CAPSULE );
+		CM_TraceAgainstBox( &sweep[i], t->start, t->end, t->mins, t->maxs, t->boxMins, t->boxMaxs,
+			t->brushmask, t->origin, capsule, boxCapsule );
+	}
+	sweepTime = Microseconds() - start;
+
+	match = qtrue;
+	for ( i = 0, t = traces ; i < count ; i++, t++ ) {
+		s = &stats[t->kind];
+		s->count++;
+		if ( hull[i].fraction < 1 || hull[i].startsolid ) {
+			s->hits++;
+		}
+		switch ( CompareTraces( &hull[i], &sweep[i] ) ) {
+		case 1:
+			s->lastBit++;
+			break;
+		case 2:
+			if ( s->differ < 4 ) {
+				printf( "  %s %i: hull %i %i %.6f, sweep %i %i %.6f\n", sweepNames[t->kind], i,
+					hull[i].allsolid, hull[i].startsolid, hull[i].fraction,
+					sweep[i].allsolid, sweep[i].startsolid, sweep[i].fraction );
+			}
+			s->differ++;
+			match = qfalse;
+			break;
+		}
+	}
+
+	printf( "%i box sweeps, seed %u: hull %.3f ms, sweep %.3f ms, %.2fx\n", count, seed,
+		hullTime / 1000.0, sweepTime / 1000.0, hullTime / sweepTime );
+	printf( "  kind               count     hits   last bit   differ\n" );
+	for ( i = 0 ; i < SWEEP_NUM_KINDS ; i++ ) {
+		s = &stats[i];
+		printf( "  %-16s %7i  %7i    %7i  %7i\n", sweepNames[i], s->count, s->hits, s->lastBit, s->differ );
+	}
+
+	free( traces );
+	free( hull );
+	free( sweep );
+	return match;
+}
+
+static void PrintStats( benchStats_t *stats, int rounds ) {
+	benchStats_t	*s;
+	double			total;
+	int				count;
+	unsigned		checksum;
+	int				i;
+
+	printf( "  kind        count     hits    total ms    traces/sec   usec/trace   checksum\n" );
+
+	total = 0;
+	count = 0;
+	checksum = 2166136261u;
+	for ( i = 0 ; i < BENCH_NUM_KINDS ; i++ ) {
+		s = &stats[i];
+		if ( !s->count ) {
+			continue;
+		}
+		printf( "  %-9s %7i  %7i %11.3f %13.0f %12.3f   %08x\n", kindNames[i], s->count, s->hits,
+			s->total / 1000.0, s->count * rounds / ( s->total / 1000000.0 ),
+			s->total / ( s->count * rounds ), s->checksum );
+
+		total += s->total;
+		count += s->count;
+		checksum = ChecksumInts( checksum, &s->checksum, 1 );
+	}
+	printf( "  %-9s %7i  %7s %11.3f %13.0f %12.3f   %08x\n", "all", count, "",
+		total / 1000.0, count * rounds / ( total / 1000000.0 ), total / ( count * rounds ), checksum );
+}
+
+static void Usage( void ) {
+	printf( "usage: cmbench [options] <map.bsp>\n"
+		"  -n <count>            number of traces of each kind (default 20000)\n"
+		"  -rounds <count>       run the workload this many times (default 5)\n"
+		"  -seed <seed>          workload random seed (default 1)\n"
+		"  -set <cvar> <value>   set a cm_ cvar before the map is loaded\n"
+		"  -dump <file>          write every trace result to a text file\n"
+		"  -threads <count>      also run the workload split over this many threads\n"
+		"                        and check the results against the serial run\n"
+		"  -boxsweeps            compare <count> random entity clips through the temp\n"
+		"                        box hull and CM_TraceAgainstBox instead\n" );
+	exit( 1 );
+}
+
+int main( int argc, char **argv ) {
+	const char		*mapName;
+	const char		*dumpName;
+	benchTrace_t	*traces;
+	benchStats_t	stats[BENCH_NUM_KINDS];
+	FILE			*dump;
+	double			start;
+	int				count, rounds, numTraces, numThreads;
+	int				checksum;
+	qboolean		match, boxSweeps;
+	int				i;
+
+	mapName = NULL;
+	dumpName = NULL;
+	count = 20000;
+	rounds = 5;
+	numThreads = 0;
+	boxSweeps = qfalse;
+
+	for ( i = 1 ; i < argc ; i++ ) {
+		if ( !strcmp( argv[i], "-n" ) && i + 1 < argc ) {
+			count = atoi( argv[++i] );
+		} else if ( !strcmp( argv[i], "-rounds" ) && i + 1 < argc ) {
+			rounds = atoi( argv[++i] );
+		} else if ( !strcmp( argv[i], "-seed" ) && i + 1 < argc ) {
+			seed = strtoul( argv[++i], NULL, 0 );
+		} else if ( !strcmp( argv[i], "-set" ) && i + 2 < argc ) {
+			SetCvar( argv[i + 1], argv[i + 2] );
+			i += 2;
+		} else if ( !strcmp( argv[i], "-dump" ) && i + 1 < argc ) {
+			dumpName = argv[++i];
+		} else if ( !strcmp( argv[i], "-threads" ) && i + 1 < argc ) {
+			numThreads = atoi( argv[++i] );
+		} else if ( !strcmp( argv[i], "-boxsweeps" ) ) {
+			boxSweeps = qtrue;
+		} else if ( argv[i][0] == '-' || mapName ) {
+			Usage();
+		} else {
+			mapName = argv[i];
+		}
+	}
+	if ( !mapName || count <= 0 || rounds <= 0 || numThreads < 0 || numThreads > CM_MAX_TRACE_CONTEXTS ) {
+		Usage();
+	}
+
+	start = Microseconds();
+	CM_LoadMap( mapName, qfalse, &checksum );
+	printf( "%s: loaded in %.1f ms, %i brushes, %i leafs, %i inline models, checksum %08x\n",
+		mapName, ( Microseconds() - start ) / 1000.0, cm.numBrushes, cm.numLeafs,
+		cm.numSubModels, (unsigned)checksum );
+
+	for ( i = 0 ; i < numBenchCvars ; i++ ) {
+		printf( "  %s %s\n", benchCvars[i].name, benchCvars[i].value );
+	}
+
+	if ( boxSweeps ) {
+		return CompareBoxSweeps( count ) ? 0 : 2;
+	}
+
+	traces = GenerateTraces( count, &numTraces );
+
+	dump = NULL;
+	if ( dumpName ) {
+		dump = fopen( dumpName, "w" );
+		if ( !dump ) {
+			Com_Error( ERR_FATAL, "couldn't write %s", dumpName );
+		}
+	}
+
+	// warm the caches once
+	RunBenchmark( traces, numTraces, 1, NULL, stats );
+
+	RunBenchmark( traces, numTraces, rounds, dump, stats );
+	printf( "%i traces x %i rounds, seed %u\n", numTraces, rounds, seed );
+	PrintStats( stats, rounds );
+
+	match = qtrue;
+	if ( numThreads ) {
+		match = RunThreaded( traces, numTraces, rounds, numThreads, stats );
+	}
+
+	if ( dump ) {
+		fclose( dump );
+	}
+	free( traces );
+	return match ? 0 : 2;
+}
@@ -0,0 +1,715 @@
+/*
+===========================================================================
+Copyright (C) 1999-2005 Id Software, Inc.
+
+This file is part of Quake III Arena source code.
+
+Quake III Arena source code is free software; you can redistribute it
+and/or modify it under the terms of the GNU General Public License as
+published by the Free Software Foundation; either version 2 of the License,
+or (at your option) any later version.
+
+Quake III Arena source code is distributed in the hope that it will be
+useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Quake III Arena source code; if not, write to the Free Software
+Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+===========================================================================
+*/
+// qvmreplay.c -- runs a vmrecord capture through the qvm interpreter and
+// compiler outside of the engine, reporting divergence and per call timing.
+// The dispatch mode replays it through the interpreter twice instead, once
+// with switch dispatch and once with threaded dispatch.
+
+#include "../../qcommon/vm_local.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <setjmp.h>
+#include <time.h>
+#ifdef _WIN32
+#include <windows.h>
+#endif
+
+#define	MAX_REPLAY_CALLNUMS	64
+#define	MAX_REPLAY_SYSCALLS	1024
+
+typedef struct {
+	int		count;
+	double	total;		// usec
+	double	max;
+} callStats_t;
+
+typedef struct {
+	const char		*name;
+	vmInterpret_t	interpret;
+	qboolean		switchDispatch;	// use the VM_SWITCH_DISPATCH interpreter
+	qboolean		diverged;
+	int				numCalls;
+	int				numSyscalls;
+	callStats_t		stats[MAX_REPLAY_CALLNUMS];
+} replayRun_t;
+
+static const char	*qvmPath;
+static FILE			*capture;
+static long			captureStart;
+static char			vmName[MAX_QPATH];
+static int			dataLength;
+static int			syscallArgs[MAX_REPLAY_SYSCALLS];	// arguments every call site passes
+
+static cvar_t		developer;
+cvar_t				*com_developer = &developer;
+
+#if idx64
+int (*Q_VMftol)(void);
+#elif id386
+long (QDECL *Q_ftol)(float f);
+int (QDECL *Q_VMftol)(void);
+void (QDECL *Q_SnapVector)(vec3_t vec);
+#endif
+
+static vm_t			*replayVM;
+static replayRun_t	*run;
+static jmp_buf		abortRun;
+
+// vm_switch.c
+int	VM_CallInterpretedSwitch( vm_t *vm, int *args );
+
+/*
+==============================================================================
+
+ENGINE STUBS
+
+just enough of qcommon for vm.c and the vm backends
+
+==============================================================================
+*/
+
+void QDECL Com_Printf( const char *fmt, ... ) {
+	va_list		argptr;
+
+	va_start( argptr, fmt );
+	vprintf( fmt, argptr );
+	va_end( argptr );
+}
+
+void QDECL Com_DPrintf( const char *fmt, ... ) {
+}
+
+void QDECL Com_Error( int level, const char *fmt, ... ) {
+	va_list		argptr;
+
+	printf( "ERROR: " );
+	va_start( argptr, fmt );
+	vprintf( fmt, argptr );
+	va_end( argptr );
+	printf( "\n" );
+
+	if ( !run ) {
+		exit( 1 );
+	}
+
+	run->diverged = qtrue;
+	longjmp( abortRun, 1 );
+}
+
+#ifdef HUNK_DEBUG
+void *Hunk_AllocDebug( int size, ha_pref preference, char *label, char *file, int line ) {
+#else
+void *Hunk_Alloc( int size, ha_pref preference ) {
+#endif
+	void	*buf;
+
+	// leaked, each run creates a single vm
+	buf = calloc( 1, size );
+	if ( !buf ) {
+		Com_Error( ERR_FATAL, "Hunk_Alloc: out of memory" );
+	}
+	return buf;
+}
+
+int Hunk_MemoryRemaining( void ) {
+	return 0;
+}
+
+#ifdef ZONE_DEBUG
+void *Z_MallocDebug( int size, char *label, char *file, int line ) {
+#else
+void *Z_Malloc( int size ) {
+#endif
+	void	*buf;
+
+	buf = calloc( 1, size );
+	if ( !buf ) {
+		Com_Error( ERR_FATAL, "Z_Malloc: out of memory" );
+	}
+	return buf;
+}
+
+void Z_Free( void *ptr ) {
+	free( ptr );
+}
+
+cvar_t *Cvar_Get( const char *var_name, const char *value, int flags ) {
+	return NULL;
+}
+
+void Cmd_AddCommand( const char *cmd_name, xcommand_t function ) {
+}
+
+int Cmd_Argc( void ) {
+	return 0;
+}
+
+char *Cmd_Argv( int arg ) {
+	return "";
+}
+
+vmInterpret_t FS_FindVM( void **startSearch, char *found, int foundlen, const char *name, int enableDll ) {
+	// only the qvm given on the command line
+	if ( *startSearch ) {
+		return -1;
+	}
+
+	*startSearch = (void *)qvmPath;
+	Q_strncpyz( found, qvmPath, foundlen );
+	return VMI_COMPILED;
+}
+
+long FS_ReadFileDir( const char *qpath, void *searchPath, qboolean unpure, void **buffer ) {
+	FILE	*f;
+	long	len;
+	byte	*buf;
+
+	*buffer = NULL;
+
+	f = fopen( qvmPath, "rb" );
+	if ( !f ) {
+		return -1;
+	}
+
+	fseek( f, 0, SEEK_END );
+	len = ftell( f );
+	fseek( f, 0, SEEK_SET );
+
+	buf = malloc( len + 1 );
+	if ( fread( buf, 1, len, f ) != len ) {
+		free( buf );
+		fclose( f );
+		return -1;
+	}
+	buf[len] = 0;
+	fclose( f );
+
+	*buffer = buf;
+	return len;
+}
+
+long FS_ReadFile( const char *qpath, void **buffer ) {
+	// no symbol files
+	if ( buffer ) {
+		*buffer = NULL;
+	}
+	return -1;
+}
+
+void FS_FreeFile( void *buffer ) {
+	free( buffer );
+}
+
+qboolean FS_Which( const char *filename, void *searchPath ) {
+	return qtrue;
+}
+
+fileHandle_t FS_FOpenFileWrite( const char *qpath ) {
+	return 0;
+}
+
+int FS_Write( const void *buffer, int len, fileHandle_t f ) {
+	return 0;
+}
+
+void FS_FCloseFile( fileHandle_t f ) {
+}
+
+void * QDECL Sys_LoadGameDll( const char *name, intptr_t (QDECL **entryPoint)(int, ...),
+				  intptr_t (QDECL *systemcalls)(intptr_t, ...) ) {
+	return NULL;
+}
+
+void Sys_UnloadDll( void *dllHandle ) {
+}
+
+/*
+==============================================================================
+
+REPLAY
+
+==============================================================================
+*/
+
+static double Microseconds( void ) {
+#ifdef _WIN32
+	static LARGE_INTEGER	freq;
+	LARGE_INTEGER			now;
+
+	if ( !freq.QuadPart ) {
+		QueryPerformanceFrequency( &freq );
+	}
+	QueryPerformanceCounter( &now );
+	return (double)now.QuadPart * 1000000.0 / freq.QuadPart;
+#else
+	struct timespec	now;
+
+	clock_gettime( CLOCK_MONOTONIC, &now );
+	return now.tv_sec * 1000000.0 + now.tv_nsec / 1000.0;
+#endif
+}
+
+static void ReadCapture( void *buffer, int len ) {
+	if ( fread( buffer, 1, len, capture ) != len ) {
+		Com_Error( ERR_DROP, "unexpected end of capture" );
+	}
+}
+
+static int ReadInt( void ) {
+	int		value;
+
+	ReadCapture( &value, sizeof( value ) );
+	return value;
+}
+
+static int64_t ReadInt64( void ) {
+	int64_t	value;
+
+	ReadCapture( &value, sizeof( value ) );
+	return value;
+}
+
+static void ReadPatches( void ) {
+	int		ofs, len;
+
+	while ( 1 ) {
+		ofs = ReadInt();
+		len = ReadInt();
+		if ( !len ) {
+			break;
+		}
+		if ( ofs < 0 || len < 0 || ofs + len > dataLength ) {
+			Com_Error( ERR_DROP, "bad patch %i, %i in capture", ofs, len );
+		}
+		ReadCapture( replayVM->dataBase + ofs, len );
+	}
+}
+
+/*
+=================
+FindSyscallArgs
+
+Only the arguments a system call is actually passed can be compared, the
+stack slots after them hold whatever the backend left there.  The qvm
+pushes the arguments with OP_ARG right before calling the negative address
+of the system call, so the highest ARG offset since the previous call gives
+the number of arguments at each call site.
+=================
+*/
+static void FindSyscallArgs( void ) {
+	vmHeader_t	header;
+	byte		*buf, *code;
+	long		len;
+	int			i, pc, op, operand;
+	int			prevOp, prevOperand;
+	int			maxArg, num, numArgs;
+
+	for ( i = 0 ; i < MAX_REPLAY_SYSCALLS ; i++ ) {
+		syscallArgs[i] = -1;
+	}
+
+	len = FS_ReadFileDir( qvmPath, NULL, qfalse, (void **)&buf );
+	if ( len < (long)sizeof( header ) ) {
+		Com_Error( ERR_FATAL, "couldn't read %s", qvmPath );
+	}
+	Com_Memcpy( &header, buf, sizeof( header ) );
+	for ( i = 0 ; i < sizeof( header ) / 4 ; i++ ) {
+		((int *)&header)[i] = LittleLong( ((int *)&header)[i] );
+	}
+	if ( header.codeOffset < 0 || header.codeLength < 0 || header.codeOffset + header.codeLength > len ) {
+		Com_Error( ERR_FATAL, "%s has a bad header", qvmPath );
+	}
+	code = buf + header.codeOffset;
+
+	prevOp = OP_UNDEF;
+	prevOperand = 0;
+	maxArg = 0;
+	for ( i = 0, pc = 0 ; i < header.instructionCount && pc < header.codeLength ; i++ ) {
+		op = code[pc++];
+		operand = 0;
+
+		switch ( op ) {
+		case OP_ENTER:
+		case OP_CONST:
+		case OP_LOCAL:
+		case OP_LEAVE:
+		case OP_EQ:
+		case OP_NE:
+		case OP_LTI:
+		case OP_LEI:
+		case OP_GTI:
+		case OP_GEI:
+		case OP_LTU:
+		case OP_LEU:
+		case OP_GTU:
+		case OP_GEU:
+		case OP_EQF:
+		case OP_NEF:
+		case OP_LTF:
+		case OP_LEF:
+		case OP_GTF:
+		case OP_GEF:
+		case OP_BLOCK_COPY:
+			if ( pc + 4 > header.codeLength ) {
+				break;
+			}
+			Com_Memcpy( &operand, code + pc, 4 );
+			operand = LittleLong( operand );
+			pc += 4;
+			break;
+		case OP_ARG:
+			if ( pc + 1 > header.codeLength ) {
+				break;
+			}
+			operand = code[pc++];
+			if ( operand > maxArg ) {
+				maxArg = operand;
+			}
+			break;
+		case OP_CALL:
+			if ( prevOp == OP_CONST && prevOperand < 0 ) {
+				num = -1 - prevOperand;
+				// the first argument goes 8 bytes into the frame
+				numArgs = maxArg >= 8 ? ( maxArg - 8 ) / 4 + 1 : 0;
+				if ( num < MAX_REPLAY_SYSCALLS && ( syscallArgs[num] < 0 || numArgs < syscallArgs[num] ) ) {
+					syscallArgs[num] = numArgs;
+				}
+			}
+			maxArg = 0;
+			break;
+		default:
+			break;
+		}
+
+		if ( op == OP_ENTER || op == OP_LEAVE ) {
+			maxArg = 0;
+		}
+		prevOp = op;
+		prevOperand = operand;
+	}
+
+	FS_FreeFile( buf );
+}
+
+static void ReplayCall( void );
+
+/*
+=================
+ReplayVMCall
+
+VM_Call always runs the interpreter the engine was built with, the
+switch dispatch runs go through the second copy of it directly
+=================
+*/
+static intptr_t ReplayVMCall( int *args ) {
+	vm_t		*oldVM;
+	intptr_t	r;
+
+	if ( !run->switchDispatch ) {
+		return VM_Call( replayVM, args[0], args[1], args[2], args[3], args[4], args[5],
+			args[6], args[7], args[8], args[9], args[10] );
+	}
+
+	oldVM = currentVM;
+	currentVM = replayVM;
+	replayVM->callLevel++;
+	r = VM_CallInterpretedSwitch( replayVM, args );
+	replayVM->callLevel--;
+	currentVM = oldVM;
+
+	return r;
+}
+
+/*
+=================
+ReplaySyscall
+
+Hands the vm whatever the engine returned during the recording
+=================
+*/
+static intptr_t ReplaySyscall( intptr_t *args ) {
+	int		recorded[VM_RECORD_SYSCALL_ARGS];
+	int64_t	r;
+	int		type;
+	int		i;
+
+	// calls back into the vm made from within the system call come first
+	while ( ( type = ReadInt() ) == VMR_CALL ) {
+		ReplayCall();
+	}
+
+	if ( type != VMR_SYSCALL ) {
+		Com_Error( ERR_DROP, "call %i: vm made system call %i where the recording returned",
+			run->numCalls, (int)args[0] );
+	}
+
+	for ( i = 0 ; i < VM_RECORD_SYSCALL_ARGS ; i++ ) {
+		recorded[i] = ReadInt();
+	}
+	r = ReadInt64();
+
+	if ( recorded[0] != args[0] ) {
+		Com_Error( ERR_DROP, "call %i: system call %i where the recording has %i (%i %i %i %i)",
+			run->numCalls, (int)args[0], recorded[0], recorded[1], recorded[2], recorded[3], recorded[4] );
+	}
+	if ( recorded[0] < 0 || recorded[0] >= MAX_REPLAY_SYSCALLS ) {
+		Com_Error( ERR_DROP, "call %i: bad system call %i in capture", run->numCalls, recorded[0] );
+	}
+
+	for ( i = 1 ; i < VM_RECORD_SYSCALL_ARGS && i <= syscallArgs[recorded[0]] ; i++ ) {
+		if ( recorded[i] != (int)args[i] ) {
+			Com_Error( ERR_DROP, "call %i: system call %i has (%i %i %i %i) where the recording has (%i %i %i %i)",
+				run->numCalls, (int)args[0], (int)args[1], (int)args[2], (int)args[3], (int)args[4],
+				recorded[1], recorded[2], recorded[3], recorded[4] );
+		}
+	}
+
+	ReadPatches();
+	run->numSyscalls++;
+
+	return r;
+}
+
+/*
+=================
+ReplayCall
+
+The VMR_CALL type has already been read
+=================
+*/
+static void ReplayCall( void ) {
+	int			args[VM_RECORD_CALL_ARGS];
+	int			programStack;
+	int64_t		recordedResult;
+	unsigned	recordedChecksum;
+	intptr_t	r;
+	double		start, usec;
+	qboolean	topLevel;
+	int			i;
+
+	topLevel = !replayVM->callLevel;
+
+	programStack = ReadInt();
+	for ( i = 0 ; i < VM_RECORD_CALL_ARGS ; i++ ) {
+		args[i] = ReadInt();
+	}
+	ReadPatches();
+
+	if ( programStack != replayVM->programStack ) {
+		Com_Error( ERR_DROP, "call %i: programStack %i, recording has %i",
+			run->numCalls, replayVM->programStack, programStack );
+	}
+
+	run->numCalls++;
+
+	start = Microseconds();
+	r = ReplayVMCall( args );
+	usec = Microseconds() - start;
+
+	if ( ReadInt() != VMR_RETURN ) {
+		Com_Error( ERR_DROP, "call %i (%i): vm returned before making all recorded system calls",
+			run->numCalls, args[0] );
+	}
+
+	recordedResult = ReadInt64();
+	recordedChecksum = ReadInt();
+
+	if ( (int)r != (int)recordedResult ) {
+		Com_Error( ERR_DROP, "call %i (%i): returned %i, recording has %i",
+			run->numCalls, args[0], (int)r, (int)recordedResult );
+	}
+
+	if ( VM_DataChecksum( replayVM ) != recordedChecksum ) {
+		Com_Error( ERR_DROP, "call %i (%i): data segment differs from the recording",
+			run->numCalls, args[0] );
+	}
+
+	// nested calls are timed as part of their caller
+	if ( topLevel && args[0] >= 0 && args[0] < MAX_REPLAY_CALLNUMS ) {
+		callStats_t	*s = &run->stats[args[0]];
+
+		s->count++;
+		s->total += usec;
+		if ( usec > s->max ) {
+			s->max = usec;
+		}
+	}
+}
+
+static void Replay( replayRun_t *r ) {
+	int		type;
+
+	run = r;
+	replayVM = NULL;
+
+	if ( setjmp( abortRun ) ) {
+		if ( replayVM ) {
+			replayVM->callLevel = 0;
+			VM_Free( replayVM );
+		}
+		run = NULL;
+		return;
+	}
+
+	replayVM = VM_Create( vmName, ReplaySyscall, r->interpret );
+	if ( !replayVM ) {
+		Com_Error( ERR_DROP, "couldn't load %s", qvmPath );
+	}
+
+	// don't let a missing compiler pass as a match
+	if ( r->interpret == VMI_COMPILED && !replayVM->compiled ) {
+		Com_Error( ERR_DROP, "no vm compiler for " ARCH_STRING " in this build" );
+	}
+
+	if ( replayVM->dataMask + 1 != dataLength ) {
+		Com_Error( ERR_DROP, "%s has %i bytes of data, the recording %i",
+			qvmPath, replayVM->dataMask + 1, dataLength );
+	}
+
+	// the first call carries the complete data segment
+	Com_Memset( replayVM->dataBase, 0, dataLength );
+	fseek( capture, captureStart, SEEK_SET );
+
+	while ( fread( &type, sizeof( type ), 1, capture ) == 1 ) {
+		if ( type != VMR_CALL ) {
+			Com_Error( ERR_DROP, "capture out of sync" );
+		}
+		ReplayCall();
+	}
+
+	VM_Free( replayVM );
+	run = NULL;
+}
+
+static void PrintRun( replayRun_t *r, replayRun_t *baseline ) {
+	int			i;
+	callStats_t	*s;
+
+	printf( "\n%s: %i calls, %i system calls replayed, %s\n", r->name, r->numCalls,
+		r->numSyscalls, r->diverged ? "DIVERGED" : "matches the recording" );
+
+	printf( "  call    count    total ms    avg usec    max usec" );
+	if ( baseline ) {
+		printf( "   vs %s", baseline->name );
+	}
+	printf( "\n" );
+
+	for ( i = 0 ; i < MAX_REPLAY_CALLNUMS ; i++ ) {
+		s = &r->stats[i];
+		if ( !s->count ) {
+			continue;
+		}
+		printf( "  %4i %8i %11.3f %11.2f %11.2f", i, s->count, s->total / 1000.0,
+			s->total / s->count, s->max );
+		if ( baseline && baseline->stats[i].count && s->total > 0 ) {
+			printf( "   %6.2fx", baseline->stats[i].total / s->total );
+		}
+		printf( "\n" );
+	}
+}
+
+int main( int argc, char **argv ) {
+	replayRun_t	runs[2];
+	int			numRuns;
+	int			i;
+
+	if ( argc < 3 || argc > 4 ) {
+		printf( "usage: qvmreplay <qvm> <capture> [interpreted|compiled|dispatch]\n" );
+		return 1;
+	}
+
+	qvmPath = argv[1];
+
+	capture = fopen( argv[2], "rb" );
+	if ( !capture ) {
+		printf( "couldn't open %s\n", argv[2] );
+		return 1;
+	}
+
+	if ( ReadInt() != VM_RECORD_MAGIC ) {
+		printf( "%s is not a vm capture\n", argv[2] );
+		return 1;
+	}
+	dataLength = ReadInt();
+	ReadCapture( vmName, sizeof( vmName ) );
+	vmName[sizeof( vmName ) - 1] = 0;
+	captureStart = ftell( capture );
+
+	Com_Memset( runs, 0, sizeof( runs ) );
+	numRuns = 0;
+
+	if ( argc < 4 || !Q_stricmp( argv[3], "interpreted" ) ) {
+		runs[numRuns].name = "interpreted";
+		runs[numRuns].interpret = VMI_BYTECODE;
+		numRuns++;
+	}
+	if ( argc < 4 || !Q_stricmp( argv[3], "compiled" ) ) {
+		runs[numRuns].name = "compiled";
+		runs[numRuns].interpret = VMI_COMPILED;
+		numRuns++;
+	}
+	if ( argc == 4 && !Q_stricmp( argv[3], "dispatch" ) ) {
+		runs[numRuns].name = "switch";
+		runs[numRuns].interpret = VMI_BYTECODE;
+		runs[numRuns].switchDispatch = qtrue;
+		numRuns++;
+		runs[numRuns].name = "threaded";
+		runs[numRuns].interpret = VMI_BYTECODE;
+		numRuns++;
+#ifndef __GNUC__
+		printf( "no threaded dispatch with this compiler, both runs use the switch\n" );
+#endif
+	}
+	if ( !numRuns ) {
+		printf( "unknown vm backend %s\n", argv[3] );
+		return 1;
+	}
+
+	// no cpu detection, the x87 versions work everywhere
+#if idx64
+	Q_VMftol = qvmftolsse;
+#elif id386
+	Q_ftol = qftolx87;
+	Q_VMftol = qvmftolx87;
+	Q_SnapVector = qsnapvectorx87;
+#endif
+
+	VM_Init();
+	FindSyscallArgs();
+
+	for ( i = 0 ; i < numRuns ; i++ ) {
+		Replay( &runs[i] );
+	}
+
+	for ( i = 0 ; i < numRuns ; i++ ) {
+		PrintRun( &runs[i], i ? &runs[0] : NULL );
+	}
+
+	fclose( capture );
+
+	for ( i = 0 ; i < numRuns ; i++ ) {
+		if ( runs[i].diverged ) {
+			return 2;
+		}
+	}
+	return 0;
+}
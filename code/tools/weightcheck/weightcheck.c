@@ -0,0 +1,508 @@
+/*
+===========================================================================
+Copyright (C) 1999-2005 Id Software, Inc.
+
+This file is part of Quake III Arena source code.
+
+Quake III Arena source code is free software; you can redistribute it
+and/or modify it under the terms of the GNU General Public License as
+published by the Free Software Foundation; either version 2 of the License,
+or (at your option) any later version.
+
+Quake III Arena source code is distributed in the hope that it will be
+useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Quake III Arena source code; if not, write to the Free Software
+Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+===========================================================================
+*/
+// weightcheck.c -- loads random fuzzy weight configurations with the bot
+// library and checks the compiled weights against the seperator lists they
+// were compiled from, on random inventories
+
+#include "../../qcommon/q_shared.h"
+#include "../../botlib/l_memory.h"
+#include "../../botlib/l_libvar.h"
+#include "../../botlib/botlib.h"
+#include "../../botlib/be_interface.h"
+#include "../../botlib/be_ai_weight.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#ifdef _WIN32
+#include <windows.h>
+#endif
+
+#define	WEIGHT_CONFIGS		40
+#define	WEIGHT_DEPTH		4
+#define	WEIGHT_INVENTORY	256
+#define	WEIGHT_FILE			"weightcheck.c"
+#define	WEIGHT_DEFAULTVALUE	999999		// MAX_INVENTORYVALUE in be_ai_weight.c
+
+static unsigned		seed = 1;
+static unsigned		randSeed;
+
+static FILE			*checkFiles[8];
+
+static char			*weightText;
+static int			weightTextLength, weightTextSize;
+
+/*
+==============================================================================
+
+ENGINE STUBS
+
+just enough of the engine for the bot library to load weight configurations
+
+==============================================================================
+*/
+
+void QDECL Com_Printf( const char *fmt, ... ) {
+	va_list		argptr;
+
+	va_start( argptr, fmt );
+	vprintf( fmt, argptr );
+	va_end( argptr );
+}
+
+void QDECL Com_Error( int level, const char *fmt, ... ) {
+	va_list		argptr;
+
+	printf( "ERROR: " );
+	va_start( argptr, fmt );
+	vprintf( fmt, argptr );
+	va_end( argptr );
+	printf( "\n" );
+	exit( 1 );
+}
+
+static __attribute__ ((format (printf, 2, 3))) void QDECL BotImport_Print( int type, char *fmt, ... ) {
+	va_list		argptr;
+
+	// only errors, loading the file is chatty
+	if ( type != PRT_ERROR && type != PRT_FATAL ) {
+		return;
+	}
+	va_start( argptr, fmt );
+	vprintf( fmt, argptr );
+	va_end( argptr );
+}
+
+static void *BotImport_GetMemory( int size ) {
+	void	*buf;
+
+	buf = malloc( size );
+	if ( !buf ) {
+		Com_Error( ERR_FATAL, "GetMemory: out of memory" );
+	}
+	return buf;
+}
+
+static void BotImport_FreeMemory( void *ptr ) {
+	free( ptr );
+}
+
+static int BotImport_AvailableMemory( void ) {
+	return 256 * 1024 * 1024;
+}
+
+static void *BotImport_HunkAlloc( int size ) {
+	void	*buf;
+
+	buf = calloc( 1, size );
+	if ( !buf ) {
+		Com_Error( ERR_FATAL, "HunkAlloc: out of memory" );
+	}
+	return buf;
+}
+
+// only the generated weight file can be opened
+static int BotImport_FS_FOpenFile( const char *qpath, fileHandle_t *f, fsMode_t mode ) {
+	FILE	*fp;
+	int		i;
+
+	*f = 0;
+	for ( i = 1 ; i < ARRAY_LEN( checkFiles ) ; i++ ) {
+		if ( !checkFiles[i] ) {
+			break;
+		}
+	}
+	if ( i == ARRAY_LEN( checkFiles ) ) {
+		return -1;
+	}
+	if ( mode != FS_READ || !weightText || strcmp( qpath, BOTFILESBASEFOLDER "/" WEIGHT_FILE ) ) {
+		return -1;
+	}
+	fp = tmpfile();
+	if ( !fp ) {
+		return -1;
+	}
+	fwrite( weightText, 1, weightTextLength, fp );
+	rewind( fp );
+	checkFiles[i] = fp;
+	*f = i;
+	return weightTextLength;
+}
+
+static int BotImport_FS_Read( void *buffer, int len, fileHandle_t f ) {
+	return fread( buffer, 1, len, checkFiles[f] );
+}
+
+static void BotImport_FS_FCloseFile( fileHandle_t f ) {
+	fclose( checkFiles[f] );
+	checkFiles[f] = NULL;
+}
+
+static int BotImport_FS_Seek( fileHandle_t f, long offset, int origin ) {
+	switch ( origin ) {
+	case FS_SEEK_CUR:
+		return fseek( checkFiles[f], offset, SEEK_CUR );
+	case FS_SEEK_END:
+		return fseek( checkFiles[f], offset, SEEK_END );
+	default:
+		return fseek( checkFiles[f], offset, SEEK_SET );
+	}
+}
+
+// be_ai_weight.c
+void ScaleFuzzyBalanceRange( weightconfig_t *config, float scale );
+
+/*
+==============================================================================
+
+WORKLOAD
+
+==============================================================================
+*/
+
+static double Microseconds( void ) {
+#ifdef _WIN32
+	static LARGE_INTEGER	freq;
+	LARGE_INTEGER			now;
+
+	if ( !freq.QuadPart ) {
+		QueryPerformanceFrequency( &freq );
+	}
+	QueryPerformanceCounter( &now );
+	return (double)now.QuadPart * 1000000.0 / freq.QuadPart;
+#else
+	struct timespec	now;
+
+	clock_gettime( CLOCK_MONOTONIC, &now );
+	return now.tv_sec * 1000000.0 + now.tv_nsec / 1000.0;
+#endif
+}
+
+// the undecided weights draw from the c library's rand(), so the workload
+// has its own generator
+static float Random( void ) {
+	randSeed = randSeed * 1664525 + 1013904223;
+	return ( randSeed >> 8 ) / (float)( 1 << 24 );
+}
+
+static __attribute__ ((format (printf, 1, 2))) void WeightPrintf( const char *fmt, ... ) {
+	va_list		argptr;
+	int			len;
+
+	va_start( argptr, fmt );
+	len = vsnprintf( NULL, 0, fmt, argptr );
+	va_end( argptr );
+	if ( weightTextLength + len + 1 > weightTextSize ) {
+		weightTextSize = ( weightTextLength + len + 1 ) * 2;
+		weightText = realloc( weightText, weightTextSize );
+		if ( !weightText ) {
+			Com_Error( ERR_FATAL, "out of memory" );
+		}
+	}
+	va_start( argptr, fmt );
+	vsnprintf( weightText + weightTextLength, len + 1, fmt, argptr );
+	va_end( argptr );
+	weightTextLength += len;
+}
+
+static void GenerateWeight_r( int depth ) {
+	int		numCases, value, i;
+
+	if ( depth > 0 && Random() < 0.67f ) {
+		numCases = 1 + (int)( Random() * 6 );
+		value = (int)( Random() * 5 );
+		WeightPrintf( "switch(%i) {\n", (int)( Random() * WEIGHT_INVENTORY ) );
+		for ( i = 0 ; i < numCases ; i++ ) {
+			value += 1 + (int)( Random() * 40 );
+			WeightPrintf( "case %i: ", value );
+			GenerateWeight_r( depth - 1 );
+		}
+		if ( Random() < 0.75f ) {
+			WeightPrintf( "default: " );
+			GenerateWeight_r( depth - 1 );
+		}
+		WeightPrintf( "}\n" );
+	} else if ( Random() < 0.5f ) {
+		WeightPrintf( "return balance(%i, %i, %i);\n", (int)( Random() * 200 ),
+			(int)( Random() * 100 ), 100 + (int)( Random() * 200 ) );
+	} else {
+		WeightPrintf( "return %i;\n", (int)( Random() * 300 ) );
+	}
+}
+
+static void GenerateWeightFile( void ) {
+	int		numWeights, i;
+
+	weightTextLength = 0;
+	numWeights = 1 + (int)( Random() * 40 );
+	for ( i = 0 ; i < numWeights ; i++ ) {
+		WeightPrintf( "weight \"w%i\"\n{\n", i );
+		GenerateWeight_r( WEIGHT_DEPTH );
+		WeightPrintf( "}\n" );
+	}
+}
+
+/*
+==============================================================================
+
+CHECK
+
+==============================================================================
+*/
+
+// the evaluation of the seperator lists the compiled weights replaced
+static float ReferenceWeight_r( int *inventory, fuzzyseperator_t *fs ) {
+	float	scale, w1, w2;
+
+	if ( inventory[fs->index] < fs->value ) {
+		if ( fs->child ) {
+			return ReferenceWeight_r( inventory, fs->child );
+		}
+		return fs->weight;
+	}
+	if ( !fs->next ) {
+		return fs->weight;
+	}
+	if ( inventory[fs->index] >= fs->next->value ) {
+		return ReferenceWeight_r( inventory, fs->next );
+	}
+	w1 = fs->child ? ReferenceWeight_r( inventory, fs->child ) : fs->weight;
+	w2 = fs->next->child ? ReferenceWeight_r( inventory, fs->next->child ) : fs->next->weight;
+	if ( fs->next->value == WEIGHT_DEFAULTVALUE ) {
+		return w2;
+	}
+	scale = (float)( inventory[fs->index] - fs->value ) / ( fs->next->value - fs->value );
+	return ( 1 - scale ) * w1 + scale * w2;
+}
+
+static float ReferenceWeightUndecided_r( int *inventory, fuzzyseperator_t *fs ) {
+	float	scale, w1, w2;
+
+	if ( inventory[fs->index] < fs->value ) {
+		if ( fs->child ) {
+			return ReferenceWeightUndecided_r( inventory, fs->child );
+		}
+		return fs->minweight + random() * ( fs->maxweight - fs->minweight );
+	}
+	if ( !fs->next ) {
+		return fs->weight;
+	}
+	if ( inventory[fs->index] >= fs->next->value ) {
+		return ReferenceWeightUndecided_r( inventory, fs->next );
+	}
+	if ( fs->child ) {
+		w1 = ReferenceWeightUndecided_r( inventory, fs->child );
+	} else {
+		w1 = fs->minweight + random() * ( fs->maxweight - fs->minweight );
+	}
+	// the second weight is decided, like the original
+	if ( fs->next->child ) {
+		w2 = ReferenceWeight_r( inventory, fs->next->child );
+	} else {
+		w2 = fs->next->minweight + random() * ( fs->next->maxweight - fs->next->minweight );
+	}
+	if ( fs->next->value == WEIGHT_DEFAULTVALUE ) {
+		return w2;
+	}
+	scale = (float)( inventory[fs->index] - fs->value ) / ( fs->next->value - fs->value );
+	return ( 1 - scale ) * w1 + scale * w2;
+}
+
+/*
+=================
+CompareWeights
+
+Both the decided and the undecided weights have to match bit for bit, the
+undecided ones also have to draw as many random numbers from the same seed
+=================
+*/
+static int CompareWeights( weightconfig_t *wc, int *inventories, int numInventories ) {
+	int		*inventory;
+	float	a, b;
+	int		mismatches;
+	int		i, j;
+
+	mismatches = 0;
+	for ( i = 0 ; i < numInventories ; i++ ) {
+		inventory = &inventories[i * WEIGHT_INVENTORY];
+		for ( j = 0 ; j < wc->numweights ; j++ ) {
+			a = ReferenceWeight_r( inventory, wc->weights[j].firstseperator );
+			b = FuzzyWeight( inventory, wc, j );
+			if ( a != b ) {
+				mismatches++;
+			}
+
+			srand( i * MAX_WEIGHTS + j );
+			a = ReferenceWeightUndecided_r( inventory, wc->weights[j].firstseperator );
+			a += random();
+			srand( i * MAX_WEIGHTS + j );
+			b = FuzzyWeightUndecided( inventory, wc, j );
+			b += random();
+			if ( a != b ) {
+				mismatches++;
+			}
+		}
+	}
+	return mismatches;
+}
+
+static void TimeWeights( weightconfig_t *wc, int *inventories, int numInventories, int rounds,
+	double *referenceTime, double *compiledTime ) {
+	volatile float	sum;
+	double			start;
+	int				i, j, r;
+
+	sum = 0;
+	start = Microseconds();
+	for ( r = 0 ; r < rounds ; r++ ) {
+		for ( i = 0 ; i < numInventories ; i++ ) {
+			for ( j = 0 ; j < wc->numweights ; j++ ) {
+				sum += ReferenceWeight_r( &inventories[i * WEIGHT_INVENTORY], wc->weights[j].firstseperator );
+			}
+		}
+	}
+	*referenceTime += Microseconds() - start;
+
+	start = Microseconds();
+	for ( r = 0 ; r < rounds ; r++ ) {
+		for ( i = 0 ; i < numInventories ; i++ ) {
+			for ( j = 0 ; j < wc->numweights ; j++ ) {
+				sum += FuzzyWeight( &inventories[i * WEIGHT_INVENTORY], wc, j );
+			}
+		}
+	}
+	*compiledTime += Microseconds() - start;
+}
+
+/*
+=================
+RunWeights
+
+Generates random weight configurations and checks the compiled weights
+against the seperator lists on random inventories, as loaded and again
+after the configurations were evolved and their balance ranges scaled
+=================
+*/
+static int RunWeights( int numInventories, int rounds ) {
+	weightconfig_t	*wc;
+	int				*inventories;
+	double			referenceTime, compiledTime;
+	int				numWeights, numEvaluations, mismatches;
+	int				c, i, stage;
+
+	inventories = calloc( numInventories, WEIGHT_INVENTORY * sizeof( int ) );
+	if ( !inventories ) {
+		Com_Error( ERR_FATAL, "out of memory" );
+	}
+	// always parse the generated file again
+	LibVarSet( "bot_reloadcharacters", "1" );
+
+	randSeed = seed;
+	numWeights = 0;
+	numEvaluations = 0;
+	mismatches = 0;
+	referenceTime = 0;
+	compiledTime = 0;
+	for ( c = 0 ; c < WEIGHT_CONFIGS ; c++ ) {
+		GenerateWeightFile();
+		wc = ReadWeightConfig( WEIGHT_FILE );
+		if ( !wc ) {
+			Com_Error( ERR_FATAL, "couldn't load weight configuration %i", c );
+		}
+		numWeights += wc->numweights;
+		for ( stage = 0 ; stage < 3 ; stage++ ) {
+			if ( stage == 1 ) {
+				EvolveWeightConfig( wc );
+			} else if ( stage == 2 ) {
+				ScaleFuzzyBalanceRange( wc, 0.5f );
+			}
+			// a few values below zero and past the case values
+			for ( i = 0 ; i < numInventories * WEIGHT_INVENTORY ; i++ ) {
+				inventories[i] = (int)( Random() * 250 ) - 5;
+			}
+			mismatches += CompareWeights( wc, inventories, numInventories );
+			TimeWeights( wc, inventories, numInventories, rounds, &referenceTime, &compiledTime );
+			numEvaluations += numInventories * wc->numweights * rounds;
+		}
+		FreeWeightConfig( wc );
+	}
+	free( inventories );
+
+	printf( "%i weight configurations, %i weights, %i inventories x 3 stages x %i rounds, seed %u\n",
+		WEIGHT_CONFIGS, numWeights, numInventories, rounds, seed );
+	printf( "  kind         weights/sec  usec/weight\n" );
+	printf( "  %-10s %13.0f %12.4f\n", "seperators", numEvaluations / ( referenceTime / 1000000.0 ),
+		referenceTime / numEvaluations );
+	printf( "  %-10s %13.0f %12.4f\n", "compiled", numEvaluations / ( compiledTime / 1000000.0 ),
+		compiledTime / numEvaluations );
+
+	if ( mismatches ) {
+		printf( "compiled weights gave %i different results\n", mismatches );
+		return 1;
+	}
+	return 0;
+}
+
+static void Usage( void ) {
+	printf( "usage: weightcheck [options]\n"
+		"  -n <count>            random inventories per weight configuration (default 2000)\n"
+		"  -rounds <count>       time the evaluation this many times (default 5)\n"
+		"  -seed <seed>          workload random seed (default 1)\n" );
+	exit( 1 );
+}
+
+int main( int argc, char **argv ) {
+	botlib_import_t	import;
+	int				count, rounds;
+	int				i;
+
+	count = 2000;
+	rounds = 5;
+
+	for ( i = 1 ; i < argc ; i++ ) {
+		if ( !strcmp( argv[i], "-n" ) && i + 1 < argc ) {
+			count = atoi( argv[++i] );
+		} else if ( !strcmp( argv[i], "-rounds" ) && i + 1 < argc ) {
+			rounds = atoi( argv[++i] );
+		} else if ( !strcmp( argv[i], "-seed" ) && i + 1 < argc ) {
+			seed = strtoul( argv[++i], NULL, 0 );
+		} else {
+			Usage();
+		}
+	}
+	if ( count <= 0 || rounds <= 0 ) {
+		Usage();
+	}
+
+	Com_Memset( &import, 0, sizeof( import ) );
+	import.Print = BotImport_Print;
+	import.GetMemory = BotImport_GetMemory;
+	import.FreeMemory = BotImport_FreeMemory;
+	import.AvailableMemory = BotImport_AvailableMemory;
+	import.HunkAlloc = BotImport_HunkAlloc;
+	import.FS_FOpenFile = BotImport_FS_FOpenFile;
+	import.FS_Read = BotImport_FS_Read;
+	import.FS_FCloseFile = BotImport_FS_FCloseFile;
+	import.FS_Seek = BotImport_FS_Seek;
+	botimport = import;
+
+	return RunWeights( count, rounds );
+}